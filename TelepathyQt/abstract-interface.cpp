@@ -34,6 +34,8 @@
 #include <TelepathyQt/Types>
 
 #include <QDBusPendingCall>
+#include <QHash>
+#include <QPair>
 #include <QDBusVariant>
 
 namespace Tp
@@ -42,14 +44,55 @@ namespace Tp
 struct TP_QT_NO_EXPORT AbstractInterface::Private
 {
     Private();
+
+    void clearCache();
+    bool isStale(const QString &name, uint requestSerial) const;
+
     QString mError;
     QString mMessage;
     bool monitorProperties;
+
+    // property cache
+    bool cachingProperties;
+    bool cacheSeeded;
+    bool cacheComplete;
+    QVariantMap cache;
+    // Bumped for every PropertiesChanged, so replies to requests made before a change don't
+    // overwrite the newer values
+    uint changeSerial;
+    uint invalidationSerial;
+    QHash<QString, uint> changeSerials;
+    QHash<PendingOperation *, QPair<QString, uint> > pendingGets;
+    QHash<PendingOperation *, uint> pendingGetAlls;
+    uint cacheHits;
+    uint cacheMisses;
 };
 
 AbstractInterface::Private::Private()
-    : monitorProperties(false)
+    : monitorProperties(false),
+      cachingProperties(false),
+      cacheSeeded(false),
+      cacheComplete(false),
+      changeSerial(0),
+      invalidationSerial(0),
+      cacheHits(0),
+      cacheMisses(0)
+{
+}
+
+void AbstractInterface::Private::clearCache()
+{
+    cacheSeeded = false;
+    cacheComplete = false;
+    cache.clear();
+    changeSerials.clear();
+    pendingGets.clear();
+    pendingGetAlls.clear();
+}
+
+bool AbstractInterface::Private::isStale(const QString &name, uint requestSerial) const
 {
+    return changeSerials.value(name, 0) > requestSerial;
 }
 
 /**
@@ -107,16 +150,38 @@ void AbstractInterface::invalidate(DBusProxy *proxy,
         mPriv->mError = error;
         mPriv->mMessage = message;
     }
+
+    // nothing will keep the cache up to date anymore
+    mPriv->cachingProperties = false;
+    mPriv->clearCache();
 }
 
 PendingVariant *AbstractInterface::internalRequestProperty(const QString &name) const
 {
+    DBusProxy *proxy = qobject_cast<DBusProxy*>(parent());
+
+    if (mPriv->cachingProperties) {
+        if (mPriv->cache.contains(name)) {
+            ++mPriv->cacheHits;
+            return new PendingVariant(mPriv->cache.value(name), DBusProxyPtr(proxy));
+        }
+        ++mPriv->cacheMisses;
+    }
+
     QDBusMessage msg = QDBusMessage::createMethodCall(service(), path(),
             TP_QT_IFACE_PROPERTIES, QLatin1String("Get"));
     msg << interface() << name;
     QDBusPendingCall pendingCall = connection().asyncCall(msg);
-    DBusProxy *proxy = qobject_cast<DBusProxy*>(parent());
-    return new PendingVariant(pendingCall, DBusProxyPtr(proxy));
+    PendingVariant *pv = new PendingVariant(pendingCall, DBusProxyPtr(proxy));
+
+    if (mPriv->cachingProperties) {
+        mPriv->pendingGets.insert(pv, qMakePair(name, mPriv->changeSerial));
+        connect(pv,
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(onRequestPropertyFinished(Tp::PendingOperation*)));
+    }
+
+    return pv;
 }
 
 PendingOperation *AbstractInterface::internalSetProperty(const QString &name,
@@ -132,12 +197,30 @@ PendingOperation *AbstractInterface::internalSetProperty(const QString &name,
 
 PendingVariantMap *AbstractInterface::internalRequestAllProperties() const
 {
+    DBusProxy *proxy = qobject_cast<DBusProxy*>(parent());
+
+    if (mPriv->cachingProperties) {
+        if (mPriv->cacheComplete) {
+            ++mPriv->cacheHits;
+            return new PendingVariantMap(mPriv->cache, DBusProxyPtr(proxy));
+        }
+        ++mPriv->cacheMisses;
+    }
+
     QDBusMessage msg = QDBusMessage::createMethodCall(service(), path(),
             TP_QT_IFACE_PROPERTIES, QLatin1String("GetAll"));
     msg << interface();
     QDBusPendingCall pendingCall = connection().asyncCall(msg);
-    DBusProxy *proxy = qobject_cast<DBusProxy*>(parent());
-    return new PendingVariantMap(pendingCall, DBusProxyPtr(proxy));
+    PendingVariantMap *pvm = new PendingVariantMap(pendingCall, DBusProxyPtr(proxy));
+
+    if (mPriv->cachingProperties) {
+        mPriv->pendingGetAlls.insert(pvm, mPriv->changeSerial);
+        connect(pvm,
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(onRequestAllPropertiesFinished(Tp::PendingOperation*)));
+    }
+
+    return pvm;
 }
 
 /**
@@ -148,6 +231,9 @@ PendingVariantMap *AbstractInterface::internalRequestAllProperties() const
  * By default, AbstractInterface does not monitor properties: you need to call this method
  * for this to happen.
  *
+ * Stopping monitoring also disables the property cache, as it could not be kept up to date
+ * anymore.
+ *
  * \param monitorProperties Whether this interface should monitor property changes or not.
  * \sa isMonitoringProperties
  *     propertiesChanged()
@@ -158,6 +244,10 @@ void AbstractInterface::setMonitorProperties(bool monitorProperties)
         return;
     }
 
+    if (!monitorProperties) {
+        setCachingProperties(false);
+    }
+
     QStringList argumentMatch;
     argumentMatch << interface();
 
@@ -178,7 +268,10 @@ void AbstractInterface::setMonitorProperties(bool monitorProperties)
     if (!success) {
         warning() << "Connection or disconnection to " << TP_QT_IFACE_PROPERTIES <<
                 ".PropertiesChanged failed.";
+        return;
     }
+
+    mPriv->monitorProperties = monitorProperties;
 }
 
 /**
@@ -198,13 +291,224 @@ bool AbstractInterface::isMonitoringProperties() const
     return mPriv->monitorProperties;
 }
 
+/**
+ * Sets whether this abstract interface will be caching the values of its properties.
+ *
+ * When caching is enabled, the interface starts monitoring properties and seeds the cache with a
+ * single GetAll call, emitting propertyCacheSeeded() once done. The cached values are then kept up
+ * to date from the PropertiesChanged signal. Properties which are only invalidated are dropped from
+ * the cache and fetched again the next time they are requested.
+ *
+ * While caching, the generated requestProperty*() and requestAllProperties() methods are
+ * answered from the cache whenever possible, without going to the bus, and the cached values can
+ * also be read synchronously with cachedProperty().
+ *
+ * Disabling caching drops all cached values, but does not stop monitoring properties.
+ *
+ * By default, AbstractInterface does not cache properties.
+ *
+ * \param cachingProperties Whether this interface should cache its properties or not.
+ * \sa isCachingProperties(), propertyCacheHits(), propertyCacheMisses()
+ */
+void AbstractInterface::setCachingProperties(bool cachingProperties)
+{
+    if (cachingProperties == mPriv->cachingProperties) {
+        return;
+    }
+
+    if (!cachingProperties) {
+        mPriv->cachingProperties = false;
+        mPriv->clearCache();
+        return;
+    }
+
+    if (!isValid()) {
+        warning() << "Not caching properties on invalid interface" << interface();
+        return;
+    }
+
+    // Start listening for changes before seeding, so nothing happening in between is missed
+    setMonitorProperties(true);
+    if (!mPriv->monitorProperties) {
+        warning() << "Not caching properties on" << interface() <<
+                "as they cannot be monitored";
+        return;
+    }
+
+    mPriv->cachingProperties = true;
+    internalRequestAllProperties();
+}
+
+/**
+ * Return whether this abstract interface is caching the values of its properties.
+ *
+ * \return \c true if the interface is caching properties, \c false otherwise.
+ * \sa setCachingProperties()
+ */
+bool AbstractInterface::isCachingProperties() const
+{
+    return mPriv->cachingProperties;
+}
+
+/**
+ * Return whether the property cache has been seeded with the values of all properties on this
+ * interface.
+ *
+ * \return \c true if the cache has been seeded, \c false otherwise.
+ * \sa setCachingProperties(), propertyCacheSeeded()
+ */
+bool AbstractInterface::isPropertyCacheSeeded() const
+{
+    return mPriv->cacheSeeded;
+}
+
+/**
+ * Return whether the property cache holds a value for the property with the given \a name.
+ *
+ * This method does not count as a cache hit or miss.
+ *
+ * \param name The name of the property.
+ * \return \c true if a value is cached, \c false otherwise.
+ * \sa cachedProperty()
+ */
+bool AbstractInterface::hasCachedProperty(const QString &name) const
+{
+    return mPriv->cache.contains(name);
+}
+
+/**
+ * Return the cached value of the property with the given \a name.
+ *
+ * \param name The name of the property.
+ * \return The cached value, or an invalid QVariant if the property is not cached.
+ * \sa hasCachedProperty(), setCachingProperties()
+ */
+QVariant AbstractInterface::cachedProperty(const QString &name) const
+{
+    QVariantMap::const_iterator i = mPriv->cache.constFind(name);
+    if (i == mPriv->cache.constEnd()) {
+        ++mPriv->cacheMisses;
+        return QVariant();
+    }
+
+    ++mPriv->cacheHits;
+    return i.value();
+}
+
+/**
+ * Return the values of all the properties currently in the cache.
+ *
+ * \return A map of property names to their cached values.
+ * \sa setCachingProperties()
+ */
+QVariantMap AbstractInterface::cachedProperties() const
+{
+    return mPriv->cache;
+}
+
+/**
+ * Return the number of property lookups answered from the cache.
+ *
+ * This counts the calls to cachedProperty() which found a value and the property requests which
+ * did not need to go to the bus.
+ *
+ * \return The number of cache hits.
+ * \sa propertyCacheMisses()
+ */
+uint AbstractInterface::propertyCacheHits() const
+{
+    return mPriv->cacheHits;
+}
+
+/**
+ * Return the number of property lookups that could not be answered from the cache.
+ *
+ * This counts the calls to cachedProperty() which did not find a value and the property requests
+ * made while caching which still had to go to the bus.
+ *
+ * \return The number of cache misses.
+ * \sa propertyCacheHits()
+ */
+uint AbstractInterface::propertyCacheMisses() const
+{
+    return mPriv->cacheMisses;
+}
+
 void AbstractInterface::onPropertiesChanged(const QString &interface,
             const QVariantMap &changedProperties,
             const QStringList &invalidatedProperties)
 {
+    if (mPriv->cachingProperties) {
+        ++mPriv->changeSerial;
+
+        for (QVariantMap::const_iterator i = changedProperties.constBegin();
+                i != changedProperties.constEnd(); ++i) {
+            mPriv->cache.insert(i.key(), i.value());
+            mPriv->changeSerials.insert(i.key(), mPriv->changeSerial);
+        }
+
+        foreach (const QString &name, invalidatedProperties) {
+            mPriv->cache.remove(name);
+            mPriv->changeSerials.insert(name, mPriv->changeSerial);
+        }
+
+        if (!invalidatedProperties.isEmpty()) {
+            mPriv->invalidationSerial = mPriv->changeSerial;
+            mPriv->cacheComplete = false;
+        }
+    }
+
     emit propertiesChanged(changedProperties, invalidatedProperties);
 }
 
+void AbstractInterface::onRequestPropertyFinished(PendingOperation *op)
+{
+    if (!mPriv->pendingGets.contains(op)) {
+        // caching was disabled meanwhile
+        return;
+    }
+
+    QPair<QString, uint> request = mPriv->pendingGets.take(op);
+    if (op->isError() || mPriv->isStale(request.first, request.second)) {
+        return;
+    }
+
+    PendingVariant *pv = qobject_cast<PendingVariant *>(op);
+    mPriv->cache.insert(request.first, pv->result());
+}
+
+void AbstractInterface::onRequestAllPropertiesFinished(PendingOperation *op)
+{
+    if (!mPriv->pendingGetAlls.contains(op)) {
+        return;
+    }
+
+    uint requestSerial = mPriv->pendingGetAlls.take(op);
+    if (op->isError()) {
+        warning().nospace() << "Unable to seed property cache for " << interface() <<
+                ": " << op->errorName() << ": " << op->errorMessage();
+        return;
+    }
+
+    PendingVariantMap *pvm = qobject_cast<PendingVariantMap *>(op);
+    QVariantMap properties = pvm->result();
+    for (QVariantMap::const_iterator i = properties.constBegin();
+            i != properties.constEnd(); ++i) {
+        if (!mPriv->isStale(i.key(), requestSerial)) {
+            mPriv->cache.insert(i.key(), i.value());
+        }
+    }
+
+    if (mPriv->invalidationSerial <= requestSerial) {
+        mPriv->cacheComplete = true;
+    }
+
+    if (!mPriv->cacheSeeded) {
+        mPriv->cacheSeeded = true;
+        emit propertyCacheSeeded();
+    }
+}
+
 /**
  * \fn void AbstractInterface::propertiesChanged(const QVariantMap &changedProperties,
  *             const QStringList &invalidatedProperties)
@@ -217,4 +521,13 @@ void AbstractInterface::onPropertiesChanged(const QString &interface,
  * \sa isMonitoringProperties()
  */
 
+/**
+ * \fn void AbstractInterface::propertyCacheSeeded()
+ *
+ * Emitted once the property cache has been filled with the values of all properties on this
+ * interface, after caching was enabled.
+ *
+ * \sa setCachingProperties(), isPropertyCacheSeeded()
+ */
+
 } // Tp
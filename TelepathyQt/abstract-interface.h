@@ -30,6 +30,7 @@
 #include <TelepathyQt/Global>
 
 #include <QDBusAbstractInterface>
+#include <QVariant>
 
 namespace Tp
 {
@@ -54,9 +55,21 @@ public:
     void setMonitorProperties(bool monitorProperties);
     bool isMonitoringProperties() const;
 
+    void setCachingProperties(bool cachingProperties);
+    bool isCachingProperties() const;
+    bool isPropertyCacheSeeded() const;
+
+    bool hasCachedProperty(const QString &name) const;
+    QVariant cachedProperty(const QString &name) const;
+    QVariantMap cachedProperties() const;
+
+    uint propertyCacheHits() const;
+    uint propertyCacheMisses() const;
+
 Q_SIGNALS:
     void propertiesChanged(const QVariantMap &changedProperties,
             const QStringList &invalidatedProperties);
+    void propertyCacheSeeded();
 
 protected Q_SLOTS:
     virtual void invalidate(Tp::DBusProxy *proxy,
@@ -76,6 +89,8 @@ private Q_SLOTS:
     TP_QT_NO_EXPORT void onPropertiesChanged(const QString &interface,
             const QVariantMap &changedProperties,
             const QStringList &invalidatedProperties);
+    TP_QT_NO_EXPORT void onRequestPropertyFinished(Tp::PendingOperation *op);
+    TP_QT_NO_EXPORT void onRequestAllPropertiesFinished(Tp::PendingOperation *op);
 
 private:
     struct Private;
@@ -25,8 +25,10 @@
 #include "TelepathyQt/debug-internal.h"
 
 #include <QLatin1String>
-#include <QStringList>
+#include <QList>
 #include <QMetaObject>
+#include <QMetaProperty>
+#include <QStringList>
 #include <QVariantMap>
 
 namespace Tp
@@ -35,6 +37,8 @@ namespace Tp
 struct TP_QT_NO_EXPORT AccountPropertyFilter::Private
 {
     Private()
+        : compiled(false),
+          compiledValid(false)
     {
         if (supportedAccountProperties.isEmpty()) {
             const QMetaObject metaObject = Account::staticMetaObject;
@@ -44,11 +48,80 @@ struct TP_QT_NO_EXPORT AccountPropertyFilter::Private
         }
     }
 
+    struct CompiledProperty
+    {
+        QMetaProperty property;
+        // QMetaType::UnknownType if the value could not be converted to the property type
+        int type;
+        QVariant value;
+    };
+
+    void compile(const QVariantMap &filter);
+    static bool propertyMatches(const CompiledProperty &compiledProperty, const QVariant &value);
+
     static QStringList supportedAccountProperties;
+
+    // The filter map the compiled properties were built from. As long as the filter is not
+    // changed it shares its data with this copy, so checking for changes is cheap.
+    QVariantMap compiledFilter;
+    QList<CompiledProperty> compiledProperties;
+    bool compiled;
+    bool compiledValid;
 };
 
 QStringList AccountPropertyFilter::Private::supportedAccountProperties;
 
+void AccountPropertyFilter::Private::compile(const QVariantMap &filter)
+{
+    compiledFilter = filter;
+    compiledProperties.clear();
+    compiled = true;
+    compiledValid = true;
+
+    const QMetaObject &metaObject = Account::staticMetaObject;
+    for (QVariantMap::const_iterator i = filter.constBegin(); i != filter.constEnd(); ++i) {
+        int index = metaObject.indexOfProperty(i.key().toLatin1().constData());
+        if (index < 0) {
+            compiledValid = false;
+            compiledProperties.clear();
+            return;
+        }
+
+        CompiledProperty compiledProperty;
+        compiledProperty.property = metaObject.property(index);
+        compiledProperty.type = compiledProperty.property.userType();
+        compiledProperty.value = i.value();
+        if (compiledProperty.value.userType() != compiledProperty.type &&
+            !compiledProperty.value.convert(compiledProperty.type)) {
+            compiledProperty.type = QMetaType::UnknownType;
+            compiledProperty.value = i.value();
+        }
+        compiledProperties.append(compiledProperty);
+    }
+}
+
+bool AccountPropertyFilter::Private::propertyMatches(const CompiledProperty &compiledProperty,
+        const QVariant &value)
+{
+    if (value.userType() != compiledProperty.type) {
+        return value == compiledProperty.value;
+    }
+
+    switch (compiledProperty.type) {
+    case QMetaType::Bool:
+        return *static_cast<const bool *>(value.constData()) ==
+            *static_cast<const bool *>(compiledProperty.value.constData());
+    case QMetaType::UInt:
+        return *static_cast<const uint *>(value.constData()) ==
+            *static_cast<const uint *>(compiledProperty.value.constData());
+    case QMetaType::QString:
+        return *static_cast<const QString *>(value.constData()) ==
+            *static_cast<const QString *>(compiledProperty.value.constData());
+    default:
+        return value == compiledProperty.value;
+    }
+}
+
 /**
  * \class Tp::AccountPropertyFilter
  * \ingroup utils
@@ -91,4 +164,36 @@ bool AccountPropertyFilter::isValid() const
     return true;
 }
 
+/**
+ * Return whether \a account matches this filter.
+ *
+ * The property names in the filter are resolved to Account meta-properties once, and resolved
+ * again only after the filter is changed, so matching a large number of accounts doesn't look up
+ * each property by name for every account.
+ *
+ * \param account The account to check.
+ * \return \c true if all the filter properties of \a account have the filter values,
+ *         \c false otherwise.
+ */
+bool AccountPropertyFilter::matches(const AccountPtr &account) const
+{
+    QVariantMap currentFilter = filter();
+    if (!mPriv->compiled || currentFilter != mPriv->compiledFilter) {
+        mPriv->compile(currentFilter);
+    }
+
+    if (!mPriv->compiledValid) {
+        return GenericPropertyFilter<Account>::matches(account);
+    }
+
+    foreach (const Private::CompiledProperty &compiledProperty, mPriv->compiledProperties) {
+        if (!Private::propertyMatches(compiledProperty,
+                    compiledProperty.property.read(account.data()))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 } // Tp
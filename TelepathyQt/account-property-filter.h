@@ -46,6 +46,8 @@ public:
 
     bool isValid() const;
 
+    bool matches(const AccountPtr &account) const;
+
 private:
     AccountPropertyFilter();
 
@@ -22,6 +22,8 @@
 
 #include <TelepathyQt/AccountPropertyFilter>
 
+#include <QSet>
+
 namespace Tp
 {
 
@@ -37,6 +39,8 @@ struct TP_QT_NO_EXPORT AccountSet::Private
             const QVariantMap &filter);
 
     void init();
+    void addFilterDependencies(const AccountFilterConstPtr &filter);
+    bool filterDependsOn(const QString &propertyName) const;
     void connectSignals();
     void insertAccounts();
     void insertAccount(const AccountPtr &account);
@@ -48,6 +52,11 @@ struct TP_QT_NO_EXPORT AccountSet::Private
     AccountSet *parent;
     AccountManagerPtr accountManager;
     AccountFilterConstPtr filter;
+    // Account properties and capabilities the filter looks at, so that changes to anything else
+    // don't cause the filter to be re-evaluated
+    QSet<QString> filterProperties;
+    bool filterDependsOnAllProperties;
+    bool filterDependsOnCapabilities;
     QHash<QString, AccountWrapper *> wrappers;
     QHash<QString, AccountPtr> accounts;
     bool ready;
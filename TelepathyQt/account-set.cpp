@@ -30,9 +30,15 @@
 
 #include <TelepathyQt/Account>
 #include <TelepathyQt/AccountFilter>
+#include <TelepathyQt/AccountCapabilityFilter>
 #include <TelepathyQt/AccountManager>
+#include <TelepathyQt/AndFilter>
 #include <TelepathyQt/ConnectionCapabilities>
 #include <TelepathyQt/ConnectionManager>
+#include <TelepathyQt/NotFilter>
+#include <TelepathyQt/OrFilter>
+
+#include <QMetaProperty>
 
 namespace Tp
 {
@@ -43,6 +49,8 @@ AccountSet::Private::Private(AccountSet *parent,
     : parent(parent),
       accountManager(accountManager),
       filter(filter),
+      filterDependsOnAllProperties(false),
+      filterDependsOnCapabilities(false),
       ready(false)
 {
     init();
@@ -53,6 +61,8 @@ AccountSet::Private::Private(AccountSet *parent,
         const QVariantMap &filterMap)
     : parent(parent),
       accountManager(accountManager),
+      filterDependsOnAllProperties(false),
+      filterDependsOnCapabilities(false),
       ready(false)
 {
     AccountPropertyFilterPtr propertyFilter = AccountPropertyFilter::create();
@@ -67,12 +77,68 @@ AccountSet::Private::Private(AccountSet *parent,
 void AccountSet::Private::init()
 {
     if (filter->isValid()) {
+        addFilterDependencies(filter);
         connectSignals();
         insertAccounts();
         ready = true;
     }
 }
 
+void AccountSet::Private::addFilterDependencies(const AccountFilterConstPtr &filter)
+{
+    if (!filter) {
+        return;
+    }
+
+    const Filter<Account> *f = filter.data();
+    if (const AccountPropertyFilter *propertyFilter =
+            dynamic_cast<const AccountPropertyFilter *>(f)) {
+        const QMetaObject &metaObject = Account::staticMetaObject;
+        foreach (const QString &propertyName, propertyFilter->filter().keys()) {
+            int index = metaObject.indexOfProperty(propertyName.toLatin1().constData());
+            if (index < 0) {
+                // the filter is invalid and never matches
+                continue;
+            }
+
+            QMetaProperty property = metaObject.property(index);
+            if (property.isConstant()) {
+                continue;
+            }
+
+            if (!property.hasNotifySignal()) {
+                // we can't tell when it changes, so check it whenever anything changes
+                filterDependsOnAllProperties = true;
+            }
+            if (propertyName == QLatin1String("capabilities")) {
+                filterDependsOnCapabilities = true;
+            }
+            filterProperties.insert(propertyName);
+        }
+    } else if (dynamic_cast<const AccountCapabilityFilter *>(f)) {
+        filterDependsOnCapabilities = true;
+    } else if (const AndFilter<Account> *andFilter = dynamic_cast<const AndFilter<Account> *>(f)) {
+        foreach (const AccountFilterConstPtr &subFilter, andFilter->filters()) {
+            addFilterDependencies(subFilter);
+        }
+    } else if (const OrFilter<Account> *orFilter = dynamic_cast<const OrFilter<Account> *>(f)) {
+        foreach (const AccountFilterConstPtr &subFilter, orFilter->filters()) {
+            addFilterDependencies(subFilter);
+        }
+    } else if (const NotFilter<Account> *notFilter = dynamic_cast<const NotFilter<Account> *>(f)) {
+        addFilterDependencies(notFilter->filter());
+    } else {
+        // custom filter, it could look at anything
+        filterDependsOnAllProperties = true;
+        filterDependsOnCapabilities = true;
+    }
+}
+
+bool AccountSet::Private::filterDependsOn(const QString &propertyName) const
+{
+    return filterDependsOnAllProperties || filterProperties.contains(propertyName);
+}
+
 void AccountSet::Private::connectSignals()
 {
     parent->connect(accountManager.data(),
@@ -116,10 +182,12 @@ void AccountSet::Private::wrapAccount(const AccountPtr &account)
             SLOT(onAccountRemoved(Tp::AccountPtr)));
     parent->connect(wrapper,
             SIGNAL(accountPropertyChanged(Tp::AccountPtr,QString)),
-            SLOT(onAccountChanged(Tp::AccountPtr)));
-    parent->connect(wrapper,
-            SIGNAL(accountCapabilitiesChanged(Tp::AccountPtr,Tp::ConnectionCapabilities)),
-            SLOT(onAccountChanged(Tp::AccountPtr)));
+            SLOT(onAccountPropertyChanged(Tp::AccountPtr,QString)));
+    if (filterDependsOnCapabilities) {
+        parent->connect(wrapper,
+                SIGNAL(accountCapabilitiesChanged(Tp::AccountPtr,Tp::ConnectionCapabilities)),
+                SLOT(onAccountChanged(Tp::AccountPtr)));
+    }
     wrappers.insert(account->objectPath(), wrapper);
 }
 
@@ -415,4 +483,12 @@ void AccountSet::onAccountChanged(const AccountPtr &account)
     mPriv->filterAccount(account);
 }
 
+void AccountSet::onAccountPropertyChanged(const AccountPtr &account,
+        const QString &propertyName)
+{
+    if (mPriv->filterDependsOn(propertyName)) {
+        mPriv->filterAccount(account);
+    }
+}
+
 } // Tp
@@ -67,6 +67,8 @@ private Q_SLOTS:
     TP_QT_NO_EXPORT void onNewAccount(const Tp::AccountPtr &account);
     TP_QT_NO_EXPORT void onAccountRemoved(const Tp::AccountPtr &account);
     TP_QT_NO_EXPORT void onAccountChanged(const Tp::AccountPtr &account);
+    TP_QT_NO_EXPORT void onAccountPropertyChanged(const Tp::AccountPtr &account,
+            const QString &propertyName);
 
 private:
     struct Private;
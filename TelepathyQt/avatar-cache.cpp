@@ -0,0 +1,968 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2026 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "TelepathyQt/avatar-cache.h"
+
+#include "TelepathyQt/debug-internal.h"
+
+#include <TelepathyQt/Utils>
+
+#include <QtCore/QCache>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QLockFile>
+#include <QtCore/QPair>
+#include <QtCore/QSaveFile>
+#include <QtCore/QSet>
+#include <QtCore/QTemporaryFile>
+#include <QtCore/QVector>
+#include <QtCore/QtEndian>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace Tp
+{
+
+namespace
+{
+
+// The index is a hidden file, so it can never clash with an escaped token
+// (escapeAsIdentifier() never produces a leading '.') and is skipped when
+// scanning a cache directory written by an older version.
+const char indexFileName[] = ".avatar-index";
+const quint32 indexMagic = 0x54504156; // "TPAV"
+const quint32 indexVersion = 2;
+
+// Serializes the read-merge-write of the index between processes sharing the cache
+const char indexLockFileName[] = ".avatar-index.lock";
+const int indexLockTimeout = 2000;
+
+// Layout of the index, all little endian, so that lookups can binary search the mapped
+// file instead of parsing it into memory first:
+//  - header: magic, version, number of records, size of the string table (4 bytes each)
+//  - records, sorted by key hash: key hash, key offset, MIME type offset (4 bytes each),
+//    key length, MIME type length (2 bytes each), avatar size, last used time (8 bytes each)
+//  - string table: the keys and MIME types, in Latin-1
+enum {
+    HeaderSize = 16,
+    RecordSize = 32,
+    MaxStringLength = 0xffff
+};
+
+qint64 currentTime()
+{
+    return QDateTime::currentMSecsSinceEpoch() / 1000;
+}
+
+// FNV-1a, as qHash() is seeded differently in each process
+quint32 keyHash(const QByteArray &key)
+{
+    quint32 hash = 2166136261u;
+    for (int i = 0; i < key.size(); ++i) {
+        hash ^= (uchar) key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Files are written next to their final name and renamed into place, so that other
+// processes sharing the cache never see a partial avatar
+bool writeFileAtomically(const QString &fileName, const QByteArray &data)
+{
+    QTemporaryFile file(fileName);
+    if (!file.open() || file.write(data) != data.size()) {
+        return false;
+    }
+    file.setAutoRemove(false);
+    if (!file.rename(fileName)) {
+        file.remove();
+        return false;
+    }
+    return true;
+}
+
+struct Entry
+{
+    Entry()
+        : size(0),
+          lastUsed(0)
+    {
+    }
+
+    Entry(const QString &mimeType, qint64 size, qint64 lastUsed)
+        : mimeType(mimeType),
+          size(size),
+          lastUsed(lastUsed)
+    {
+    }
+
+    QString mimeType;
+    qint64 size;
+    qint64 lastUsed;
+};
+
+typedef QHash<QString, Entry> Entries;
+
+// Read-only view of an index file, which stays mapped for as long as it is open
+class IndexView
+{
+public:
+    IndexView()
+        : mMapped(0),
+          mData(0),
+          mCount(0),
+          mStrings(0),
+          mFileSize(-1)
+    {
+    }
+
+    ~IndexView()
+    {
+        close();
+    }
+
+    bool open(const QString &fileName);
+    void close();
+
+    // Whether the file changed since it was opened. Costs a stat().
+    bool isStale() const;
+
+    int count() const { return mCount; }
+    int find(const QByteArray &key) const;
+
+    QString key(int i) const { return string(i, 4, 12); }
+    QString mimeType(int i) const { return string(i, 8, 14); }
+    qint64 size(int i) const { return qFromLittleEndian<qint64>(record(i) + 16); }
+    qint64 lastUsed(int i) const { return qFromLittleEndian<qint64>(record(i) + 24); }
+    Entry entry(int i) const { return Entry(mimeType(i), size(i), lastUsed(i)); }
+
+    static bool write(QIODevice *device, const Entries &entries);
+
+private:
+    Q_DISABLE_COPY(IndexView)
+
+    bool validate(qint64 size);
+
+    const uchar *record(int i) const { return mData + HeaderSize + i * RecordSize; }
+    quint32 hash(int i) const { return qFromLittleEndian<quint32>(record(i)); }
+
+    QString string(int i, int offsetAt, int lengthAt) const
+    {
+        const uchar *r = record(i);
+        return QString::fromLatin1(
+                reinterpret_cast<const char *>(mStrings + qFromLittleEndian<quint32>(r + offsetAt)),
+                qFromLittleEndian<quint16>(r + lengthAt));
+    }
+
+    QFile mFile;
+    uchar *mMapped;
+    // Used instead of the mapping if the file can't be mapped
+    QByteArray mBuffer;
+    const uchar *mData;
+    int mCount;
+    const uchar *mStrings;
+
+    qint64 mFileSize;
+    QDateTime mModified;
+};
+
+bool IndexView::open(const QString &fileName)
+{
+    close();
+
+    mFile.setFileName(fileName);
+    QFileInfo info(fileName);
+    mFileSize = info.exists() ? info.size() : -1;
+    mModified = info.lastModified();
+
+    if (!mFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    if (mFileSize < HeaderSize || mFileSize > INT_MAX) {
+        warning() << "Ignoring corrupt avatar index" << fileName;
+        close();
+        return false;
+    }
+
+    mMapped = mFile.map(0, mFileSize);
+    if (mMapped) {
+        mData = mMapped;
+    } else {
+        mBuffer = mFile.readAll();
+        mData = reinterpret_cast<const uchar *>(mBuffer.constData());
+    }
+
+    if (!validate(mBuffer.isNull() ? mFileSize : mBuffer.size())) {
+        warning() << "Ignoring corrupt avatar index" << fileName;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void IndexView::close()
+{
+    if (mMapped) {
+        mFile.unmap(mMapped);
+        mMapped = 0;
+    }
+    mFile.close();
+    mBuffer.clear();
+    mData = 0;
+    mCount = 0;
+    mStrings = 0;
+}
+
+bool IndexView::isStale() const
+{
+    QFileInfo info(mFile.fileName());
+    if (!info.exists()) {
+        return mFileSize != -1;
+    }
+    return info.size() != mFileSize || info.lastModified() != mModified;
+}
+
+bool IndexView::validate(qint64 size)
+{
+    if (size < HeaderSize ||
+            qFromLittleEndian<quint32>(mData) != indexMagic ||
+            qFromLittleEndian<quint32>(mData + 4) != indexVersion) {
+        return false;
+    }
+
+    quint32 count = qFromLittleEndian<quint32>(mData + 8);
+    quint32 stringsSize = qFromLittleEndian<quint32>(mData + 12);
+    if (count > (size - HeaderSize) / RecordSize ||
+            HeaderSize + qint64(count) * RecordSize + stringsSize != size) {
+        return false;
+    }
+
+    mCount = count;
+    mStrings = mData + HeaderSize + qint64(count) * RecordSize;
+
+    // One pass over the records, so that lookups don't have to bounds check
+    for (int i = 0; i < mCount; ++i) {
+        const uchar *r = record(i);
+        if (qFromLittleEndian<quint32>(r + 4) + qint64(qFromLittleEndian<quint16>(r + 12)) >
+                    stringsSize ||
+                qFromLittleEndian<quint32>(r + 8) + qint64(qFromLittleEndian<quint16>(r + 14)) >
+                    stringsSize ||
+                (i > 0 && hash(i) < hash(i - 1))) {
+            mCount = 0;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int IndexView::find(const QByteArray &key) const
+{
+    quint32 wanted = keyHash(key);
+
+    int first = 0;
+    int last = mCount;
+    while (first < last) {
+        int middle = first + (last - first) / 2;
+        if (hash(middle) < wanted) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    for (int i = first; i < mCount && hash(i) == wanted; ++i) {
+        const uchar *r = record(i);
+        if (qFromLittleEndian<quint16>(r + 12) == key.size() &&
+                memcmp(mStrings + qFromLittleEndian<quint32>(r + 4), key.constData(),
+                    key.size()) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+bool IndexView::write(QIODevice *device, const Entries &entries)
+{
+    struct Record
+    {
+        bool operator<(const Record &other) const { return hash < other.hash; }
+
+        quint32 hash;
+        quint32 keyOffset;
+        quint32 mimeTypeOffset;
+        quint16 keyLength;
+        quint16 mimeTypeLength;
+        qint64 size;
+        qint64 lastUsed;
+    };
+
+    QVector<Record> records;
+    records.reserve(entries.size());
+    QByteArray strings;
+    for (Entries::const_iterator i = entries.constBegin(); i != entries.constEnd(); ++i) {
+        QByteArray key = i.key().toLatin1();
+        QByteArray mimeType = i->mimeType.toLatin1();
+        if (key.size() > MaxStringLength || mimeType.size() > MaxStringLength) {
+            continue;
+        }
+
+        Record record;
+        record.hash = keyHash(key);
+        record.keyOffset = strings.size();
+        record.keyLength = key.size();
+        strings += key;
+        record.mimeTypeOffset = strings.size();
+        record.mimeTypeLength = mimeType.size();
+        strings += mimeType;
+        record.size = i->size;
+        record.lastUsed = i->lastUsed;
+        records.append(record);
+    }
+    std::sort(records.begin(), records.end());
+
+    QDataStream out(device);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << indexMagic << indexVersion << quint32(records.size()) << quint32(strings.size());
+    foreach (const Record &record, records) {
+        out << record.hash << record.keyOffset << record.mimeTypeOffset <<
+            record.keyLength << record.mimeTypeLength << record.size << record.lastUsed;
+    }
+    out.writeRawData(strings.constData(), strings.size());
+
+    return out.status() == QDataStream::Ok;
+}
+
+}
+
+struct TP_QT_NO_EXPORT AvatarCache::Private
+{
+    Private(const QString &path);
+
+    void load();
+    void scan();
+    void recount();
+    void reloadIfStale();
+    void mergeIndex();
+    void evict(const QString &keep);
+
+    bool find(const QString &key, Entry *entry) const;
+    void touch(const QString &key, qint64 now);
+    void forget(const QString &key, qint64 size);
+
+    QString indexFileName() const;
+    QString fileNameForKey(const QString &key) const;
+
+    QString path;
+    bool loaded;
+    bool dirty;
+    bool pathCreated;
+
+    // The index as last loaded or written, which lookups are answered from, and what
+    // changed since then
+    IndexView index;
+    Entries changed;
+    QSet<QString> removed;
+    // Last used times of unchanged index entries. They only matter for eviction, so they
+    // don't make the index dirty, and are written along with the next real change.
+    QHash<QString, qint64> used;
+
+    int count;
+    qint64 diskUsage;
+    qint64 maxDiskSize;
+
+    // The avatars most recently read back from disk
+    QCache<QString, QByteArray> recent;
+};
+
+AvatarCache::Private::Private(const QString &path)
+    : path(path),
+      loaded(false),
+      dirty(false),
+      pathCreated(false),
+      count(0),
+      diskUsage(0),
+      maxDiskSize(AvatarCache::DefaultMaxDiskSize),
+      recent(AvatarCache::DefaultMaxMemoryCost)
+{
+}
+
+void AvatarCache::Private::load()
+{
+    if (loaded) {
+        return;
+    }
+
+    loaded = true;
+
+    if (index.open(indexFileName())) {
+        recount();
+        debug() << "Loaded avatar index with" << count << "entries from" << path;
+        return;
+    }
+
+    // No usable index yet, either because the cache is new or because it was
+    // populated by a version of the library which only kept per-token files
+    scan();
+}
+
+void AvatarCache::Private::scan()
+{
+    QDir dir(path);
+    if (!dir.exists()) {
+        return;
+    }
+
+    QHash<QString, QString> mimeTypes;
+    QFileInfoList files = dir.entryInfoList(QDir::Files);
+    foreach (const QFileInfo &info, files) {
+        QString name = info.fileName();
+        if (name.endsWith(QLatin1String(".mime"))) {
+            QFile mimeTypeFile(info.filePath());
+            if (mimeTypeFile.open(QIODevice::ReadOnly)) {
+                mimeTypes.insert(name.left(name.length() - 5),
+                        QString(QLatin1String(mimeTypeFile.readAll())));
+            }
+            continue;
+        }
+
+        changed.insert(name, Entry(QString(), info.size(),
+                    info.lastRead().toMSecsSinceEpoch() / 1000));
+    }
+
+    for (QHash<QString, QString>::const_iterator i = mimeTypes.constBegin();
+            i != mimeTypes.constEnd(); ++i) {
+        Entries::iterator entry = changed.find(i.key());
+        if (entry != changed.end()) {
+            entry->mimeType = i.value();
+        }
+    }
+
+    recount();
+
+    if (!changed.isEmpty()) {
+        debug() << "Migrated" << changed.size() << "avatar(s) from" << path << "to an index";
+        pathCreated = true;
+        dirty = true;
+    }
+}
+
+void AvatarCache::Private::recount()
+{
+    count = 0;
+    diskUsage = 0;
+
+    bool overridden = !changed.isEmpty() || !removed.isEmpty();
+    for (int i = 0; i < index.count(); ++i) {
+        if (overridden) {
+            QString key = index.key(i);
+            if (changed.contains(key) || removed.contains(key)) {
+                continue;
+            }
+        }
+        ++count;
+        diskUsage += index.size(i);
+    }
+
+    for (Entries::const_iterator i = changed.constBegin(); i != changed.constEnd(); ++i) {
+        ++count;
+        diskUsage += i->size;
+    }
+}
+
+void AvatarCache::Private::reloadIfStale()
+{
+    // Another process sharing the cache may have added avatars to the index since we
+    // loaded it. Our own changes since then are kept on top of it.
+    if (!index.isStale()) {
+        return;
+    }
+
+    index.open(indexFileName());
+    recount();
+}
+
+void AvatarCache::Private::mergeIndex()
+{
+    // Avatars missing from the index on disk were evicted by another process sharing the
+    // cache, unless we added them ourselves since we loaded ours
+    Entries merged;
+    IndexView onDisk;
+    if (onDisk.open(indexFileName())) {
+        merged.reserve(onDisk.count());
+        for (int i = 0; i < onDisk.count(); ++i) {
+            QString key = onDisk.key(i);
+            if (removed.contains(key)) {
+                continue;
+            }
+
+            Entry entry = onDisk.entry(i);
+            Entries::const_iterator ours = changed.constFind(key);
+            if (ours != changed.constEnd()) {
+                entry.lastUsed = qMax(entry.lastUsed, ours->lastUsed);
+                if (!ours->mimeType.isEmpty()) {
+                    entry.mimeType = ours->mimeType;
+                }
+            } else {
+                entry.lastUsed = qMax(entry.lastUsed, used.value(key));
+            }
+            merged.insert(key, entry);
+        }
+    }
+
+    for (Entries::const_iterator i = changed.constBegin(); i != changed.constEnd(); ++i) {
+        if (!merged.contains(i.key()) &&
+                (removed.contains(i.key()) || index.find(i.key().toLatin1()) < 0)) {
+            merged.insert(i.key(), *i);
+        }
+    }
+
+    index.close();
+    changed = merged;
+    removed.clear();
+    used.clear();
+    recount();
+}
+
+void AvatarCache::Private::evict(const QString &keep)
+{
+    if (maxDiskSize <= 0 || diskUsage <= maxDiskSize) {
+        return;
+    }
+
+    // Evict down to 90% of the budget, so that a cache sitting at its limit
+    // does not have to sort the whole index again on every insertion
+    qint64 target = maxDiskSize - maxDiskSize / 10;
+
+    QList<QPair<qint64, QString> > byAge;
+    byAge.reserve(count);
+    for (int i = 0; i < index.count(); ++i) {
+        QString key = index.key(i);
+        if (key != keep && !changed.contains(key) && !removed.contains(key)) {
+            byAge.append(qMakePair(used.value(key, index.lastUsed(i)), key));
+        }
+    }
+    for (Entries::const_iterator i = changed.constBegin(); i != changed.constEnd(); ++i) {
+        if (i.key() != keep) {
+            byAge.append(qMakePair(i->lastUsed, i.key()));
+        }
+    }
+    std::sort(byAge.begin(), byAge.end());
+
+    int evicted = 0;
+    for (int i = 0; i < byAge.size() && diskUsage > target; ++i) {
+        const QString &key = byAge[i].second;
+        Entry entry;
+        find(key, &entry);
+
+        QString fileName = fileNameForKey(key);
+        QFile::remove(fileName);
+        QFile::remove(fileName + QLatin1String(".mime"));
+
+        forget(key, entry.size);
+        ++evicted;
+    }
+
+    debug() << "Evicted" << evicted << "avatar(s) from" << path;
+}
+
+bool AvatarCache::Private::find(const QString &key, Entry *entry) const
+{
+    Entries::const_iterator i = changed.constFind(key);
+    if (i != changed.constEnd()) {
+        *entry = *i;
+        return true;
+    }
+
+    if (removed.contains(key)) {
+        return false;
+    }
+
+    int record = index.find(key.toLatin1());
+    if (record < 0) {
+        return false;
+    }
+
+    *entry = index.entry(record);
+    return true;
+}
+
+void AvatarCache::Private::touch(const QString &key, qint64 now)
+{
+    Entries::iterator i = changed.find(key);
+    if (i != changed.end()) {
+        i->lastUsed = now;
+    } else {
+        used.insert(key, now);
+    }
+}
+
+void AvatarCache::Private::forget(const QString &key, qint64 size)
+{
+    changed.remove(key);
+    used.remove(key);
+    if (index.find(key.toLatin1()) >= 0) {
+        removed.insert(key);
+    }
+    recent.remove(key);
+
+    --count;
+    diskUsage -= size;
+    dirty = true;
+}
+
+QString AvatarCache::Private::indexFileName() const
+{
+    return QString(QLatin1String("%1/%2")).arg(path).arg(QLatin1String(Tp::indexFileName));
+}
+
+QString AvatarCache::Private::fileNameForKey(const QString &key) const
+{
+    return QString(QLatin1String("%1/%2")).arg(path).arg(key);
+}
+
+/**
+ * \class AvatarCache
+ * \ingroup utils
+ * \headerfile TelepathyQt/avatar-cache.h <TelepathyQt/AvatarCache>
+ *
+ * \brief The AvatarCache class stores avatars on disk, indexed by token.
+ *
+ * All avatars in the cache directory are described by a single index file, sorted
+ * by token hash, which stays memory-mapped. Lookups binary search it in place, without
+ * touching the avatar files, and the on-disk store is kept below maxDiskSize() by
+ * evicting the least recently used avatars. Whether an avatar file is still there is
+ * only found out when it is read back with avatar().
+ *
+ * Several processes may share the same cache directory. Avatars they add are picked up
+ * once they wrote their index, and sync() merges their index changes with ours.
+ */
+
+AvatarCache::AvatarCache(const QString &path)
+    : mPriv(new Private(path))
+{
+}
+
+AvatarCache::~AvatarCache()
+{
+    sync();
+    delete mPriv;
+}
+
+QString AvatarCache::path() const
+{
+    return mPriv->path;
+}
+
+/**
+ * Look up the avatar with the given \a token.
+ *
+ * \param token The avatar token.
+ * \param avatarData Set to the cached avatar if it is found.
+ * \return \c true if the avatar is cached, \c false otherwise.
+ */
+bool AvatarCache::lookup(const QString &token, AvatarData &avatarData)
+{
+    mPriv->load();
+
+    QString key = escapeAsIdentifier(token);
+    Entry entry;
+    if (!mPriv->find(key, &entry)) {
+        mPriv->reloadIfStale();
+        if (!mPriv->find(key, &entry)) {
+            return false;
+        }
+    }
+
+    mPriv->touch(key, currentTime());
+    avatarData = AvatarData(mPriv->fileNameForKey(key), entry.mimeType);
+    return true;
+}
+
+/**
+ * Look up the avatars with the given \a tokens in one go.
+ *
+ * \param tokens The avatar tokens.
+ * \return A map from each token which is cached to its avatar.
+ */
+QHash<QString, AvatarData> AvatarCache::lookup(const QStringList &tokens)
+{
+    mPriv->load();
+
+    QHash<QString, AvatarData> ret;
+    QStringList missed;
+    qint64 now = currentTime();
+    Entry entry;
+    foreach (const QString &token, tokens) {
+        QString key = escapeAsIdentifier(token);
+        if (!mPriv->find(key, &entry)) {
+            missed << token;
+            continue;
+        }
+
+        mPriv->touch(key, now);
+        ret.insert(token, AvatarData(mPriv->fileNameForKey(key), entry.mimeType));
+    }
+
+    if (missed.isEmpty()) {
+        return ret;
+    }
+
+    // Checking whether another process updated the index costs one stat() for the batch
+    mPriv->reloadIfStale();
+    foreach (const QString &token, missed) {
+        QString key = escapeAsIdentifier(token);
+        if (mPriv->find(key, &entry)) {
+            mPriv->touch(key, now);
+            ret.insert(token, AvatarData(mPriv->fileNameForKey(key), entry.mimeType));
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Read back the avatar with the given \a token.
+ *
+ * The most recently read avatars are kept in memory, up to maxMemoryCost() bytes.
+ * An avatar whose file was removed from disk is dropped from the cache.
+ *
+ * \param token The avatar token.
+ * \return The avatar image data, or an empty QByteArray if it is not cached.
+ */
+QByteArray AvatarCache::avatar(const QString &token)
+{
+    mPriv->load();
+
+    QString key = escapeAsIdentifier(token);
+    Entry entry;
+    if (!mPriv->find(key, &entry)) {
+        mPriv->reloadIfStale();
+        if (!mPriv->find(key, &entry)) {
+            return QByteArray();
+        }
+    }
+
+    mPriv->touch(key, currentTime());
+
+    QByteArray *cached = mPriv->recent.object(key);
+    if (cached) {
+        return *cached;
+    }
+
+    QFile file(mPriv->fileNameForKey(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        // Another process sharing the cache may have evicted it
+        debug() << "Avatar" << file.fileName() << "is gone, dropping it from the cache";
+        mPriv->forget(key, entry.size);
+        return QByteArray();
+    }
+
+    QByteArray data = file.readAll();
+    // QCache takes ownership, and deletes the copy right away if it's over budget
+    mPriv->recent.insert(key, new QByteArray(data), data.size());
+    return data;
+}
+
+/**
+ * Store the avatar \a data with the given \a token and \a mimeType.
+ *
+ * If the cache grows past maxDiskSize(), the least recently used avatars
+ * are removed from it.
+ *
+ * \return The cached avatar, with an empty file name if it could not be written.
+ */
+AvatarData AvatarCache::insert(const QString &token, const QByteArray &data,
+        const QString &mimeType)
+{
+    mPriv->load();
+
+    QString key = escapeAsIdentifier(token);
+    QString fileName = mPriv->fileNameForKey(key);
+    qint64 now = currentTime();
+
+    Entry entry;
+    if (mPriv->find(key, &entry)) {
+        // We would have to write the avatar anyway if another process evicted it
+        if (QFile::exists(fileName)) {
+            // Tokens identify the image, so the data we have is already up to date
+            mPriv->touch(key, now);
+            if (entry.mimeType.isEmpty() && !mimeType.isEmpty()) {
+                entry.mimeType = mimeType;
+                entry.lastUsed = now;
+                writeFileAtomically(fileName + QLatin1String(".mime"), mimeType.toLatin1());
+                mPriv->changed.insert(key, entry);
+                mPriv->used.remove(key);
+                mPriv->dirty = true;
+            }
+            return AvatarData(fileName, entry.mimeType);
+        }
+
+        mPriv->forget(key, entry.size);
+    }
+
+    if (!mPriv->pathCreated) {
+        if (!QDir().mkpath(mPriv->path)) {
+            warning() << "Unable to create avatar cache directory" << mPriv->path;
+            return AvatarData(QString(), mimeType);
+        }
+        mPriv->pathCreated = true;
+    }
+
+    // The MIME type is also kept next to the avatar, for processes sharing the cache
+    // which look avatars up without the index. It is written first, so that it is
+    // there as soon as the avatar is.
+    if (!mimeType.isEmpty() &&
+            !writeFileAtomically(fileName + QLatin1String(".mime"), mimeType.toLatin1())) {
+        warning() << "Unable to write avatar MIME type to" << fileName + QLatin1String(".mime");
+    }
+
+    if (!writeFileAtomically(fileName, data)) {
+        warning() << "Unable to write avatar to" << fileName;
+        return AvatarData(QString(), mimeType);
+    }
+
+    mPriv->changed.insert(key, Entry(mimeType, data.size(), now));
+    ++mPriv->count;
+    mPriv->diskUsage += data.size();
+    mPriv->recent.remove(key);
+    mPriv->dirty = true;
+
+    mPriv->evict(key);
+
+    return AvatarData(fileName, mimeType);
+}
+
+/**
+ * Return the number of avatars in the cache.
+ */
+int AvatarCache::count() const
+{
+    mPriv->load();
+    return mPriv->count;
+}
+
+/**
+ * Return the total size in bytes of the avatars in the cache.
+ */
+qint64 AvatarCache::diskUsage() const
+{
+    mPriv->load();
+    return mPriv->diskUsage;
+}
+
+/**
+ * Return the maximum total size in bytes of the avatars kept on disk.
+ *
+ * A value of 0 means that the cache is never trimmed.
+ */
+qint64 AvatarCache::maxDiskSize() const
+{
+    return mPriv->maxDiskSize;
+}
+
+void AvatarCache::setMaxDiskSize(qint64 maxDiskSize)
+{
+    mPriv->maxDiskSize = maxDiskSize;
+    if (mPriv->loaded) {
+        mPriv->evict(QString());
+    }
+}
+
+/**
+ * Return the budget in bytes of the avatars read back by avatar() which are kept in memory.
+ */
+int AvatarCache::maxMemoryCost() const
+{
+    return mPriv->recent.maxCost();
+}
+
+void AvatarCache::setMaxMemoryCost(int maxMemoryCost)
+{
+    mPriv->recent.setMaxCost(maxMemoryCost);
+}
+
+/**
+ * Return whether avatars were added to or removed from the cache since the index was
+ * last loaded or written by sync().
+ *
+ * Looking avatars up doesn't make the index dirty. The times they were last used are
+ * written along with the next change.
+ */
+bool AvatarCache::isDirty() const
+{
+    return mPriv->dirty;
+}
+
+/**
+ * Write the index to disk, if it changed since it was last loaded or written.
+ *
+ * Changes other processes made to the index in the meantime are merged in first.
+ *
+ * \return \c true if the index on disk is up to date, \c false otherwise.
+ */
+bool AvatarCache::sync()
+{
+    if (!mPriv->dirty) {
+        return true;
+    }
+
+    if (!mPriv->pathCreated) {
+        if (!QDir().mkpath(mPriv->path)) {
+            return false;
+        }
+        mPriv->pathCreated = true;
+    }
+
+    QLockFile lock(QString(QLatin1String("%1/%2")).arg(mPriv->path).arg(
+                QLatin1String(indexLockFileName)));
+    if (!lock.tryLock(indexLockTimeout)) {
+        warning() << "Unable to lock avatar index in" << mPriv->path;
+        return false;
+    }
+
+    // Leaves everything in changed, with no index underneath, until the new one is written
+    mPriv->mergeIndex();
+    mPriv->evict(QString());
+
+    QSaveFile file(mPriv->indexFileName());
+    if (!file.open(QIODevice::WriteOnly) || !IndexView::write(&file, mPriv->changed) ||
+            !file.commit()) {
+        warning() << "Unable to write avatar index" << file.fileName();
+        return false;
+    }
+
+    mPriv->changed.clear();
+    mPriv->index.open(mPriv->indexFileName());
+    mPriv->recount();
+    mPriv->dirty = false;
+    return true;
+}
+
+} // Tp
@@ -62,7 +62,8 @@ BaseCallContent::Adaptee::Adaptee(const QDBusConnection &dbusConnection,
     : QObject(content),
       mContent(content)
 {
-    debug() << "Creating service::CallContentAdaptor for " << content->dbusObject();
+    tpDebug(DebugCategoryService) << "Creating service::CallContentAdaptor for " <<
+        content->dbusObject();
     mAdaptor = new Service::CallContentAdaptor(dbusConnection, this, content->dbusObject());
 }
 
@@ -176,10 +177,11 @@ bool BaseCallContent::registerObject(DBusError *error)
     QString busName = mPriv->channel->busName();
     QString objectPath = QString(QLatin1String("%1/%2"))
                          .arg(mPriv->channel->objectPath(), name);
-    debug() << "Registering Content: busName: " << busName << " objectName: " << objectPath;
+    tpDebug(DebugCategoryService) << "Registering Content: busName: " << busName <<
+        " objectName: " << objectPath;
     DBusError _error;
 
-    debug() << "CallContent: registering interfaces  at " << dbusObject();
+    tpDebug(DebugCategoryService) << "CallContent: registering interfaces  at " << dbusObject();
     foreach(const AbstractCallContentInterfacePtr & iface, mPriv->interfaces) {
         if (!iface->registerInterface(dbusObject())) {
             // lets not fail if an optional interface fails registering, lets warn only
@@ -228,7 +230,7 @@ bool BaseCallContent::plugInterface(const AbstractCallContentInterfacePtr &inter
         return false;
     }
 
-    debug() << "Interface" << interface->interfaceName() << "plugged";
+    tpDebug(DebugCategoryService) << "Interface" << interface->interfaceName() << "plugged";
     mPriv->interfaces.insert(interface->interfaceName(), interface);
     return true;
 }
@@ -391,6 +391,7 @@ private Q_SLOTS:
             const Tp::Service::ChannelInterfaceGroupAdaptor::RemoveMembersContextPtr &context);
     void removeMembersWithReason(const Tp::UIntList &contacts, const QString &message, uint reason,
             const Tp::Service::ChannelInterfaceGroupAdaptor::RemoveMembersWithReasonContextPtr &context);
+    void flushMembersChange();
 
 Q_SIGNALS:
     void handleOwnersChanged(const Tp::HandleOwnerMap &added, const Tp::UIntList &removed);
@@ -40,11 +40,20 @@
 #include <TelepathyQt/AbstractProtocolInterface>
 
 #include <QDateTime>
+#include <QFile>
+#include <QPointer>
+#include <QSet>
 #include <QString>
 #include <QTcpServer>
 #include <QTcpSocket>
+#include <QTimer>
 #include <QVariantMap>
 
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <sys/sendfile.h>
+#endif
+
 namespace Tp
 {
 
@@ -94,7 +103,8 @@ BaseChannel::Adaptee::Adaptee(const QDBusConnection &dbusConnection,
     : QObject(channel),
       mChannel(channel)
 {
-    debug() << "Creating service::channelAdaptor for " << channel->dbusObject();
+    tpDebug(DebugCategoryService) << "Creating service::channelAdaptor for " <<
+        channel->dbusObject();
     mAdaptor = new Service::ChannelAdaptor(dbusConnection, this, channel->dbusObject());
 }
 
@@ -173,10 +183,11 @@ bool BaseChannel::registerObject(DBusError *error)
     //        .arg(mPriv->connection->busName(),name);
     QString objectPath = QString(QLatin1String("%1/%2"))
                          .arg(mPriv->connection->objectPath(), name);
-    debug() << "Registering channel: busName: " << busName << " objectName: " << objectPath;
+    tpDebug(DebugCategoryService) << "Registering channel: busName: " << busName <<
+        " objectName: " << objectPath;
     DBusError _error;
 
-    debug() << "Channel: registering interfaces  at " << dbusObject();
+    tpDebug(DebugCategoryService) << "Channel: registering interfaces  at " << dbusObject();
     foreach(const AbstractChannelInterfacePtr & iface, mPriv->interfaces) {
         if (!iface->registerInterface(dbusObject())) {
             // lets not fail if an optional interface fails registering, lets warn only
@@ -353,7 +364,7 @@ bool BaseChannel::plugInterface(const AbstractChannelInterfacePtr &interface)
         return false;
     }
 
-    debug() << "Interface" << interface->interfaceName() << "plugged";
+    tpDebug(DebugCategoryService) << "Interface" << interface->interfaceName() << "plugged";
     mPriv->interfaces.insert(interface->interfaceName(), interface);
     interface->setBaseChannel(this);
     return true;
@@ -399,7 +410,8 @@ BaseChannelTextType::Adaptee::~Adaptee()
 void BaseChannelTextType::Adaptee::acknowledgePendingMessages(const Tp::UIntList &IDs,
         const Tp::Service::ChannelTypeTextAdaptor::AcknowledgePendingMessagesContextPtr &context)
 {
-    debug() << "BaseConnectionContactsInterface::acknowledgePendingMessages " << IDs;
+    tpDebug(DebugCategoryService) <<
+        "BaseConnectionContactsInterface::acknowledgePendingMessages " << IDs;
     DBusError error;
     mInterface->acknowledgePendingMessages(IDs, &error);
     if (error.isValid()) {
@@ -413,18 +425,43 @@ struct TP_QT_NO_EXPORT BaseChannelTextType::Private {
     Private(BaseChannelTextType *parent, BaseChannel* channel)
         : channel(channel),
           pendingMessagesId(0),
+          maxPendingMessages(0),
           adaptee(new BaseChannelTextType::Adaptee(parent)) {
     }
 
+    void removePendingMessage(QMap<uint, Tp::MessagePartList>::iterator i);
+
     BaseChannel* channel;
     /* maps pending-message-id to message part list */
     QMap<uint, Tp::MessagePartList> pendingMessages;
+    /* maps message-token to the pending-message-ids of the messages which have it, oldest
+     * first; tokens are only meant to be unique, so a sender may reuse one */
+    QHash<QString, QList<uint> > pendingMessageTokens;
     /* increasing unique id of pending messages */
     uint pendingMessagesId;
+    /* 0 means that the queue is unbounded */
+    uint maxPendingMessages;
     MessageAcknowledgedCallback messageAcknowledgedCB;
     BaseChannelTextType::Adaptee *adaptee;
 };
 
+void BaseChannelTextType::Private::removePendingMessage(QMap<uint, Tp::MessagePartList>::iterator i)
+{
+    const MessagePart &header = i->front();
+    MessagePart::const_iterator token = header.constFind(QLatin1String("message-token"));
+    if (token != header.constEnd()) {
+        QHash<QString, QList<uint> >::iterator t = pendingMessageTokens.find(token->variant().toString());
+        if (t != pendingMessageTokens.end()) {
+            t->removeOne(i.key());
+            if (t->isEmpty()) {
+                pendingMessageTokens.erase(t);
+            }
+        }
+    }
+
+    pendingMessages.erase(i);
+}
+
 /**
  * \class BaseChannelTextType
  * \ingroup servicechannel
@@ -474,6 +511,11 @@ void BaseChannelTextType::addReceivedMessage(const Tp::MessagePartList &msg)
     header[QLatin1String("pending-message-id")] = QDBusVariant(pendingMessageId);
     mPriv->pendingMessages[pendingMessageId] = message;
 
+    if (header.count(QLatin1String("message-token"))) {
+        mPriv->pendingMessageTokens[header[QLatin1String("message-token")].variant().toString()]
+            .append(pendingMessageId);
+    }
+
     uint timestamp = 0;
     if (header.count(QLatin1String("message-received")))
         timestamp = header[QLatin1String("message-received")].variant().toUInt();
@@ -514,6 +556,18 @@ void BaseChannelTextType::addReceivedMessage(const Tp::MessagePartList &msg)
         QMetaObject::invokeMethod(messagesIface.data(), "messageReceived",
                                   Qt::QueuedConnection,
                                   Q_ARG(Tp::MessagePartList, message));
+
+    /* Drop the oldest messages if the queue is bounded */
+    if (mPriv->maxPendingMessages && uint(mPriv->pendingMessages.size()) > mPriv->maxPendingMessages) {
+        Tp::UIntList spilled;
+        QMap<uint, Tp::MessagePartList>::const_iterator i = mPriv->pendingMessages.constBegin();
+        for (int count = mPriv->pendingMessages.size() - mPriv->maxPendingMessages; count > 0; --count, ++i) {
+            spilled.append(i.key());
+        }
+        tpDebug(DebugCategoryService) << "Pending message queue is full, dropping" <<
+            spilled.count() << "message(s)";
+        removePendingMessages(spilled);
+    }
 }
 
 Tp::MessagePartListList BaseChannelTextType::pendingMessages() const
@@ -521,6 +575,30 @@ Tp::MessagePartListList BaseChannelTextType::pendingMessages() const
     return mPriv->pendingMessages.values();
 }
 
+/**
+ * Return the maximum number of messages kept in the pending messages queue.
+ *
+ * \return The maximum queue length, or 0 if the queue is unbounded.
+ * \sa setMaxPendingMessages()
+ */
+uint BaseChannelTextType::maxPendingMessages() const
+{
+    return mPriv->maxPendingMessages;
+}
+
+/**
+ * Set the maximum number of messages kept in the pending messages queue.
+ *
+ * Once the queue is full, addReceivedMessage() drops the oldest pending messages, which are
+ * signalled as removed. By default the queue is unbounded.
+ *
+ * \param count The maximum queue length, or 0 to keep all the messages until they are acknowledged.
+ */
+void BaseChannelTextType::setMaxPendingMessages(uint count)
+{
+    mPriv->maxPendingMessages = count;
+}
+
 /*
  * Will be called with the value of the message-token field after a received message has been acknowledged,
  * if the message-token field existed in the header.
@@ -533,20 +611,22 @@ void BaseChannelTextType::setMessageAcknowledgedCallback(const MessageAcknowledg
 void BaseChannelTextType::acknowledgePendingMessages(const QStringList &tokens, DBusError *error)
 {
     Tp::UIntList IDs;
+    IDs.reserve(tokens.count());
+    QSet<QString> seenTokens;
 
     Q_FOREACH (const QString &token, tokens) {
-        Q_FOREACH (const Tp::MessagePartList &message, mPriv->pendingMessages) {
-            const MessagePart &header = message.front();
-            if (header.value(QLatin1String("message-token")).variant().toString() == token) {
-                uint id = mPriv->pendingMessages.key(message);
-                IDs.append(id);
-            }
+        if (seenTokens.contains(token)) {
+            continue;
         }
-    }
+        seenTokens.insert(token);
 
-    if (tokens.count() != IDs.count()) {
-        error->set(TP_QT_ERROR_INVALID_ARGUMENT, QLatin1String("Token not found"));
-        return;
+        QHash<QString, QList<uint> >::const_iterator i = mPriv->pendingMessageTokens.constFind(token);
+        if (i == mPriv->pendingMessageTokens.constEnd()) {
+            error->set(TP_QT_ERROR_INVALID_ARGUMENT, QLatin1String("Token not found"));
+            return;
+        }
+        // Every pending message with the token is acknowledged
+        IDs.append(i.value());
     }
 
     removePendingMessages(IDs);
@@ -554,26 +634,37 @@ void BaseChannelTextType::acknowledgePendingMessages(const QStringList &tokens,
 
 void BaseChannelTextType::acknowledgePendingMessages(const Tp::UIntList &IDs, DBusError* error)
 {
+    /* Nothing is acknowledged if any of the IDs is unknown */
     Q_FOREACH (uint id, IDs) {
-        QMap<uint, Tp::MessagePartList>::Iterator i = mPriv->pendingMessages.find(id);
-        if (i == mPriv->pendingMessages.end()) {
+        if (!mPriv->pendingMessages.contains(id)) {
             error->set(TP_QT_ERROR_INVALID_ARGUMENT, QLatin1String("id not found"));
             return;
         }
+    }
 
-        const MessagePart &header = i->front();
-        if (header.count(QLatin1String("message-token")) && mPriv->messageAcknowledgedCB.isValid()) {
-            mPriv->messageAcknowledgedCB(header[QLatin1String("message-token")].variant().toString());
+    if (mPriv->messageAcknowledgedCB.isValid()) {
+        Q_FOREACH (uint id, IDs) {
+            const MessagePart &header = mPriv->pendingMessages[id].front();
+            if (header.count(QLatin1String("message-token"))) {
+                mPriv->messageAcknowledgedCB(header[QLatin1String("message-token")].variant().toString());
+            }
         }
     }
 
     removePendingMessages(IDs);
 }
 
+/*
+ * Remove the given messages from the pending messages queue, signalling all of them
+ * in a single PendingMessagesRemoved.
+ */
 void BaseChannelTextType::removePendingMessages(const UIntList &IDs)
 {
     foreach (uint id, IDs) {
-        mPriv->pendingMessages.remove(id);
+        QMap<uint, Tp::MessagePartList>::iterator i = mPriv->pendingMessages.find(id);
+        if (i != mPriv->pendingMessages.end()) {
+            mPriv->removePendingMessage(i);
+        }
     }
 
     /* Signal on ChannelMessagesInterface */
@@ -607,13 +698,7 @@ BaseChannelMessagesInterface::Adaptee::~Adaptee()
 void BaseChannelMessagesInterface::Adaptee::sendMessage(const Tp::MessagePartList &message, uint flags,
         const Tp::Service::ChannelInterfaceMessagesAdaptor::SendMessageContextPtr &context)
 {
-    DBusError error;
-    QString token = mInterface->sendMessage(message, flags, &error);
-    if (error.isValid()) {
-        context->setFinishedWithError(error.name(), error.message());
-        return;
-    }
-    context->setFinished(token);
+    mInterface->sendMessage(message, flags, DeferredReply<QString>::forContext(context));
 }
 
 struct TP_QT_NO_EXPORT BaseChannelMessagesInterface::Private {
@@ -631,15 +716,107 @@ struct TP_QT_NO_EXPORT BaseChannelMessagesInterface::Private {
           adaptee(new BaseChannelMessagesInterface::Adaptee(parent)) {
     }
 
+    class SendMessageReply;
+
+    void announceSentMessage(const Tp::MessagePartList &message, uint flags, const QString &token);
+
     BaseChannelTextType* textTypeInterface;
     QStringList supportedContentTypes;
     Tp::UIntList messageTypes;
     uint messagePartSupportFlags;
     uint deliveryReportingSupport;
     SendMessageCallback sendMessageCB;
+    SendMessageAsyncCallback sendMessageAsyncCB;
     BaseChannelMessagesInterface::Adaptee *adaptee;
 };
 
+// Announces the message given to a SendMessageAsyncCallback once its token is known
+class TP_QT_NO_EXPORT BaseChannelMessagesInterface::Private::SendMessageReply
+    : public DeferredReply<QString>::Handler
+{
+public:
+    SendMessageReply(BaseChannelMessagesInterface::Private *priv,
+            const Tp::MessagePartList &message, uint flags, const DeferredReply<QString> &reply)
+        : mPriv(priv),
+          mAdaptee(priv->adaptee),
+          mMessage(message),
+          mFlags(flags),
+          mReply(reply)
+    {
+    }
+
+protected:
+    void onFinished(const QString &token)
+    {
+        // The adaptee goes away with the interface, and with it the private data
+        if (mAdaptee) {
+            mPriv->announceSentMessage(mMessage, mFlags, token);
+        }
+        mReply.setFinished(token);
+    }
+
+    void onFailed(const QString &errorName, const QString &errorMessage)
+    {
+        mReply.setFinishedWithError(errorName, errorMessage);
+    }
+
+private:
+    BaseChannelMessagesInterface::Private *mPriv;
+    QPointer<QObject> mAdaptee;
+    Tp::MessagePartList mMessage;
+    uint mFlags;
+    DeferredReply<QString> mReply;
+};
+
+void BaseChannelMessagesInterface::Private::announceSentMessage(const Tp::MessagePartList &message,
+        uint flags, const QString &token)
+{
+    Tp::MessagePartList fixedMessage = message;
+
+    MessagePart header = fixedMessage.front();
+
+    uint timestamp = 0;
+    if (header.contains(QLatin1String("message-sent"))) {
+        timestamp = header[QLatin1String("message-sent")].variant().toUInt();
+    } else {
+        timestamp = QDateTime::currentMSecsSinceEpoch() / 1000;
+        header[QLatin1String("message-sent")] = QDBusVariant(timestamp);
+    }
+
+    fixedMessage.replace(0, header);
+
+    //emit after return
+    QMetaObject::invokeMethod(adaptee, "messageSent",
+                              Qt::QueuedConnection,
+                              Q_ARG(Tp::MessagePartList, fixedMessage),
+                              Q_ARG(uint, flags),
+                              Q_ARG(QString, token));
+
+    if (message.empty()) {
+        warning() << "Sending empty message";
+        return;
+    }
+
+    uint type = ChannelTextMessageTypeNormal;
+    if (header.count(QLatin1String("message-type")))
+        type = header[QLatin1String("message-type")].variant().toUInt();
+
+    QString content;
+    for (MessagePartList::const_iterator i = message.begin() + 1; i != message.end(); ++i)
+        if (i->count(QLatin1String("content-type"))
+                && i->value(QLatin1String("content-type")).variant().toString() == QLatin1String("text/plain")
+                && i->count(QLatin1String("content"))) {
+            content = i->value(QLatin1String("content")).variant().toString();
+            break;
+        }
+    //emit after return
+    QMetaObject::invokeMethod(textTypeInterface, "sent",
+                              Qt::QueuedConnection,
+                              Q_ARG(uint, timestamp),
+                              Q_ARG(uint, type),
+                              Q_ARG(QString, content));
+}
+
 /**
  * \class BaseChannelMessagesInterface
  * \ingroup servicechannel
@@ -752,52 +929,54 @@ QString BaseChannelMessagesInterface::sendMessage(const Tp::MessagePartList &mes
         return QString();
     }
     const QString token = mPriv->sendMessageCB(message, flags, error);
+    mPriv->announceSentMessage(message, flags, token);
+    return token;
+}
 
-    Tp::MessagePartList fixedMessage = message;
-
-    MessagePart header = fixedMessage.front();
-
-    uint timestamp = 0;
-    if (header.contains(QLatin1String("message-sent"))) {
-        timestamp = header[QLatin1String("message-sent")].variant().toUInt();
-    } else {
-        timestamp = QDateTime::currentMSecsSinceEpoch() / 1000;
-        header[QLatin1String("message-sent")] = QDBusVariant(timestamp);
-    }
-
-    fixedMessage.replace(0, header);
-
-    //emit after return
-    QMetaObject::invokeMethod(mPriv->adaptee, "messageSent",
-                              Qt::QueuedConnection,
-                              Q_ARG(Tp::MessagePartList, fixedMessage),
-                              Q_ARG(uint, flags),
-                              Q_ARG(QString, token));
+/**
+ * Set the callback used to send messages asynchronously.
+ *
+ * The callback receives the message, the flags and a DeferredReply which it finishes with
+ * the message token, or with an error, once the message has been handed to the server.
+ *
+ * If set, this callback is used for the SendMessage D-Bus method instead of the synchronous
+ * one. The MessageSent and Sent signals are emitted when the reply is finished with a token.
+ *
+ * \param cb The callback.
+ */
+void BaseChannelMessagesInterface::setSendMessageAsyncCallback(const SendMessageAsyncCallback &cb)
+{
+    mPriv->sendMessageAsyncCB = cb;
+}
 
-    if (message.empty()) {
-        warning() << "Sending empty message";
-        return token;
+/**
+ * Send the given \a message and finish \a reply with its token.
+ *
+ * The callback set with setSendMessageAsyncCallback() is used if there is one, otherwise the
+ * message is sent with the synchronous callback and \a reply is finished before this method
+ * returns.
+ *
+ * \param message The message to send.
+ * \param flags The flags of the message.
+ * \param reply The reply to finish with the message token or an error.
+ */
+void BaseChannelMessagesInterface::sendMessage(const Tp::MessagePartList &message, uint flags,
+        const DeferredReply<QString> &reply)
+{
+    if (!mPriv->sendMessageAsyncCB.isValid()) {
+        DBusError error;
+        QString token = sendMessage(message, flags, &error);
+        if (error.isValid()) {
+            reply.setFinishedWithError(error);
+            return;
+        }
+        reply.setFinished(token);
+        return;
     }
 
-    uint type = ChannelTextMessageTypeNormal;
-    if (header.count(QLatin1String("message-type")))
-        type = header[QLatin1String("message-type")].variant().toUInt();
-
-    QString content;
-    for (MessagePartList::const_iterator i = message.begin() + 1; i != message.end(); ++i)
-        if (i->count(QLatin1String("content-type"))
-                && i->value(QLatin1String("content-type")).variant().toString() == QLatin1String("text/plain")
-                && i->count(QLatin1String("content"))) {
-            content = i->value(QLatin1String("content")).variant().toString();
-            break;
-        }
-    //emit after return
-    QMetaObject::invokeMethod(mPriv->textTypeInterface, "sent",
-                              Qt::QueuedConnection,
-                              Q_ARG(uint, timestamp),
-                              Q_ARG(uint, type),
-                              Q_ARG(QString, content));
-    return token;
+    mPriv->sendMessageAsyncCB(message, flags, DeferredReply<QString>(
+                SharedPtr<DeferredReply<QString>::Handler>(
+                    new Private::SendMessageReply(mPriv, message, flags, reply))));
 }
 
 // Chan.T.FileTransfer
@@ -814,8 +993,15 @@ struct TP_QT_NO_EXPORT BaseChannelFileTransferType::Private {
           weOpenedDevice(false),
           serverSocket(0),
           clientSocket(0),
+          zeroCopy(true),
+          reportedTransferredBytes(0),
+          transferredBytesTimer(new QTimer(parent)),
           adaptee(new BaseChannelFileTransferType::Adaptee(parent))
     {
+        // Big transfers move data much faster than clients care to be told about it
+        transferredBytesTimer->setSingleShot(true);
+        transferredBytesTimer->setInterval(100);
+
         contentType = request.value(TP_QT_IFACE_CHANNEL_TYPE_FILE_TRANSFER + QLatin1String(".ContentType")).toString();
         filename = request.value(TP_QT_IFACE_CHANNEL_TYPE_FILE_TRANSFER + QLatin1String(".Filename")).toString();
         size = request.value(TP_QT_IFACE_CHANNEL_TYPE_FILE_TRANSFER + QLatin1String(".Size")).toULongLong();
@@ -859,13 +1045,95 @@ struct TP_QT_NO_EXPORT BaseChannelFileTransferType::Private {
     bool weOpenedDevice;
     QTcpServer *serverSocket; // Server socket is an implementation detail.
     QIODevice *clientSocket; // A socket to communicate with a Telepathy client
+    QByteArray buffer; // Reused by every doTransfer() which can't use sendFile()
+    QByteArray pendingOutput; // Data the output did not accept yet, written before anything else
+    bool zeroCopy;
+    qulonglong reportedTransferredBytes;
+    QTimer *transferredBytesTimer;
     BaseChannelFileTransferType::Direction direction;
     BaseChannelFileTransferType::Adaptee *adaptee;
 
+    qint64 sendFile(QIODevice *input, QIODevice *output, qint64 maxSize, bool *wouldBlock);
+    void reportTransferredBytes();
+
     friend class BaseChannelFileTransferType::Adaptee;
 
 };
 
+/*
+ * Copy up to maxSize bytes from input to output in the kernel, without going through userspace buffers.
+ *
+ * This is only possible if input is a QFile and output is a socket with nothing queued in its Qt buffer.
+ * Returns the number of bytes sent, or -1 if the devices can't be used for this, in which case the
+ * caller has to copy the data itself. wouldBlock is set if the socket send buffer is full.
+ */
+qint64 BaseChannelFileTransferType::Private::sendFile(QIODevice *input, QIODevice *output,
+        qint64 maxSize, bool *wouldBlock)
+{
+    *wouldBlock = false;
+
+#ifdef Q_OS_LINUX
+    if (!zeroCopy) {
+        return -1;
+    }
+
+    QFile *file = qobject_cast<QFile *>(input);
+    QAbstractSocket *socket = qobject_cast<QAbstractSocket *>(output);
+    if (!file || !socket || file->handle() < 0 || socket->socketDescriptor() < 0) {
+        zeroCopy = false;
+        return -1;
+    }
+
+    // Whatever is still queued in the socket buffer has to go first to keep the stream in order
+    if (socket->bytesToWrite() > 0) {
+        return -1;
+    }
+
+    off_t offset = file->pos();
+    qint64 sent = 0;
+    while (sent < maxSize) {
+        ssize_t result = ::sendfile(socket->socketDescriptor(), file->handle(), &offset,
+                maxSize - sent);
+        if (result > 0) {
+            sent += result;
+        } else if (result == 0) {
+            // End of file
+            break;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            *wouldBlock = true;
+            break;
+        } else {
+            if (sent == 0) {
+                // Most likely a file system which does not support sendfile()
+                tpDebug(DebugCategoryService) <<
+                    "BaseChannelFileTransferType: sendfile() failed, errno" << errno
+                        << "- falling back to buffered copies";
+                zeroCopy = false;
+                return -1;
+            }
+            break;
+        }
+    }
+
+    // sendfile() doesn't move the file position, and QFile may have read ahead
+    file->seek(offset);
+    return sent;
+#else
+    Q_UNUSED(input);
+    Q_UNUSED(output);
+    Q_UNUSED(maxSize);
+    return -1;
+#endif
+}
+
+void BaseChannelFileTransferType::Private::reportTransferredBytes()
+{
+    reportedTransferredBytes = transferredBytes;
+    QMetaObject::invokeMethod(adaptee, "transferredBytesChanged", Q_ARG(qulonglong, transferredBytes)); //Can simply use emit in Qt5
+}
+
 BaseChannelFileTransferType::Adaptee::Adaptee(BaseChannelFileTransferType *interface)
     : QObject(interface),
       mInterface(interface)
@@ -953,7 +1221,7 @@ void BaseChannelFileTransferType::Adaptee::setUri(const QString &uri)
 void BaseChannelFileTransferType::Adaptee::acceptFile(uint addressType, uint accessControl, const QDBusVariant &accessControlParam, qulonglong offset,
         const Tp::Service::ChannelTypeFileTransferAdaptor::AcceptFileContextPtr &context)
 {
-    debug() << "BaseChannelFileTransferType::Adaptee::acceptFile";
+    tpDebug(DebugCategoryService) << "BaseChannelFileTransferType::Adaptee::acceptFile";
 
     if (mInterface->mPriv->device) {
         context->setFinishedWithError(TP_QT_ERROR_NOT_AVAILABLE, QLatin1String("File transfer can only be started once in the same channel"));
@@ -981,7 +1249,7 @@ void BaseChannelFileTransferType::Adaptee::acceptFile(uint addressType, uint acc
 void BaseChannelFileTransferType::Adaptee::provideFile(uint addressType, uint accessControl, const QDBusVariant &accessControlParam,
         const Tp::Service::ChannelTypeFileTransferAdaptor::ProvideFileContextPtr &context)
 {
-    debug() << "BaseChannelFileTransferType::Adaptee::provideFile";
+    tpDebug(DebugCategoryService) << "BaseChannelFileTransferType::Adaptee::provideFile";
 
     DBusError error;
     mInterface->createSocket(addressType, accessControl, accessControlParam, &error);
@@ -1063,6 +1331,14 @@ void BaseChannelFileTransferType::Adaptee::provideFile(uint addressType, uint ac
  * -# If transferredBytes == size, then the channel state changes to Completed.
  *    Otherwise the interface waits for further data from the client socket.
  *
+ * Data path:
+ * + On Linux, if the device of an incoming transfer is a QFile and the client socket is a QAbstractSocket,
+ *   the file is sent with sendfile() and never copied to userspace.
+ * + Otherwise, the data is copied through a buffer. Reading stops while the output device has too much data
+ *   queued, and resumes on its bytesWritten() signal.
+ * + Seekable devices skip to the initial offset instead of reading and discarding the data before it.
+ * + The TransferredBytesChanged D-Bus signal is rate-limited; transferredBytes() is always up to date.
+ *
  * Subclassing:
  * + Reimplement a public virtual method availableSocketTypes() to expose extra socket types.
  * + Overload protected createSocket() method to provide own socket address type, access control and its param
@@ -1079,6 +1355,7 @@ BaseChannelFileTransferType::BaseChannelFileTransferType(const QVariantMap &requ
     : AbstractChannelInterface(TP_QT_IFACE_CHANNEL_TYPE_FILE_TRANSFER),
       mPriv(new Private(this, request))
 {
+    connect(mPriv->transferredBytesTimer, SIGNAL(timeout()), this, SLOT(onTransferredBytesTimeout()));
 }
 
 bool BaseChannelFileTransferType::createSocket(uint addressType, uint accessControl, const QDBusVariant &accessControlParam, Tp::DBusError *error)
@@ -1155,12 +1432,29 @@ void BaseChannelFileTransferType::setTransferredBytes(qulonglong count)
     }
 
     mPriv->transferredBytes = count;
-    QMetaObject::invokeMethod(mPriv->adaptee, "transferredBytesChanged", Q_ARG(qulonglong, count)); //Can simply use emit in Qt5
 
     if (transferredBytes() == size()) {
+        mPriv->transferredBytesTimer->stop();
+        mPriv->reportTransferredBytes();
+
         mPriv->clientSocket->close();
         mPriv->serverSocket->close();
         setState(Tp::FileTransferStateCompleted, Tp::FileTransferStateChangeReasonNone);
+        return;
+    }
+
+    // Rate-limit TransferredBytesChanged, the timer reports the latest count once it expires
+    if (!mPriv->transferredBytesTimer->isActive()) {
+        mPriv->reportTransferredBytes();
+        mPriv->transferredBytesTimer->start();
+    }
+}
+
+void BaseChannelFileTransferType::onTransferredBytesTimeout()
+{
+    if (mPriv->reportedTransferredBytes != mPriv->transferredBytes) {
+        mPriv->reportTransferredBytes();
+        mPriv->transferredBytesTimer->start();
     }
 }
 
@@ -1218,13 +1512,77 @@ void BaseChannelFileTransferType::doTransfer()
         break;
     }
 
-    static const int c_blockSize = 16 * 1024;
-    char buffer[c_blockSize];
-    char *inputPointer = buffer;
+    // Limits of the data moved per event loop iteration, and of the data queued in the output device
+    static const qint64 c_bufferSize = 256 * 1024;
+    static const qint64 c_maxBytesPerIteration = 4 * c_bufferSize;
+    static const qint64 c_highWaterMark = 4 * c_bufferSize;
+    static const qint64 c_wakeUpBlockSize = 16 * 1024;
 
-    qint64 length = input->read(buffer, sizeof(buffer));
+    // Let the output drain first, its bytesWritten() signal resumes the transfer
+    if (output->bytesToWrite() > c_highWaterMark) {
+        return;
+    }
+
+    // Devices with a bounded buffer, like an IODevice with a high-water mark, may take only a
+    // part of a write
+    if (!mPriv->pendingOutput.isEmpty()) {
+        qint64 written = output->write(mPriv->pendingOutput);
+        if (written > 0) {
+            mPriv->pendingOutput.remove(0, int(written));
+        }
+        if (!mPriv->pendingOutput.isEmpty()) {
+            return;
+        }
+    }
+
+    // deviceOffset is the number of already skipped bytes, seekable devices don't have to be read for that
+    if (mPriv->deviceOffset < initialOffset() && !input->isSequential()) {
+        qint64 diff = initialOffset() - mPriv->deviceOffset;
+        if (input->seek(input->pos() + diff)) {
+            mPriv->deviceOffset += diff;
+        }
+    }
+
+    qint64 budget = c_maxBytesPerIteration;
+
+    if (mPriv->direction == BaseChannelFileTransferType::Incoming &&
+            mPriv->deviceOffset >= initialOffset()) {
+        bool wouldBlock;
+        qint64 sent = mPriv->sendFile(input, output, budget, &wouldBlock);
+        if (sent > 0) {
+            mPriv->deviceOffset += sent;
+            setTransferredBytes(transferredBytes() + sent);
+            budget -= sent;
+        }
+
+        if (sent >= 0) {
+            if (!wouldBlock) {
+                if (input->bytesAvailable() > 0) {
+                    QMetaObject::invokeMethod(this, "doTransfer", Qt::QueuedConnection);
+                }
+                return;
+            }
+
+            // The socket is full. Queue a small block through the socket itself, so that its
+            // bytesWritten() signal tells us when it's worth trying again.
+            budget = qMin(budget, c_wakeUpBlockSize);
+        }
+    }
+
+    if (mPriv->buffer.size() != c_bufferSize) {
+        mPriv->buffer.resize(int(c_bufferSize));
+    }
+
+    while (budget > 0 && output->bytesToWrite() <= c_highWaterMark) {
+        char *inputPointer = mPriv->buffer.data();
+        qint64 length = input->read(inputPointer, qMin(budget, c_bufferSize));
+
+        if (length <= 0) {
+            break;
+        }
+
+        budget -= length;
 
-    if (length) {
         // deviceOffset is the number of already skipped bytes
         if (mPriv->deviceOffset + length > initialOffset()) {
             if (mPriv->deviceOffset < initialOffset()) {
@@ -1233,12 +1591,18 @@ void BaseChannelFileTransferType::doTransfer()
                 inputPointer += diff;
                 mPriv->deviceOffset += diff;
             }
-            output->write(inputPointer, length);
+            qint64 written = output->write(inputPointer, length);
+            if (written < length) {
+                mPriv->deviceOffset += length;
+                written = qMax<qint64>(written, 0);
+                mPriv->pendingOutput = QByteArray(inputPointer + written, int(length - written));
+                return;
+            }
         }
         mPriv->deviceOffset += length;
     }
 
-    if (input->bytesAvailable() > 0) {
+    if (input->bytesAvailable() > 0 && output->bytesToWrite() <= c_highWaterMark) {
         QMetaObject::invokeMethod(this, "doTransfer", Qt::QueuedConnection);
     }
 }
@@ -1246,6 +1610,10 @@ void BaseChannelFileTransferType::doTransfer()
 void BaseChannelFileTransferType::onBytesWritten(qint64 count)
 {
     setTransferredBytes(transferredBytes() + count);
+
+    if (state() == Tp::FileTransferStateOpen) {
+        doTransfer();
+    }
 }
 
 /**
@@ -1469,6 +1837,9 @@ bool BaseChannelFileTransferType::remoteAcceptFile(QIODevice *output, qulonglong
     mPriv->weOpenedDevice = !deviceIsAlreadynOpened;
     mPriv->initialOffset = offset;
 
+    // Resume the transfer once the device drained the data queued by doTransfer()
+    connect(mPriv->device, SIGNAL(bytesWritten(qint64)), this, SLOT(doTransfer()));
+
     QMetaObject::invokeMethod(mPriv->adaptee, "initialOffsetDefined", Q_ARG(qulonglong, offset)); //Can simply use emit in Qt5
     setState(Tp::FileTransferStateAccepted, Tp::FileTransferStateChangeReasonNone);
 
@@ -1628,7 +1999,7 @@ void BaseChannelRoomListType::Adaptee::getListingRooms(
 void BaseChannelRoomListType::Adaptee::listRooms(
         const Tp::Service::ChannelTypeRoomListAdaptor::ListRoomsContextPtr &context)
 {
-    debug() << "BaseChannelRoomListType::Adaptee::listRooms";
+    tpDebug(DebugCategoryService) << "BaseChannelRoomListType::Adaptee::listRooms";
     DBusError error;
     mInterface->listRooms(&error);
     if (error.isValid()) {
@@ -1641,7 +2012,7 @@ void BaseChannelRoomListType::Adaptee::listRooms(
 void BaseChannelRoomListType::Adaptee::stopListing(
         const Tp::Service::ChannelTypeRoomListAdaptor::StopListingContextPtr &context)
 {
-    debug() << "BaseChannelRoomListType::Adaptee::stopListing";
+    tpDebug(DebugCategoryService) << "BaseChannelRoomListType::Adaptee::stopListing";
     DBusError error;
     mInterface->stopListing(&error);
     if (error.isValid()) {
@@ -1874,7 +2245,8 @@ QVariantMap BaseChannelCaptchaAuthenticationInterface::Adaptee::captchaErrorDeta
 
 void BaseChannelCaptchaAuthenticationInterface::Adaptee::getCaptchas(const Tp::Service::ChannelInterfaceCaptchaAuthenticationAdaptor::GetCaptchasContextPtr &context)
 {
-    debug() << "BaseChannelCaptchaAuthenticationInterface::Adaptee::getCaptchas";
+    tpDebug(DebugCategoryService) <<
+        "BaseChannelCaptchaAuthenticationInterface::Adaptee::getCaptchas";
     DBusError error;
     Tp::CaptchaInfoList captchaInfo;
     uint numberRequired;
@@ -1889,7 +2261,7 @@ void BaseChannelCaptchaAuthenticationInterface::Adaptee::getCaptchas(const Tp::S
 
 void BaseChannelCaptchaAuthenticationInterface::Adaptee::getCaptchaData(uint ID, const QString& mimeType, const Tp::Service::ChannelInterfaceCaptchaAuthenticationAdaptor::GetCaptchaDataContextPtr &context)
 {
-    debug() << "BaseChannelCaptchaAuthenticationInterface::Adaptee::getCaptchaData " << ID << mimeType;
+    tpDebug(DebugCategoryService) << "BaseChannelCaptchaAuthenticationInterface::Adaptee::getCaptchaData " << ID << mimeType;
     DBusError error;
     QByteArray captchaData = mInterface->mPriv->getCaptchaDataCB(ID, mimeType, &error);
     if (error.isValid()) {
@@ -1901,7 +2273,8 @@ void BaseChannelCaptchaAuthenticationInterface::Adaptee::getCaptchaData(uint ID,
 
 void BaseChannelCaptchaAuthenticationInterface::Adaptee::answerCaptchas(const Tp::CaptchaAnswers& answers, const Tp::Service::ChannelInterfaceCaptchaAuthenticationAdaptor::AnswerCaptchasContextPtr &context)
 {
-    debug() << "BaseChannelCaptchaAuthenticationInterface::Adaptee::answerCaptchas";
+    tpDebug(DebugCategoryService) <<
+        "BaseChannelCaptchaAuthenticationInterface::Adaptee::answerCaptchas";
     DBusError error;
     mInterface->mPriv->answerCaptchasCB(answers, &error);
     if (error.isValid()) {
@@ -1913,7 +2286,8 @@ void BaseChannelCaptchaAuthenticationInterface::Adaptee::answerCaptchas(const Tp
 
 void BaseChannelCaptchaAuthenticationInterface::Adaptee::cancelCaptcha(uint reason, const QString& debugMessage, const Tp::Service::ChannelInterfaceCaptchaAuthenticationAdaptor::CancelCaptchaContextPtr &context)
 {
-    debug() << "BaseChannelCaptchaAuthenticationInterface::Adaptee::cancelCaptcha "
+    tpDebug(DebugCategoryService) <<
+        "BaseChannelCaptchaAuthenticationInterface::Adaptee::cancelCaptcha "
              << reason << " " << debugMessage;
     DBusError error;
     mInterface->mPriv->cancelCaptchaCB(reason, debugMessage, &error);
@@ -2114,7 +2488,8 @@ bool BaseChannelSASLAuthenticationInterface::Adaptee::maySaveResponse() const
 void BaseChannelSASLAuthenticationInterface::Adaptee::startMechanism(const QString &mechanism,
         const Tp::Service::ChannelInterfaceSASLAuthenticationAdaptor::StartMechanismContextPtr &context)
 {
-    debug() << "BaseChannelSASLAuthenticationInterface::Adaptee::startMechanism";
+    tpDebug(DebugCategoryService) <<
+        "BaseChannelSASLAuthenticationInterface::Adaptee::startMechanism";
     DBusError error;
     mInterface->startMechanism(mechanism, &error);
     if (error.isValid()) {
@@ -2127,7 +2502,8 @@ void BaseChannelSASLAuthenticationInterface::Adaptee::startMechanism(const QStri
 void BaseChannelSASLAuthenticationInterface::Adaptee::startMechanismWithData(const QString &mechanism, const QByteArray &initialData,
         const Tp::Service::ChannelInterfaceSASLAuthenticationAdaptor::StartMechanismWithDataContextPtr &context)
 {
-    debug() << "BaseChannelSASLAuthenticationInterface::Adaptee::startMechanismWithData";
+    tpDebug(DebugCategoryService) <<
+        "BaseChannelSASLAuthenticationInterface::Adaptee::startMechanismWithData";
     DBusError error;
     mInterface->startMechanismWithData(mechanism, initialData, &error);
     if (error.isValid()) {
@@ -2140,7 +2516,7 @@ void BaseChannelSASLAuthenticationInterface::Adaptee::startMechanismWithData(con
 void BaseChannelSASLAuthenticationInterface::Adaptee::respond(const QByteArray &responseData,
         const Tp::Service::ChannelInterfaceSASLAuthenticationAdaptor::RespondContextPtr &context)
 {
-    debug() << "BaseChannelSASLAuthenticationInterface::Adaptee::respond";
+    tpDebug(DebugCategoryService) << "BaseChannelSASLAuthenticationInterface::Adaptee::respond";
     DBusError error;
     mInterface->respond(responseData, &error);
     if (error.isValid()) {
@@ -2153,7 +2529,7 @@ void BaseChannelSASLAuthenticationInterface::Adaptee::respond(const QByteArray &
 void BaseChannelSASLAuthenticationInterface::Adaptee::acceptSasl(
         const Tp::Service::ChannelInterfaceSASLAuthenticationAdaptor::AcceptSASLContextPtr &context)
 {
-    debug() << "BaseChannelSASLAuthenticationInterface::Adaptee::acceptSasl";
+    tpDebug(DebugCategoryService) << "BaseChannelSASLAuthenticationInterface::Adaptee::acceptSasl";
     DBusError error;
     mInterface->acceptSasl(&error);
     if (error.isValid()) {
@@ -2166,7 +2542,7 @@ void BaseChannelSASLAuthenticationInterface::Adaptee::acceptSasl(
 void BaseChannelSASLAuthenticationInterface::Adaptee::abortSasl(uint reason, const QString &debugMessage,
         const Tp::Service::ChannelInterfaceSASLAuthenticationAdaptor::AbortSASLContextPtr &context)
 {
-    debug() << "BaseChannelSASLAuthenticationInterface::Adaptee::abortSasl";
+    tpDebug(DebugCategoryService) << "BaseChannelSASLAuthenticationInterface::Adaptee::abortSasl";
     DBusError error;
     mInterface->abortSasl(reason, debugMessage, &error);
     if (error.isValid()) {
@@ -2513,7 +2889,7 @@ Tp::ChatStateMap BaseChannelChatStateInterface::Adaptee::chatStates() const
 void BaseChannelChatStateInterface::Adaptee::setChatState(uint state,
         const Tp::Service::ChannelInterfaceChatStateAdaptor::SetChatStateContextPtr &context)
 {
-    debug() << "BaseChannelChatStateInterface::Adaptee::setChatState";
+    tpDebug(DebugCategoryService) << "BaseChannelChatStateInterface::Adaptee::setChatState";
     DBusError error;
     mInterface->setChatState(state, &error);
     if (error.isValid()) {
@@ -2588,23 +2964,54 @@ void BaseChannelChatStateInterface::chatStateChanged(uint contact, uint state)
 struct TP_QT_NO_EXPORT BaseChannelGroupInterface::Private {
     Private(BaseChannelGroupInterface *parent)
         : connection(0),
+          membersListDirty(false),
           selfHandle(0),
+          pendingListsChanged(false),
+          membersChangeScheduled(false),
           adaptee(new BaseChannelGroupInterface::Adaptee(parent))
     {
     }
 
     Tp::UIntList getLocalPendingList() const;
-    bool updateMemberIdentifiers();
+    const Tp::UIntList &membersList() const;
+    void setMembersList(const Tp::UIntList &members, Tp::UIntList *added, Tp::UIntList *removed);
+    void updatePendingSets();
+    bool removeFromPendingLists(const Tp::UIntList &handles);
+    bool isReferenced(uint handle) const;
+    void addMemberIdentifiers(const Tp::UIntList &handles);
+    void pruneMemberIdentifiers(const Tp::UIntList &handles);
+    void recordMembersChange(const Tp::UIntList &added, const Tp::UIntList &removed, bool listsChanged, const QVariantMap &details);
+    void flushMembersChange();
     void emitMembersChangedSignal(const Tp::UIntList &added, const Tp::UIntList &removed, const Tp::UIntList &localPending, const Tp::UIntList &remotePending, QVariantMap details) const;
 
     BaseConnection *connection;
     Tp::ChannelGroupFlags groupFlags;
     Tp::HandleOwnerMap handleOwners;
+    QSet<uint> ownerHandles;
     Tp::LocalPendingInfoList localPendingMembers;
-    Tp::UIntList members;
+    QSet<uint> localPendingSet;
+    QSet<uint> localPendingActors;
+
+    // The set is authoritative. Removals only mark the list dirty, and it is compacted when read.
+    QSet<uint> memberSet;
+    mutable Tp::UIntList members;
+    mutable bool membersListDirty;
+
     Tp::UIntList remotePendingMembers;
+    QSet<uint> remotePendingSet;
     uint selfHandle;
     Tp::HandleIdentifierMap memberIdentifiers;
+
+    // Changes not signalled yet, merged until the event loop runs again. The lists keep the
+    // order and the sets tell which entries are still part of the change.
+    Tp::UIntList pendingAdded;
+    QSet<uint> pendingAddedSet;
+    Tp::UIntList pendingRemoved;
+    QSet<uint> pendingRemovedSet;
+    bool pendingListsChanged;
+    QVariantMap pendingDetails;
+    bool membersChangeScheduled;
+
     AddMembersCallback addMembersCB;
     RemoveMembersCallback removeMembersCB;
     BaseChannelGroupInterface::Adaptee *adaptee;
@@ -2640,6 +3047,11 @@ Tp::UIntList BaseChannelGroupInterface::Adaptee::members() const
     return mInterface->members();
 }
 
+void BaseChannelGroupInterface::Adaptee::flushMembersChange()
+{
+    mInterface->mPriv->flushMembersChange();
+}
+
 Tp::UIntList BaseChannelGroupInterface::Adaptee::remotePendingMembers() const
 {
     return mInterface->remotePendingMembers();
@@ -2705,33 +3117,233 @@ UIntList BaseChannelGroupInterface::Private::getLocalPendingList() const
     return localPending;
 }
 
-bool BaseChannelGroupInterface::Private::updateMemberIdentifiers()
+const UIntList &BaseChannelGroupInterface::Private::membersList() const
+{
+    if (membersListDirty) {
+        // Drop removed members, and duplicates of members removed and added back
+        QSet<uint> seen;
+        seen.reserve(memberSet.size());
+        Tp::UIntList compacted;
+        compacted.reserve(memberSet.size());
+        foreach (uint handle, members) {
+            if (memberSet.contains(handle) && !seen.contains(handle)) {
+                seen.insert(handle);
+                compacted << handle;
+            }
+        }
+        members = compacted;
+        membersListDirty = false;
+    }
+    return members;
+}
+
+void BaseChannelGroupInterface::Private::setMembersList(const UIntList &newMembers,
+        UIntList *added, UIntList *removed)
 {
-    Tp::UIntList handles = members + remotePendingMembers + handleOwners.values();
-    handles << selfHandle;
+    QSet<uint> newSet;
+    newSet.reserve(newMembers.size());
+    Tp::UIntList uniqueMembers;
+    uniqueMembers.reserve(newMembers.size());
 
+    foreach (uint handle, newMembers) {
+        if (newSet.contains(handle)) {
+            continue;
+        }
+        newSet.insert(handle);
+        uniqueMembers << handle;
+
+        if (!memberSet.contains(handle)) {
+            *added << handle;
+        }
+    }
+
+    foreach (uint handle, membersList()) {
+        if (!newSet.contains(handle)) {
+            *removed << handle;
+        }
+    }
+
+    members = uniqueMembers;
+    membersListDirty = false;
+    memberSet = newSet;
+}
+
+void BaseChannelGroupInterface::Private::updatePendingSets()
+{
+    localPendingSet.clear();
+    localPendingActors.clear();
     foreach (const Tp::LocalPendingInfo &info, localPendingMembers) {
-        handles << info.toBeAdded;
-        if (info.actor && !handles.contains(info.actor)) {
-            handles << info.actor;
+        localPendingSet.insert(info.toBeAdded);
+        if (info.actor) {
+            localPendingActors.insert(info.actor);
         }
     }
 
-    Tp::DBusError error;
-    const QStringList identifiers = connection->inspectHandles(Tp::HandleTypeContact, handles, &error);
+    remotePendingSet = QSet<uint>::fromList(remotePendingMembers);
+}
+
+bool BaseChannelGroupInterface::Private::removeFromPendingLists(const UIntList &handles)
+{
+    if (localPendingSet.isEmpty() && remotePendingSet.isEmpty()) {
+        return false;
+    }
+
+    QSet<uint> handleSet;
+    foreach (uint handle, handles) {
+        if (localPendingSet.contains(handle) || remotePendingSet.contains(handle)) {
+            handleSet.insert(handle);
+        }
+    }
 
-    if (error.isValid() || (handles.count() != identifiers.count())) {
+    if (handleSet.isEmpty()) {
         return false;
     }
 
-    memberIdentifiers.clear();
+    Tp::LocalPendingInfoList keptLocalPending;
+    foreach (const Tp::LocalPendingInfo &info, localPendingMembers) {
+        if (!handleSet.contains(info.toBeAdded)) {
+            keptLocalPending << info;
+        }
+    }
+    localPendingMembers = keptLocalPending;
 
-    for (int i = 0; i < identifiers.count(); ++i) {
-        memberIdentifiers[handles.at(i)] = identifiers.at(i);
+    Tp::UIntList keptRemotePending;
+    foreach (uint handle, remotePendingMembers) {
+        if (!handleSet.contains(handle)) {
+            keptRemotePending << handle;
+        }
     }
+    remotePendingMembers = keptRemotePending;
+
+    updatePendingSets();
     return true;
 }
 
+bool BaseChannelGroupInterface::Private::isReferenced(uint handle) const
+{
+    return handle == selfHandle || memberSet.contains(handle) ||
+        localPendingSet.contains(handle) || localPendingActors.contains(handle) ||
+        remotePendingSet.contains(handle) || handleOwners.contains(handle) ||
+        ownerHandles.contains(handle);
+}
+
+void BaseChannelGroupInterface::Private::addMemberIdentifiers(const UIntList &handles)
+{
+    if (!connection) {
+        return;
+    }
+
+    // Only look up the handles which were not mentioned in the channel yet
+    QSet<uint> newHandleSet;
+    Tp::UIntList newHandles;
+    foreach (uint handle, handles) {
+        if (handle && !memberIdentifiers.contains(handle) && !newHandleSet.contains(handle)) {
+            newHandleSet.insert(handle);
+            newHandles << handle;
+        }
+    }
+
+    if (newHandles.isEmpty()) {
+        return;
+    }
+
+    Tp::DBusError error;
+    const QStringList identifiers = connection->inspectHandles(Tp::HandleTypeContact, newHandles, &error);
+
+    if (error.isValid() || (newHandles.count() != identifiers.count())) {
+        return;
+    }
+
+    for (int i = 0; i < identifiers.count(); ++i) {
+        memberIdentifiers[newHandles.at(i)] = identifiers.at(i);
+    }
+}
+
+void BaseChannelGroupInterface::Private::pruneMemberIdentifiers(const UIntList &handles)
+{
+    foreach (uint handle, handles) {
+        if (!isReferenced(handle)) {
+            memberIdentifiers.remove(handle);
+        }
+    }
+}
+
+void BaseChannelGroupInterface::Private::recordMembersChange(const UIntList &added,
+        const UIntList &removed, bool listsChanged, const QVariantMap &details)
+{
+    if (membersChangeScheduled && details != pendingDetails) {
+        // The details describe the whole change, so only merge changes that share them
+        flushMembersChange();
+    }
+
+    foreach (uint handle, added) {
+        if (pendingRemovedSet.remove(handle)) {
+            // Removed and added back within the same change
+            continue;
+        }
+        if (!pendingAddedSet.contains(handle)) {
+            pendingAddedSet.insert(handle);
+            pendingAdded << handle;
+        }
+    }
+
+    foreach (uint handle, removed) {
+        if (pendingAddedSet.remove(handle)) {
+            continue;
+        }
+        if (!pendingRemovedSet.contains(handle)) {
+            pendingRemovedSet.insert(handle);
+            pendingRemoved << handle;
+        }
+    }
+
+    pendingListsChanged = pendingListsChanged || listsChanged;
+    pendingDetails = details;
+
+    if (!membersChangeScheduled) {
+        membersChangeScheduled = true;
+        QMetaObject::invokeMethod(adaptee, "flushMembersChange", Qt::QueuedConnection);
+    }
+}
+
+void BaseChannelGroupInterface::Private::flushMembersChange()
+{
+    if (!membersChangeScheduled) {
+        return;
+    }
+    membersChangeScheduled = false;
+
+    Tp::UIntList added;
+    foreach (uint handle, pendingAdded) {
+        if (pendingAddedSet.remove(handle)) {
+            added << handle;
+        }
+    }
+
+    Tp::UIntList removed;
+    foreach (uint handle, pendingRemoved) {
+        if (pendingRemovedSet.remove(handle)) {
+            removed << handle;
+        }
+    }
+
+    const bool listsChanged = pendingListsChanged;
+    const QVariantMap details = pendingDetails;
+
+    pendingAdded.clear();
+    pendingAddedSet.clear();
+    pendingRemoved.clear();
+    pendingRemovedSet.clear();
+    pendingListsChanged = false;
+    pendingDetails.clear();
+
+    if (added.isEmpty() && removed.isEmpty() && !listsChanged) {
+        return;
+    }
+
+    emitMembersChangedSignal(added, removed, getLocalPendingList(), remotePendingMembers, details);
+}
+
 void BaseChannelGroupInterface::Private::emitMembersChangedSignal(const UIntList &added, const UIntList &removed, const UIntList &localPending, const UIntList &remotePending, QVariantMap details) const
 {
     const uint actor = details.value(QLatin1String("actor"), 0).toUInt();
@@ -2826,7 +3438,13 @@ void BaseChannelGroupInterface::Private::emitMembersChangedSignal(const UIntList
  *
  * Note, that the interface automatically update the MemberIdentifiers property on members changes.
  *
- * \sa setGroupFlags(), setSelfHandle(), setMembers(), setAddMembersCallback(),
+ * Membership is kept in hash sets, so large groups can be updated cheaply. Connection managers
+ * which learn about joins and parts one at a time (such as in big chat rooms) should use
+ * addToMembers() and removeFromMembers() rather than passing the whole list to setMembers().
+ * The MembersChanged signals for changes made within one iteration of the event loop with the
+ * same details are merged into one, which is emitted when the event loop runs again.
+ *
+ * \sa setGroupFlags(), setSelfHandle(), setMembers(), addToMembers(), setAddMembersCallback(),
  * setRemoveMembersCallback(), setHandleOwners(),
  * setLocalPendingMembers(), setRemotePendingMembers()
  */
@@ -2902,7 +3520,18 @@ void BaseChannelGroupInterface::setGroupFlags(const Tp::ChannelGroupFlags &flags
  */
 Tp::UIntList BaseChannelGroupInterface::members() const
 {
-    return mPriv->members;
+    return mPriv->membersList();
+}
+
+/**
+ * Return whether a contact is a member of this channel.
+ *
+ * \param handle The handle of the contact.
+ * \return \c true if \a handle is in members(), \c false otherwise.
+ */
+bool BaseChannelGroupInterface::isMember(uint handle) const
+{
+    return mPriv->memberSet.contains(handle);
 }
 
 /**
@@ -2921,41 +3550,78 @@ Tp::UIntList BaseChannelGroupInterface::members() const
  */
 void BaseChannelGroupInterface::setMembers(const UIntList &members, const QVariantMap &details)
 {
-    Tp::UIntList localPendingList = mPriv->getLocalPendingList();
+    Tp::UIntList added;
+    Tp::UIntList removed;
+    mPriv->setMembersList(members, &added, &removed);
+
+    // Added members are removed from the local and remote pending lists
+    bool listsChanged = mPriv->removeFromPendingLists(added);
 
+    mPriv->addMemberIdentifiers(added);
+    mPriv->pruneMemberIdentifiers(removed);
+    mPriv->recordMembersChange(added, removed, listsChanged, details);
+}
+
+/**
+ * Add contacts to the list of current members of the channel.
+ *
+ * Unlike setMembers(), this only looks at the given contacts, which makes it the cheaper way to
+ * report changes to large groups. Contacts which are already members are ignored. Added members
+ * are automatically removed from the local and remote pending lists.
+ *
+ * \param members The contacts which joined the channel.
+ * \param details The map with an information about the change.
+ *
+ * \sa removeFromMembers(), setMembers()
+ */
+void BaseChannelGroupInterface::addToMembers(const Tp::UIntList &members, const QVariantMap &details)
+{
     Tp::UIntList added;
     foreach (uint handle, members) {
-        if (!mPriv->members.contains(handle)) {
+        if (!mPriv->memberSet.contains(handle)) {
+            mPriv->memberSet.insert(handle);
+            mPriv->members << handle;
             added << handle;
+        }
+    }
 
-            // Remove added member from the local pending list
-            int indexInLocalPending = localPendingList.indexOf(handle);
-
-            if (indexInLocalPending >= 0) {
-                localPendingList.removeAt(indexInLocalPending);
-                mPriv->localPendingMembers.removeAt(indexInLocalPending);
-            }
+    if (added.isEmpty()) {
+        return;
+    }
 
-            // Remove added member from the remote pending list
-            int indexInRemotePending = mPriv->remotePendingMembers.indexOf(handle);
+    bool listsChanged = mPriv->removeFromPendingLists(added);
 
-            if (indexInRemotePending >= 0) {
-                mPriv->remotePendingMembers.removeAt(indexInRemotePending);
-            }
-        }
-    }
+    mPriv->addMemberIdentifiers(added);
+    mPriv->recordMembersChange(added, Tp::UIntList(), listsChanged, details);
+}
 
+/**
+ * Remove contacts from the list of current members of the channel.
+ *
+ * Contacts which are not members are ignored.
+ *
+ * \param members The contacts which left the channel.
+ * \param details The map with an information about the change.
+ *
+ * \sa addToMembers(), setMembers()
+ */
+void BaseChannelGroupInterface::removeFromMembers(const Tp::UIntList &members, const QVariantMap &details)
+{
     Tp::UIntList removed;
-    foreach (uint handle, mPriv->members) {
-        if (!members.contains(handle)) {
+    foreach (uint handle, members) {
+        if (mPriv->memberSet.remove(handle)) {
             removed << handle;
         }
     }
 
-    mPriv->members = members;
+    if (removed.isEmpty()) {
+        return;
+    }
+
+    mPriv->membersListDirty = true;
 
-    mPriv->updateMemberIdentifiers();
-    mPriv->emitMembersChangedSignal(added, removed, localPendingList, mPriv->remotePendingMembers, details);
+    mPriv->pruneMemberIdentifiers(removed);
+    mPriv->recordMembersChange(Tp::UIntList(), removed, false, details);
 }
 
 /**
@@ -2976,26 +3642,24 @@ void BaseChannelGroupInterface::setMembers(const UIntList &members, const QVaria
 void BaseChannelGroupInterface::setMembers(const Tp::UIntList &members, const Tp::LocalPendingInfoList &localPending, const Tp::UIntList &remotePending, const QVariantMap &details)
 {
     Tp::UIntList added;
-    foreach (uint handle, members) {
-        if (!mPriv->members.contains(handle)) {
-            added << handle;
-        }
-    }
-
     Tp::UIntList removed;
-    foreach (uint handle, mPriv->members) {
-        if (!members.contains(handle)) {
-            removed << handle;
-        }
-    }
+    mPriv->setMembersList(members, &added, &removed);
+
+    const Tp::UIntList oldLocalPending = mPriv->getLocalPendingList();
+    const Tp::UIntList oldLocalPendingActors = mPriv->localPendingActors.toList();
+    const Tp::UIntList oldRemotePending = mPriv->remotePendingMembers;
 
     // Do not use the setters here to avoid signal duplication
     mPriv->localPendingMembers = localPending;
     mPriv->remotePendingMembers = remotePending;
-    mPriv->members = members;
+    mPriv->updatePendingSets();
 
-    mPriv->updateMemberIdentifiers();
-    mPriv->emitMembersChangedSignal(added, removed, mPriv->getLocalPendingList(), remotePending, details);
+    const Tp::UIntList newLocalPending = mPriv->getLocalPendingList();
+    bool listsChanged = (newLocalPending != oldLocalPending) || (remotePending != oldRemotePending);
+
+    mPriv->addMemberIdentifiers(added + newLocalPending + mPriv->localPendingActors.toList() + remotePending);
+    mPriv->pruneMemberIdentifiers(removed + oldLocalPending + oldLocalPendingActors + oldRemotePending);
+    mPriv->recordMembersChange(added, removed, listsChanged, details);
 }
 
 /**
@@ -3041,8 +3705,13 @@ void BaseChannelGroupInterface::setHandleOwners(const Tp::HandleOwnerMap &handle
         }
     }
 
+    const Tp::UIntList oldOwners = mPriv->ownerHandles.toList();
+
     mPriv->handleOwners = handleOwners;
-    mPriv->updateMemberIdentifiers();
+    mPriv->ownerHandles = QSet<uint>::fromList(handleOwners.values());
+
+    mPriv->addMemberIdentifiers(handleOwners.keys() + handleOwners.values());
+    mPriv->pruneMemberIdentifiers(removed + oldOwners);
 
     Tp::HandleIdentifierMap identifiers;
 
@@ -3079,13 +3748,18 @@ Tp::LocalPendingInfoList BaseChannelGroupInterface::localPendingMembers() const
  */
 void BaseChannelGroupInterface::setLocalPendingMembers(const Tp::LocalPendingInfoList &localPendingMembers)
 {
+    const Tp::UIntList oldLocalPending = mPriv->getLocalPendingList() +
+            mPriv->localPendingActors.toList();
+
     mPriv->localPendingMembers = localPendingMembers;
-    mPriv->updateMemberIdentifiers();
+    mPriv->updatePendingSets();
+
+    mPriv->addMemberIdentifiers(mPriv->getLocalPendingList() + mPriv->localPendingActors.toList());
+    mPriv->pruneMemberIdentifiers(oldLocalPending);
 
     uint actor = 0;
     uint reason = Tp::ChannelGroupChangeReasonNone;
     QString message;
-    Tp::UIntList localPending;
 
     Tp::HandleIdentifierMap contactIds;
 
@@ -3095,8 +3769,6 @@ void BaseChannelGroupInterface::setLocalPendingMembers(const Tp::LocalPendingInf
         message = localPendingMembers.first().message;
 
         foreach (const Tp::LocalPendingInfo &info, localPendingMembers) {
-            localPending << info.toBeAdded;
-
             if (actor != info.actor) {
                 actor = 0;
             }
@@ -3119,7 +3791,7 @@ void BaseChannelGroupInterface::setLocalPendingMembers(const Tp::LocalPendingInf
     details.insert(QLatin1String("contact-ids"), QVariant::fromValue(contactIds));
     details.insert(QLatin1String("message"), QVariant::fromValue(message));
 
-    mPriv->emitMembersChangedSignal(/* addedMembers */ Tp::UIntList(), /* removedMembers */ Tp::UIntList(), localPending, mPriv->remotePendingMembers, details);
+    mPriv->recordMembersChange(/* addedMembers */ Tp::UIntList(), /* removedMembers */ Tp::UIntList(), /* listsChanged */ true, details);
 }
 
 /**
@@ -3152,10 +3824,14 @@ Tp::UIntList BaseChannelGroupInterface::remotePendingMembers() const
  */
 void BaseChannelGroupInterface::setRemotePendingMembers(const Tp::UIntList &remotePendingMembers)
 {
+    const Tp::UIntList oldRemotePending = mPriv->remotePendingMembers;
+
     mPriv->remotePendingMembers = remotePendingMembers;
+    mPriv->updatePendingSets();
 
-    mPriv->updateMemberIdentifiers();
-    mPriv->emitMembersChangedSignal(/* addedMembers */ Tp::UIntList(), /* removedMembers */ Tp::UIntList(), mPriv->getLocalPendingList(), mPriv->remotePendingMembers, /* details */ QVariantMap());
+    mPriv->addMemberIdentifiers(remotePendingMembers);
+    mPriv->pruneMemberIdentifiers(oldRemotePending);
+    mPriv->recordMembersChange(/* addedMembers */ Tp::UIntList(), /* removedMembers */ Tp::UIntList(), /* listsChanged */ true, /* details */ QVariantMap());
 }
 
 /**
@@ -3182,8 +3858,12 @@ uint BaseChannelGroupInterface::selfHandle() const
  */
 void BaseChannelGroupInterface::setSelfHandle(uint selfHandle)
 {
+    const uint oldSelfHandle = mPriv->selfHandle;
     mPriv->selfHandle = selfHandle;
 
+    mPriv->addMemberIdentifiers(Tp::UIntList() << selfHandle);
+    mPriv->pruneMemberIdentifiers(Tp::UIntList() << oldSelfHandle);
+
     // selfHandleChanged is deprecated since 0.23.4.
     QMetaObject::invokeMethod(mPriv->adaptee, "selfHandleChanged", Q_ARG(uint, selfHandle)); //Can simply use emit in Qt5
 
@@ -3580,7 +4260,7 @@ bool BaseChannelRoomConfigInterface::Adaptee::configurationRetrieved() const
 void BaseChannelRoomConfigInterface::Adaptee::updateConfiguration(const QVariantMap &properties,
         const Tp::Service::ChannelInterfaceRoomConfigAdaptor::UpdateConfigurationContextPtr &context)
 {
-    debug() << "BaseChannelRoomConfigInterface::Adaptee::updateConfiguration";
+    tpDebug(DebugCategoryService) << "BaseChannelRoomConfigInterface::Adaptee::updateConfiguration";
     DBusError error;
     mInterface->updateConfiguration(properties, &error);
     if (error.isValid()) {
@@ -31,6 +31,7 @@
 #include <TelepathyQt/Types>
 #include <TelepathyQt/Callbacks>
 #include <TelepathyQt/Constants>
+#include <TelepathyQt/DeferredReply>
 
 #include <QDBusConnection>
 
@@ -138,6 +139,9 @@ public:
 
     Tp::MessagePartListList pendingMessages() const;
 
+    uint maxPendingMessages() const;
+    void setMaxPendingMessages(uint count);
+
     /* Convenience function */
     void addReceivedMessage(const Tp::MessagePartList &message);
     void acknowledgePendingMessages(const QStringList &tokens, DBusError *error);
@@ -195,8 +199,12 @@ public:
 
     typedef Callback3<QString, const Tp::MessagePartList&, uint, DBusError*> SendMessageCallback;
     void setSendMessageCallback(const SendMessageCallback &cb);
+
+    typedef Callback3<void, const Tp::MessagePartList&, uint, const DeferredReply<QString>&> SendMessageAsyncCallback;
+    void setSendMessageAsyncCallback(const SendMessageAsyncCallback &cb);
 protected:
     QString sendMessage(const Tp::MessagePartList &message, uint flags, DBusError* error);
+    void sendMessage(const Tp::MessagePartList &message, uint flags, const DeferredReply<QString> &reply);
 private Q_SLOTS:
     void pendingMessagesRemoved(const Tp::UIntList &messageIDs);
     void messageReceived(const Tp::MessagePartList &message);
@@ -284,6 +292,7 @@ private Q_SLOTS:
     TP_QT_NO_EXPORT void onSocketConnection();
     TP_QT_NO_EXPORT void doTransfer();
     TP_QT_NO_EXPORT void onBytesWritten(qint64 count);
+    TP_QT_NO_EXPORT void onTransferredBytesTimeout();
 
 private:
     TP_QT_NO_EXPORT void setUri(const QString &uri);
@@ -630,6 +639,9 @@ public:
     Tp::UIntList members() const;
     void setMembers(const Tp::UIntList &members, const QVariantMap &details);
     void setMembers(const Tp::UIntList &members, const Tp::LocalPendingInfoList &localPending, const Tp::UIntList &remotePending, const QVariantMap &details);
+    void addToMembers(const Tp::UIntList &members, const QVariantMap &details);
+    void removeFromMembers(const Tp::UIntList &members, const QVariantMap &details);
+    bool isMember(uint handle) const;
 
     Tp::HandleOwnerMap handleOwners() const;
     void setHandleOwners(const Tp::HandleOwnerMap &handleOwners);
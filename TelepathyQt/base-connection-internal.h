@@ -27,9 +27,56 @@
 #include <TelepathyQt/Types>
 #include "TelepathyQt/debug-internal.h"
 
+#include <QMap>
+#include <QTimer>
+
 namespace Tp
 {
 
+// Collects per-contact changes of a connection interface, keeping the last value for each
+// contact, until the receiver's flush slot is called by the timer. A negative interval disables
+// the aggregation, and 0 flushes when the event loop runs again.
+template<typename T>
+class TP_QT_NO_EXPORT ContactChangeAggregator
+{
+public:
+    ContactChangeAggregator(QObject *receiver, const char *flushSlot)
+        : mInterval(0)
+    {
+        mTimer.setSingleShot(true);
+        QObject::connect(&mTimer, SIGNAL(timeout()), receiver, flushSlot);
+    }
+
+    int interval() const { return mInterval; }
+    void setInterval(int msec) { mInterval = msec; }
+    bool isEnabled() const { return mInterval >= 0; }
+
+    bool isEmpty() const { return mPending.isEmpty(); }
+
+    void insert(uint handle, const T &value)
+    {
+        mPending.insert(handle, value);
+        if (!mTimer.isActive()) {
+            mTimer.start(mInterval);
+        }
+    }
+
+    QMap<uint, T> take()
+    {
+        mTimer.stop();
+        QMap<uint, T> ret;
+        ret.swap(mPending);
+        return ret;
+    }
+
+private:
+    Q_DISABLE_COPY(ContactChangeAggregator)
+
+    QMap<uint, T> mPending;
+    QTimer mTimer;
+    int mInterval;
+};
+
 class TP_QT_NO_EXPORT BaseConnection::Adaptee : public QObject
 {
     Q_OBJECT
@@ -115,6 +162,8 @@ Q_SIGNALS:
     void channelClosed(const QDBusObjectPath &removed);
 
 public:
+    void resumeEnsures(const QVariantMap &request);
+
     BaseConnectionRequestsInterface *mInterface;
 };
 
@@ -154,6 +203,7 @@ private Q_SLOTS:
                      const Tp::Service::ConnectionInterfaceSimplePresenceAdaptor::SetPresenceContextPtr &context);
     void getPresences(const Tp::UIntList &contacts,
                       const Tp::Service::ConnectionInterfaceSimplePresenceAdaptor::GetPresencesContextPtr &context);
+    void flushChanges();
 Q_SIGNALS:
     void presencesChanged(const Tp::SimpleContactPresences &presence);
 
@@ -308,6 +358,7 @@ private Q_SLOTS:
             const Tp::Service::ConnectionInterfaceAliasingAdaptor::GetAliasesContextPtr &context);
     void setAliases(const Tp::AliasMap &aliases,
             const Tp::Service::ConnectionInterfaceAliasingAdaptor::SetAliasesContextPtr &context);
+    void flushChanges();
 
 Q_SIGNALS:
     void aliasesChanged(const Tp::AliasPairList &aliases);
@@ -350,6 +401,7 @@ private Q_SLOTS:
             const Tp::Service::ConnectionInterfaceAvatarsAdaptor::SetAvatarContextPtr &context);
     void clearAvatar(
             const Tp::Service::ConnectionInterfaceAvatarsAdaptor::ClearAvatarContextPtr &context);
+    void flushChanges();
 
 Q_SIGNALS:
     void avatarUpdated(uint contact, const QString &newAvatarToken);
@@ -372,6 +424,7 @@ private Q_SLOTS:
             const Tp::Service::ConnectionInterfaceClientTypesAdaptor::GetClientTypesContextPtr &context);
     void requestClientTypes(uint contact,
             const Tp::Service::ConnectionInterfaceClientTypesAdaptor::RequestClientTypesContextPtr &context);
+    void flushChanges();
 
 Q_SIGNALS:
     void clientTypesUpdated(uint contact, const QStringList &clientTypes);
@@ -304,7 +304,7 @@ bool BaseConnectionManager::addProtocol(const BaseProtocolPtr &protocol)
         return false;
     }
 
-    debug() << "Protocol" << protocol->name() << "added to CM";
+    tpDebug(DebugCategoryService) << "Protocol" << protocol->name() << "added to CM";
     mPriv->protocols.insert(protocol->name(), protocol);
     return true;
 }
@@ -359,14 +359,15 @@ bool BaseConnectionManager::registerObject(const QString &busName, const QString
         escapedProtocolName.replace(QLatin1Char('-'), QLatin1Char('_'));
         QString protoObjectPath = QString(
                 QLatin1String("%1/%2")).arg(objectPath).arg(escapedProtocolName);
-        debug() << "Registering protocol" << protocol->name() << "at path" << protoObjectPath <<
+        tpDebug(DebugCategoryService) << "Registering protocol" << protocol->name() << "at path" <<
+            protoObjectPath <<
             "for CM" << objectPath << "at bus name" << busName;
         if (!protocol->registerObject(busName, protoObjectPath, error)) {
             return false;
         }
     }
 
-    debug() << "Registering CM" << objectPath << "at bus name" << busName;
+    tpDebug(DebugCategoryService) << "Registering CM" << objectPath << "at bus name" << busName;
     // Only call DBusService::registerObject after registering the protocols as we don't want to
     // advertise isRegistered if some protocol cannot be registered
     if (!DBusService::registerObject(busName, objectPath, error)) {
@@ -29,15 +29,322 @@
 #include "TelepathyQt/debug-internal.h"
 
 #include <TelepathyQt/BaseChannel>
+#include <TelepathyQt/BaseHandleRepository>
 #include <TelepathyQt/DBusObject>
 #include <TelepathyQt/Utils>
 #include <TelepathyQt/AbstractProtocolInterface>
+#include <QPair>
+#include <QPointer>
 #include <QString>
 #include <QVariantMap>
 
 namespace Tp
 {
 
+namespace
+{
+
+// Channel request keys, built once instead of on every lookup
+struct ChannelRequestKeys
+{
+    ChannelRequestKeys()
+        : channelType(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType")),
+          targetHandleType(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandleType")),
+          targetHandle(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandle")),
+          targetID(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetID"))
+    {
+    }
+
+    const QString channelType;
+    const QString targetHandleType;
+    const QString targetHandle;
+    const QString targetID;
+};
+
+Q_GLOBAL_STATIC(ChannelRequestKeys, channelRequestKeys)
+
+struct ChannelTargetKey
+{
+    ChannelTargetKey(const QString &channelType, uint targetHandleType,
+            uint targetHandle, const QString &targetID = QString())
+        : channelType(channelType),
+          targetHandleType(targetHandleType),
+          targetHandle(targetHandle),
+          targetID(targetID)
+    {
+    }
+
+    bool operator==(const ChannelTargetKey &other) const
+    {
+        return targetHandle == other.targetHandle &&
+            targetHandleType == other.targetHandleType &&
+            channelType == other.channelType &&
+            targetID == other.targetID;
+    }
+
+    QString channelType;
+    uint targetHandleType;
+    uint targetHandle;
+    QString targetID;
+};
+
+inline uint qHash(const ChannelTargetKey &key)
+{
+    return qHash(key.channelType) ^ qHash(key.targetID) ^
+        (key.targetHandleType << 24) ^ key.targetHandle;
+}
+
+// The key of the target a request asks for, by TargetHandle if it has one and by TargetID
+// otherwise. Returns false if the request has no target.
+bool channelTargetKey(const QVariantMap &request, ChannelTargetKey *key)
+{
+    const ChannelRequestKeys *keys = channelRequestKeys();
+
+    QVariantMap::const_iterator it = request.constFind(keys->targetHandleType);
+    if (it == request.constEnd()) {
+        return false;
+    }
+
+    key->channelType = request.value(keys->channelType).toString();
+    key->targetHandleType = it.value().toUInt();
+
+    it = request.constFind(keys->targetHandle);
+    if (it != request.constEnd()) {
+        key->targetHandle = it.value().toUInt();
+        key->targetID.clear();
+        return true;
+    }
+
+    it = request.constFind(keys->targetID);
+    if (it != request.constEnd()) {
+        key->targetHandle = 0;
+        key->targetID = it.value().toString();
+        return !key->targetID.isEmpty();
+    }
+
+    return false;
+}
+
+// Resolves the target and initiator IDs of a channel returned by a CreateChannel callback,
+// registers it on the bus and adds it to the connection
+bool setUpNewChannel(BaseConnection *connection, const BaseChannelPtr &channel,
+        const QVariantMap &request, bool suppressHandler, DBusError *error)
+{
+    QString targetID = channel->targetID();
+    if ((channel->targetHandle() != 0) && targetID.isEmpty()) {
+        QStringList list = connection->inspectHandles(channel->targetHandleType(),  UIntList() << channel->targetHandle(), error);
+        if (error->isValid()) {
+            tpDebug(DebugCategoryService) << "BaseConnection::createChannel: could not resolve handle " << channel->targetHandle();
+            return false;
+        } else {
+            tpDebug(DebugCategoryService) << "BaseConnection::createChannel: found targetID " <<
+                *list.begin();
+            targetID = *list.begin();
+        }
+        channel->setTargetID(targetID);
+    }
+
+    if (request.contains(TP_QT_IFACE_CHANNEL + QLatin1String(".InitiatorHandle"))) {
+        channel->setInitiatorHandle(request.value(TP_QT_IFACE_CHANNEL + QLatin1String(".InitiatorHandle")).toUInt());
+    }
+
+    QString initiatorID = channel->initiatorID();
+    if ((channel->initiatorHandle() != 0) && initiatorID.isEmpty()) {
+        QStringList list = connection->inspectHandles(HandleTypeContact, UIntList() << channel->initiatorHandle(), error);
+        if (error->isValid()) {
+            tpDebug(DebugCategoryService) << "BaseConnection::createChannel: could not resolve handle " << channel->initiatorHandle();
+            return false;
+        } else {
+            tpDebug(DebugCategoryService) << "BaseConnection::createChannel: found initiatorID " <<
+                *list.begin();
+            initiatorID = *list.begin();
+        }
+        channel->setInitiatorID(initiatorID);
+    }
+    channel->setRequested(suppressHandler);
+
+    channel->registerObject(error);
+    if (error->isValid())
+        return false;
+
+    connection->addChannel(channel, suppressHandler);
+    return true;
+}
+
+// Sets up the channel given to the reply of a CreateChannelAsyncCallback before passing it on
+class NewChannelReply : public DeferredReply<BaseChannelPtr>::Handler
+{
+public:
+    NewChannelReply(BaseConnection *connection, const QVariantMap &request,
+            bool suppressHandler, const DeferredReply<BaseChannelPtr> &reply)
+        : mConnection(connection),
+          mRequest(request),
+          mSuppressHandler(suppressHandler),
+          mReply(reply)
+    {
+    }
+
+protected:
+    void onFinished(const BaseChannelPtr &channel)
+    {
+        if (!mConnection) {
+            mReply.setFinishedWithError(TP_QT_ERROR_NOT_AVAILABLE,
+                    QLatin1String("The connection was destroyed"));
+            return;
+        }
+        if (!channel) {
+            mReply.setFinishedWithError(TP_QT_ERROR_NOT_AVAILABLE,
+                    QLatin1String("No channel was created"));
+            return;
+        }
+
+        DBusError error;
+        if (!setUpNewChannel(mConnection.data(), channel, mRequest, mSuppressHandler, &error)) {
+            mReply.setFinishedWithError(error);
+            return;
+        }
+        mReply.setFinished(channel);
+    }
+
+    void onFailed(const QString &errorName, const QString &errorMessage)
+    {
+        mReply.setFinishedWithError(errorName, errorMessage);
+    }
+
+private:
+    QPointer<BaseConnection> mConnection;
+    QVariantMap mRequest;
+    bool mSuppressHandler;
+    DeferredReply<BaseChannelPtr> mReply;
+};
+
+void finishChannelContext(const Service::ConnectionAdaptor::RequestChannelContextPtr &context,
+        const BaseChannelPtr &channel, bool /* yours */)
+{
+    context->setFinished(QDBusObjectPath(channel->objectPath()));
+}
+
+void finishChannelContext(const Service::ConnectionInterfaceRequestsAdaptor::CreateChannelContextPtr &context,
+        const BaseChannelPtr &channel, bool /* yours */)
+{
+    context->setFinished(QDBusObjectPath(channel->objectPath()), channel->details().properties);
+}
+
+void finishChannelContext(const Service::ConnectionInterfaceRequestsAdaptor::EnsureChannelContextPtr &context,
+        const BaseChannelPtr &channel, bool yours)
+{
+    context->setFinished(yours, QDBusObjectPath(channel->objectPath()), channel->details().properties);
+}
+
+// Answers a RequestChannel, CreateChannel or EnsureChannel call with the channel once it exists
+template<typename Context>
+class ChannelContextReply : public DeferredReply<BaseChannelPtr>::Handler
+{
+public:
+    ChannelContextReply(const Context &context, bool yours)
+        : mContext(context),
+          mYours(yours)
+    {
+    }
+
+    static DeferredReply<BaseChannelPtr> create(const Context &context, bool yours = true)
+    {
+        return DeferredReply<BaseChannelPtr>(SharedPtr<DeferredReply<BaseChannelPtr>::Handler>(
+                    new ChannelContextReply<Context>(context, yours)));
+    }
+
+protected:
+    void onFinished(const BaseChannelPtr &channel)
+    {
+        finishChannelContext(mContext, channel, mYours);
+    }
+
+    void onFailed(const QString &errorName, const QString &errorMessage)
+    {
+        mContext->setFinishedWithError(errorName, errorMessage);
+    }
+
+private:
+    Context mContext;
+    bool mYours;
+};
+
+// Lets the EnsureChannel calls which waited for this one to create their channel go on, once
+// it has been created or has failed
+class EnsureChannelReply : public DeferredReply<BaseChannelPtr>::Handler
+{
+public:
+    EnsureChannelReply(BaseConnectionRequestsInterface::Adaptee *adaptee,
+            const QVariantMap &request, const DeferredReply<BaseChannelPtr> &reply)
+        : mAdaptee(adaptee),
+          mRequest(request),
+          mReply(reply)
+    {
+    }
+
+    ~EnsureChannelReply()
+    {
+        // Dropped without an answer, which fails the call, so the waiting ones must not hang
+        if (!isFinished()) {
+            resume();
+        }
+    }
+
+protected:
+    void onFinished(const BaseChannelPtr &channel)
+    {
+        mReply.setFinished(channel);
+        resume();
+    }
+
+    void onFailed(const QString &errorName, const QString &errorMessage)
+    {
+        mReply.setFinishedWithError(errorName, errorMessage);
+        resume();
+    }
+
+private:
+    void resume()
+    {
+        if (mAdaptee) {
+            mAdaptee->resumeEnsures(mRequest);
+        }
+    }
+
+    QPointer<BaseConnectionRequestsInterface::Adaptee> mAdaptee;
+    QVariantMap mRequest;
+    DeferredReply<BaseChannelPtr> mReply;
+};
+
+// Answers GetContactByID with the attributes of the handle the identifier was resolved to
+class ContactByIDReply : public DeferredReply<Tp::ContactAttributesMap>::Handler
+{
+public:
+    ContactByIDReply(uint handle,
+            const Service::ConnectionInterfaceContactsAdaptor::GetContactByIDContextPtr &context)
+        : mHandle(handle),
+          mContext(context)
+    {
+    }
+
+protected:
+    void onFinished(const Tp::ContactAttributesMap &attributes)
+    {
+        mContext->setFinished(mHandle, attributes.value(mHandle));
+    }
+
+    void onFailed(const QString &errorName, const QString &errorMessage)
+    {
+        mContext->setFinishedWithError(errorName, errorMessage);
+    }
+
+private:
+    uint mHandle;
+    Service::ConnectionInterfaceContactsAdaptor::GetContactByIDContextPtr mContext;
+};
+
+}
+
 struct TP_QT_NO_EXPORT BaseConnection::Private {
     Private(BaseConnection *connection, const QDBusConnection &dbusConnection,
             const QString &cmName, const QString &protocolName,
@@ -48,26 +355,74 @@ struct TP_QT_NO_EXPORT BaseConnection::Private {
           parameters(parameters),
           selfHandle(0),
           status(Tp::ConnectionStatusDisconnected),
+          customChannelMatching(false),
           adaptee(new BaseConnection::Adaptee(dbusConnection, connection))
     {
     }
 
+    void indexChannel(BaseChannel *channel);
+    void unindexChannel(BaseChannel *channel);
+    QList<BaseChannel*> indexedChannels(const QVariantMap &request) const;
+
     BaseConnection *connection;
     QString cmName;
     QString protocolName;
     QVariantMap parameters;
     QHash<QString, AbstractConnectionInterfacePtr> interfaces;
     QSet<BaseChannelPtr> channels;
+    // Channels by (ChannelType, TargetHandleType, TargetHandle) and by
+    // (ChannelType, TargetHandleType, TargetID), see getExistingChannel()
+    QMultiHash<ChannelTargetKey, BaseChannel*> channelIndex;
+    QHash<BaseChannel*, QString> indexedTargetIDs;
     uint selfHandle;
     QString selfID;
     uint status;
     CreateChannelCallback createChannelCB;
+    CreateChannelAsyncCallback createChannelAsyncCB;
     ConnectCallback connectCB;
     InspectHandlesCallback inspectHandlesCB;
     RequestHandlesCallback requestHandlesCB;
+    RequestHandlesAsyncCallback requestHandlesAsyncCB;
+    QHash<uint, BaseHandleRepositoryPtr> handleRepositories;
+    bool customChannelMatching;
     BaseConnection::Adaptee *adaptee;
 };
 
+void BaseConnection::Private::indexChannel(BaseChannel *channel)
+{
+    // The TargetID may be set after construction, so remember the one used for the index
+    const QString targetID = channel->targetID();
+    channelIndex.insert(ChannelTargetKey(channel->channelType(),
+                channel->targetHandleType(), channel->targetHandle()), channel);
+    if (!targetID.isEmpty()) {
+        channelIndex.insert(ChannelTargetKey(channel->channelType(),
+                    channel->targetHandleType(), 0, targetID), channel);
+    }
+    indexedTargetIDs.insert(channel, targetID);
+}
+
+void BaseConnection::Private::unindexChannel(BaseChannel *channel)
+{
+    const QString targetID = indexedTargetIDs.take(channel);
+    channelIndex.remove(ChannelTargetKey(channel->channelType(),
+                channel->targetHandleType(), channel->targetHandle()), channel);
+    if (!targetID.isEmpty()) {
+        channelIndex.remove(ChannelTargetKey(channel->channelType(),
+                    channel->targetHandleType(), 0, targetID), channel);
+    }
+}
+
+QList<BaseChannel*> BaseConnection::Private::indexedChannels(const QVariantMap &request) const
+{
+    ChannelTargetKey key(QString(), 0, 0);
+    if (!channelTargetKey(request, &key)) {
+        // The default matching rejects requests without a target
+        return QList<BaseChannel*>();
+    }
+
+    return channelIndex.values(key);
+}
+
 BaseConnection::Adaptee::Adaptee(const QDBusConnection &dbusConnection,
                                  BaseConnection *connection)
     : QObject(connection),
@@ -129,7 +484,7 @@ void BaseConnection::Adaptee::connect(const Tp::Service::ConnectionAdaptor::Conn
 
 void BaseConnection::Adaptee::disconnect(const Tp::Service::ConnectionAdaptor::DisconnectContextPtr &context)
 {
-    debug() << "BaseConnection::Adaptee::disconnect";
+    tpDebug(DebugCategoryService) << "BaseConnection::Adaptee::disconnect";
 
     foreach(const BaseChannelPtr &channel, mConnection->mPriv->channels) {
         /* BaseChannel::closed() signal triggers removeChannel() method call with proper cleanup */
@@ -192,7 +547,7 @@ void BaseConnection::Adaptee::listChannels(const Service::ConnectionAdaptor::Lis
 void BaseConnection::Adaptee::requestChannel(const QString &type, uint handleType, uint handle, bool suppressHandler,
         const Tp::Service::ConnectionAdaptor::RequestChannelContextPtr &context)
 {
-    debug() << "BaseConnection::Adaptee::requestChannel (deprecated)";
+    tpDebug(DebugCategoryService) << "BaseConnection::Adaptee::requestChannel (deprecated)";
     DBusError error;
 
     QVariantMap request;
@@ -200,13 +555,18 @@ void BaseConnection::Adaptee::requestChannel(const QString &type, uint handleTyp
     request[TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandleType")] = handleType;
     request[TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandle")] = handle;
 
-    bool yours;
-    BaseChannelPtr channel = mConnection->ensureChannel(request, yours, suppressHandler, &error);
-    if (error.isValid() || !channel) {
+    BaseChannelPtr channel = mConnection->getExistingChannel(request, &error);
+    if (error.isValid()) {
         context->setFinishedWithError(error.name(), error.message());
         return;
     }
-    context->setFinished(QDBusObjectPath(channel->objectPath()));
+    if (channel) {
+        context->setFinished(QDBusObjectPath(channel->objectPath()));
+        return;
+    }
+
+    mConnection->createChannel(request, suppressHandler,
+            ChannelContextReply<Service::ConnectionAdaptor::RequestChannelContextPtr>::create(context));
 }
 
 void BaseConnection::Adaptee::releaseHandles(uint handleType, const UIntList &handles, const Service::ConnectionAdaptor::ReleaseHandlesContextPtr &context)
@@ -220,13 +580,8 @@ void BaseConnection::Adaptee::releaseHandles(uint handleType, const UIntList &ha
 void BaseConnection::Adaptee::requestHandles(uint handleType, const QStringList &identifiers,
         const Tp::Service::ConnectionAdaptor::RequestHandlesContextPtr &context)
 {
-    DBusError error;
-    Tp::UIntList handles = mConnection->requestHandles(handleType, identifiers, &error);
-    if (error.isValid()) {
-        context->setFinishedWithError(error.name(), error.message());
-        return;
-    }
-    context->setFinished(handles);
+    mConnection->requestHandles(handleType, identifiers,
+            DeferredReply<Tp::UIntList>::forContext(context));
 }
 
 /**
@@ -357,13 +712,14 @@ void BaseConnection::setSelfContact(uint selfHandle, const QString &selfID)
 
 uint BaseConnection::status() const
 {
-    debug() << "BaseConnection::status = " << mPriv->status << " " << this;
+    tpDebug(DebugCategoryService) << "BaseConnection::status = " << mPriv->status << " " << this;
     return mPriv->status;
 }
 
 void BaseConnection::setStatus(uint newStatus, uint reason)
 {
-    debug() << "BaseConnection::setStatus " << newStatus << " " << reason << " " << this;
+    tpDebug(DebugCategoryService) << "BaseConnection::setStatus " << newStatus << " " << reason <<
+        " " << this;
     bool changed = (newStatus != mPriv->status);
     mPriv->status = newStatus;
     if (changed)
@@ -381,7 +737,7 @@ Tp::BaseChannelPtr BaseConnection::createChannel(const QVariantMap &request, boo
         error->set(TP_QT_ERROR_NOT_IMPLEMENTED, QLatin1String("Not implemented"));
         return BaseChannelPtr();
     }
-    if (!mPriv->inspectHandlesCB.isValid()) {
+    if (!mPriv->inspectHandlesCB.isValid() && mPriv->handleRepositories.isEmpty()) {
         error->set(TP_QT_ERROR_NOT_IMPLEMENTED, QLatin1String("Not implemented"));
         return BaseChannelPtr();
     }
@@ -398,44 +754,73 @@ Tp::BaseChannelPtr BaseConnection::createChannel(const QVariantMap &request, boo
     if (error->isValid())
         return BaseChannelPtr();
 
-    QString targetID = channel->targetID();
-    if ((channel->targetHandle() != 0) && targetID.isEmpty()) {
-        QStringList list = mPriv->inspectHandlesCB(channel->targetHandleType(),  UIntList() << channel->targetHandle(), error);
-        if (error->isValid()) {
-            debug() << "BaseConnection::createChannel: could not resolve handle " << channel->targetHandle();
-            return BaseChannelPtr();
-        } else {
-            debug() << "BaseConnection::createChannel: found targetID " << *list.begin();
-            targetID = *list.begin();
+    if (!setUpNewChannel(this, channel, request, suppressHandler, error))
+        return BaseChannelPtr();
+
+    return channel;
+}
+
+/**
+ * Set the callback used to create channels asynchronously.
+ *
+ * The callback receives the request details and a DeferredReply which it finishes with the
+ * new channel, or with an error, once the channel has been created. The target and initiator
+ * of the channel are then resolved and the channel is registered and added to this connection,
+ * as for channels returned by the callback set with setCreateChannelCallback().
+ *
+ * If set, this callback is used for the CreateChannel, EnsureChannel and RequestChannel D-Bus
+ * methods instead of the synchronous one, so several slow requests can be pending at once.
+ *
+ * \param cb The callback.
+ * \sa createChannel()
+ */
+void BaseConnection::setCreateChannelAsyncCallback(const CreateChannelAsyncCallback &cb)
+{
+    mPriv->createChannelAsyncCB = cb;
+}
+
+/**
+ * Create a new channel satisfying the given \a request and finish \a reply with it.
+ *
+ * The callback set with setCreateChannelAsyncCallback() is used if there is one, otherwise
+ * the channel is created with the synchronous callback and \a reply is finished before this
+ * method returns.
+ *
+ * \param request A dictionary containing the desirable properties.
+ * \param suppressHandler An option to suppress handler for the new channel.
+ * \param reply The reply to finish with the new channel or an error.
+ * \sa setCreateChannelAsyncCallback()
+ */
+void BaseConnection::createChannel(const QVariantMap &request, bool suppressHandler,
+        const DeferredReply<BaseChannelPtr> &reply)
+{
+    if (!mPriv->createChannelAsyncCB.isValid()) {
+        DBusError error;
+        BaseChannelPtr channel = createChannel(request, suppressHandler, &error);
+        if (error.isValid()) {
+            reply.setFinishedWithError(error);
+            return;
         }
-        channel->setTargetID(targetID);
+        reply.setFinished(channel);
+        return;
     }
 
-    if (request.contains(TP_QT_IFACE_CHANNEL + QLatin1String(".InitiatorHandle"))) {
-        channel->setInitiatorHandle(request.value(TP_QT_IFACE_CHANNEL + QLatin1String(".InitiatorHandle")).toUInt());
+    if (!mPriv->inspectHandlesCB.isValid() && mPriv->handleRepositories.isEmpty()) {
+        reply.setFinishedWithError(TP_QT_ERROR_NOT_IMPLEMENTED, QLatin1String("Not implemented"));
+        return;
     }
 
-    QString initiatorID = channel->initiatorID();
-    if ((channel->initiatorHandle() != 0) && initiatorID.isEmpty()) {
-        QStringList list = mPriv->inspectHandlesCB(HandleTypeContact, UIntList() << channel->initiatorHandle(), error);
-        if (error->isValid()) {
-            debug() << "BaseConnection::createChannel: could not resolve handle " << channel->initiatorHandle();
-            return BaseChannelPtr();
-        } else {
-            debug() << "BaseConnection::createChannel: found initiatorID " << *list.begin();
-            initiatorID = *list.begin();
-        }
-        channel->setInitiatorID(initiatorID);
+    if (request.contains(TP_QT_IFACE_CHANNEL + QLatin1String(".Requested"))) {
+        reply.setFinishedWithError(TP_QT_ERROR_INVALID_ARGUMENT, QString(QLatin1String("The %1.Requested property must not be presented in the request details.")).arg(TP_QT_IFACE_CHANNEL));
+        return;
     }
-    channel->setRequested(suppressHandler);
 
-    channel->registerObject(error);
-    if (error->isValid())
-        return BaseChannelPtr();
-
-    addChannel(channel, suppressHandler);
+    QVariantMap requestDetails = request;
+    requestDetails[TP_QT_IFACE_CHANNEL + QLatin1String(".Requested")] = suppressHandler;
 
-    return channel;
+    mPriv->createChannelAsyncCB(requestDetails, DeferredReply<BaseChannelPtr>(
+                SharedPtr<DeferredReply<BaseChannelPtr>::Handler>(
+                    new NewChannelReply(this, request, suppressHandler, reply))));
 }
 
 void BaseConnection::setConnectCallback(const ConnectCallback &cb)
@@ -450,6 +835,11 @@ void BaseConnection::setInspectHandlesCallback(const InspectHandlesCallback &cb)
 
 QStringList BaseConnection::inspectHandles(uint handleType, const Tp::UIntList &handles, DBusError *error)
 {
+    BaseHandleRepositoryPtr repository = mPriv->handleRepositories.value(handleType);
+    if (repository) {
+        return repository->identifiers(handles, error);
+    }
+
     if (!mPriv->inspectHandlesCB.isValid()) {
         error->set(TP_QT_ERROR_NOT_IMPLEMENTED, QLatin1String("Not implemented"));
         return QStringList();
@@ -464,6 +854,11 @@ void BaseConnection::setRequestHandlesCallback(const RequestHandlesCallback &cb)
 
 Tp::UIntList BaseConnection::requestHandles(uint handleType, const QStringList &identifiers, DBusError *error)
 {
+    BaseHandleRepositoryPtr repository = mPriv->handleRepositories.value(handleType);
+    if (repository) {
+        return repository->ensureHandles(identifiers, error);
+    }
+
     if (!mPriv->requestHandlesCB.isValid()) {
         error->set(TP_QT_ERROR_NOT_IMPLEMENTED, QLatin1String("Not implemented"));
         return Tp::UIntList();
@@ -471,9 +866,89 @@ Tp::UIntList BaseConnection::requestHandles(uint handleType, const QStringList &
     return mPriv->requestHandlesCB(handleType, identifiers, error);
 }
 
+/**
+ * Set the callback used to request handles asynchronously.
+ *
+ * The callback receives the handle type, the identifiers and a DeferredReply which it
+ * finishes with the handles, in the order of the identifiers, or with an error.
+ *
+ * As for the synchronous callback, a handle repository set with setHandleRepository() takes
+ * precedence for its handle type.
+ *
+ * \param cb The callback.
+ * \sa requestHandles()
+ */
+void BaseConnection::setRequestHandlesAsyncCallback(const RequestHandlesAsyncCallback &cb)
+{
+    mPriv->requestHandlesAsyncCB = cb;
+}
+
+/**
+ * Request handles for the given \a identifiers and finish \a reply with them.
+ *
+ * The handle repository for \a handleType or the callback set with
+ * setRequestHandlesAsyncCallback() is used if there is one, otherwise the handles are requested
+ * with the synchronous callback. In both of these cases \a reply is finished before this method
+ * returns.
+ *
+ * \param handleType The handle type.
+ * \param identifiers The identifiers to get handles for.
+ * \param reply The reply to finish with the handles or an error.
+ * \sa setRequestHandlesAsyncCallback()
+ */
+void BaseConnection::requestHandles(uint handleType, const QStringList &identifiers,
+        const DeferredReply<Tp::UIntList> &reply)
+{
+    if (mPriv->requestHandlesAsyncCB.isValid() && !mPriv->handleRepositories.contains(handleType)) {
+        mPriv->requestHandlesAsyncCB(handleType, identifiers, reply);
+        return;
+    }
+
+    DBusError error;
+    Tp::UIntList handles = requestHandles(handleType, identifiers, &error);
+    if (error.isValid()) {
+        reply.setFinishedWithError(error);
+        return;
+    }
+    reply.setFinished(handles);
+}
+
+/**
+ * Return the handle repository used for handles of the given \a handleType.
+ *
+ * \param handleType The handle type.
+ * \return A pointer to the repository, or a null pointer if none has been set.
+ * \sa setHandleRepository()
+ */
+BaseHandleRepositoryPtr BaseConnection::handleRepository(uint handleType) const
+{
+    return mPriv->handleRepositories.value(handleType);
+}
+
+/**
+ * Set the handle repository used for handles of the type returned by
+ * BaseHandleRepository::handleType().
+ *
+ * Once set, requestHandles() and inspectHandles() for that handle type are served by the
+ * \a repository instead of the callbacks set with setRequestHandlesCallback() and
+ * setInspectHandlesCallback().
+ *
+ * \param repository The handle repository.
+ * \sa handleRepository()
+ */
+void BaseConnection::setHandleRepository(const BaseHandleRepositoryPtr &repository)
+{
+    if (!repository) {
+        warning() << "BaseConnection::setHandleRepository: Null repository";
+        return;
+    }
+
+    mPriv->handleRepositories.insert(repository->handleType(), repository);
+}
+
 Tp::ChannelInfoList BaseConnection::channelsInfo()
 {
-    debug() << "BaseConnection::channelsInfo:";
+    tpDebug(DebugCategoryService) << "BaseConnection::channelsInfo:";
     Tp::ChannelInfoList list;
     foreach(const BaseChannelPtr & c, mPriv->channels) {
         Tp::ChannelInfo info;
@@ -481,7 +956,7 @@ Tp::ChannelInfoList BaseConnection::channelsInfo()
         info.channelType = c->channelType();
         info.handle = c->targetHandle();
         info.handleType = c->targetHandleType();
-        debug() << "BaseConnection::channelsInfo " << info.channel.path();
+        tpDebug(DebugCategoryService) << "BaseConnection::channelsInfo " << info.channel.path();
         list << info;
     }
     return list;
@@ -500,23 +975,47 @@ Tp::ChannelDetailsList BaseConnection::channelsDetails()
  *
  * Returns an existing channel satisfying the given \a request or a null pointer if such a channel does not exist.
  *
- * This method iterates over the existing channels and calls matchChannel() to find the one satisfying the \a request.
+ * The candidate channels are looked up in an index keyed by ChannelType, TargetHandleType and
+ * TargetHandle or TargetID, and matchChannel() is called to confirm each candidate. Channels whose
+ * TargetID is set after they are added with addChannel() can only be found by their TargetHandle.
+ *
+ * If custom channel matching is enabled with setCustomChannelMatching(), this method instead
+ * iterates over all the existing channels of the requested type and calls matchChannel() to find
+ * the one satisfying the \a request.
  *
  * If \a error is passed, any error that may occur will be stored there.
  *
  * \param request A dictionary containing the desirable properties.
  * \param error A pointer to an empty DBusError where any possible error will be stored.
  * \return A pointer to a channel satisfying the given \a request or a null pointer.
- * \sa matchChannel()
+ * \sa matchChannel(), setCustomChannelMatching()
  */
 Tp::BaseChannelPtr BaseConnection::getExistingChannel(const QVariantMap &request, DBusError *error)
 {
-    if (!request.contains(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType"))) {
+    const ChannelRequestKeys *keys = channelRequestKeys();
+    if (!request.contains(keys->channelType)) {
         error->set(TP_QT_ERROR_INVALID_ARGUMENT, QLatin1String("Missing parameters"));
         return Tp::BaseChannelPtr();
     }
 
-    const QString channelType = request.value(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType")).toString();
+    if (!mPriv->customChannelMatching) {
+        foreach (BaseChannel *channel, mPriv->indexedChannels(request)) {
+            BaseChannelPtr channelPtr(channel);
+            bool match = matchChannel(channelPtr, request, error);
+
+            if (error->isValid()) {
+                return BaseChannelPtr();
+            }
+
+            if (match) {
+                return channelPtr;
+            }
+        }
+
+        return Tp::BaseChannelPtr();
+    }
+
+    const QString channelType = request.value(keys->channelType).toString();
 
     foreach(const BaseChannelPtr &channel, mPriv->channels) {
         if (channel->channelType() != channelType) {
@@ -556,7 +1055,7 @@ Tp::BaseChannelPtr BaseConnection::getExistingChannel(const QVariantMap &request
  */
 Tp::BaseChannelPtr BaseConnection::ensureChannel(const QVariantMap &request, bool &yours, bool suppressHandler, DBusError *error)
 {
-    if (!request.contains(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType"))) {
+    if (!request.contains(channelRequestKeys()->channelType)) {
         error->set(TP_QT_ERROR_INVALID_ARGUMENT, QLatin1String("Missing parameters"));
         return Tp::BaseChannelPtr();
     }
@@ -579,6 +1078,7 @@ void BaseConnection::addChannel(BaseChannelPtr channel, bool suppressHandler)
     }
 
     mPriv->channels.insert(channel);
+    mPriv->indexChannel(channel.data());
 
     BaseConnectionRequestsInterfacePtr reqIface =
         BaseConnectionRequestsInterfacePtr::dynamicCast(interface(TP_QT_IFACE_CONNECTION_INTERFACE_REQUESTS));
@@ -618,6 +1118,7 @@ void BaseConnection::removeChannel()
         reqIface->channelClosed(QDBusObjectPath(channel->objectPath()));
     }
 
+    mPriv->unindexChannel(channel.data());
     mPriv->channels.remove(channel);
 }
 
@@ -682,7 +1183,7 @@ bool BaseConnection::plugInterface(const AbstractConnectionInterfacePtr &interfa
         return false;
     }
 
-    debug() << "Interface" << interface->interfaceName() << "plugged";
+    tpDebug(DebugCategoryService) << "Interface" << interface->interfaceName() << "plugged";
     mPriv->interfaces.insert(interface->interfaceName(), interface);
     interface->setBaseConnection(this);
     return true;
@@ -711,22 +1212,22 @@ bool BaseConnection::registerObject(DBusError *error)
             error->set(TP_QT_ERROR_INVALID_ARGUMENT,
                        mPriv->protocolName + QLatin1String("is not a valid protocol name"));
         }
-        debug() << "Unable to register connection - invalid protocol name";
+        tpDebug(DebugCategoryService) << "Unable to register connection - invalid protocol name";
         return false;
     }
 
     QString escapedProtocolName = mPriv->protocolName;
     escapedProtocolName.replace(QLatin1Char('-'), QLatin1Char('_'));
     QString name = uniqueName();
-    debug() << "cmName: " << mPriv->cmName << " escapedProtocolName: " << escapedProtocolName << " name:" << name;
+    tpDebug(DebugCategoryService) << "cmName: " << mPriv->cmName << " escapedProtocolName: " << escapedProtocolName << " name:" << name;
     QString busName = QString(QLatin1String("%1%2.%3.%4"))
                       .arg(TP_QT_CONNECTION_BUS_NAME_BASE, mPriv->cmName, escapedProtocolName, name);
     QString objectPath = QString(QLatin1String("%1%2/%3/%4"))
                          .arg(TP_QT_CONNECTION_OBJECT_PATH_BASE, mPriv->cmName, escapedProtocolName, name);
-    debug() << "busName: " << busName << " objectName: " << objectPath;
+    tpDebug(DebugCategoryService) << "busName: " << busName << " objectName: " << objectPath;
     DBusError _error;
 
-    debug() << "Connection: registering interfaces  at " << dbusObject();
+    tpDebug(DebugCategoryService) << "Connection: registering interfaces  at " << dbusObject();
     foreach(const AbstractConnectionInterfacePtr & iface, mPriv->interfaces) {
         if (!iface->registerInterface(dbusObject())) {
             // lets not fail if an optional interface fails registering, lets warn only
@@ -769,6 +1270,9 @@ bool BaseConnection::registerObject(const QString &busName,
  * It is warranted, that the type of the channel meets the requested type.
  *
  * The default implementation compares TargetHandleType and TargetHandle/TargetID.
+ * Unless custom channel matching is enabled with setCustomChannelMatching(), this method is
+ * only called for the channels having the requested target, so reimplementations can only
+ * reject candidates there.
  * If \a error is passed, any error that may occur will be stored there.
  *
  * \param channel A pointer to a channel to be checked.
@@ -782,16 +1286,17 @@ bool BaseConnection::matchChannel(const BaseChannelPtr &channel, const QVariantM
 {
     Q_UNUSED(error);
 
-    if (request.contains(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandleType"))) {
-        uint targetHandleType = request.value(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandleType")).toUInt();
+    const ChannelRequestKeys *keys = channelRequestKeys();
+    if (request.contains(keys->targetHandleType)) {
+        uint targetHandleType = request.value(keys->targetHandleType).toUInt();
         if (channel->targetHandleType() != targetHandleType) {
             return false;
         }
-        if (request.contains(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandle"))) {
-            uint targetHandle = request.value(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandle")).toUInt();
+        if (request.contains(keys->targetHandle)) {
+            uint targetHandle = request.value(keys->targetHandle).toUInt();
             return channel->targetHandle() == targetHandle;
-        } else  if (request.contains(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetID"))) {
-            const QString targetID = request.value(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetID")).toString();
+        } else  if (request.contains(keys->targetID)) {
+            const QString targetID = request.value(keys->targetID).toString();
             return channel->targetID() == targetID;
         } else {
             // Request is not valid
@@ -803,6 +1308,33 @@ bool BaseConnection::matchChannel(const BaseChannelPtr &channel, const QVariantM
     return false;
 }
 
+/**
+ * Return whether getExistingChannel() calls matchChannel() for all the existing channels
+ * of the requested type instead of looking up candidates by their target.
+ *
+ * \return \c true if custom channel matching is enabled, \c false otherwise.
+ * \sa setCustomChannelMatching()
+ */
+bool BaseConnection::hasCustomChannelMatching() const
+{
+    return mPriv->customChannelMatching;
+}
+
+/**
+ * Set whether getExistingChannel() should call matchChannel() for all the existing channels
+ * of the requested type.
+ *
+ * Subclasses reimplementing matchChannel() to accept channels by other properties than
+ * TargetHandleType and TargetHandle/TargetID must enable this. It is disabled by default.
+ *
+ * \param enabled Whether to enable custom channel matching.
+ * \sa hasCustomChannelMatching(), matchChannel()
+ */
+void BaseConnection::setCustomChannelMatching(bool enabled)
+{
+    mPriv->customChannelMatching = enabled;
+}
+
 /**
  * \fn void BaseConnection::disconnected()
  *
@@ -832,6 +1364,19 @@ void AbstractConnectionInterface::setBaseConnection(BaseConnection *connection)
 }
 
 // Conn.I.Requests
+struct TP_QT_NO_EXPORT BaseConnectionRequestsInterface::Private {
+    Private(BaseConnectionRequestsInterface *parent, BaseConnection *connection_)
+        : connection(connection_), adaptee(new BaseConnectionRequestsInterface::Adaptee(parent)) {
+    }
+    BaseConnection *connection;
+    BaseConnectionRequestsInterface::Adaptee *adaptee;
+
+    // EnsureChannel calls waiting for the one in flight for the same target, which answers
+    // them with yours set to false once its channel exists
+    typedef QPair<QVariantMap, Service::ConnectionInterfaceRequestsAdaptor::EnsureChannelContextPtr> PendingEnsure;
+    QHash<ChannelTargetKey, QList<PendingEnsure> > pendingEnsures;
+};
+
 BaseConnectionRequestsInterface::Adaptee::Adaptee(BaseConnectionRequestsInterface *interface)
     : QObject(interface),
       mInterface(interface)
@@ -845,41 +1390,68 @@ BaseConnectionRequestsInterface::Adaptee::~Adaptee()
 void BaseConnectionRequestsInterface::Adaptee::ensureChannel(const QVariantMap &request,
         const Tp::Service::ConnectionInterfaceRequestsAdaptor::EnsureChannelContextPtr &context)
 {
+    if (!request.contains(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType"))) {
+        context->setFinishedWithError(TP_QT_ERROR_INVALID_ARGUMENT, QLatin1String("Missing parameters"));
+        return;
+    }
+
+    BaseConnection *connection = mInterface->mPriv->connection;
     DBusError error;
-    bool yours;
-    QDBusObjectPath channel;
-    QVariantMap details;
 
-    mInterface->ensureChannel(request, yours, channel, details, &error);
+    BaseChannelPtr channel = connection->getExistingChannel(request, &error);
     if (error.isValid()) {
         context->setFinishedWithError(error.name(), error.message());
         return;
     }
-    context->setFinished(yours, channel, details);
+    if (channel) {
+        context->setFinished(false, QDBusObjectPath(channel->objectPath()),
+                channel->details().properties);
+        return;
+    }
+
+    ChannelTargetKey key(QString(), 0, 0);
+    if (channelTargetKey(request, &key)) {
+        QHash<ChannelTargetKey, QList<Private::PendingEnsure> >::iterator pending =
+            mInterface->mPriv->pendingEnsures.find(key);
+        if (pending != mInterface->mPriv->pendingEnsures.end()) {
+            pending->append(qMakePair(request, context));
+            return;
+        }
+        mInterface->mPriv->pendingEnsures.insert(key, QList<Private::PendingEnsure>());
+    }
+
+    connection->createChannel(request, /* suppressHandler */ true,
+            DeferredReply<BaseChannelPtr>(SharedPtr<DeferredReply<BaseChannelPtr>::Handler>(
+                    new EnsureChannelReply(this, request,
+                        ChannelContextReply<Service::ConnectionInterfaceRequestsAdaptor::EnsureChannelContextPtr>::create(context)))));
 }
 
-void BaseConnectionRequestsInterface::Adaptee::createChannel(const QVariantMap &request,
-        const Tp::Service::ConnectionInterfaceRequestsAdaptor::CreateChannelContextPtr &context)
+void BaseConnectionRequestsInterface::Adaptee::resumeEnsures(const QVariantMap &request)
 {
-    DBusError error;
-    QDBusObjectPath channel;
-    QVariantMap details;
-
-    mInterface->createChannel(request, channel, details, &error);
-    if (error.isValid()) {
-        context->setFinishedWithError(error.name(), error.message());
+    ChannelTargetKey key(QString(), 0, 0);
+    if (!channelTargetKey(request, &key)) {
         return;
     }
-    context->setFinished(channel, details);
+
+    // Those waiting are answered with the new channel, or if the creation failed the first
+    // of them tries again, with the others waiting for it in turn
+    QList<Private::PendingEnsure> waiting = mInterface->mPriv->pendingEnsures.take(key);
+    foreach (const Private::PendingEnsure &pending, waiting) {
+        ensureChannel(pending.first, pending.second);
+    }
 }
 
-struct TP_QT_NO_EXPORT BaseConnectionRequestsInterface::Private {
-    Private(BaseConnectionRequestsInterface *parent, BaseConnection *connection_)
-        : connection(connection_), adaptee(new BaseConnectionRequestsInterface::Adaptee(parent)) {
+void BaseConnectionRequestsInterface::Adaptee::createChannel(const QVariantMap &request,
+        const Tp::Service::ConnectionInterfaceRequestsAdaptor::CreateChannelContextPtr &context)
+{
+    if (!request.contains(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType"))) {
+        context->setFinishedWithError(TP_QT_ERROR_INVALID_ARGUMENT, QLatin1String("Missing parameters"));
+        return;
     }
-    BaseConnection *connection;
-    BaseConnectionRequestsInterface::Adaptee *adaptee;
-};
+
+    mInterface->mPriv->connection->createChannel(request, /* suppressHandler */ true,
+            ChannelContextReply<Service::ConnectionInterfaceRequestsAdaptor::CreateChannelContextPtr>::create(context));
+}
 
 /**
  * \class BaseConnectionRequestsInterface
@@ -982,12 +1554,38 @@ struct TP_QT_NO_EXPORT BaseConnectionContactsInterface::Private {
     {
     }
 
+    uint ensureContactHandle(const QString &identifier, DBusError *error) const;
+
     QStringList contactAttributeInterfaces;
     GetContactAttributesCallback getContactAttributesCB;
+    GetContactAttributesAsyncCallback getContactAttributesAsyncCB;
     BaseConnection *connection;
     BaseConnectionContactsInterface::Adaptee *adaptee;
 };
 
+uint BaseConnectionContactsInterface::Private::ensureContactHandle(const QString &identifier,
+        DBusError *error) const
+{
+    Tp::UIntList handles;
+    BaseHandleRepositoryPtr repository = connection->handleRepository(Tp::HandleTypeContact);
+    if (repository) {
+        uint contactHandle = repository->ensureHandle(identifier, error);
+        if (contactHandle) {
+            handles << contactHandle;
+        }
+    } else {
+        handles = connection->requestHandles(Tp::HandleTypeContact, QStringList() << identifier, error);
+    }
+
+    if (error->isValid() || handles.isEmpty()) {
+        // The check for empty handles is paranoid, because the error must be set in such case.
+        error->set(TP_QT_ERROR_INVALID_HANDLE, QLatin1String("Could not process ID"));
+        return 0;
+    }
+
+    return handles.first();
+}
+
 BaseConnectionContactsInterface::Adaptee::Adaptee(BaseConnectionContactsInterface *interface)
     : QObject(interface),
       mInterface(interface)
@@ -1006,29 +1604,38 @@ QStringList BaseConnectionContactsInterface::Adaptee::contactAttributeInterfaces
 void BaseConnectionContactsInterface::Adaptee::getContactAttributes(const Tp::UIntList &handles, const QStringList &interfaces, bool /* hold */,
         const Tp::Service::ConnectionInterfaceContactsAdaptor::GetContactAttributesContextPtr &context)
 {
-    DBusError error;
-    Tp::ContactAttributesMap attributes = mInterface->getContactAttributes(handles, interfaces, &error);
-    if (error.isValid()) {
-        context->setFinishedWithError(error.name(), error.message());
-        return;
-    }
-    context->setFinished(attributes);
+    mInterface->getContactAttributes(handles, interfaces,
+            DeferredReply<Tp::ContactAttributesMap>::forContext(context));
 }
 
 void BaseConnectionContactsInterface::Adaptee::getContactByID(const QString &identifier, const QStringList &interfaces,
         const Tp::Service::ConnectionInterfaceContactsAdaptor::GetContactByIDContextPtr &context)
 {
-    debug() << "BaseConnectionContactsInterface::Adaptee::getContactByID";
+    tpDebug(DebugCategoryService) << "BaseConnectionContactsInterface::Adaptee::getContactByID";
     DBusError error;
     uint handle;
     QVariantMap attributes;
 
-    mInterface->getContactByID(identifier, interfaces, handle, attributes, &error);
+    if (!mInterface->mPriv->getContactAttributesAsyncCB.isValid()) {
+        mInterface->getContactByID(identifier, interfaces, handle, attributes, &error);
+        if (error.isValid()) {
+            context->setFinishedWithError(error.name(), error.message());
+            return;
+        }
+        context->setFinished(handle, attributes);
+        return;
+    }
+
+    handle = mInterface->mPriv->ensureContactHandle(identifier, &error);
     if (error.isValid()) {
         context->setFinishedWithError(error.name(), error.message());
         return;
     }
-    context->setFinished(handle, attributes);
+
+    mInterface->getContactAttributes(Tp::UIntList() << handle, interfaces,
+            DeferredReply<Tp::ContactAttributesMap>(
+                SharedPtr<DeferredReply<Tp::ContactAttributesMap>::Handler>(
+                    new ContactByIDReply(handle, context))));
 }
 
 /**
@@ -1107,22 +1714,67 @@ Tp::ContactAttributesMap BaseConnectionContactsInterface::getContactAttributes(c
     return mPriv->getContactAttributesCB(handles, interfaces, error);
 }
 
+/**
+ * Set the callback used to get contact attributes asynchronously.
+ *
+ * The callback receives the handles, the interfaces and a DeferredReply which it finishes
+ * with the attributes of the contacts, or with an error.
+ *
+ * If set, this callback is used for the GetContactAttributes and GetContactByID D-Bus methods
+ * instead of the synchronous one.
+ *
+ * \param cb The callback.
+ * \sa getContactAttributes()
+ */
+void BaseConnectionContactsInterface::setGetContactAttributesAsyncCallback(const GetContactAttributesAsyncCallback &cb)
+{
+    mPriv->getContactAttributesAsyncCB = cb;
+}
+
+/**
+ * Get the attributes of the contacts with the given \a handles and finish \a reply with them.
+ *
+ * The callback set with setGetContactAttributesAsyncCallback() is used if there is one,
+ * otherwise the attributes are got with the synchronous callback and \a reply is finished
+ * before this method returns.
+ *
+ * \param handles The contact handles.
+ * \param interfaces The interfaces to get the attributes of.
+ * \param reply The reply to finish with the attributes or an error.
+ * \sa setGetContactAttributesAsyncCallback()
+ */
+void BaseConnectionContactsInterface::getContactAttributes(const Tp::UIntList &handles,
+        const QStringList &interfaces, const DeferredReply<Tp::ContactAttributesMap> &reply)
+{
+    if (mPriv->getContactAttributesAsyncCB.isValid()) {
+        mPriv->getContactAttributesAsyncCB(handles, interfaces, reply);
+        return;
+    }
+
+    DBusError error;
+    Tp::ContactAttributesMap attributes = getContactAttributes(handles, interfaces, &error);
+    if (error.isValid()) {
+        reply.setFinishedWithError(error);
+        return;
+    }
+    reply.setFinished(attributes);
+}
+
 void BaseConnectionContactsInterface::getContactByID(const QString &identifier, const QStringList &interfaces, uint &handle, QVariantMap &attributes, DBusError *error)
 {
-    const Tp::UIntList handles = mPriv->connection->requestHandles(Tp::HandleTypeContact, QStringList() << identifier, error);
-    if (error->isValid() || handles.isEmpty()) {
-        // The check for empty handles is paranoid, because the error must be set in such case.
-        error->set(TP_QT_ERROR_INVALID_HANDLE, QLatin1String("Could not process ID"));
+    const uint contactHandle = mPriv->ensureContactHandle(identifier, error);
+    if (error->isValid()) {
         return;
     }
 
-    const Tp::ContactAttributesMap result = getContactAttributes(handles, interfaces, error);
+    const Tp::ContactAttributesMap result = getContactAttributes(Tp::UIntList() << contactHandle,
+            interfaces, error);
 
     if (error->isValid()) {
         return;
     }
 
-    handle = handles.first();
+    handle = contactHandle;
     attributes = result.value(handle);
 }
 
@@ -1140,7 +1792,8 @@ BaseConnectionSimplePresenceInterface::Adaptee::~Adaptee()
 struct TP_QT_NO_EXPORT BaseConnectionSimplePresenceInterface::Private {
     Private(BaseConnectionSimplePresenceInterface *parent)
         : maximumStatusMessageLength(0),
-          adaptee(new BaseConnectionSimplePresenceInterface::Adaptee(parent)) {
+          adaptee(new BaseConnectionSimplePresenceInterface::Adaptee(parent)),
+          pendingPresences(adaptee, SLOT(flushChanges())) {
     }
     SetPresenceCallback setPresenceCB;
     SimpleStatusSpecMap statuses;
@@ -1148,6 +1801,8 @@ struct TP_QT_NO_EXPORT BaseConnectionSimplePresenceInterface::Private {
     /* The current presences */
     SimpleContactPresences presences;
     BaseConnectionSimplePresenceInterface::Adaptee *adaptee;
+    /* The presences changed since the last PresencesChanged signal */
+    ContactChangeAggregator<SimplePresence> pendingPresences;
 };
 
 /**
@@ -1156,6 +1811,10 @@ struct TP_QT_NO_EXPORT BaseConnectionSimplePresenceInterface::Private {
  * \headerfile TelepathyQt/base-connection.h <TelepathyQt/BaseConnection>
  *
  * \brief Base class for implementations of Connection.Interface.SimplePresence
+ *
+ * Presence changes passed to setPresences() are merged per contact and signalled together in a
+ * single PresencesChanged signal, once per iteration of the event loop by default. See
+ * setChangeAggregationInterval() to change this.
  */
 
 /**
@@ -1187,12 +1846,18 @@ void BaseConnectionSimplePresenceInterface::setPresences(const Tp::SimpleContact
 {
     Tp::SimpleContactPresences newPresences;
 
-    foreach(uint handle, presences.keys()) {
-        if (mPriv->presences.contains(handle) && mPriv->presences.value(handle) == presences.value(handle)) {
+    for (SimpleContactPresences::const_iterator i = presences.constBegin(); i != presences.constEnd(); ++i) {
+        SimpleContactPresences::iterator current = mPriv->presences.find(i.key());
+        if (current != mPriv->presences.end() && current.value() == i.value()) {
             continue;
         }
-        mPriv->presences[handle] = presences[handle];
-        newPresences[handle] = presences[handle];
+        mPriv->presences.insert(i.key(), i.value());
+
+        if (mPriv->pendingPresences.isEnabled()) {
+            mPriv->pendingPresences.insert(i.key(), i.value());
+        } else {
+            newPresences.insert(i.key(), i.value());
+        }
     }
 
     if (!newPresences.isEmpty()) {
@@ -1200,6 +1865,56 @@ void BaseConnectionSimplePresenceInterface::setPresences(const Tp::SimpleContact
     }
 }
 
+/**
+ * Return the interval at which presence changes are signalled.
+ *
+ * \return The interval in milliseconds, 0 if changes are signalled once per iteration of the
+ *         event loop, or a negative value if they are signalled as they are set.
+ * \sa setChangeAggregationInterval()
+ */
+int BaseConnectionSimplePresenceInterface::changeAggregationInterval() const
+{
+    return mPriv->pendingPresences.interval();
+}
+
+/**
+ * Set the interval at which presence changes are signalled.
+ *
+ * Changes passed to setPresences() during the interval are merged, keeping the last presence of
+ * each contact, and sent in one PresencesChanged signal. This saves clients from handling a
+ * signal per contact when a backend receives presences one at a time, for instance just after
+ * connecting. The default is 0, which signals the changes when the event loop runs again.
+ *
+ * Changes to the presence of the user are signalled right away when they are made with the
+ * SetPresence method. Use flushChanges() to do the same for other changes.
+ *
+ * \param msec The interval in milliseconds, or a negative value to signal each change as it is
+ *             set.
+ * \sa changeAggregationInterval(), flushChanges()
+ */
+void BaseConnectionSimplePresenceInterface::setChangeAggregationInterval(int msec)
+{
+    if (msec < 0) {
+        flushChanges();
+    }
+    mPriv->pendingPresences.setInterval(msec);
+}
+
+/**
+ * Signal the presence changes which are waiting for the aggregation interval to end.
+ *
+ * \sa setChangeAggregationInterval()
+ */
+void BaseConnectionSimplePresenceInterface::flushChanges()
+{
+    if (mPriv->pendingPresences.isEmpty()) {
+        return;
+    }
+
+    const SimpleContactPresences presences = mPriv->pendingPresences.take();
+    QMetaObject::invokeMethod(mPriv->adaptee, "presencesChanged", Q_ARG(Tp::SimpleContactPresences, presences)); //Can simply use emit in Qt5
+}
+
 void BaseConnectionSimplePresenceInterface::setSetPresenceCallback(const SetPresenceCallback &cb)
 {
     mPriv->setPresenceCB = cb;
@@ -1263,7 +1978,8 @@ void BaseConnectionSimplePresenceInterface::Adaptee::setPresence(const QString &
 
     QString statusMessage = statusMessage_;
     if ((uint)statusMessage.length() > mInterface->mPriv->maximumStatusMessageLength) {
-        debug() << "BaseConnectionSimplePresenceInterface::Adaptee::setPresence: "
+        tpDebug(DebugCategoryService) <<
+            "BaseConnectionSimplePresenceInterface::Adaptee::setPresence: "
                 << "truncating status to " << mInterface->mPriv->maximumStatusMessageLength;
         statusMessage = statusMessage.left(mInterface->mPriv->maximumStatusMessageLength);
     }
@@ -1281,15 +1997,27 @@ void BaseConnectionSimplePresenceInterface::Adaptee::setPresence(const QString &
     mInterface->mPriv->presences[selfHandle] = presence;
 
     /* Emit PresencesChanged */
-    SimpleContactPresences presences;
-    presences[selfHandle] = presence;
-    //emit after return
-    QMetaObject::invokeMethod(mInterface->mPriv->adaptee, "presencesChanged",
-                              Qt::QueuedConnection,
-                              Q_ARG(Tp::SimpleContactPresences, presences));
+    if (mInterface->mPriv->pendingPresences.isEnabled()) {
+        // Do not make the user wait for the aggregation interval, send it with whatever is pending
+        mInterface->mPriv->pendingPresences.insert(selfHandle, presence);
+        //emit after return
+        QMetaObject::invokeMethod(this, "flushChanges", Qt::QueuedConnection);
+    } else {
+        SimpleContactPresences presences;
+        presences[selfHandle] = presence;
+        //emit after return
+        QMetaObject::invokeMethod(mInterface->mPriv->adaptee, "presencesChanged",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(Tp::SimpleContactPresences, presences));
+    }
     context->setFinished();
 }
 
+void BaseConnectionSimplePresenceInterface::Adaptee::flushChanges()
+{
+    mInterface->flushChanges();
+}
+
 void BaseConnectionSimplePresenceInterface::Adaptee::getPresences(const Tp::UIntList &contacts,
         const Tp::Service::ConnectionInterfaceSimplePresenceAdaptor::GetPresencesContextPtr &context)
 {
@@ -1361,7 +2089,8 @@ bool BaseConnectionContactListInterface::Adaptee::downloadAtConnection() const
 void BaseConnectionContactListInterface::Adaptee::getContactListAttributes(const QStringList &interfaces, bool hold,
         const Tp::Service::ConnectionInterfaceContactListAdaptor::GetContactListAttributesContextPtr &context)
 {
-    debug() << "BaseConnectionContactListInterface::Adaptee::getContactListAttributes";
+    tpDebug(DebugCategoryService) <<
+        "BaseConnectionContactListInterface::Adaptee::getContactListAttributes";
     DBusError error;
     Tp::ContactAttributesMap attributes = mInterface->getContactListAttributes(interfaces, hold, &error);
     if (error.isValid()) {
@@ -1374,7 +2103,8 @@ void BaseConnectionContactListInterface::Adaptee::getContactListAttributes(const
 void BaseConnectionContactListInterface::Adaptee::requestSubscription(const Tp::UIntList &contacts, const QString &message,
         const Tp::Service::ConnectionInterfaceContactListAdaptor::RequestSubscriptionContextPtr &context)
 {
-    debug() << "BaseConnectionContactListInterface::Adaptee::requestSubscription";
+    tpDebug(DebugCategoryService) <<
+        "BaseConnectionContactListInterface::Adaptee::requestSubscription";
     DBusError error;
     mInterface->requestSubscription(contacts, message, &error);
     if (error.isValid()) {
@@ -1387,7 +2117,8 @@ void BaseConnectionContactListInterface::Adaptee::requestSubscription(const Tp::
 void BaseConnectionContactListInterface::Adaptee::authorizePublication(const Tp::UIntList &contacts,
         const Tp::Service::ConnectionInterfaceContactListAdaptor::AuthorizePublicationContextPtr &context)
 {
-    debug() << "BaseConnectionContactListInterface::Adaptee::authorizePublication";
+    tpDebug(DebugCategoryService) <<
+        "BaseConnectionContactListInterface::Adaptee::authorizePublication";
     DBusError error;
     mInterface->authorizePublication(contacts, &error);
     if (error.isValid()) {
@@ -1400,7 +2131,7 @@ void BaseConnectionContactListInterface::Adaptee::authorizePublication(const Tp:
 void BaseConnectionContactListInterface::Adaptee::removeContacts(const Tp::UIntList &contacts,
         const Tp::Service::ConnectionInterfaceContactListAdaptor::RemoveContactsContextPtr &context)
 {
-    debug() << "BaseConnectionContactListInterface::Adaptee::removeContacts";
+    tpDebug(DebugCategoryService) << "BaseConnectionContactListInterface::Adaptee::removeContacts";
     DBusError error;
     mInterface->removeContacts(contacts, &error);
     if (error.isValid()) {
@@ -1413,7 +2144,7 @@ void BaseConnectionContactListInterface::Adaptee::removeContacts(const Tp::UIntL
 void BaseConnectionContactListInterface::Adaptee::unsubscribe(const Tp::UIntList &contacts,
         const Tp::Service::ConnectionInterfaceContactListAdaptor::UnsubscribeContextPtr &context)
 {
-    debug() << "BaseConnectionContactListInterface::Adaptee::unsubscribe";
+    tpDebug(DebugCategoryService) << "BaseConnectionContactListInterface::Adaptee::unsubscribe";
     DBusError error;
     mInterface->unsubscribe(contacts, &error);
     if (error.isValid()) {
@@ -1426,7 +2157,7 @@ void BaseConnectionContactListInterface::Adaptee::unsubscribe(const Tp::UIntList
 void BaseConnectionContactListInterface::Adaptee::unpublish(const Tp::UIntList &contacts,
         const Tp::Service::ConnectionInterfaceContactListAdaptor::UnpublishContextPtr &context)
 {
-    debug() << "BaseConnectionContactListInterface::Adaptee::unpublish";
+    tpDebug(DebugCategoryService) << "BaseConnectionContactListInterface::Adaptee::unpublish";
     DBusError error;
     mInterface->unpublish(contacts, &error);
     if (error.isValid()) {
@@ -1439,7 +2170,7 @@ void BaseConnectionContactListInterface::Adaptee::unpublish(const Tp::UIntList &
 void BaseConnectionContactListInterface::Adaptee::download(
         const Tp::Service::ConnectionInterfaceContactListAdaptor::DownloadContextPtr &context)
 {
-    debug() << "BaseConnectionContactListInterface::Adaptee::download";
+    tpDebug(DebugCategoryService) << "BaseConnectionContactListInterface::Adaptee::download";
     DBusError error;
     mInterface->download(&error);
     if (error.isValid()) {
@@ -1688,7 +2419,8 @@ QStringList BaseConnectionContactGroupsInterface::Adaptee::groups() const
 void BaseConnectionContactGroupsInterface::Adaptee::setContactGroups(uint contact, const QStringList &groups,
         const Tp::Service::ConnectionInterfaceContactGroupsAdaptor::SetContactGroupsContextPtr &context)
 {
-    debug() << "BaseConnectionContactGroupsInterface::Adaptee::setContactGroups";
+    tpDebug(DebugCategoryService) <<
+        "BaseConnectionContactGroupsInterface::Adaptee::setContactGroups";
     DBusError error;
     mInterface->setContactGroups(contact, groups, &error);
     if (error.isValid()) {
@@ -1701,7 +2433,8 @@ void BaseConnectionContactGroupsInterface::Adaptee::setContactGroups(uint contac
 void BaseConnectionContactGroupsInterface::Adaptee::setGroupMembers(const QString &group, const Tp::UIntList &members,
         const Tp::Service::ConnectionInterfaceContactGroupsAdaptor::SetGroupMembersContextPtr &context)
 {
-    debug() << "BaseConnectionContactGroupsInterface::Adaptee::setGroupMembers";
+    tpDebug(DebugCategoryService) <<
+        "BaseConnectionContactGroupsInterface::Adaptee::setGroupMembers";
     DBusError error;
     mInterface->setGroupMembers(group, members, &error);
     if (error.isValid()) {
@@ -1714,7 +2447,7 @@ void BaseConnectionContactGroupsInterface::Adaptee::setGroupMembers(const QStrin
 void BaseConnectionContactGroupsInterface::Adaptee::addToGroup(const QString &group, const Tp::UIntList &members,
         const Tp::Service::ConnectionInterfaceContactGroupsAdaptor::AddToGroupContextPtr &context)
 {
-    debug() << "BaseConnectionContactGroupsInterface::Adaptee::addToGroup";
+    tpDebug(DebugCategoryService) << "BaseConnectionContactGroupsInterface::Adaptee::addToGroup";
     DBusError error;
     mInterface->addToGroup(group, members, &error);
     if (error.isValid()) {
@@ -1727,7 +2460,8 @@ void BaseConnectionContactGroupsInterface::Adaptee::addToGroup(const QString &gr
 void BaseConnectionContactGroupsInterface::Adaptee::removeFromGroup(const QString &group, const Tp::UIntList &members,
         const Tp::Service::ConnectionInterfaceContactGroupsAdaptor::RemoveFromGroupContextPtr &context)
 {
-    debug() << "BaseConnectionContactGroupsInterface::Adaptee::removeFromGroup";
+    tpDebug(DebugCategoryService) <<
+        "BaseConnectionContactGroupsInterface::Adaptee::removeFromGroup";
     DBusError error;
     mInterface->removeFromGroup(group, members, &error);
     if (error.isValid()) {
@@ -1740,7 +2474,7 @@ void BaseConnectionContactGroupsInterface::Adaptee::removeFromGroup(const QStrin
 void BaseConnectionContactGroupsInterface::Adaptee::removeGroup(const QString &group,
         const Tp::Service::ConnectionInterfaceContactGroupsAdaptor::RemoveGroupContextPtr &context)
 {
-    debug() << "BaseConnectionContactGroupsInterface::Adaptee::removeGroup";
+    tpDebug(DebugCategoryService) << "BaseConnectionContactGroupsInterface::Adaptee::removeGroup";
     DBusError error;
     mInterface->removeGroup(group, &error);
     if (error.isValid()) {
@@ -1753,7 +2487,7 @@ void BaseConnectionContactGroupsInterface::Adaptee::removeGroup(const QString &g
 void BaseConnectionContactGroupsInterface::Adaptee::renameGroup(const QString &oldName, const QString &newName,
         const Tp::Service::ConnectionInterfaceContactGroupsAdaptor::RenameGroupContextPtr &context)
 {
-    debug() << "BaseConnectionContactGroupsInterface::Adaptee::renameGroup";
+    tpDebug(DebugCategoryService) << "BaseConnectionContactGroupsInterface::Adaptee::renameGroup";
     DBusError error;
     mInterface->renameGroup(oldName, newName, &error);
     if (error.isValid()) {
@@ -1973,7 +2707,7 @@ Tp::FieldSpecs BaseConnectionContactInfoInterface::Adaptee::supportedFields() co
 void BaseConnectionContactInfoInterface::Adaptee::getContactInfo(const Tp::UIntList &contacts,
         const Tp::Service::ConnectionInterfaceContactInfoAdaptor::GetContactInfoContextPtr &context)
 {
-    debug() << "BaseConnectionContactInfoInterface::Adaptee::getContactInfo";
+    tpDebug(DebugCategoryService) << "BaseConnectionContactInfoInterface::Adaptee::getContactInfo";
     DBusError error;
     Tp::ContactInfoMap contactInfo = mInterface->getContactInfo(contacts, &error);
     if (error.isValid()) {
@@ -1986,7 +2720,8 @@ void BaseConnectionContactInfoInterface::Adaptee::getContactInfo(const Tp::UIntL
 void BaseConnectionContactInfoInterface::Adaptee::refreshContactInfo(const Tp::UIntList &contacts,
         const Tp::Service::ConnectionInterfaceContactInfoAdaptor::RefreshContactInfoContextPtr &context)
 {
-    debug() << "BaseConnectionContactInfoInterface::Adaptee::refreshContactInfo";
+    tpDebug(DebugCategoryService) <<
+        "BaseConnectionContactInfoInterface::Adaptee::refreshContactInfo";
     DBusError error;
     mInterface->refreshContactInfo(contacts, &error);
     if (error.isValid()) {
@@ -1999,7 +2734,8 @@ void BaseConnectionContactInfoInterface::Adaptee::refreshContactInfo(const Tp::U
 void BaseConnectionContactInfoInterface::Adaptee::requestContactInfo(uint contact,
         const Tp::Service::ConnectionInterfaceContactInfoAdaptor::RequestContactInfoContextPtr &context)
 {
-    debug() << "BaseConnectionContactInfoInterface::Adaptee::requestContactInfo";
+    tpDebug(DebugCategoryService) <<
+        "BaseConnectionContactInfoInterface::Adaptee::requestContactInfo";
     DBusError error;
     Tp::ContactInfoFieldList contactInfo = mInterface->requestContactInfo(contact, &error);
     if (error.isValid()) {
@@ -2012,7 +2748,7 @@ void BaseConnectionContactInfoInterface::Adaptee::requestContactInfo(uint contac
 void BaseConnectionContactInfoInterface::Adaptee::setContactInfo(const Tp::ContactInfoFieldList &contactInfo,
         const Tp::Service::ConnectionInterfaceContactInfoAdaptor::SetContactInfoContextPtr &context)
 {
-    debug() << "BaseConnectionContactInfoInterface::Adaptee::setContactInfo";
+    tpDebug(DebugCategoryService) << "BaseConnectionContactInfoInterface::Adaptee::setContactInfo";
     DBusError error;
     mInterface->setContactInfo(contactInfo, &error);
     if (error.isValid()) {
@@ -2243,7 +2979,8 @@ void BaseConnectionAddressingInterface::Adaptee::getContactsByURI(const QStringL
 // Conn.I.Aliasing
 struct TP_QT_NO_EXPORT BaseConnectionAliasingInterface::Private {
     Private(BaseConnectionAliasingInterface *parent)
-        : adaptee(new BaseConnectionAliasingInterface::Adaptee(parent))
+        : adaptee(new BaseConnectionAliasingInterface::Adaptee(parent)),
+          pendingAliases(adaptee, SLOT(flushChanges()))
     {
     }
 
@@ -2252,6 +2989,7 @@ struct TP_QT_NO_EXPORT BaseConnectionAliasingInterface::Private {
     GetAliasesCallback getAliasesCB;
     SetAliasesCallback setAliasesCB;
     BaseConnectionAliasingInterface::Adaptee *adaptee;
+    ContactChangeAggregator<QString> pendingAliases;
 };
 
 BaseConnectionAliasingInterface::Adaptee::Adaptee(BaseConnectionAliasingInterface *interface)
@@ -2264,10 +3002,15 @@ BaseConnectionAliasingInterface::Adaptee::~Adaptee()
 {
 }
 
+void BaseConnectionAliasingInterface::Adaptee::flushChanges()
+{
+    mInterface->flushChanges();
+}
+
 void BaseConnectionAliasingInterface::Adaptee::getAliasFlags(
         const Tp::Service::ConnectionInterfaceAliasingAdaptor::GetAliasFlagsContextPtr &context)
 {
-    debug() << "BaseConnectionAliasingInterface::Adaptee::getAliasFlags";
+    tpDebug(DebugCategoryService) << "BaseConnectionAliasingInterface::Adaptee::getAliasFlags";
     DBusError error;
     Tp::ConnectionAliasFlags aliasFlags = mInterface->getAliasFlags(&error);
     if (error.isValid()) {
@@ -2280,7 +3023,7 @@ void BaseConnectionAliasingInterface::Adaptee::getAliasFlags(
 void BaseConnectionAliasingInterface::Adaptee::requestAliases(const Tp::UIntList &contacts,
         const Tp::Service::ConnectionInterfaceAliasingAdaptor::RequestAliasesContextPtr &context)
 {
-    debug() << "BaseConnectionAliasingInterface::Adaptee::requestAliases";
+    tpDebug(DebugCategoryService) << "BaseConnectionAliasingInterface::Adaptee::requestAliases";
     DBusError error;
     QStringList aliases = mInterface->requestAliases(contacts, &error);
     if (error.isValid()) {
@@ -2293,7 +3036,7 @@ void BaseConnectionAliasingInterface::Adaptee::requestAliases(const Tp::UIntList
 void BaseConnectionAliasingInterface::Adaptee::getAliases(const Tp::UIntList &contacts,
         const Tp::Service::ConnectionInterfaceAliasingAdaptor::GetAliasesContextPtr &context)
 {
-    debug() << "BaseConnectionAliasingInterface::Adaptee::getAliases";
+    tpDebug(DebugCategoryService) << "BaseConnectionAliasingInterface::Adaptee::getAliases";
     DBusError error;
     Tp::AliasMap aliases = mInterface->getAliases(contacts, &error);
     if (error.isValid()) {
@@ -2306,7 +3049,7 @@ void BaseConnectionAliasingInterface::Adaptee::getAliases(const Tp::UIntList &co
 void BaseConnectionAliasingInterface::Adaptee::setAliases(const Tp::AliasMap &aliases,
         const Tp::Service::ConnectionInterfaceAliasingAdaptor::SetAliasesContextPtr &context)
 {
-    debug() << "BaseConnectionAliasingInterface::Adaptee::setAliases";
+    tpDebug(DebugCategoryService) << "BaseConnectionAliasingInterface::Adaptee::setAliases";
     DBusError error;
     mInterface->setAliases(aliases, &error);
     if (error.isValid()) {
@@ -2405,13 +3148,76 @@ void BaseConnectionAliasingInterface::setAliases(const Tp::AliasMap &aliases, DB
 
 void BaseConnectionAliasingInterface::aliasesChanged(const Tp::AliasPairList &aliases)
 {
+    if (!mPriv->pendingAliases.isEnabled()) {
+        QMetaObject::invokeMethod(mPriv->adaptee, "aliasesChanged", Q_ARG(Tp::AliasPairList, aliases)); //Can simply use emit in Qt5
+        return;
+    }
+
+    foreach (const Tp::AliasPair &pair, aliases) {
+        mPriv->pendingAliases.insert(pair.handle, pair.alias);
+    }
+}
+
+/**
+ * Return the interval at which alias changes are signalled.
+ *
+ * \return The interval in milliseconds, 0 if changes are signalled once per iteration of the
+ *         event loop, or a negative value if they are signalled as they are reported.
+ * \sa setChangeAggregationInterval()
+ */
+int BaseConnectionAliasingInterface::changeAggregationInterval() const
+{
+    return mPriv->pendingAliases.interval();
+}
+
+/**
+ * Set the interval at which alias changes are signalled.
+ *
+ * Changes passed to aliasesChanged() during the interval are merged, keeping the last alias of
+ * each contact, and sent in one AliasesChanged signal. The default is 0, which signals the
+ * changes when the event loop runs again.
+ *
+ * \param msec The interval in milliseconds, or a negative value to signal each change as it is
+ *             reported.
+ * \sa changeAggregationInterval(), flushChanges()
+ */
+void BaseConnectionAliasingInterface::setChangeAggregationInterval(int msec)
+{
+    if (msec < 0) {
+        flushChanges();
+    }
+    mPriv->pendingAliases.setInterval(msec);
+}
+
+/**
+ * Signal the alias changes which are waiting for the aggregation interval to end.
+ *
+ * This is useful after a change of the alias of the user.
+ *
+ * \sa setChangeAggregationInterval()
+ */
+void BaseConnectionAliasingInterface::flushChanges()
+{
+    if (mPriv->pendingAliases.isEmpty()) {
+        return;
+    }
+
+    const QMap<uint, QString> pendingAliases = mPriv->pendingAliases.take();
+    Tp::AliasPairList aliases;
+    for (QMap<uint, QString>::const_iterator i = pendingAliases.constBegin(); i != pendingAliases.constEnd(); ++i) {
+        Tp::AliasPair pair;
+        pair.handle = i.key();
+        pair.alias = i.value();
+        aliases << pair;
+    }
     QMetaObject::invokeMethod(mPriv->adaptee, "aliasesChanged", Q_ARG(Tp::AliasPairList, aliases)); //Can simply use emit in Qt5
 }
 
 // Conn.I.Avatars
 struct TP_QT_NO_EXPORT BaseConnectionAvatarsInterface::Private {
     Private(BaseConnectionAvatarsInterface *parent)
-        : adaptee(new BaseConnectionAvatarsInterface::Adaptee(parent))
+        : adaptee(new BaseConnectionAvatarsInterface::Adaptee(parent)),
+          pendingAvatarTokens(adaptee, SLOT(flushChanges()))
     {
     }
 
@@ -2421,6 +3227,7 @@ struct TP_QT_NO_EXPORT BaseConnectionAvatarsInterface::Private {
     SetAvatarCallback setAvatarCB;
     ClearAvatarCallback clearAvatarCB;
     BaseConnectionAvatarsInterface::Adaptee *adaptee;
+    ContactChangeAggregator<QString> pendingAvatarTokens;
 
     friend class BaseConnectionAvatarsInterface::Adaptee;
 };
@@ -2435,6 +3242,11 @@ BaseConnectionAvatarsInterface::Adaptee::~Adaptee()
 {
 }
 
+void BaseConnectionAvatarsInterface::Adaptee::flushChanges()
+{
+    mInterface->flushChanges();
+}
+
 QStringList BaseConnectionAvatarsInterface::Adaptee::supportedAvatarMimeTypes() const
 {
     return mInterface->mPriv->avatarDetails.supportedMimeTypes();
@@ -2478,7 +3290,8 @@ uint BaseConnectionAvatarsInterface::Adaptee::maximumAvatarBytes() const
 void BaseConnectionAvatarsInterface::Adaptee::getKnownAvatarTokens(const Tp::UIntList &contacts,
         const Tp::Service::ConnectionInterfaceAvatarsAdaptor::GetKnownAvatarTokensContextPtr &context)
 {
-    debug() << "BaseConnectionAvatarsInterface::Adaptee::getKnownAvatarTokens";
+    tpDebug(DebugCategoryService) <<
+        "BaseConnectionAvatarsInterface::Adaptee::getKnownAvatarTokens";
     DBusError error;
     Tp::AvatarTokenMap tokens = mInterface->getKnownAvatarTokens(contacts, &error);
     if (error.isValid()) {
@@ -2491,7 +3304,7 @@ void BaseConnectionAvatarsInterface::Adaptee::getKnownAvatarTokens(const Tp::UIn
 void BaseConnectionAvatarsInterface::Adaptee::requestAvatars(const Tp::UIntList &contacts,
         const Tp::Service::ConnectionInterfaceAvatarsAdaptor::RequestAvatarsContextPtr &context)
 {
-    debug() << "BaseConnectionAvatarsInterface::Adaptee::requestAvatars";
+    tpDebug(DebugCategoryService) << "BaseConnectionAvatarsInterface::Adaptee::requestAvatars";
     DBusError error;
     mInterface->requestAvatars(contacts, &error);
     if (error.isValid()) {
@@ -2504,7 +3317,7 @@ void BaseConnectionAvatarsInterface::Adaptee::requestAvatars(const Tp::UIntList
 void BaseConnectionAvatarsInterface::Adaptee::setAvatar(const QByteArray &avatar, const QString &mimeType,
         const Tp::Service::ConnectionInterfaceAvatarsAdaptor::SetAvatarContextPtr &context)
 {
-    debug() << "BaseConnectionAvatarsInterface::Adaptee::setAvatar";
+    tpDebug(DebugCategoryService) << "BaseConnectionAvatarsInterface::Adaptee::setAvatar";
     DBusError error;
     QString token = mInterface->setAvatar(avatar, mimeType, &error);
     if (error.isValid()) {
@@ -2517,7 +3330,7 @@ void BaseConnectionAvatarsInterface::Adaptee::setAvatar(const QByteArray &avatar
 void BaseConnectionAvatarsInterface::Adaptee::clearAvatar(
         const Tp::Service::ConnectionInterfaceAvatarsAdaptor::ClearAvatarContextPtr &context)
 {
-    debug() << "BaseConnectionAvatarsInterface::Adaptee::clearAvatar";
+    tpDebug(DebugCategoryService) << "BaseConnectionAvatarsInterface::Adaptee::clearAvatar";
     DBusError error;
     mInterface->clearAvatar(&error);
     if (error.isValid()) {
@@ -2626,9 +3439,61 @@ void BaseConnectionAvatarsInterface::clearAvatar(DBusError *error)
 
 void BaseConnectionAvatarsInterface::avatarUpdated(uint contact, const QString &newAvatarToken)
 {
+    if (mPriv->pendingAvatarTokens.isEnabled()) {
+        mPriv->pendingAvatarTokens.insert(contact, newAvatarToken);
+        return;
+    }
+
     QMetaObject::invokeMethod(mPriv->adaptee, "avatarUpdated", Q_ARG(uint, contact), Q_ARG(QString, newAvatarToken)); //Can simply use emit in Qt5
 }
 
+/**
+ * Return the interval at which avatar token changes are signalled.
+ *
+ * \return The interval in milliseconds, 0 if changes are signalled once per iteration of the
+ *         event loop, or a negative value if they are signalled as they are reported.
+ * \sa setChangeAggregationInterval()
+ */
+int BaseConnectionAvatarsInterface::changeAggregationInterval() const
+{
+    return mPriv->pendingAvatarTokens.interval();
+}
+
+/**
+ * Set the interval at which avatar token changes are signalled.
+ *
+ * Changes passed to avatarUpdated() during the interval are merged, keeping the last token of
+ * each contact. The Avatars interface has no signal for several contacts, so one AvatarUpdated
+ * signal is still sent per contact, but tokens replaced during the interval are never sent.
+ * The default is 0, which signals the changes when the event loop runs again.
+ *
+ * \param msec The interval in milliseconds, or a negative value to signal each change as it is
+ *             reported.
+ * \sa changeAggregationInterval(), flushChanges()
+ */
+void BaseConnectionAvatarsInterface::setChangeAggregationInterval(int msec)
+{
+    if (msec < 0) {
+        flushChanges();
+    }
+    mPriv->pendingAvatarTokens.setInterval(msec);
+}
+
+/**
+ * Signal the avatar token changes which are waiting for the aggregation interval to end.
+ *
+ * This is useful after a change of the avatar of the user.
+ *
+ * \sa setChangeAggregationInterval()
+ */
+void BaseConnectionAvatarsInterface::flushChanges()
+{
+    const QMap<uint, QString> tokens = mPriv->pendingAvatarTokens.take();
+    for (QMap<uint, QString>::const_iterator i = tokens.constBegin(); i != tokens.constEnd(); ++i) {
+        QMetaObject::invokeMethod(mPriv->adaptee, "avatarUpdated", Q_ARG(uint, i.key()), Q_ARG(QString, i.value())); //Can simply use emit in Qt5
+    }
+}
+
 void BaseConnectionAvatarsInterface::avatarRetrieved(uint contact, const QString &token, const QByteArray &avatar, const QString &type)
 {
     QMetaObject::invokeMethod(mPriv->adaptee, "avatarRetrieved", Q_ARG(uint, contact), Q_ARG(QString, token), Q_ARG(QByteArray, avatar), Q_ARG(QString, type)); //Can simply use emit in Qt5
@@ -2638,13 +3503,15 @@ void BaseConnectionAvatarsInterface::avatarRetrieved(uint contact, const QString
 // The BaseConnectionClientTypesInterface code is fully or partially generated by the TelepathyQt-Generator.
 struct TP_QT_NO_EXPORT BaseConnectionClientTypesInterface::Private {
     Private(BaseConnectionClientTypesInterface *parent)
-        : adaptee(new BaseConnectionClientTypesInterface::Adaptee(parent))
+        : adaptee(new BaseConnectionClientTypesInterface::Adaptee(parent)),
+          pendingClientTypes(adaptee, SLOT(flushChanges()))
     {
     }
 
     GetClientTypesCallback getClientTypesCB;
     RequestClientTypesCallback requestClientTypesCB;
     BaseConnectionClientTypesInterface::Adaptee *adaptee;
+    ContactChangeAggregator<QStringList> pendingClientTypes;
 };
 
 BaseConnectionClientTypesInterface::Adaptee::Adaptee(BaseConnectionClientTypesInterface *interface)
@@ -2657,10 +3524,15 @@ BaseConnectionClientTypesInterface::Adaptee::~Adaptee()
 {
 }
 
+void BaseConnectionClientTypesInterface::Adaptee::flushChanges()
+{
+    mInterface->flushChanges();
+}
+
 void BaseConnectionClientTypesInterface::Adaptee::getClientTypes(const Tp::UIntList &contacts,
         const Tp::Service::ConnectionInterfaceClientTypesAdaptor::GetClientTypesContextPtr &context)
 {
-    debug() << "BaseConnectionClientTypesInterface::Adaptee::getClientTypes";
+    tpDebug(DebugCategoryService) << "BaseConnectionClientTypesInterface::Adaptee::getClientTypes";
     DBusError error;
     Tp::ContactClientTypes clientTypes = mInterface->getClientTypes(contacts, &error);
     if (error.isValid()) {
@@ -2673,7 +3545,8 @@ void BaseConnectionClientTypesInterface::Adaptee::getClientTypes(const Tp::UIntL
 void BaseConnectionClientTypesInterface::Adaptee::requestClientTypes(uint contact,
         const Tp::Service::ConnectionInterfaceClientTypesAdaptor::RequestClientTypesContextPtr &context)
 {
-    debug() << "BaseConnectionClientTypesInterface::Adaptee::requestClientTypes";
+    tpDebug(DebugCategoryService) <<
+        "BaseConnectionClientTypesInterface::Adaptee::requestClientTypes";
     DBusError error;
     QStringList clientTypes = mInterface->requestClientTypes(contact, &error);
     if (error.isValid()) {
@@ -2744,9 +3617,59 @@ QStringList BaseConnectionClientTypesInterface::requestClientTypes(uint contact,
 
 void BaseConnectionClientTypesInterface::clientTypesUpdated(uint contact, const QStringList &clientTypes)
 {
+    if (mPriv->pendingClientTypes.isEnabled()) {
+        mPriv->pendingClientTypes.insert(contact, clientTypes);
+        return;
+    }
+
     QMetaObject::invokeMethod(mPriv->adaptee, "clientTypesUpdated", Q_ARG(uint, contact), Q_ARG(QStringList, clientTypes)); //Can simply use emit in Qt5
 }
 
+/**
+ * Return the interval at which client type changes are signalled.
+ *
+ * \return The interval in milliseconds, 0 if changes are signalled once per iteration of the
+ *         event loop, or a negative value if they are signalled as they are reported.
+ * \sa setChangeAggregationInterval()
+ */
+int BaseConnectionClientTypesInterface::changeAggregationInterval() const
+{
+    return mPriv->pendingClientTypes.interval();
+}
+
+/**
+ * Set the interval at which client type changes are signalled.
+ *
+ * Changes passed to clientTypesUpdated() during the interval are merged, keeping the last client
+ * types of each contact. The ClientTypes interface has no signal for several contacts, so one
+ * ClientTypesUpdated signal is still sent per contact. The default is 0, which signals the
+ * changes when the event loop runs again.
+ *
+ * \param msec The interval in milliseconds, or a negative value to signal each change as it is
+ *             reported.
+ * \sa changeAggregationInterval(), flushChanges()
+ */
+void BaseConnectionClientTypesInterface::setChangeAggregationInterval(int msec)
+{
+    if (msec < 0) {
+        flushChanges();
+    }
+    mPriv->pendingClientTypes.setInterval(msec);
+}
+
+/**
+ * Signal the client type changes which are waiting for the aggregation interval to end.
+ *
+ * \sa setChangeAggregationInterval()
+ */
+void BaseConnectionClientTypesInterface::flushChanges()
+{
+    const QMap<uint, QStringList> clientTypes = mPriv->pendingClientTypes.take();
+    for (QMap<uint, QStringList>::const_iterator i = clientTypes.constBegin(); i != clientTypes.constEnd(); ++i) {
+        QMetaObject::invokeMethod(mPriv->adaptee, "clientTypesUpdated", Q_ARG(uint, i.key()), Q_ARG(QStringList, i.value())); //Can simply use emit in Qt5
+    }
+}
+
 // Conn.I.ContactCapabilities
 // The BaseConnectionContactCapabilitiesInterface code is fully or partially generated by the TelepathyQt-Generator.
 struct TP_QT_NO_EXPORT BaseConnectionContactCapabilitiesInterface::Private {
@@ -2773,7 +3696,8 @@ BaseConnectionContactCapabilitiesInterface::Adaptee::~Adaptee()
 void BaseConnectionContactCapabilitiesInterface::Adaptee::updateCapabilities(const Tp::HandlerCapabilitiesList &handlerCapabilities,
         const Tp::Service::ConnectionInterfaceContactCapabilitiesAdaptor::UpdateCapabilitiesContextPtr &context)
 {
-    debug() << "BaseConnectionContactCapabilitiesInterface::Adaptee::updateCapabilities";
+    tpDebug(DebugCategoryService) <<
+        "BaseConnectionContactCapabilitiesInterface::Adaptee::updateCapabilities";
     DBusError error;
     mInterface->updateCapabilities(handlerCapabilities, &error);
     if (error.isValid()) {
@@ -2786,7 +3710,8 @@ void BaseConnectionContactCapabilitiesInterface::Adaptee::updateCapabilities(con
 void BaseConnectionContactCapabilitiesInterface::Adaptee::getContactCapabilities(const Tp::UIntList &handles,
         const Tp::Service::ConnectionInterfaceContactCapabilitiesAdaptor::GetContactCapabilitiesContextPtr &context)
 {
-    debug() << "BaseConnectionContactCapabilitiesInterface::Adaptee::getContactCapabilities";
+    tpDebug(DebugCategoryService) <<
+        "BaseConnectionContactCapabilitiesInterface::Adaptee::getContactCapabilities";
     DBusError error;
     Tp::ContactCapabilitiesMap contactCapabilities = mInterface->getContactCapabilities(handles, &error);
     if (error.isValid()) {
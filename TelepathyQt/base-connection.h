@@ -33,6 +33,7 @@
 #include <TelepathyQt/Types>
 #include <TelepathyQt/Callbacks>
 #include <TelepathyQt/Constants>
+#include <TelepathyQt/DeferredReply>
 
 #include <QDBusConnection>
 
@@ -85,6 +86,11 @@ public:
     void setCreateChannelCallback(const CreateChannelCallback &cb);
     BaseChannelPtr createChannel(const QVariantMap &request, bool suppressHandler, DBusError *error);
 
+    typedef Callback2<void, const QVariantMap &, const DeferredReply<BaseChannelPtr> &> CreateChannelAsyncCallback;
+    void setCreateChannelAsyncCallback(const CreateChannelAsyncCallback &cb);
+    void createChannel(const QVariantMap &request, bool suppressHandler,
+            const DeferredReply<BaseChannelPtr> &reply);
+
     typedef Callback1<void, DBusError*> ConnectCallback;
     void setConnectCallback(const ConnectCallback &cb);
 
@@ -96,6 +102,14 @@ public:
     void setRequestHandlesCallback(const RequestHandlesCallback &cb);
     Tp::UIntList requestHandles(uint handleType, const QStringList &identifiers, DBusError *error);
 
+    typedef Callback3<void, uint, const QStringList &, const DeferredReply<Tp::UIntList> &> RequestHandlesAsyncCallback;
+    void setRequestHandlesAsyncCallback(const RequestHandlesAsyncCallback &cb);
+    void requestHandles(uint handleType, const QStringList &identifiers,
+            const DeferredReply<Tp::UIntList> &reply);
+
+    BaseHandleRepositoryPtr handleRepository(uint handleType) const;
+    void setHandleRepository(const BaseHandleRepositoryPtr &repository);
+
     Tp::ChannelInfoList channelsInfo();
     Tp::ChannelDetailsList channelsDetails();
 
@@ -127,6 +141,9 @@ protected:
 
     virtual bool matchChannel(const Tp::BaseChannelPtr &channel, const QVariantMap &request, Tp::DBusError *error);
 
+    bool hasCustomChannelMatching() const;
+    void setCustomChannelMatching(bool enabled);
+
 private:
     class Adaptee;
     friend class Adaptee;
@@ -225,6 +242,11 @@ public:
     void setGetContactAttributesCallback(const GetContactAttributesCallback &cb);
     Tp::ContactAttributesMap getContactAttributes(const Tp::UIntList &handles, const QStringList &interfaces, DBusError *error);
 
+    typedef Callback3<void, const Tp::UIntList &, const QStringList &, const DeferredReply<Tp::ContactAttributesMap> &> GetContactAttributesAsyncCallback;
+    void setGetContactAttributesAsyncCallback(const GetContactAttributesAsyncCallback &cb);
+    void getContactAttributes(const Tp::UIntList &handles, const QStringList &interfaces,
+            const DeferredReply<Tp::ContactAttributesMap> &reply);
+
     void getContactByID(const QString &identifier, const QStringList &interfaces, uint &handle, QVariantMap &attributes, DBusError *error);
 
 protected:
@@ -271,6 +293,10 @@ public:
 
     void setPresences(const Tp::SimpleContactPresences &presences);
 
+    int changeAggregationInterval() const;
+    void setChangeAggregationInterval(int msec);
+    void flushChanges();
+
     Tp::SimpleContactPresences getPresences(const Tp::UIntList &contacts);
 
 protected:
@@ -564,6 +590,10 @@ public:
 
     void aliasesChanged(const Tp::AliasPairList &aliases);
 
+    int changeAggregationInterval() const;
+    void setChangeAggregationInterval(int msec);
+    void flushChanges();
+
 protected:
     BaseConnectionAliasingInterface();
 
@@ -618,6 +648,10 @@ public:
     void avatarUpdated(uint contact, const QString &newAvatarToken);
     void avatarRetrieved(uint contact, const QString &token, const QByteArray &avatar, const QString &type);
 
+    int changeAggregationInterval() const;
+    void setChangeAggregationInterval(int msec);
+    void flushChanges();
+
 protected:
     BaseConnectionAvatarsInterface();
 
@@ -660,6 +694,10 @@ public:
 
     void clientTypesUpdated(uint contact, const QStringList &clientTypes);
 
+    int changeAggregationInterval() const;
+    void setChangeAggregationInterval(int msec);
+    void flushChanges();
+
 protected:
     BaseConnectionClientTypesInterface();
 
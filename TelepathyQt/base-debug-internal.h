@@ -26,6 +26,7 @@
 #include <QObject>
 #include <QString>
 #include <QStringList>
+#include <QTimer>
 #include <QVariantMap>
 
 namespace Tp
@@ -48,11 +49,14 @@ public Q_SLOTS:
     void setEnabled(bool enabled);
 
 private Q_SLOTS:
+    void scheduleFlush();
+    void flushPendingMessages();
     void getMessages(
             const Tp::Service::DebugAdaptor::GetMessagesContextPtr &context);
 
 public:
     BaseDebug *mInterface;
+    QTimer mFlushTimer;
 };
 
 }
@@ -24,6 +24,11 @@
 
 #include <TelepathyQt/DBusObject>
 
+#include <QDateTime>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+
 #include "TelepathyQt/_gen/base-debug.moc.hpp"
 #include "TelepathyQt/_gen/base-debug-internal.moc.hpp"
 
@@ -36,27 +41,97 @@ struct TP_QT_NO_EXPORT BaseDebug::Private
         : parent(parent),
           enabled(false),
           getMessagesLimit(0),
-          lastMessageIndex(-1),
+          historyStart(0),
+          historyCount(0),
+          batchInterval(0),
+          maxBatchSize(1000),
+          droppedMessages(0),
+          droppedSinceFlush(0),
+          flushScheduled(false),
           adaptee(new BaseDebug::Adaptee(dbusConnection, parent))
     {
     }
 
+    void appendToHistory(const DebugMessage &message);
+    DebugMessageList history() const;
+    void clearHistory();
+
     BaseDebug *parent;
+
+    // Guards everything below, as messages may be added from any thread
+    mutable QMutex mutex;
     bool enabled;
     int getMessagesLimit;
-    int lastMessageIndex;
 
-    DebugMessageList messages;
+    // Ring buffer holding the last getMessagesLimit messages, oldest at historyStart
+    QVector<DebugMessage> messages;
+    int historyStart;
+    int historyCount;
+
+    int batchInterval;
+    int maxBatchSize;
+    QVector<DebugMessage> pendingMessages;
+    uint droppedMessages;
+    uint droppedSinceFlush;
+    bool flushScheduled;
 
     GetMessagesCallback getMessageCB;
     BaseDebug::Adaptee *adaptee;
 };
 
+void BaseDebug::Private::appendToHistory(const DebugMessage &message)
+{
+    if (getMessagesLimit == 0) {
+        return;
+    }
+
+    if (getMessagesLimit > 0 && historyCount == getMessagesLimit) {
+        // Full, overwrite the oldest message
+        messages[historyStart] = message;
+        historyStart = (historyStart + 1) % historyCount;
+        return;
+    }
+
+    if (historyStart != 0) {
+        // The limit was raised or removed after wrapping around, unroll the ring first
+        QVector<DebugMessage> unrolled;
+        unrolled.reserve(historyCount + 1);
+        for (int i = 0; i < historyCount; ++i) {
+            unrolled.append(messages.at((historyStart + i) % historyCount));
+        }
+        messages = unrolled;
+        historyStart = 0;
+    }
+
+    messages.append(message);
+    ++historyCount;
+}
+
+DebugMessageList BaseDebug::Private::history() const
+{
+    DebugMessageList ret;
+    ret.reserve(historyCount);
+    for (int i = 0; i < historyCount; ++i) {
+        ret.append(messages.at((historyStart + i) % historyCount));
+    }
+    return ret;
+}
+
+void BaseDebug::Private::clearHistory()
+{
+    messages.clear();
+    historyStart = 0;
+    historyCount = 0;
+}
+
 BaseDebug::Adaptee::Adaptee(const QDBusConnection &dbusConnection, BaseDebug *interface)
     : QObject(interface),
       mInterface(interface)
 {
     (void) new Service::DebugAdaptor(dbusConnection, this, interface->dbusObject());
+
+    mFlushTimer.setSingleShot(true);
+    connect(&mFlushTimer, SIGNAL(timeout()), SLOT(flushPendingMessages()));
 }
 
 bool BaseDebug::Adaptee::isEnabled()
@@ -66,7 +141,44 @@ bool BaseDebug::Adaptee::isEnabled()
 
 void BaseDebug::Adaptee::setEnabled(bool enabled)
 {
-    mInterface->mPriv->enabled = enabled;
+    mInterface->setEnabled(enabled);
+}
+
+void BaseDebug::Adaptee::scheduleFlush()
+{
+    if (!mFlushTimer.isActive()) {
+        mFlushTimer.start(mInterface->batchInterval());
+    }
+}
+
+void BaseDebug::Adaptee::flushPendingMessages()
+{
+    QVector<DebugMessage> messages;
+    uint dropped;
+    bool enabled;
+    {
+        QMutexLocker locker(&mInterface->mPriv->mutex);
+        messages.swap(mInterface->mPriv->pendingMessages);
+        dropped = mInterface->mPriv->droppedSinceFlush;
+        mInterface->mPriv->droppedSinceFlush = 0;
+        mInterface->mPriv->flushScheduled = false;
+        enabled = mInterface->mPriv->enabled;
+    }
+
+    if (!enabled) {
+        return;
+    }
+
+    foreach (const DebugMessage &message, messages) {
+        emit newDebugMessage(message.timestamp, message.domain, message.level, message.message);
+    }
+
+    if (dropped) {
+        qint64 msec = QDateTime::currentMSecsSinceEpoch();
+        emit newDebugMessage(msec / 1000 + (msec % 1000 / 1000.0),
+                QLatin1String("tp-qt"), DebugLevelWarning,
+                QString(QLatin1String("%1 debug messages were dropped")).arg(dropped));
+    }
 }
 
 void BaseDebug::Adaptee::getMessages(const Service::DebugAdaptor::GetMessagesContextPtr &context)
@@ -89,14 +201,54 @@ BaseDebug::BaseDebug(const QDBusConnection &dbusConnection) :
 
 bool BaseDebug::isEnabled() const
 {
+    QMutexLocker locker(&mPriv->mutex);
     return mPriv->enabled;
 }
 
 int BaseDebug::getMessagesLimit() const
 {
+    QMutexLocker locker(&mPriv->mutex);
     return mPriv->getMessagesLimit;
 }
 
+/**
+ * Return the interval in milliseconds at which NewDebugMessage signals are sent in batches.
+ *
+ * \return The batch interval, or 0 if signals are sent as messages arrive.
+ * \sa setBatchInterval()
+ */
+int BaseDebug::batchInterval() const
+{
+    QMutexLocker locker(&mPriv->mutex);
+    return mPriv->batchInterval;
+}
+
+/**
+ * Return the maximum number of NewDebugMessage signals sent per batch.
+ *
+ * \return The maximum batch size.
+ * \sa setMaxBatchSize()
+ */
+int BaseDebug::maxBatchSize() const
+{
+    QMutexLocker locker(&mPriv->mutex);
+    return mPriv->maxBatchSize;
+}
+
+/**
+ * Return the number of messages which were not signalled because a batch was full.
+ *
+ * Dropped messages are still recorded in the history returned by getMessages().
+ *
+ * \return The number of dropped messages since this object was created.
+ * \sa setMaxBatchSize()
+ */
+uint BaseDebug::droppedMessages() const
+{
+    QMutexLocker locker(&mPriv->mutex);
+    return mPriv->droppedMessages;
+}
+
 void BaseDebug::setGetMessagesCallback(const BaseDebug::GetMessagesCallback &cb)
 {
     mPriv->getMessageCB = cb;
@@ -105,12 +257,9 @@ void BaseDebug::setGetMessagesCallback(const BaseDebug::GetMessagesCallback &cb)
 DebugMessageList BaseDebug::getMessages(Tp::DBusError *error) const
 {
     if (!mPriv->getMessageCB.isValid()) {
+        QMutexLocker locker(&mPriv->mutex);
         if (mPriv->getMessagesLimit) {
-            if (mPriv->lastMessageIndex < 0) {
-                return mPriv->messages;
-            } else {
-                return mPriv->messages.mid(mPriv->lastMessageIndex + 1) + mPriv->messages.mid(0, mPriv->lastMessageIndex + 1);
-            }
+            return mPriv->history();
         }
         error->set(TP_QT_ERROR_NOT_IMPLEMENTED, QLatin1String("Not implemented"));
         return DebugMessageList();
@@ -121,33 +270,62 @@ DebugMessageList BaseDebug::getMessages(Tp::DBusError *error) const
 
 void BaseDebug::setEnabled(bool enabled)
 {
+    QMutexLocker locker(&mPriv->mutex);
     mPriv->enabled = enabled;
 }
 
 void BaseDebug::setGetMessagesLimit(int limit)
 {
+    QMutexLocker locker(&mPriv->mutex);
     mPriv->getMessagesLimit = limit;
-    DebugMessageList messages;
 
-    if (mPriv->lastMessageIndex < 0) {
-        messages = mPriv->messages;
-    } else {
-        messages = mPriv->messages.mid(mPriv->lastMessageIndex + 1) + mPriv->messages.mid(0, mPriv->lastMessageIndex + 1);
+    if (limit >= 0 && mPriv->historyCount > limit) {
+        DebugMessageList messages = mPriv->history();
+        mPriv->clearHistory();
+        mPriv->messages.reserve(limit);
+        for (int i = messages.count() - limit; i < messages.count(); ++i) {
+            mPriv->messages.append(messages.at(i));
+        }
+        mPriv->historyCount = limit;
     }
+}
 
-    mPriv->lastMessageIndex = -1;
+/**
+ * Set the interval at which NewDebugMessage signals are sent.
+ *
+ * By default signals are sent as messages arrive. With a positive \a msec, messages are queued
+ * and sent together at most once every \a msec milliseconds, which saves a wakeup of the bus
+ * daemon and of the debug monitor for each message of a busy service.
+ *
+ * \param msec The batch interval in milliseconds, or 0 to send messages as they arrive.
+ * \sa setMaxBatchSize()
+ */
+void BaseDebug::setBatchInterval(int msec)
+{
+    QMutexLocker locker(&mPriv->mutex);
+    mPriv->batchInterval = qMax(msec, 0);
+}
 
-    if (mPriv->messages.count() <= limit) {
-        mPriv->messages = messages;
-    } else {
-        mPriv->messages = messages.mid(messages.count() - limit, limit);
-    }
+/**
+ * Set the maximum number of NewDebugMessage signals sent per batch.
+ *
+ * Messages arriving while the current batch is full are not signalled, and a single warning
+ * reporting how many were dropped is sent at the end of the batch instead. This has no effect
+ * unless a batch interval is set.
+ *
+ * \param size The maximum batch size.
+ * \sa setBatchInterval(), droppedMessages()
+ */
+void BaseDebug::setMaxBatchSize(int size)
+{
+    QMutexLocker locker(&mPriv->mutex);
+    mPriv->maxBatchSize = qMax(size, 1);
 }
 
 void BaseDebug::clear()
 {
-    mPriv->messages.clear();
-    mPriv->lastMessageIndex = -1;
+    QMutexLocker locker(&mPriv->mutex);
+    mPriv->clearHistory();
 }
 
 void BaseDebug::newDebugMessage(const QString &domain, DebugLevel level, const QString &message)
@@ -160,33 +338,41 @@ void BaseDebug::newDebugMessage(const QString &domain, DebugLevel level, const Q
 
 void BaseDebug::newDebugMessage(double time, const QString &domain, DebugLevel level, const QString &message)
 {
-    if (mPriv->getMessagesLimit != 0) {
-        DebugMessage newMessage;
-        newMessage.timestamp = time;
-        newMessage.domain = domain;
-        newMessage.level = level;
-        newMessage.message = message;
+    DebugMessage newMessage;
+    newMessage.timestamp = time;
+    newMessage.domain = domain;
+    newMessage.level = level;
+    newMessage.message = message;
 
-        if (mPriv->messages.count() == mPriv->getMessagesLimit) {
-            ++mPriv->lastMessageIndex;
+    QMutexLocker locker(&mPriv->mutex);
+    mPriv->appendToHistory(newMessage);
 
-            if (mPriv->lastMessageIndex >= mPriv->messages.count()) {
-                mPriv->lastMessageIndex = 0;
-            }
+    if (!mPriv->enabled) {
+        return;
+    }
 
-            mPriv->messages[mPriv->lastMessageIndex] = newMessage;
-        } else { // This works when the limit is not hitted yet, or when there is no limit at all (negative limit number)
-            mPriv->messages << newMessage;
+    if (mPriv->batchInterval > 0) {
+        if (mPriv->pendingMessages.count() >= mPriv->maxBatchSize) {
+            ++mPriv->droppedMessages;
+            ++mPriv->droppedSinceFlush;
+        } else {
+            mPriv->pendingMessages.append(newMessage);
         }
-    }
 
-    if (!isEnabled()) {
+        if (!mPriv->flushScheduled) {
+            mPriv->flushScheduled = true;
+            // The flush timer lives in the thread of the adaptee
+            QMetaObject::invokeMethod(mPriv->adaptee, "scheduleFlush", Qt::QueuedConnection);
+        }
         return;
     }
 
+    locker.unlock();
+
+    // Queued when called from another thread
     QMetaObject::invokeMethod(mPriv->adaptee, "newDebugMessage",
                               Q_ARG(double, time), Q_ARG(QString, domain),
-                              Q_ARG(uint, level), Q_ARG(QString, message)); //Can simply use emit in Qt5
+                              Q_ARG(uint, level), Q_ARG(QString, message));
 }
 
 QVariantMap BaseDebug::immutableProperties() const
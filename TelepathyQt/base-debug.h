@@ -44,6 +44,10 @@ public:
     bool isEnabled() const;
     int getMessagesLimit() const;
 
+    int batchInterval() const;
+    int maxBatchSize() const;
+    uint droppedMessages() const;
+
     typedef Callback1<DebugMessageList, DBusError*> GetMessagesCallback;
     void setGetMessagesCallback(const GetMessagesCallback &cb);
 
@@ -52,6 +56,8 @@ public:
 public Q_SLOTS:
     void setEnabled(bool enabled);
     void setGetMessagesLimit(int limit);
+    void setBatchInterval(int msec);
+    void setMaxBatchSize(int size);
     void clear();
 
     void newDebugMessage(const QString &domain, DebugLevel level, const QString &message);
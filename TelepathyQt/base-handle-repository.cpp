@@ -0,0 +1,279 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2026 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <TelepathyQt/BaseHandleRepository>
+
+#include <TelepathyQt/DBusError>
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+namespace Tp
+{
+
+struct TP_QT_NO_EXPORT BaseHandleRepository::Private
+{
+    Private(HandleType handleType)
+        : handleType(handleType)
+    {
+    }
+
+    uint intern(const QString &normalizedIdentifier);
+
+    HandleType handleType;
+    NormalizeIdentifierCallback normalizeIdentifierCB;
+    // Handle N is stored at identifiers[N - 1]; the hash key shares the same string data
+    QVector<QString> identifiers;
+    QHash<QString, uint> handles;
+};
+
+uint BaseHandleRepository::Private::intern(const QString &normalizedIdentifier)
+{
+    QHash<QString, uint>::const_iterator it = handles.constFind(normalizedIdentifier);
+    if (it != handles.constEnd()) {
+        return it.value();
+    }
+
+    identifiers.append(normalizedIdentifier);
+    uint handle = identifiers.size();
+    handles.insert(identifiers.last(), handle);
+    return handle;
+}
+
+/**
+ * \class BaseHandleRepository
+ * \ingroup serviceconn
+ * \headerfile TelepathyQt/base-handle-repository.h <TelepathyQt/BaseHandleRepository>
+ *
+ * \brief Base class for mapping identifiers to handles of one handle type.
+ *
+ * Connection managers can plug a repository per handle type into a BaseConnection with
+ * BaseConnection::setHandleRepository() instead of implementing the RequestHandles and
+ * InspectHandles callbacks.
+ *
+ * Identifiers are normalized with the callback set by setNormalizeIdentifierCallback() and
+ * stored once. Handles are allocated densely starting from 1 and are never released, so
+ * per-handle data can be kept in arrays indexed by \c handle - 1.
+ */
+
+/**
+ * Class constructor.
+ *
+ * \param handleType The type of the handles managed by this repository.
+ */
+BaseHandleRepository::BaseHandleRepository(HandleType handleType)
+    : mPriv(new Private(handleType))
+{
+}
+
+/**
+ * Class destructor.
+ */
+BaseHandleRepository::~BaseHandleRepository()
+{
+    delete mPriv;
+}
+
+/**
+ * Return the type of the handles managed by this repository.
+ *
+ * \return The handle type as #HandleType.
+ */
+HandleType BaseHandleRepository::handleType() const
+{
+    return mPriv->handleType;
+}
+
+/**
+ * Set the callback used to normalize identifiers before they are assigned a handle.
+ *
+ * The callback must return the normalized form of the given identifier, or set an error
+ * if the identifier is not valid. Without a callback, identifiers are used as they are and
+ * only empty identifiers are rejected.
+ *
+ * \param cb The callback to set.
+ * \sa normalizeIdentifier()
+ */
+void BaseHandleRepository::setNormalizeIdentifierCallback(const NormalizeIdentifierCallback &cb)
+{
+    mPriv->normalizeIdentifierCB = cb;
+}
+
+/**
+ * Return the normalized form of \a identifier.
+ *
+ * \param identifier The identifier to normalize.
+ * \param error A pointer to an empty DBusError where any possible error will be stored.
+ * \return The normalized identifier, or an empty string if \a identifier is not valid.
+ * \sa setNormalizeIdentifierCallback()
+ */
+QString BaseHandleRepository::normalizeIdentifier(const QString &identifier, DBusError *error) const
+{
+    QString normalizedIdentifier = identifier;
+    if (mPriv->normalizeIdentifierCB.isValid()) {
+        normalizedIdentifier = mPriv->normalizeIdentifierCB(identifier, error);
+        if (error->isValid()) {
+            return QString();
+        }
+    }
+
+    if (normalizedIdentifier.isEmpty()) {
+        error->set(TP_QT_ERROR_INVALID_HANDLE,
+                QString(QLatin1String("Invalid identifier \"%1\"")).arg(identifier));
+        return QString();
+    }
+
+    return normalizedIdentifier;
+}
+
+/**
+ * Return the number of handles allocated by this repository.
+ *
+ * The valid handles are the ones from 1 to count().
+ *
+ * \return The number of handles.
+ */
+int BaseHandleRepository::count() const
+{
+    return mPriv->identifiers.size();
+}
+
+/**
+ * Reserve space for at least \a size handles.
+ *
+ * \param size The number of handles to reserve space for.
+ */
+void BaseHandleRepository::reserve(int size)
+{
+    mPriv->identifiers.reserve(size);
+    mPriv->handles.reserve(size);
+}
+
+/**
+ * Return whether \a handle has been allocated by this repository.
+ *
+ * \param handle The handle to check.
+ * \return \c true if the handle is valid, \c false otherwise.
+ */
+bool BaseHandleRepository::isValidHandle(uint handle) const
+{
+    return handle != 0 && handle <= uint(mPriv->identifiers.size());
+}
+
+/**
+ * Return the handle already allocated for \a normalizedIdentifier.
+ *
+ * Unlike ensureHandle(), this method neither normalizes the identifier nor allocates a
+ * new handle.
+ *
+ * \param normalizedIdentifier A normalized identifier.
+ * \return The handle, or 0 if none has been allocated for the identifier.
+ */
+uint BaseHandleRepository::handle(const QString &normalizedIdentifier) const
+{
+    return mPriv->handles.value(normalizedIdentifier);
+}
+
+/**
+ * Return the normalized identifier of \a handle.
+ *
+ * \param handle The handle.
+ * \return The identifier, or an empty string if \a handle is not valid.
+ */
+QString BaseHandleRepository::identifier(uint handle) const
+{
+    if (!isValidHandle(handle)) {
+        return QString();
+    }
+    return mPriv->identifiers.at(handle - 1);
+}
+
+/**
+ * Return the handle for \a identifier, allocating a new one if needed.
+ *
+ * \param identifier The identifier, which will be normalized.
+ * \param error A pointer to an empty DBusError where any possible error will be stored.
+ * \return The handle, or 0 if \a identifier is not valid.
+ */
+uint BaseHandleRepository::ensureHandle(const QString &identifier, DBusError *error)
+{
+    const QString normalizedIdentifier = normalizeIdentifier(identifier, error);
+    if (error->isValid()) {
+        return 0;
+    }
+    return mPriv->intern(normalizedIdentifier);
+}
+
+/**
+ * Return the handles for \a identifiers, allocating new ones if needed.
+ *
+ * All the identifiers are normalized before any handle is allocated, so no handle is
+ * allocated if one of them is not valid.
+ *
+ * \param identifiers The identifiers, which will be normalized.
+ * \param error A pointer to an empty DBusError where any possible error will be stored.
+ * \return The handles in the same order as \a identifiers, or an empty list on error.
+ */
+Tp::UIntList BaseHandleRepository::ensureHandles(const QStringList &identifiers, DBusError *error)
+{
+    QStringList normalizedIdentifiers;
+    normalizedIdentifiers.reserve(identifiers.size());
+    foreach (const QString &identifier, identifiers) {
+        normalizedIdentifiers.append(normalizeIdentifier(identifier, error));
+        if (error->isValid()) {
+            return Tp::UIntList();
+        }
+    }
+
+    Tp::UIntList result;
+    result.reserve(normalizedIdentifiers.size());
+    foreach (const QString &normalizedIdentifier, normalizedIdentifiers) {
+        result.append(mPriv->intern(normalizedIdentifier));
+    }
+    return result;
+}
+
+/**
+ * Return the normalized identifiers of \a handles.
+ *
+ * \param handles The handles.
+ * \param error A pointer to an empty DBusError where any possible error will be stored.
+ * \return The identifiers in the same order as \a handles, or an empty list if one of
+ *         the handles is not valid.
+ */
+QStringList BaseHandleRepository::identifiers(const Tp::UIntList &handles, DBusError *error) const
+{
+    QStringList result;
+    result.reserve(handles.size());
+    foreach (uint handle, handles) {
+        if (!isValidHandle(handle)) {
+            error->set(TP_QT_ERROR_INVALID_HANDLE,
+                    QString(QLatin1String("Invalid handle %1")).arg(handle));
+            return QStringList();
+        }
+        result.append(mPriv->identifiers.at(handle - 1));
+    }
+    return result;
+}
+
+} // Tp
@@ -683,7 +683,7 @@ bool BaseProtocol::plugInterface(const AbstractProtocolInterfacePtr &interface)
         return false;
     }
 
-    debug() << "Interface" << interface->interfaceName() << "plugged";
+    tpDebug(DebugCategoryService) << "Interface" << interface->interfaceName() << "plugged";
     mPriv->interfaces.insert(interface->interfaceName(), interface);
     return true;
 }
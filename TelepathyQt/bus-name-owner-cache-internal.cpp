@@ -0,0 +1,181 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2026 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "TelepathyQt/bus-name-owner-cache-internal.h"
+
+#include "TelepathyQt/_gen/bus-name-owner-cache-internal.moc.hpp"
+
+#include "TelepathyQt/debug-internal.h"
+
+#include <QCoreApplication>
+#include <QDBusConnectionInterface>
+#include <QDBusReply>
+#include <QMutexLocker>
+#include <QPair>
+#include <QStringList>
+
+namespace Tp
+{
+
+namespace
+{
+
+typedef QPair<QString, QString> BusUniqueId;
+
+QMutex registryMutex;
+QHash<BusUniqueId, BusNameOwnerCache *> registry;
+bool registryCleanupAdded = false;
+
+void clearRegistry()
+{
+    QMutexLocker locker(&registryMutex);
+    qDeleteAll(registry);
+    registry.clear();
+}
+
+}
+
+/**
+ * Return the owner cache for \a bus, creating it if needed.
+ *
+ * There is one cache per bus connection, shared by all the proxies using it, so that
+ * resolving the well-known name of a service to its unique name only costs a D-Bus
+ * round trip the first time.
+ */
+BusNameOwnerCache *BusNameOwnerCache::forBus(const QDBusConnection &bus)
+{
+    QMutexLocker locker(&registryMutex);
+
+    if (!registryCleanupAdded && QCoreApplication::instance()) {
+        qAddPostRoutine(clearRegistry);
+        registryCleanupAdded = true;
+    }
+
+    // Caches are only deleted when the application exits, as other threads may still be using
+    // the cache of a connection which went away. A new connection of the same name has another
+    // unique name, so it gets a fresh cache.
+    BusUniqueId busUniqueId(bus.name(), bus.baseService());
+    BusNameOwnerCache *cache = registry.value(busUniqueId);
+    if (!cache) {
+        cache = new BusNameOwnerCache(bus);
+        registry.insert(busUniqueId, cache);
+    }
+    return cache;
+}
+
+BusNameOwnerCache::BusNameOwnerCache(const QDBusConnection &bus)
+    : QObject(),
+      mBus(bus)
+{
+    // The cache is shared by all threads, so receive owner changes in the main thread rather
+    // than in whichever thread happened to resolve a name first, which may not run an event
+    // loop or may finish before the cache is gone
+    if (QCoreApplication::instance()) {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
+}
+
+BusNameOwnerCache::~BusNameOwnerCache()
+{
+}
+
+/**
+ * Return the cached unique name owning \a name, or an empty string if it is not known.
+ */
+QString BusNameOwnerCache::owner(const QString &name) const
+{
+    QMutexLocker locker(&mMutex);
+    return mOwners.value(name);
+}
+
+/**
+ * Return the unique name owning \a name, asking the bus daemon only if it is not cached.
+ *
+ * On failure an empty string is returned and \a error and \a message are set.
+ */
+QString BusNameOwnerCache::resolve(const QString &name, QString &error, QString &message)
+{
+    QString cached = owner(name);
+    if (!cached.isEmpty()) {
+        return cached;
+    }
+
+    // Start watching before asking, so that an owner change racing with the reply
+    // is seen after it and can't leave a stale entry behind
+    watch(name);
+
+    QDBusReply<QString> reply = mBus.interface()->serviceOwner(name);
+
+    QMutexLocker locker(&mMutex);
+    if (!reply.isValid()) {
+        if (!mOwners.contains(name)) {
+            unwatch(name);
+        }
+        error = reply.error().name();
+        message = reply.error().message();
+        return QString();
+    }
+
+    mOwners.insert(name, reply.value());
+    return reply.value();
+}
+
+void BusNameOwnerCache::onServiceOwnerChanged(const QString &name,
+        const QString &oldOwner, const QString &newOwner)
+{
+    Q_UNUSED(oldOwner);
+
+    QMutexLocker locker(&mMutex);
+    if (!mOwners.contains(name)) {
+        return;
+    }
+
+    if (newOwner.isEmpty()) {
+        debug() << "Bus name" << name << "lost its owner, dropping it from the cache";
+        mOwners.remove(name);
+        unwatch(name);
+    } else {
+        mOwners.insert(name, newOwner);
+    }
+}
+
+// Resolving happens in any thread, so owner changes are subscribed to on the bus connection,
+// which is thread-safe, rather than with a QDBusServiceWatcher, which may only be used in the
+// thread it lives in. The match rule is in place when this returns, and the signals are
+// delivered to the thread of the cache. Connecting the same name twice adds a single match.
+void BusNameOwnerCache::watch(const QString &name)
+{
+    mBus.connect(QLatin1String("org.freedesktop.DBus"), QString(),
+            QLatin1String("org.freedesktop.DBus"), QLatin1String("NameOwnerChanged"),
+            QStringList() << name, QString(),
+            this, SLOT(onServiceOwnerChanged(QString,QString,QString)));
+}
+
+void BusNameOwnerCache::unwatch(const QString &name)
+{
+    mBus.disconnect(QLatin1String("org.freedesktop.DBus"), QString(),
+            QLatin1String("org.freedesktop.DBus"), QLatin1String("NameOwnerChanged"),
+            QStringList() << name, QString(),
+            this, SLOT(onServiceOwnerChanged(QString,QString,QString)));
+}
+
+} // Tp
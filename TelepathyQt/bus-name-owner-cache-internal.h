@@ -0,0 +1,71 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2026 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef _TelepathyQt_bus_name_owner_cache_internal_h_HEADER_GUARD_
+#define _TelepathyQt_bus_name_owner_cache_internal_h_HEADER_GUARD_
+
+#include <TelepathyQt/Global>
+
+#include <QDBusConnection>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+
+namespace Tp
+{
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+class TP_QT_NO_EXPORT BusNameOwnerCache : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(BusNameOwnerCache)
+
+public:
+    static BusNameOwnerCache *forBus(const QDBusConnection &bus);
+
+    ~BusNameOwnerCache();
+
+    QString owner(const QString &name) const;
+    QString resolve(const QString &name, QString &error, QString &message);
+
+private Q_SLOTS:
+    void onServiceOwnerChanged(const QString &name, const QString &oldOwner,
+            const QString &newOwner);
+
+private:
+    BusNameOwnerCache(const QDBusConnection &bus);
+
+    void watch(const QString &name);
+    void unwatch(const QString &name);
+
+    QDBusConnection mBus;
+    mutable QMutex mMutex;
+    QHash<QString, QString> mOwners;
+};
+
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+} // Tp
+
+#endif
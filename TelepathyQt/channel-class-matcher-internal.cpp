@@ -0,0 +1,158 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2026 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "TelepathyQt/channel-class-matcher-internal.h"
+
+#include <TelepathyQt/Constants>
+
+#include <QDBusArgument>
+#include <QtAlgorithms>
+
+namespace Tp
+{
+
+namespace
+{
+
+struct ChannelClassKeys
+{
+    ChannelClassKeys()
+        : channelType(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType")),
+          targetHandleType(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandleType"))
+    {
+    }
+
+    QString channelType;
+    QString targetHandleType;
+};
+
+Q_GLOBAL_STATIC(ChannelClassKeys, channelClassKeys)
+
+}
+
+ChannelClassIndex::ChannelClassIndex()
+{
+}
+
+ChannelClassIndex::~ChannelClassIndex()
+{
+}
+
+void ChannelClassIndex::clear()
+{
+    mResiduals.clear();
+    mByChannelType.clear();
+    mAnyChannelType = Bucket();
+}
+
+int ChannelClassIndex::add(const ChannelClassSpec &channelClass)
+{
+    const ChannelClassKeys *keys = channelClassKeys();
+    int pos = mResiduals.size();
+
+    QVariantMap props = channelClass.allProperties();
+    Bucket *bucket = &mAnyChannelType;
+    if (props.contains(keys->channelType)) {
+        bucket = &mByChannelType[qdbus_cast<QString>(props.take(keys->channelType))];
+    }
+    if (props.contains(keys->targetHandleType)) {
+        bucket->byHandleType[qdbus_cast<uint>(props.take(keys->targetHandleType))].append(pos);
+    } else {
+        bucket->anyHandleType.append(pos);
+    }
+
+    Residual residual;
+    for (QVariantMap::const_iterator i = props.constBegin(); i != props.constEnd(); ++i) {
+        residual.append(qMakePair(i.key(), i.value()));
+    }
+    mResiduals.append(residual);
+
+    return pos;
+}
+
+QList<int> ChannelClassIndex::matching(const ChannelClassSpec &channelClass,
+        bool firstOnly) const
+{
+    return lookup(channelClass.allProperties(), false, firstOnly);
+}
+
+QList<int> ChannelClassIndex::matchingChannel(const QVariantMap &immutableProperties,
+        bool firstOnly) const
+{
+    // ChannelClassSpec(immutableProperties) defaults both to empty values when missing
+    return lookup(immutableProperties, true, firstOnly);
+}
+
+QList<int> ChannelClassIndex::lookup(const QVariantMap &props, bool normalize,
+        bool firstOnly) const
+{
+    const ChannelClassKeys *keys = channelClassKeys();
+    QList<int> ret;
+
+    QVariantMap::const_iterator i = props.constFind(keys->targetHandleType);
+    bool hasHandleType = normalize || i != props.constEnd();
+    uint handleType = i != props.constEnd() ? qdbus_cast<uint>(i.value()) : 0;
+
+    collect(mAnyChannelType, hasHandleType, handleType, props, ret);
+
+    i = props.constFind(keys->channelType);
+    if (normalize || i != props.constEnd()) {
+        QString channelType = i != props.constEnd() ? qdbus_cast<QString>(i.value()) : QString();
+        QHash<QString, Bucket>::const_iterator bucket = mByChannelType.constFind(channelType);
+        if (bucket != mByChannelType.constEnd()) {
+            collect(*bucket, hasHandleType, handleType, props, ret);
+        }
+    }
+
+    // Candidates come from up to four buckets, each in insertion order
+    qSort(ret);
+    if (firstOnly && ret.size() > 1) {
+        ret.erase(ret.begin() + 1, ret.end());
+    }
+    return ret;
+}
+
+void ChannelClassIndex::collect(const Bucket &bucket, bool hasHandleType, uint handleType,
+        const QVariantMap &props, QList<int> &ret) const
+{
+    QList<int> candidates = bucket.anyHandleType;
+    if (hasHandleType) {
+        candidates += bucket.byHandleType.value(handleType);
+    }
+
+    foreach (int pos, candidates) {
+        bool matches = true;
+        foreach (const Residual::value_type &prop, mResiduals.at(pos)) {
+            QVariantMap::const_iterator i = props.constFind(prop.first);
+            if (i == props.constEnd() || i.value() != prop.second) {
+                matches = false;
+                break;
+            }
+        }
+
+        if (matches) {
+            ret.append(pos);
+        }
+    }
+}
+
+} // Tp
@@ -0,0 +1,142 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2026 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef _TelepathyQt_channel_class_matcher_internal_h_HEADER_GUARD_
+#define _TelepathyQt_channel_class_matcher_internal_h_HEADER_GUARD_
+
+#include <TelepathyQt/ChannelClassSpec>
+#include <TelepathyQt/Global>
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVariant>
+#include <QVariantMap>
+#include <QVector>
+
+namespace Tp
+{
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+// Index over a list of channel classes, bucketed by ChannelType and TargetHandleType, so that
+// finding the classes matching a channel only needs to check the remaining properties of the
+// classes in the channel's buckets instead of comparing against every class.
+class TP_QT_NO_EXPORT ChannelClassIndex
+{
+public:
+    ChannelClassIndex();
+    ~ChannelClassIndex();
+
+    void clear();
+    int size() const { return mResiduals.size(); }
+
+    int add(const ChannelClassSpec &channelClass);
+
+    // Positions of the added classes which are a subset of channelClass, in the order they
+    // were added
+    QList<int> matching(const ChannelClassSpec &channelClass, bool firstOnly = false) const;
+
+    // Positions of the added classes matching a channel with the given immutable properties, in
+    // the order they were added, like ChannelClassSpec::matches() would
+    QList<int> matchingChannel(const QVariantMap &immutableProperties,
+            bool firstOnly = false) const;
+
+private:
+    typedef QList<QPair<QString, QVariant> > Residual;
+
+    struct Bucket
+    {
+        QHash<uint, QList<int> > byHandleType;
+        QList<int> anyHandleType;
+    };
+
+    QList<int> lookup(const QVariantMap &props, bool normalize, bool firstOnly) const;
+    void collect(const Bucket &bucket, bool hasHandleType, uint handleType,
+            const QVariantMap &props, QList<int> &ret) const;
+
+    QVector<Residual> mResiduals;
+    QHash<QString, Bucket> mByChannelType;
+    Bucket mAnyChannelType;
+};
+
+template <typename T>
+class ChannelClassMatcher
+{
+public:
+    void clear()
+    {
+        mIndex.clear();
+        mValues.clear();
+    }
+
+    bool isEmpty() const { return mValues.isEmpty(); }
+
+    void append(const ChannelClassSpec &channelClass, const T &value)
+    {
+        mIndex.add(channelClass);
+        mValues.append(value);
+    }
+
+    QList<T> values(const ChannelClassSpec &channelClass) const
+    {
+        return valuesAt(mIndex.matching(channelClass));
+    }
+
+    QList<T> valuesForChannel(const QVariantMap &immutableProperties) const
+    {
+        return valuesAt(mIndex.matchingChannel(immutableProperties));
+    }
+
+    T firstValue(const ChannelClassSpec &channelClass, const T &defaultValue = T()) const
+    {
+        QList<int> found = mIndex.matching(channelClass, true);
+        return found.isEmpty() ? defaultValue : mValues.at(found.first());
+    }
+
+    T firstValueForChannel(const QVariantMap &immutableProperties,
+            const T &defaultValue = T()) const
+    {
+        QList<int> found = mIndex.matchingChannel(immutableProperties, true);
+        return found.isEmpty() ? defaultValue : mValues.at(found.first());
+    }
+
+private:
+    QList<T> valuesAt(const QList<int> &positions) const
+    {
+        QList<T> ret;
+        foreach (int i, positions) {
+            ret.append(mValues.at(i));
+        }
+        return ret;
+    }
+
+    ChannelClassIndex mIndex;
+    QVector<T> mValues;
+};
+
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+} // Tp
+
+#endif
@@ -88,7 +88,8 @@ ChannelDispatchOperation::Private::Private(ChannelDispatchOperation *parent)
       readinessHelper(parent->readinessHelper()),
       gotPossibleHandlers(false)
 {
-    debug() << "Creating new ChannelDispatchOperation:" << parent->objectPath();
+    tpDebug(DebugCategoryDispatch) << "Creating new ChannelDispatchOperation:" <<
+        parent->objectPath();
 
     parent->connect(baseInterface,
             SIGNAL(Finished()),
@@ -132,13 +133,13 @@ void ChannelDispatchOperation::Private::introspectMain(ChannelDispatchOperation:
             && mainProps.contains(QLatin1String("Connection"))
             && mainProps.contains(QLatin1String("Interfaces"))
             && mainProps.contains(QLatin1String("PossibleHandlers"))) {
-        debug() << "Supplied properties were sufficient, not introspecting"
+        tpDebug(DebugCategoryDispatch) << "Supplied properties were sufficient, not introspecting"
             << self->parent->objectPath();
         self->extractMainProps(mainProps, true);
         return;
     }
 
-    debug() << "Calling Properties::GetAll(ChannelDispatchOperation)";
+    tpDebug(DebugCategoryDispatch) << "Calling Properties::GetAll(ChannelDispatchOperation)";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(
                 self->properties->GetAll(TP_QT_IFACE_CHANNEL_DISPATCH_OPERATION),
@@ -210,7 +211,7 @@ void ChannelDispatchOperation::Private::extractMainProps(const QVariantMap &prop
     }
 
     if (readyOps.isEmpty()) {
-        debug() << "No proxies to prepare for CDO" << parent->objectPath();
+        tpDebug(DebugCategoryDispatch) << "No proxies to prepare for CDO" << parent->objectPath();
         readinessHelper->setIntrospectCompleted(FeatureCore, true);
     } else {
         parent->connect(new PendingComposite(readyOps, ChannelDispatchOperationPtr(parent)),
@@ -225,7 +226,7 @@ ChannelDispatchOperation::PendingClaim::PendingClaim(const ChannelDispatchOperat
       mDispatchOp(op),
       mHandler(handler)
 {
-    debug() << "Invoking CDO.Claim";
+    tpDebug(DebugCategoryDispatch) << "Invoking CDO.Claim";
     connect(new PendingVoid(op->baseInterface()->Claim(), op),
             SIGNAL(finished(Tp::PendingOperation*)),
             SLOT(onClaimFinished(Tp::PendingOperation*)));
@@ -239,7 +240,8 @@ void ChannelDispatchOperation::PendingClaim::onClaimFinished(
         PendingOperation *op)
 {
     if (!op->isError()) {
-        debug() << "CDO.Claim returned successfully, updating HandledChannels";
+        tpDebug(DebugCategoryDispatch) <<
+            "CDO.Claim returned successfully, updating HandledChannels";
         if (mHandler) {
             // register the channels in HandledChannels
             FakeHandlerManager::instance()->registerChannels(
@@ -573,7 +575,7 @@ Client::ChannelDispatchOperationInterface *ChannelDispatchOperation::baseInterfa
 
 void ChannelDispatchOperation::onFinished()
 {
-    debug() << "ChannelDispatchOperation finished and was removed";
+    tpDebug(DebugCategoryDispatch) << "ChannelDispatchOperation finished and was removed";
     invalidate(TP_QT_ERROR_OBJECT_REMOVED,
                QLatin1String("ChannelDispatchOperation finished and was removed"));
 }
@@ -584,7 +586,8 @@ void ChannelDispatchOperation::gotMainProperties(QDBusPendingCallWatcher *watche
 
     // Watcher is NULL if we didn't have to introspect at all
     if (!reply.isError()) {
-        debug() << "Got reply to Properties::GetAll(ChannelDispatchOperation)";
+        tpDebug(DebugCategoryDispatch) <<
+            "Got reply to Properties::GetAll(ChannelDispatchOperation)";
         mPriv->extractMainProps(reply.value(), false);
     } else {
         mPriv->readinessHelper->setIntrospectCompleted(FeatureCore,
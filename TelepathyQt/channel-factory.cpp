@@ -26,6 +26,7 @@
 
 #include "TelepathyQt/_gen/future-constants.h"
 
+#include "TelepathyQt/channel-class-matcher-internal.h"
 #include "TelepathyQt/debug-internal.h"
 
 #include <TelepathyQt/CallChannel>
@@ -59,12 +60,51 @@ struct TP_QT_NO_EXPORT ChannelFactory::Private
 
     typedef QPair<ChannelClassSpec, ConstructorConstPtr> CtorPair;
     QList<CtorPair> ctors;
+
+    const ChannelClassMatcher<Features> &featuresMatcher() const;
+    const ChannelClassMatcher<ConstructorConstPtr> &ctorsMatcher() const;
+
+    // Indexes over features and ctors, rebuilt lazily when those change, so that looking up a
+    // channel doesn't compare it against every registered channel class
+    mutable ChannelClassMatcher<Features> mFeaturesMatcher;
+    mutable bool featuresMatcherDirty;
+    mutable ChannelClassMatcher<ConstructorConstPtr> mCtorsMatcher;
+    mutable bool ctorsMatcherDirty;
 };
 
 ChannelFactory::Private::Private()
+    : featuresMatcherDirty(false),
+      ctorsMatcherDirty(false)
 {
 }
 
+const ChannelClassMatcher<Features> &ChannelFactory::Private::featuresMatcher() const
+{
+    if (featuresMatcherDirty) {
+        mFeaturesMatcher.clear();
+        foreach (const ChannelClassFeatures &pair, features) {
+            mFeaturesMatcher.append(pair.first, pair.second);
+        }
+        featuresMatcherDirty = false;
+    }
+
+    return mFeaturesMatcher;
+}
+
+const ChannelClassMatcher<ChannelFactory::ConstructorConstPtr> &
+        ChannelFactory::Private::ctorsMatcher() const
+{
+    if (ctorsMatcherDirty) {
+        mCtorsMatcher.clear();
+        foreach (const CtorPair &pair, ctors) {
+            mCtorsMatcher.append(pair.first, pair.second);
+        }
+        ctorsMatcherDirty = false;
+    }
+
+    return mCtorsMatcher;
+}
+
 /**
  * \class ChannelFactory
  * \ingroup utils
@@ -548,10 +588,8 @@ Features ChannelFactory::featuresFor(const ChannelClassSpec &channelClass) const
 {
     Features features;
 
-    foreach (const ChannelClassFeatures &pair, mPriv->features) {
-        if (pair.first.isSubsetOf(channelClass)) {
-            features.unite(pair.second);
-        }
+    foreach (const Features &matching, mPriv->featuresMatcher().values(channelClass)) {
+        features.unite(matching);
     }
 
     return features;
@@ -559,6 +597,8 @@ Features ChannelFactory::featuresFor(const ChannelClassSpec &channelClass) const
 
 void ChannelFactory::addFeaturesFor(const ChannelClassSpec &channelClass, const Features &features)
 {
+    mPriv->featuresMatcherDirty = true;
+
     QList<ChannelClassFeatures>::iterator i;
     for (i = mPriv->features.begin(); i != mPriv->features.end(); ++i) {
         if (channelClass.allProperties().size() > i->first.allProperties().size()) {
@@ -578,16 +618,11 @@ void ChannelFactory::addFeaturesFor(const ChannelClassSpec &channelClass, const
 
 ChannelFactory::ConstructorConstPtr ChannelFactory::constructorFor(const ChannelClassSpec &cc) const
 {
-    QList<Private::CtorPair>::iterator i;
-    for (i = mPriv->ctors.begin(); i != mPriv->ctors.end(); ++i) {
-        if (i->first.isSubsetOf(cc)) {
-            return i->second;
-        }
-    }
+    ConstructorConstPtr ctor = mPriv->ctorsMatcher().firstValue(cc);
 
-    // If this is reached, we didn't have a proper fallback constructor
-    Q_ASSERT(false);
-    return ConstructorConstPtr();
+    // If this is hit, we didn't have a proper fallback constructor
+    Q_ASSERT(!ctor.isNull());
+    return ctor;
 }
 
 void ChannelFactory::setConstructorFor(const ChannelClassSpec &channelClass,
@@ -600,6 +635,8 @@ void ChannelFactory::setConstructorFor(const ChannelClassSpec &channelClass,
         return;
     }
 
+    mPriv->ctorsMatcherDirty = true;
+
     QList<Private::CtorPair>::iterator i;
     for (i = mPriv->ctors.begin(); i != mPriv->ctors.end(); ++i) {
         if (channelClass.allProperties().size() > i->first.allProperties().size()) {
@@ -637,8 +674,9 @@ PendingReady *ChannelFactory::proxy(const ConnectionPtr &connection, const QStri
 {
     DBusProxyPtr proxy = cachedProxy(connection->busName(), channelPath);
     if (proxy.isNull()) {
-        proxy = constructorFor(ChannelClassSpec(immutableProperties))->construct(connection,
-                channelPath, immutableProperties);
+        ConstructorConstPtr ctor = mPriv->ctorsMatcher().firstValueForChannel(immutableProperties);
+        Q_ASSERT(!ctor.isNull());
+        proxy = ctor->construct(connection, channelPath, immutableProperties);
     }
 
     return nowHaveProxy(proxy);
@@ -667,7 +705,14 @@ Features ChannelFactory::featuresFor(const DBusProxyPtr &proxy) const
     ChannelPtr chan = ChannelPtr::qObjectCast(proxy);
     Q_ASSERT(!chan.isNull());
 
-    return featuresFor(ChannelClassSpec(chan->immutableProperties()));
+    Features features;
+
+    foreach (const Features &matching,
+            mPriv->featuresMatcher().valuesForChannel(chan->immutableProperties())) {
+        features.unite(matching);
+    }
+
+    return features;
 }
 
 } // Tp
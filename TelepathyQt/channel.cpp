@@ -285,15 +285,15 @@ Channel::Private::Private(Channel *parent, const ConnectionPtr &connection,
       introspectingConference(false),
       buildingConferenceChannelRemovedActorContact(false)
 {
-    debug() << "Creating new Channel:" << parent->objectPath();
+    tpDebug(DebugCategoryChannels) << "Creating new Channel:" << parent->objectPath();
 
     if (connection->isValid()) {
-        debug() << " Connecting to Channel::Closed() signal";
+        tpDebug(DebugCategoryChannels) << " Connecting to Channel::Closed() signal";
         parent->connect(baseInterface,
                         SIGNAL(Closed()),
                         SLOT(onClosed()));
 
-        debug() << " Connection to owning connection's lifetime signals";
+        tpDebug(DebugCategoryChannels) << " Connection to owning connection's lifetime signals";
         parent->connect(connection.data(),
                         SIGNAL(invalidated(Tp::DBusProxy*,QString,QString)),
                         SLOT(onConnectionInvalidated()));
@@ -344,7 +344,7 @@ void Channel::Private::introspectMain(Channel::Private *self)
 {
     // Make sure connection object is ready, as we need to use some methods that
     // are only available after connection object gets ready.
-    debug() << "Calling Connection::becomeReady()";
+    tpDebug(DebugCategoryChannels) << "Calling Connection::becomeReady()";
     self->parent->connect(self->connection->becomeReady(),
             SIGNAL(finished(Tp::PendingOperation*)),
             SLOT(onConnectionReady(Tp::PendingOperation*)));
@@ -395,7 +395,7 @@ void Channel::Private::introspectMainProperties()
     }
 
     if (needIntrospectMainProps) {
-        debug() << "Calling Properties::GetAll(Channel)";
+        tpDebug(DebugCategoryChannels) << "Calling Properties::GetAll(Channel)";
         QDBusPendingCallWatcher *watcher =
             new QDBusPendingCallWatcher(
                     properties->GetAll(TP_QT_IFACE_CHANNEL),
@@ -411,7 +411,7 @@ void Channel::Private::introspectMainProperties()
 
 void Channel::Private::introspectMainFallbackChannelType()
 {
-    debug() << "Calling Channel::GetChannelType()";
+    tpDebug(DebugCategoryChannels) << "Calling Channel::GetChannelType()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(baseInterface->GetChannelType(), parent);
     parent->connect(watcher,
@@ -421,7 +421,7 @@ void Channel::Private::introspectMainFallbackChannelType()
 
 void Channel::Private::introspectMainFallbackHandle()
 {
-    debug() << "Calling Channel::GetHandle()";
+    tpDebug(DebugCategoryChannels) << "Calling Channel::GetHandle()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(baseInterface->GetHandle(), parent);
     parent->connect(watcher,
@@ -431,7 +431,7 @@ void Channel::Private::introspectMainFallbackHandle()
 
 void Channel::Private::introspectMainFallbackInterfaces()
 {
-    debug() << "Calling Channel::GetInterfaces()";
+    tpDebug(DebugCategoryChannels) << "Calling Channel::GetInterfaces()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(baseInterface->GetInterfaces(), parent);
     parent->connect(watcher,
@@ -448,7 +448,8 @@ void Channel::Private::introspectGroup()
         Q_ASSERT(group != 0);
     }
 
-    debug() << "Introspecting Channel.Interface.Group for" << parent->objectPath();
+    tpDebug(DebugCategoryChannels) << "Introspecting Channel.Interface.Group for" <<
+        parent->objectPath();
 
     parent->connect(group,
                     SIGNAL(GroupFlagsChanged(uint,uint)),
@@ -479,7 +480,7 @@ void Channel::Private::introspectGroup()
                     SIGNAL(SelfHandleChanged(uint)),
                     SLOT(onSelfHandleChanged(uint)));
 
-    debug() << "Calling Properties::GetAll(Channel.Interface.Group)";
+    tpDebug(DebugCategoryChannels) << "Calling Properties::GetAll(Channel.Interface.Group)";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(
                 properties->GetAll(TP_QT_IFACE_CHANNEL_INTERFACE_GROUP),
@@ -493,7 +494,7 @@ void Channel::Private::introspectGroupFallbackFlags()
 {
     Q_ASSERT(group != 0);
 
-    debug() << "Calling Channel.Interface.Group::GetGroupFlags()";
+    tpDebug(DebugCategoryChannels) << "Calling Channel.Interface.Group::GetGroupFlags()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(group->GetGroupFlags(), parent);
     parent->connect(watcher,
@@ -505,7 +506,7 @@ void Channel::Private::introspectGroupFallbackMembers()
 {
     Q_ASSERT(group != 0);
 
-    debug() << "Calling Channel.Interface.Group::GetAllMembers()";
+    tpDebug(DebugCategoryChannels) << "Calling Channel.Interface.Group::GetAllMembers()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(group->GetAllMembers(), parent);
     parent->connect(watcher,
@@ -517,7 +518,8 @@ void Channel::Private::introspectGroupFallbackLocalPendingWithInfo()
 {
     Q_ASSERT(group != 0);
 
-    debug() << "Calling Channel.Interface.Group::GetLocalPendingMembersWithInfo()";
+    tpDebug(DebugCategoryChannels) <<
+        "Calling Channel.Interface.Group::GetLocalPendingMembersWithInfo()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(group->GetLocalPendingMembersWithInfo(),
                 parent);
@@ -530,7 +532,7 @@ void Channel::Private::introspectGroupFallbackSelfHandle()
 {
     Q_ASSERT(group != 0);
 
-    debug() << "Calling Channel.Interface.Group::GetSelfHandle()";
+    tpDebug(DebugCategoryChannels) << "Calling Channel.Interface.Group::GetSelfHandle()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(group->GetSelfHandle(), parent);
     parent->connect(watcher,
@@ -543,13 +545,14 @@ void Channel::Private::introspectConference()
     Q_ASSERT(properties != 0);
     Q_ASSERT(conference == 0);
 
-    debug() << "Introspecting Conference interface";
+    tpDebug(DebugCategoryChannels) << "Introspecting Conference interface";
     conference = parent->interface<Client::ChannelInterfaceConferenceInterface>();
     Q_ASSERT(conference != 0);
 
     introspectingConference = true;
 
-    debug() << "Connecting to Channel.Interface.Conference.ChannelMerged/Removed";
+    tpDebug(DebugCategoryChannels) <<
+        "Connecting to Channel.Interface.Conference.ChannelMerged/Removed";
     parent->connect(conference,
             SIGNAL(ChannelMerged(QDBusObjectPath,uint,QVariantMap)),
             SLOT(onConferenceChannelMerged(QDBusObjectPath,uint,QVariantMap)));
@@ -557,7 +560,7 @@ void Channel::Private::introspectConference()
             SIGNAL(ChannelRemoved(QDBusObjectPath,QVariantMap)),
             SLOT(onConferenceChannelRemoved(QDBusObjectPath,QVariantMap)));
 
-    debug() << "Calling Properties::GetAll(Channel.Interface.Conference)";
+    tpDebug(DebugCategoryChannels) << "Calling Properties::GetAll(Channel.Interface.Conference)";
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
             properties->GetAll(TP_QT_IFACE_CHANNEL_INTERFACE_CONFERENCE),
             parent);
@@ -588,10 +591,12 @@ void Channel::Private::continueIntrospection()
         if (!parent->isReady(Channel::FeatureCore)) {
             if (groupMembersChangedQueue.isEmpty() && !buildingContacts &&
                 !introspectingConference) {
-                debug() << "Both the IS and the MCD queue empty for the first time. Ready.";
+                tpDebug(DebugCategoryChannels) <<
+                    "Both the IS and the MCD queue empty for the first time. Ready.";
                 setReady();
             } else {
-                debug() << "Introspection done before contacts done - contacts sets ready";
+                tpDebug(DebugCategoryChannels) <<
+                    "Introspection done before contacts done - contacts sets ready";
             }
         }
     } else {
@@ -665,7 +670,7 @@ void Channel::Private::extractMainProps(const QVariantMap &props)
         nowHaveInterfaces();
     }
 
-    debug() << "Have initiator handle:" << (initiatorHandle ? "yes" : "no");
+    tpDebug(DebugCategoryChannels) << "Have initiator handle:" << (initiatorHandle ? "yes" : "no");
 }
 
 void Channel::Private::extract0176GroupProps(const QVariantMap &props)
@@ -696,7 +701,7 @@ void Channel::Private::extract0176GroupProps(const QVariantMap &props)
         introspectQueue.enqueue(&Private::introspectGroupFallbackLocalPendingWithInfo);
         introspectQueue.enqueue(&Private::introspectGroupFallbackSelfHandle);
     } else {
-        debug() << " Found properties specified in 0.17.6";
+        tpDebug(DebugCategoryChannels) << " Found properties specified in 0.17.6";
 
         groupAreHandleOwnersAvailable = true;
         groupIsSelfHandleTracked = true;
@@ -720,7 +725,7 @@ void Channel::Private::extract0176GroupProps(const QVariantMap &props)
 
 void Channel::Private::nowHaveInterfaces()
 {
-    debug() << "Channel has" << parent->interfaces().size() <<
+    tpDebug(DebugCategoryChannels) << "Channel has" << parent->interfaces().size() <<
         "optional interfaces:" << parent->interfaces();
 
     QStringList interfaces = parent->interfaces();
@@ -800,7 +805,8 @@ bool Channel::Private::setGroupFlags(uint newGroupFlags)
     if ((groupFlags & ChannelGroupFlagMembersChangedDetailed) &&
         !usingMembersChangedDetailed) {
         usingMembersChangedDetailed = true;
-        debug() << "Starting to exclusively listen to MembersChangedDetailed for" <<
+        tpDebug(DebugCategoryChannels) <<
+            "Starting to exclusively listen to MembersChangedDetailed for" <<
             parent->objectPath();
         parent->disconnect(group,
                            SIGNAL(MembersChanged(QString,Tp::UIntList,
@@ -892,7 +898,8 @@ void Channel::Private::processMembersChanged()
 
         if (!parent->isReady(Channel::FeatureCore)) {
             if (introspectQueue.isEmpty()) {
-                debug() << "Both the MCD and the introspect queue empty for the first time. Ready!";
+                tpDebug(DebugCategoryChannels) <<
+                    "Both the MCD and the introspect queue empty for the first time. Ready!";
 
                 if (initiatorHandle && !initiatorContact) {
                     warning() << " Unable to create contact object for initiator with handle" <<
@@ -911,7 +918,8 @@ void Channel::Private::processMembersChanged()
 
                 continueIntrospection();
             } else {
-                debug() << "Contact queue empty but introspect queue isn't. IS will set ready.";
+                tpDebug(DebugCategoryChannels) <<
+                    "Contact queue empty but introspect queue isn't. IS will set ready.";
             }
         }
 
@@ -971,7 +979,8 @@ void Channel::Private::updateContacts(const QList<ContactPtr> &contacts)
     ContactPtr actorContact;
     bool selfContactUpdated = false;
 
-    debug() << "Entering Chan::Priv::updateContacts() with" << contacts.size() << "contacts";
+    tpDebug(DebugCategoryChannels) << "Entering Chan::Priv::updateContacts() with" <<
+        contacts.size() << "contacts";
 
     // FIXME: simplify. Some duplication of logic present.
     foreach (ContactPtr contact, contacts) {
@@ -1123,7 +1132,7 @@ bool Channel::Private::fakeGroupInterfaceIfNeeded()
         groupSelfHandle = connection->selfHandle();
         groupInitialMembers = UIntList() << groupSelfHandle << targetHandle;
 
-        debug().nospace() << "Faking a group on channel with self handle=" <<
+        tpDebug(DebugCategoryChannels).nospace() << "Faking a group on channel with self handle=" <<
             groupSelfHandle << " and other handle=" << targetHandle;
 
         nowHaveInitialMembers();
@@ -1139,27 +1148,27 @@ void Channel::Private::setReady()
 {
     Q_ASSERT(!parent->isReady(Channel::FeatureCore));
 
-    debug() << "Channel fully ready";
-    debug() << " Channel type" << channelType;
-    debug() << " Target handle" << targetHandle;
-    debug() << " Target handle type" << targetHandleType;
+    tpDebug(DebugCategoryChannels) << "Channel fully ready";
+    tpDebug(DebugCategoryChannels) << " Channel type" << channelType;
+    tpDebug(DebugCategoryChannels) << " Target handle" << targetHandle;
+    tpDebug(DebugCategoryChannels) << " Target handle type" << targetHandleType;
 
     if (parent->interfaces().contains(TP_QT_IFACE_CHANNEL_INTERFACE_GROUP)) {
-        debug() << " Group: flags" << groupFlags;
+        tpDebug(DebugCategoryChannels) << " Group: flags" << groupFlags;
         if (groupAreHandleOwnersAvailable) {
-            debug() << " Group: Number of handle owner mappings" <<
+            tpDebug(DebugCategoryChannels) << " Group: Number of handle owner mappings" <<
                 groupHandleOwners.size();
         }
         else {
-            debug() << " Group: No handle owners property present";
+            tpDebug(DebugCategoryChannels) << " Group: No handle owners property present";
         }
-        debug() << " Group: Number of current members" <<
+        tpDebug(DebugCategoryChannels) << " Group: Number of current members" <<
             groupContacts.size();
-        debug() << " Group: Number of local pending members" <<
+        tpDebug(DebugCategoryChannels) << " Group: Number of local pending members" <<
             groupLocalPendingContacts.size();
-        debug() << " Group: Number of remote pending members" <<
+        tpDebug(DebugCategoryChannels) << " Group: Number of remote pending members" <<
             groupRemotePendingContacts.size();
-        debug() << " Group: Self handle" << groupSelfHandle <<
+        tpDebug(DebugCategoryChannels) << " Group: Self handle" << groupSelfHandle <<
             "tracked:" << (groupIsSelfHandleTracked ? "yes" : "no");
     }
 
@@ -1860,7 +1869,8 @@ void Channel::PendingLeave::onChanInvalidated(Tp::DBusProxy *proxy)
         return;
     }
 
-    debug() << "Finishing PendingLeave successfully as the channel was invalidated";
+    tpDebug(DebugCategoryChannels) <<
+        "Finishing PendingLeave successfully as the channel was invalidated";
 
     setFinished();
 }
@@ -1874,14 +1884,14 @@ void Channel::PendingLeave::onRemoveFinished(Tp::PendingOperation *op)
     ChannelPtr chan = ChannelPtr::staticCast(object());
 
     if (op->isValid()) {
-        debug() << "We left the channel" << chan->objectPath();
+        tpDebug(DebugCategoryChannels) << "We left the channel" << chan->objectPath();
 
         ContactPtr c = chan->groupSelfContact();
 
         if (chan->groupContacts().contains(c)
                 || chan->groupLocalPendingContacts().contains(c)
                 || chan->groupRemotePendingContacts().contains(c)) {
-            debug() << "Waiting for self remove to be picked up";
+            tpDebug(DebugCategoryChannels) << "Waiting for self remove to be picked up";
             connect(chan.data(),
                     SIGNAL(groupMembersChanged(Tp::Contacts,Tp::Contacts,Tp::Contacts,Tp::Contacts,
                             Tp::Channel::GroupMemberChangeDetails)),
@@ -1894,7 +1904,8 @@ void Channel::PendingLeave::onRemoveFinished(Tp::PendingOperation *op)
         return;
     }
 
-    debug() << "Leave RemoveMembersWithReason failed with " << op->errorName() << op->errorMessage()
+    tpDebug(DebugCategoryChannels) << "Leave RemoveMembersWithReason failed with " <<
+        op->errorName() << op->errorMessage()
         << "- falling back to Close";
 
     // If the channel has been closed or otherwise invalidated already in this mainloop iteration,
@@ -1916,7 +1927,7 @@ void Channel::PendingLeave::onMembersChanged(const Tp::Contacts &, const Tp::Con
     ContactPtr c = chan->groupSelfContact();
 
     if (removed.contains(c)) {
-        debug() << "Leave event picked up for" << chan->objectPath();
+        tpDebug(DebugCategoryChannels) << "Leave event picked up for" << chan->objectPath();
         setFinished();
     }
 }
@@ -1935,7 +1946,7 @@ void Channel::PendingLeave::onCloseFinished(Tp::PendingOperation *op)
             << op->errorName() << op->errorMessage() << "- so didn't leave";
         setFinishedWithError(op->errorName(), op->errorMessage());
     } else {
-        debug() << "We left (by closing) the channel" << chan->objectPath();
+        tpDebug(DebugCategoryChannels) << "We left (by closing) the channel" << chan->objectPath();
         setFinished();
     }
 }
@@ -1985,7 +1996,7 @@ PendingOperation *Channel::requestLeave(const QString &message, ChannelGroupChan
 
     if (!groupContacts().contains(self) && !groupLocalPendingContacts().contains(self)
             && !groupRemotePendingContacts().contains(self)) {
-        debug() << "Channel::requestLeave() called for " << objectPath() <<
+        tpDebug(DebugCategoryChannels) << "Channel::requestLeave() called for " << objectPath() <<
             "which we aren't a member of";
         return new PendingSuccess(ChannelPtr(this));
     }
@@ -2865,7 +2876,7 @@ void Channel::gotMainProperties(QDBusPendingCallWatcher *watcher)
     QVariantMap props;
 
     if (!reply.isError()) {
-        debug() << "Got reply to Properties::GetAll(Channel)";
+        tpDebug(DebugCategoryChannels) << "Got reply to Properties::GetAll(Channel)";
         props = reply.value();
     } else {
         warning().nospace() << "Properties::GetAll(Channel) failed with " <<
@@ -2889,7 +2900,7 @@ void Channel::gotChannelType(QDBusPendingCallWatcher *watcher)
         return;
     }
 
-    debug() << "Got reply to fallback Channel::GetChannelType()";
+    tpDebug(DebugCategoryChannels) << "Got reply to fallback Channel::GetChannelType()";
     mPriv->channelType = reply.value();
     mPriv->continueIntrospection();
 }
@@ -2906,7 +2917,7 @@ void Channel::gotHandle(QDBusPendingCallWatcher *watcher)
         return;
     }
 
-    debug() << "Got reply to fallback Channel::GetHandle()";
+    tpDebug(DebugCategoryChannels) << "Got reply to fallback Channel::GetHandle()";
     mPriv->targetHandleType = reply.argumentAt<0>();
     mPriv->targetHandle = reply.argumentAt<1>();
     mPriv->continueIntrospection();
@@ -2924,7 +2935,7 @@ void Channel::gotInterfaces(QDBusPendingCallWatcher *watcher)
         return;
     }
 
-    debug() << "Got reply to fallback Channel::GetInterfaces()";
+    tpDebug(DebugCategoryChannels) << "Got reply to fallback Channel::GetInterfaces()";
     setInterfaces(reply.value());
     mPriv->readinessHelper->setInterfaces(interfaces());
     mPriv->nowHaveInterfaces();
@@ -2936,7 +2947,7 @@ void Channel::gotInterfaces(QDBusPendingCallWatcher *watcher)
 
 void Channel::onClosed()
 {
-    debug() << "Got Channel::Closed";
+    tpDebug(DebugCategoryChannels) << "Got Channel::Closed";
 
     QString error;
     QString message;
@@ -2980,7 +2991,7 @@ void Channel::onConnectionReady(PendingOperation *op)
 
 void Channel::onConnectionInvalidated()
 {
-    debug() << "Owning connection died leaving an orphan Channel, "
+    tpDebug(DebugCategoryChannels) << "Owning connection died leaving an orphan Channel, "
         "changing to closed";
     invalidate(TP_QT_ERROR_ORPHANED,
                QLatin1String("Connection given as the owner of this channel was invalidated"));
@@ -2992,7 +3003,8 @@ void Channel::gotGroupProperties(QDBusPendingCallWatcher *watcher)
     QVariantMap props;
 
     if (!reply.isError()) {
-        debug() << "Got reply to Properties::GetAll(Channel.Interface.Group)";
+        tpDebug(DebugCategoryChannels) <<
+            "Got reply to Properties::GetAll(Channel.Interface.Group)";
         props = reply.value();
     }
     else {
@@ -3016,7 +3028,8 @@ void Channel::gotGroupFlags(QDBusPendingCallWatcher *watcher)
             reply.error().name() << ": " << reply.error().message();
     }
     else {
-        debug() << "Got reply to fallback Channel.Interface.Group::GetGroupFlags()";
+        tpDebug(DebugCategoryChannels) <<
+            "Got reply to fallback Channel.Interface.Group::GetGroupFlags()";
         mPriv->setGroupFlags(reply.value());
 
         if (mPriv->groupFlags & ChannelGroupFlagProperties) {
@@ -3037,7 +3050,8 @@ void Channel::gotAllMembers(QDBusPendingCallWatcher *watcher)
         warning().nospace() << "Channel.Interface.Group::GetAllMembers() failed with " <<
             reply.error().name() << ": " << reply.error().message();
     } else {
-        debug() << "Got reply to fallback Channel.Interface.Group::GetAllMembers()";
+        tpDebug(DebugCategoryChannels) <<
+            "Got reply to fallback Channel.Interface.Group::GetAllMembers()";
 
         mPriv->groupInitialMembers = reply.argumentAt<0>();
         mPriv->groupInitialRP = reply.argumentAt<2>();
@@ -3062,7 +3076,7 @@ void Channel::gotLocalPendingMembersWithInfo(QDBusPendingCallWatcher *watcher)
         warning() << " Falling back to what GetAllMembers returned with no extended info";
     }
     else {
-        debug() << "Got reply to fallback "
+        tpDebug(DebugCategoryChannels) << "Got reply to fallback "
             "Channel.Interface.Group::GetLocalPendingMembersWithInfo()";
         // Overrides the previous vague list provided by gotAllMembers
         mPriv->groupInitialLP = reply.value();
@@ -3079,7 +3093,8 @@ void Channel::gotSelfHandle(QDBusPendingCallWatcher *watcher)
         warning().nospace() << "Channel.Interface.Group::GetSelfHandle() failed with " <<
             reply.error().name() << ": " << reply.error().message();
     } else {
-        debug() << "Got reply to fallback Channel.Interface.Group::GetSelfHandle()";
+        tpDebug(DebugCategoryChannels) <<
+            "Got reply to fallback Channel.Interface.Group::GetSelfHandle()";
         // Don't overwrite the self handle we got from the connection with 0
         if (reply.value()) {
             mPriv->groupSelfHandle = reply.value();
@@ -3122,13 +3137,13 @@ void Channel::gotContacts(PendingOperation *op)
 
 void Channel::onGroupFlagsChanged(uint added, uint removed)
 {
-    debug().nospace() << "Got Channel.Interface.Group::GroupFlagsChanged(" <<
+    tpDebug(DebugCategoryChannels).nospace() << "Got Channel.Interface.Group::GroupFlagsChanged(" <<
         hex << added << ", " << removed << ")";
 
     added &= ~(mPriv->groupFlags);
     removed &= mPriv->groupFlags;
 
-    debug().nospace() << "Arguments after filtering (" << hex << added <<
+    tpDebug(DebugCategoryChannels).nospace() << "Arguments after filtering (" << hex << added <<
         ", " << removed << ")";
 
     uint groupFlags = mPriv->groupFlags;
@@ -3137,26 +3152,26 @@ void Channel::onGroupFlagsChanged(uint added, uint removed)
     // just emit groupFlagsChanged and related signals if the flags really
     // changed and we are ready
     if (mPriv->setGroupFlags(groupFlags) && isReady(Channel::FeatureCore)) {
-        debug() << "Emitting groupFlagsChanged with" << mPriv->groupFlags <<
+        tpDebug(DebugCategoryChannels) << "Emitting groupFlagsChanged with" << mPriv->groupFlags <<
             "value" << added << "added" << removed << "removed";
         emit groupFlagsChanged((ChannelGroupFlags) mPriv->groupFlags,
                 (ChannelGroupFlags) added, (ChannelGroupFlags) removed);
 
         if (added & ChannelGroupFlagCanAdd ||
             removed & ChannelGroupFlagCanAdd) {
-            debug() << "Emitting groupCanAddContactsChanged";
+            tpDebug(DebugCategoryChannels) << "Emitting groupCanAddContactsChanged";
             emit groupCanAddContactsChanged(groupCanAddContacts());
         }
 
         if (added & ChannelGroupFlagCanRemove ||
             removed & ChannelGroupFlagCanRemove) {
-            debug() << "Emitting groupCanRemoveContactsChanged";
+            tpDebug(DebugCategoryChannels) << "Emitting groupCanRemoveContactsChanged";
             emit groupCanRemoveContactsChanged(groupCanRemoveContacts());
         }
 
         if (added & ChannelGroupFlagCanRescind ||
             removed & ChannelGroupFlagCanRescind) {
-            debug() << "Emitting groupCanRescindContactsChanged";
+            tpDebug(DebugCategoryChannels) << "Emitting groupCanRescindContactsChanged";
             emit groupCanRescindContactsChanged(groupCanRescindContacts());
         }
     }
@@ -3172,11 +3187,12 @@ void Channel::onMembersChanged(const QString &message,
         return;
     }
 
-    debug() << "Got Channel.Interface.Group::MembersChanged with" << added.size() <<
+    tpDebug(DebugCategoryChannels) << "Got Channel.Interface.Group::MembersChanged with" <<
+        added.size() <<
         "added," << removed.size() << "removed," << localPending.size() <<
         "moved to LP," << remotePending.size() << "moved to RP," << actor <<
         "being the actor," << reason << "the reason and" << message << "the message";
-    debug() << " synthesizing a corresponding MembersChangedDetailed signal";
+    tpDebug(DebugCategoryChannels) << " synthesizing a corresponding MembersChangedDetailed signal";
 
     QVariantMap details;
 
@@ -3203,7 +3219,8 @@ void Channel::onMembersChangedDetailed(
         return;
     }
 
-    debug() << "Got Channel.Interface.Group::MembersChangedDetailed with" << added.size() <<
+    tpDebug(DebugCategoryChannels) << "Got Channel.Interface.Group::MembersChangedDetailed with" <<
+        added.size() <<
         "added," << removed.size() << "removed," << localPending.size() <<
         "moved to LP," << remotePending.size() << "moved to RP and with" << details.size() <<
         "details";
@@ -3217,14 +3234,14 @@ void Channel::Private::doMembersChangedDetailed(
         const QVariantMap &details)
 {
     if (!groupHaveMembers) {
-        debug() << "Still waiting for initial group members, "
+        tpDebug(DebugCategoryChannels) << "Still waiting for initial group members, "
             "so ignoring delta signal...";
         return;
     }
 
     if (added.isEmpty() && removed.isEmpty() &&
         localPending.isEmpty() && remotePending.isEmpty()) {
-        debug() << "Nothing really changed, so skipping membersChanged";
+        tpDebug(DebugCategoryChannels) << "Nothing really changed, so skipping membersChanged";
         return;
     }
 
@@ -3281,11 +3298,11 @@ void Channel::Private::doMembersChangedDetailed(
 void Channel::onHandleOwnersChanged(const HandleOwnerMap &added,
         const UIntList &removed)
 {
-    debug() << "Got Channel.Interface.Group::HandleOwnersChanged with" <<
+    tpDebug(DebugCategoryChannels) << "Got Channel.Interface.Group::HandleOwnersChanged with" <<
         added.size() << "added," << removed.size() << "removed";
 
     if (!mPriv->groupAreHandleOwnersAvailable) {
-        debug() << "Still waiting for initial handle owners, so ignoring "
+        tpDebug(DebugCategoryChannels) << "Still waiting for initial handle owners, so ignoring "
             "delta signal...";
         return;
     }
@@ -3301,7 +3318,7 @@ void Channel::onHandleOwnersChanged(const HandleOwnerMap &added,
 
         if (!mPriv->groupHandleOwners.contains(handle)
                 || mPriv->groupHandleOwners[handle] != global) {
-            debug() << " +++/changed" << handle << "->" << global;
+            tpDebug(DebugCategoryChannels) << " +++/changed" << handle << "->" << global;
             mPriv->groupHandleOwners[handle] = global;
             emitAdded.append(handle);
         }
@@ -3309,7 +3326,7 @@ void Channel::onHandleOwnersChanged(const HandleOwnerMap &added,
 
     foreach (uint handle, removed) {
         if (mPriv->groupHandleOwners.contains(handle)) {
-            debug() << " ---" << handle;
+            tpDebug(DebugCategoryChannels) << " ---" << handle;
             mPriv->groupHandleOwners.remove(handle);
             emitRemoved.append(handle);
         }
@@ -3318,7 +3335,8 @@ void Channel::onHandleOwnersChanged(const HandleOwnerMap &added,
     // just emit groupHandleOwnersChanged if it really changed and
     // we are ready
     if ((emitAdded.size() || emitRemoved.size()) && isReady(Channel::FeatureCore)) {
-        debug() << "Emitting groupHandleOwnersChanged with" << emitAdded.size() <<
+        tpDebug(DebugCategoryChannels) << "Emitting groupHandleOwnersChanged with" <<
+            emitAdded.size() <<
             "added" << emitRemoved.size() << "removed";
         emit groupHandleOwnersChanged(mPriv->groupHandleOwners,
                 emitAdded, emitRemoved);
@@ -3327,11 +3345,11 @@ void Channel::onHandleOwnersChanged(const HandleOwnerMap &added,
 
 void Channel::onSelfHandleChanged(uint selfHandle)
 {
-    debug().nospace() << "Got Channel.Interface.Group::SelfHandleChanged";
+    tpDebug(DebugCategoryChannels).nospace() << "Got Channel.Interface.Group::SelfHandleChanged";
 
     if (selfHandle != mPriv->groupSelfHandle) {
         mPriv->groupSelfHandle = selfHandle;
-        debug() << " Emitting groupSelfHandleChanged with new self handle" <<
+        tpDebug(DebugCategoryChannels) << " Emitting groupSelfHandleChanged with new self handle" <<
             selfHandle;
 
         // FIXME: fix self contact building with no group
@@ -3347,7 +3365,8 @@ void Channel::gotConferenceProperties(QDBusPendingCallWatcher *watcher)
     mPriv->introspectingConference = false;
 
     if (!reply.isError()) {
-        debug() << "Got reply to Properties::GetAll(Channel.Interface.Conference)";
+        tpDebug(DebugCategoryChannels) <<
+            "Got reply to Properties::GetAll(Channel.Interface.Conference)";
         props = reply.value();
 
         ConnectionPtr conn = connection();
@@ -118,7 +118,7 @@ void ClientObserverAdaptor::ObserveChannels(const QDBusObjectPath &accountPath,
         const QVariantMap &observerInfo,
         const QDBusMessage &message)
 {
-    debug() << "ObserveChannels: account:" << accountPath.path() <<
+    tpDebug(DebugCategoryDispatch) << "ObserveChannels: account:" << accountPath.path() <<
         ", connection:" << connectionPath.path();
 
     AccountFactoryConstPtr accFactory = mRegistrar->accountFactory();
@@ -214,7 +214,8 @@ void ClientObserverAdaptor::ObserveChannels(const QDBusObjectPath &accountPath,
 
     mInvocations.append(invocation);
 
-    debug() << "Preparing proxies for ObserveChannels of" << channelDetailsList.size() << "channels"
+    tpDebug(DebugCategoryDispatch) << "Preparing proxies for ObserveChannels of" <<
+        channelDetailsList.size() << "channels"
         << "for client" << mClient;
 }
 
@@ -251,7 +252,8 @@ void ClientObserverAdaptor::onReadyOpFinished(Tp::PendingOperation *op)
             continue;
         }
 
-        debug() << "Invoking application observeChannels with" << invocation->chans.size()
+        tpDebug(DebugCategoryDispatch) << "Invoking application observeChannels with" <<
+            invocation->chans.size()
             << "channels on" << mClient;
 
         mClient->observeChannels(invocation->ctx, invocation->acc, invocation->conn,
@@ -289,7 +291,7 @@ void ClientApproverAdaptor::AddDispatchOperation(const Tp::ChannelDetailsList &c
     QDBusObjectPath connectionPath = qdbus_cast<QDBusObjectPath>(
             properties.value(
                 TP_QT_IFACE_CHANNEL_DISPATCH_OPERATION + QLatin1String(".Connection")));
-    debug() << "addDispatchOperation: connection:" << connectionPath.path();
+    tpDebug(DebugCategoryDispatch) << "addDispatchOperation: connection:" << connectionPath.path();
     QString connectionBusName = connectionPath.path().mid(1).replace(
             QLatin1String("/"), QLatin1String("."));
     PendingReady *connReady = connFactory->proxy(connectionBusName, connectionPath.path(), chanFactory,
@@ -354,7 +356,7 @@ void ClientApproverAdaptor::onReadyOpFinished(Tp::PendingOperation *op)
             continue;
         }
 
-        debug() << "Invoking application addDispatchOperation with CDO"
+        tpDebug(DebugCategoryDispatch) << "Invoking application addDispatchOperation with CDO"
             << invocation->dispatchOp->objectPath() << "on" << mClient;
 
         mClient->addDispatchOperation(invocation->ctx, invocation->dispatchOp);
@@ -395,7 +397,7 @@ void ClientHandlerAdaptor::HandleChannels(const QDBusObjectPath &accountPath,
         const QVariantMap &handlerInfo,
         const QDBusMessage &message)
 {
-    debug() << "HandleChannels: account:" << accountPath.path() <<
+    tpDebug(DebugCategoryDispatch) << "HandleChannels: account:" << accountPath.path() <<
         ", connection:" << connectionPath.path();
 
     AccountFactoryConstPtr accFactory = mRegistrar->accountFactory();
@@ -408,7 +410,8 @@ void ClientHandlerAdaptor::HandleChannels(const QDBusObjectPath &accountPath,
 
     RequestTemporaryHandler *tempHandler = dynamic_cast<RequestTemporaryHandler *>(mClient);
     if (tempHandler) {
-        debug() << "  This is a temporary handler for the Request & Handle API,"
+        tpDebug(DebugCategoryDispatch) <<
+            "  This is a temporary handler for the Request & Handle API,"
             << "giving an early signal of the invocation";
         tempHandler->setDBusHandlerInvoked();
     }
@@ -475,7 +478,8 @@ void ClientHandlerAdaptor::HandleChannels(const QDBusObjectPath &accountPath,
 
     mInvocations.append(invocation);
 
-    debug() << "Preparing proxies for HandleChannels of" << channelDetailsList.size() << "channels"
+    tpDebug(DebugCategoryDispatch) << "Preparing proxies for HandleChannels of" <<
+        channelDetailsList.size() << "channels"
         << "for client" << mClient;
 }
 
@@ -508,7 +512,7 @@ void ClientHandlerAdaptor::onReadyOpFinished(Tp::PendingOperation *op)
         if (!invocation->error.isEmpty()) {
             RequestTemporaryHandler *tempHandler = dynamic_cast<RequestTemporaryHandler *>(mClient);
             if (tempHandler) {
-                debug() << "  This is a temporary handler for the Request & Handle API, indicating failure";
+                tpDebug(DebugCategoryDispatch) << "  This is a temporary handler for the Request & Handle API, indicating failure";
                 tempHandler->setDBusHandlerErrored(invocation->error, invocation->message);
             }
 
@@ -518,7 +522,8 @@ void ClientHandlerAdaptor::onReadyOpFinished(Tp::PendingOperation *op)
             continue;
         }
 
-        debug() << "Invoking application handleChannels with" << invocation->chans.size()
+        tpDebug(DebugCategoryDispatch) << "Invoking application handleChannels with" <<
+            invocation->chans.size()
             << "channels on" << mClient;
 
         mClient->handleChannels(invocation->ctx, invocation->acc, invocation->conn,
@@ -531,7 +536,7 @@ void ClientHandlerAdaptor::onContextFinished(
         const QList<ChannelPtr> &channels, ClientHandlerAdaptor *self)
 {
     if (!context->isError()) {
-        debug() << "HandleChannels context finished successfully, "
+        tpDebug(DebugCategoryDispatch) << "HandleChannels context finished successfully, "
             "updating handled channels";
 
         // register the channels in FakeHandlerManager so we report HandledChannels correctly
@@ -559,7 +564,7 @@ void ClientHandlerRequestsAdaptor::AddRequest(
         const QVariantMap &requestProperties,
         const QDBusMessage &message)
 {
-    debug() << "AddRequest:" << request.path();
+    tpDebug(DebugCategoryDispatch) << "AddRequest:" << request.path();
     message.setDelayedReply(true);
     mBus.send(message.createReply());
     mClient->addRequest(ChannelRequest::create(mBus,
@@ -575,7 +580,7 @@ void ClientHandlerRequestsAdaptor::RemoveRequest(
         const QString &errorName, const QString &errorMessage,
         const QDBusMessage &message)
 {
-    debug() << "RemoveRequest:" << request.path() << "-" << errorName
+    tpDebug(DebugCategoryDispatch) << "RemoveRequest:" << request.path() << "-" << errorName
         << "-" << errorMessage;
     message.setDelayedReply(true);
     mBus.send(message.createReply());
@@ -891,7 +896,7 @@ bool ClientRegistrar::registerClient(const AbstractClientPtr &client,
     }
 
     if (mPriv->clients.contains(client)) {
-        debug() << "Client already registered";
+        tpDebug(DebugCategoryDispatch) << "Client already registered";
         return true;
     }
 
@@ -983,7 +988,7 @@ bool ClientRegistrar::registerClient(const AbstractClientPtr &client,
         handler->setRegistered(true);
     }
 
-    debug() << "Client registered - busName:" << busName <<
+    tpDebug(DebugCategoryDispatch) << "Client registered - busName:" << busName <<
         "objectPath:" << objectPath << "interfaces:" << interfaces;
 
     mPriv->services.insert(busName);
@@ -1030,7 +1035,7 @@ bool ClientRegistrar::unregisterClient(const AbstractClientPtr &client)
     mPriv->bus.unregisterService(busName);
     mPriv->services.remove(busName);
 
-    debug() << "Client unregistered - busName:" << busName <<
+    tpDebug(DebugCategoryDispatch) << "Client unregistered - busName:" << busName <<
         "objectPath:" << objectPath;
 
     return true;
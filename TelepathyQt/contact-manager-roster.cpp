@@ -79,19 +79,19 @@ PendingOperation *ContactManager::Roster::introspect()
     ConnectionPtr conn(contactManager->connection());
 
     if (conn->hasInterface(TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_LIST)) {
-        debug() << "Connection.ContactList found, using it";
+        tpDebug(DebugCategoryContacts) << "Connection.ContactList found, using it";
 
         usingFallbackContactList = false;
 
         if (conn->hasInterface(TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_BLOCKING)) {
-            debug() << "Connection.ContactBlocking found. using it";
+            tpDebug(DebugCategoryContacts) << "Connection.ContactBlocking found. using it";
             hasContactBlockingInterface = true;
             introspectContactBlocking();
         } else {
-            debug() << "Connection.ContactBlocking not found, falling back "
+            tpDebug(DebugCategoryContacts) << "Connection.ContactBlocking not found, falling back "
                 "to contact list deny channel";
 
-            debug() << "Requesting handle for deny channel";
+            tpDebug(DebugCategoryContacts) << "Requesting handle for deny channel";
 
             contactListChannels.insert(ChannelInfo::TypeDeny,
                     ChannelInfo(ChannelInfo::TypeDeny));
@@ -104,7 +104,8 @@ PendingOperation *ContactManager::Roster::introspect()
                     SLOT(gotContactListChannelHandle(Tp::PendingOperation*)));
         }
     } else {
-        debug() << "Connection.ContactList not found, falling back to contact list channels";
+        tpDebug(DebugCategoryContacts) <<
+            "Connection.ContactList not found, falling back to contact list channels";
 
         usingFallbackContactList = true;
 
@@ -112,7 +113,7 @@ PendingOperation *ContactManager::Roster::introspect()
             QString channelId = ChannelInfo::identifierForType(
                     (ChannelInfo::Type) i);
 
-            debug() << "Requesting handle for" << channelId << "channel";
+            tpDebug(DebugCategoryContacts) << "Requesting handle for" << channelId << "channel";
 
             contactListChannels.insert(i,
                     ChannelInfo((ChannelInfo::Type) i));
@@ -142,10 +143,11 @@ PendingOperation *ContactManager::Roster::introspectGroups()
                     QLatin1String("Roster groups not supported"), conn);
         }
 
-        debug() << "Connection.ContactGroups found, using it";
+        tpDebug(DebugCategoryContacts) << "Connection.ContactGroups found, using it";
 
         if (!gotContactListInitialContacts) {
-            debug() << "Initial ContactList contacts not retrieved. Postponing introspection";
+            tpDebug(DebugCategoryContacts) <<
+                "Initial ContactList contacts not retrieved. Postponing introspection";
             groupsReintrospectionRequired = true;
             return new PendingSuccess(conn);
         }
@@ -171,7 +173,7 @@ PendingOperation *ContactManager::Roster::introspectGroups()
                 SIGNAL(finished(Tp::PendingOperation*)),
                 SLOT(gotContactListGroupsProperties(Tp::PendingOperation*)));
     } else {
-        debug() << "Connection.ContactGroups not found, falling back to contact list group channels";
+        tpDebug(DebugCategoryContacts) << "Connection.ContactGroups not found, falling back to contact list group channels";
 
         ++featureContactListGroupsTodo; // decremented in gotChannels
 
@@ -180,12 +182,12 @@ PendingOperation *ContactManager::Roster::introspectGroups()
         Client::ConnectionInterfaceRequestsInterface *iface =
             conn->interface<Client::ConnectionInterfaceRequestsInterface>();
 
-        debug() << "Connecting to Requests.NewChannels";
+        tpDebug(DebugCategoryContacts) << "Connecting to Requests.NewChannels";
         connect(iface,
                 SIGNAL(NewChannels(Tp::ChannelDetailsList)),
                 SLOT(onNewChannels(Tp::ChannelDetailsList)));
 
-        debug() << "Retrieving channels";
+        tpDebug(DebugCategoryContacts) << "Retrieving channels";
         Client::DBus::PropertiesInterface *properties =
             contactManager->connection()->interface<Client::DBus::PropertiesInterface>();
         QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
@@ -594,19 +596,19 @@ PendingOperation *ContactManager::Roster::removeContacts(
          */
 
         if (storedChannel && storedChannel->groupCanRemoveContacts()) {
-            debug() << "Removing contacts from stored list";
+            tpDebug(DebugCategoryContacts) << "Removing contacts from stored list";
             return storedChannel->groupRemoveContacts(contacts, message);
         }
 
         QList<PendingOperation*> operations;
 
         if (canRemovePresenceSubscription()) {
-            debug() << "Removing contacts from subscribe list";
+            tpDebug(DebugCategoryContacts) << "Removing contacts from subscribe list";
             operations << removePresenceSubscription(contacts, message);
         }
 
         if (canRemovePresencePublication()) {
-            debug() << "Removing contacts from publish list";
+            tpDebug(DebugCategoryContacts) << "Removing contacts from publish list";
             operations << removePresencePublication(contacts, message);
         }
 
@@ -700,7 +702,7 @@ void ContactManager::Roster::gotContactBlockingCapabilities(PendingOperation *op
         return;
     }
 
-    debug() << "Got ContactBlockingCapabilities property";
+    tpDebug(DebugCategoryContacts) << "Got ContactBlockingCapabilities property";
 
     PendingVariant *pv = qobject_cast<PendingVariant*>(op);
 
@@ -724,7 +726,7 @@ void ContactManager::Roster::gotContactBlockingBlockedContacts(
         return;
     }
 
-    debug() << "Got initial ContactBlocking blocked contacts";
+    tpDebug(DebugCategoryContacts) << "Got initial ContactBlocking blocked contacts";
 
     gotContactBlockingInitialBlockedContacts = true;
 
@@ -776,7 +778,7 @@ void ContactManager::Roster::gotContactListProperties(PendingOperation *op)
         return;
     }
 
-    debug() << "Got ContactList properties";
+    tpDebug(DebugCategoryContacts) << "Got ContactList properties";
 
     PendingVariantMap *pvm = qobject_cast<PendingVariantMap*>(op);
 
@@ -800,7 +802,7 @@ void ContactManager::Roster::gotContactListContacts(QDBusPendingCallWatcher *wat
         warning() << "Failed introspecting ContactList contacts";
 
         contactListState = ContactListStateFailure;
-        debug() << "Setting state to failure";
+        tpDebug(DebugCategoryContacts) << "Setting state to failure";
         emit contactManager->stateChanged((Tp::ContactListState) contactListState);
 
         // We may have been in state Failure and then Success, and FeatureRoster is already ready
@@ -812,7 +814,7 @@ void ContactManager::Roster::gotContactListContacts(QDBusPendingCallWatcher *wat
         return;
     }
 
-    debug() << "Got initial ContactList contacts";
+    tpDebug(DebugCategoryContacts) << "Got initial ContactList contacts";
 
     gotContactListInitialContacts = true;
 
@@ -867,7 +869,7 @@ void ContactManager::Roster::gotContactListContacts(QDBusPendingCallWatcher *wat
 void ContactManager::Roster::setStateSuccess()
 {
     if (contactManager->connection()->isValid()) {
-        debug() << "State is now success";
+        tpDebug(DebugCategoryContacts) << "State is now success";
         contactListState = ContactListStateSuccess;
         emit contactManager->stateChanged((Tp::ContactListState) contactListState);
     }
@@ -890,7 +892,8 @@ void ContactManager::Roster::onContactListStateChanged(uint state)
     contactListState = state;
 
     if (state == ContactListStateFailure) {
-        debug() << "State changed to failure, finishing roster introspection";
+        tpDebug(DebugCategoryContacts) <<
+            "State changed to failure, finishing roster introspection";
     }
 
     emit contactManager->stateChanged((Tp::ContactListState) state);
@@ -907,13 +910,15 @@ void ContactManager::Roster::onContactListStateChanged(uint state)
 void ContactManager::Roster::onContactListContactsChangedWithId(const Tp::ContactSubscriptionMap &changes,
         const Tp::HandleIdentifierMap &ids, const Tp::HandleIdentifierMap &removals)
 {
-    debug() << "Got ContactList.ContactsChangedWithID with" << changes.size() <<
+    tpDebug(DebugCategoryContacts) << "Got ContactList.ContactsChangedWithID with" <<
+        changes.size() <<
         "changes and" << removals.size() << "removals";
 
     gotContactListContactsChangedWithId = true;
 
     if (!gotContactListInitialContacts) {
-        debug() << "Ignoring ContactList changes until initial contacts are retrieved";
+        tpDebug(DebugCategoryContacts) <<
+            "Ignoring ContactList changes until initial contacts are retrieved";
         return;
     }
 
@@ -932,11 +937,12 @@ void ContactManager::Roster::onContactListContactsChanged(const Tp::ContactSubsc
         return;
     }
 
-    debug() << "Got ContactList.ContactsChanged with" << changes.size() <<
+    tpDebug(DebugCategoryContacts) << "Got ContactList.ContactsChanged with" << changes.size() <<
         "changes and" << removals.size() << "removals";
 
     if (!gotContactListInitialContacts) {
-        debug() << "Ignoring ContactList changes until initial contacts are retrieved";
+        tpDebug(DebugCategoryContacts) <<
+            "Ignoring ContactList changes until initial contacts are retrieved";
         return;
     }
 
@@ -977,7 +983,7 @@ void ContactManager::Roster::onContactListBlockedContactsConstructed(Tp::Pending
             continue;
         }
 
-        debug() << "Contact" << contact->id() << "is now blocked";
+        tpDebug(DebugCategoryContacts) << "Contact" << contact->id() << "is now blocked";
         blockedContacts.insert(contact);
         newBlockedContacts.insert(contact);
         contact->setBlocked(true);
@@ -994,7 +1000,7 @@ void ContactManager::Roster::onContactListBlockedContactsConstructed(Tp::Pending
             continue;
         }
 
-        debug() << "Contact" << contact->id() << "is now unblocked";
+        tpDebug(DebugCategoryContacts) << "Contact" << contact->id() << "is now unblocked";
         blockedContacts.remove(contact);
         unblockedContacts.insert(contact);
         contact->setBlocked(false);
@@ -1172,7 +1178,8 @@ void ContactManager::Roster::gotContactListChannelHandle(PendingOperation *op)
 
     if (op->isError()) {
         // let's not fail, because the contact lists are not supported
-        debug() << "Unable to retrieve handle for" << channelId << "channel, ignoring";
+        tpDebug(DebugCategoryContacts) << "Unable to retrieve handle for" << channelId <<
+            "channel, ignoring";
         contactListChannels.remove(type);
         onContactListChannelReady();
         return;
@@ -1180,7 +1187,8 @@ void ContactManager::Roster::gotContactListChannelHandle(PendingOperation *op)
 
     if (ph->invalidNames().size() == 1) {
         // let's not fail, because the contact lists are not supported
-        debug() << "Unable to retrieve handle for" << channelId << "channel, ignoring";
+        tpDebug(DebugCategoryContacts) << "Unable to retrieve handle for" << channelId <<
+            "channel, ignoring";
         contactListChannels.remove(type);
         onContactListChannelReady();
         return;
@@ -1188,7 +1196,7 @@ void ContactManager::Roster::gotContactListChannelHandle(PendingOperation *op)
 
     Q_ASSERT(ph->handles().size() == 1);
 
-    debug() << "Got handle for" << channelId << "channel";
+    tpDebug(DebugCategoryContacts) << "Got handle for" << channelId << "channel";
 
     if (!usingFallbackContactList) {
         Q_ASSERT(type == ChannelInfo::TypeDeny);
@@ -1199,7 +1207,7 @@ void ContactManager::Roster::gotContactListChannelHandle(PendingOperation *op)
     ReferencedHandles handle = ph->handles();
     contactListChannels[type].handle = handle;
 
-    debug() << "Requesting channel for" << channelId << "channel";
+    tpDebug(DebugCategoryContacts) << "Requesting channel for" << channelId << "channel";
     QVariantMap request;
     request.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType"),
             TP_QT_IFACE_CHANNEL_TYPE_CONTACT_LIST);
@@ -1219,7 +1227,7 @@ void ContactManager::Roster::gotContactListChannelHandle(PendingOperation *op)
 void ContactManager::Roster::gotContactListChannel(PendingOperation *op)
 {
     if (op->isError()) {
-        debug() << "Unable to create channel, ignoring";
+        tpDebug(DebugCategoryContacts) << "Unable to create channel, ignoring";
         onContactListChannelReady();
         return;
     }
@@ -1264,7 +1272,7 @@ void ContactManager::Roster::onContactListChannelReady()
     } else if (++contactListChannelsReady == ChannelInfo::LastType) {
         if (contactListChannels.isEmpty()) {
             contactListState = ContactListStateFailure;
-            debug() << "State is failure, roster not supported";
+            tpDebug(DebugCategoryContacts) << "State is failure, roster not supported";
             emit contactManager->stateChanged((Tp::ContactListState) contactListState);
 
             Q_ASSERT(introspectPendingOp);
@@ -1332,7 +1340,7 @@ void ContactManager::Roster::gotContactListGroupsProperties(PendingOperation *op
         return;
     }
 
-    debug() << "Got contact list groups properties";
+    tpDebug(DebugCategoryContacts) << "Got contact list groups properties";
     PendingVariantMap *pvm = qobject_cast<PendingVariantMap*>(op);
 
     QVariantMap props = pvm->result();
@@ -1429,7 +1437,7 @@ void ContactManager::Roster::gotChannels(QDBusPendingCallWatcher *watcher)
     QDBusPendingReply<QVariant> reply = *watcher;
 
     if (!reply.isError()) {
-        debug() << "Got channels";
+        tpDebug(DebugCategoryContacts) << "Got channels";
         onNewChannels(qdbus_cast<ChannelDetailsList>(reply.value()));
     } else {
         warning().nospace() << "Getting channels failed with " <<
@@ -1459,11 +1467,11 @@ void ContactManager::Roster::onStoredChannelMembersChanged(
     }
 
     foreach (ContactPtr contact, groupMembersAdded) {
-        debug() << "Contact" << contact->id() << "on stored list";
+        tpDebug(DebugCategoryContacts) << "Contact" << contact->id() << "on stored list";
     }
 
     foreach (ContactPtr contact, groupMembersRemoved) {
-        debug() << "Contact" << contact->id() << "removed from stored list";
+        tpDebug(DebugCategoryContacts) << "Contact" << contact->id() << "removed from stored list";
     }
 
     // Perform the needed computation for allKnownContactsChanged
@@ -1484,17 +1492,18 @@ void ContactManager::Roster::onSubscribeChannelMembersChanged(
     }
 
     foreach (ContactPtr contact, groupMembersAdded) {
-        debug() << "Contact" << contact->id() << "on subscribe list";
+        tpDebug(DebugCategoryContacts) << "Contact" << contact->id() << "on subscribe list";
         contact->setSubscriptionState(SubscriptionStateYes);
     }
 
     foreach (ContactPtr contact, groupRemotePendingMembersAdded) {
-        debug() << "Contact" << contact->id() << "added to subscribe list";
+        tpDebug(DebugCategoryContacts) << "Contact" << contact->id() << "added to subscribe list";
         contact->setSubscriptionState(SubscriptionStateAsk);
     }
 
     foreach (ContactPtr contact, groupMembersRemoved) {
-        debug() << "Contact" << contact->id() << "removed from subscribe list";
+        tpDebug(DebugCategoryContacts) << "Contact" << contact->id() <<
+            "removed from subscribe list";
         contact->setSubscriptionState(SubscriptionStateNo);
     }
 
@@ -1516,17 +1525,17 @@ void ContactManager::Roster::onPublishChannelMembersChanged(
     }
 
     foreach (ContactPtr contact, groupMembersAdded) {
-        debug() << "Contact" << contact->id() << "on publish list";
+        tpDebug(DebugCategoryContacts) << "Contact" << contact->id() << "on publish list";
         contact->setPublishState(SubscriptionStateYes);
     }
 
     foreach (ContactPtr contact, groupLocalPendingMembersAdded) {
-        debug() << "Contact" << contact->id() << "added to publish list";
+        tpDebug(DebugCategoryContacts) << "Contact" << contact->id() << "added to publish list";
         contact->setPublishState(SubscriptionStateAsk, details.message());
     }
 
     foreach (ContactPtr contact, groupMembersRemoved) {
-        debug() << "Contact" << contact->id() << "removed from publish list";
+        tpDebug(DebugCategoryContacts) << "Contact" << contact->id() << "removed from publish list";
         contact->setPublishState(SubscriptionStateNo);
     }
 
@@ -1556,12 +1565,12 @@ void ContactManager::Roster::onDenyChannelMembersChanged(
     }
 
     foreach (ContactPtr contact, groupMembersAdded) {
-        debug() << "Contact" << contact->id() << "added to deny list";
+        tpDebug(DebugCategoryContacts) << "Contact" << contact->id() << "added to deny list";
         contact->setBlocked(true);
     }
 
     foreach (ContactPtr contact, groupMembersRemoved) {
-        debug() << "Contact" << contact->id() << "removed from deny list";
+        tpDebug(DebugCategoryContacts) << "Contact" << contact->id() << "removed from deny list";
         contact->setBlocked(false);
     }
 
@@ -1614,7 +1623,7 @@ void ContactManager::Roster::onContactListGroupRemoved(Tp::DBusProxy *proxy,
 
 void ContactManager::Roster::introspectContactBlocking()
 {
-    debug() << "Requesting ContactBlockingCapabilities property";
+    tpDebug(DebugCategoryContacts) << "Requesting ContactBlockingCapabilities property";
 
     ConnectionPtr conn(contactManager->connection());
 
@@ -1649,7 +1658,7 @@ void ContactManager::Roster::introspectContactBlockingBlockedContacts()
 
 void ContactManager::Roster::introspectContactList()
 {
-    debug() << "Requesting ContactList properties";
+    tpDebug(DebugCategoryContacts) << "Requesting ContactList properties";
 
     ConnectionPtr conn(contactManager->connection());
 
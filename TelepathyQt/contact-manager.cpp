@@ -25,8 +25,11 @@
 
 #include "TelepathyQt/_gen/contact-manager.moc.hpp"
 
+#include "TelepathyQt/avatar-cache.h"
 #include "TelepathyQt/debug-internal.h"
+#include "TelepathyQt/feature-internal.h"
 #include "TelepathyQt/future-internal.h"
+#include "TelepathyQt/pending-contacts-internal.h"
 
 #include <TelepathyQt/AvatarData>
 #include <TelepathyQt/Connection>
@@ -52,8 +55,8 @@ struct TP_QT_NO_EXPORT ContactManager::Private
     ~Private();
 
     // avatar specific methods
-    bool buildAvatarFileName(QString token, bool createDir,
-        QString &avatarFileName, QString &mimeTypeFileName);
+    QString buildAvatarCachePath();
+    AvatarCache *ensureAvatarCache();
     Features realFeatures(const Features &features);
     QSet<QString> interfacesForFeatures(const Features &features);
 
@@ -62,6 +65,10 @@ struct TP_QT_NO_EXPORT ContactManager::Private
     ContactManager::Roster *roster;
 
     QHash<uint, WeakPtr<Contact> > contacts;
+    // identifier -> handle, so known contacts can be found without RequestHandles
+    QHash<QString, uint> identifierHandles;
+    // handle -> identifiers, to drop them from identifierHandles with the contact
+    QMultiHash<uint, QString> handleIdentifiers;
 
     QHash<Feature, bool> tracking;
     Features supportedFeatures;
@@ -69,9 +76,20 @@ struct TP_QT_NO_EXPORT ContactManager::Private
     // avatar
     QSet<ContactPtr> requestAvatarsQueue;
     bool requestAvatarsIdle;
+    AvatarCache *avatarCache;
+    bool syncAvatarCacheQueued;
 
     // contact info
     PendingRefreshContactInfo *refreshInfoOp;
+
+    // change coalescing
+    bool coalesceChanges;
+    int coalesceInterval;
+    bool flushChangesQueued;
+    QList<ContactPtr> changedContacts;
+    QHash<Contact*, ContactManager::ChangedFields> contactChanges;
+
+    ContactAttributesScheduler *attributesScheduler;
 };
 
 ContactManager::Private::Private(ContactManager *parent, Connection *connection)
@@ -79,18 +97,26 @@ ContactManager::Private::Private(ContactManager *parent, Connection *connection)
       connection(connection),
       roster(new ContactManager::Roster(parent)),
       requestAvatarsIdle(false),
-      refreshInfoOp(0)
+      avatarCache(0),
+      syncAvatarCacheQueued(false),
+      refreshInfoOp(0),
+      coalesceChanges(false),
+      coalesceInterval(0),
+      flushChangesQueued(false),
+      attributesScheduler(new ContactAttributesScheduler(parent))
 {
 }
 
 ContactManager::Private::~Private()
 {
     delete refreshInfoOp;
+    delete attributesScheduler;
     delete roster;
+    // writes out the index if it has pending changes
+    delete avatarCache;
 }
 
-bool ContactManager::Private::buildAvatarFileName(QString token, bool createDir,
-        QString &avatarFileName, QString &mimeTypeFileName)
+QString ContactManager::Private::buildAvatarCachePath()
 {
     QString cacheDir = QString(QLatin1String(qgetenv("XDG_CACHE_HOME")));
     if (cacheDir.isEmpty()) {
@@ -98,17 +124,16 @@ bool ContactManager::Private::buildAvatarFileName(QString token, bool createDir,
     }
 
     ConnectionPtr conn(parent->connection());
-    QString path = QString(QLatin1String("%1/telepathy/avatars/%2/%3")).
+    return QString(QLatin1String("%1/telepathy/avatars/%2/%3")).
         arg(cacheDir).arg(conn->cmName()).arg(conn->protocolName());
+}
 
-    if (createDir && !QDir().mkpath(path)) {
-        return false;
+AvatarCache *ContactManager::Private::ensureAvatarCache()
+{
+    if (!avatarCache) {
+        avatarCache = new AvatarCache(buildAvatarCachePath());
     }
-
-    avatarFileName = QString(QLatin1String("%1/%2")).arg(path).arg(escapeAsIdentifier(token));
-    mimeTypeFileName = QString(QLatin1String("%1.mime")).arg(avatarFileName);
-
-    return true;
+    return avatarCache;
 }
 
 Features ContactManager::Private::realFeatures(const Features &features)
@@ -169,7 +194,8 @@ void ContactManager::PendingRefreshContactInfo::refreshInfo()
         return;
     }
 
-    debug() << "Calling ContactInfo.RefreshContactInfo for" << mToRequest.size() << "handles";
+    tpDebug(DebugCategoryContacts) << "Calling ContactInfo.RefreshContactInfo for" <<
+        mToRequest.size() << "handles";
     Client::ConnectionInterfaceContactInfoInterface *contactInfoInterface =
         mConn->interface<Client::ConnectionInterfaceContactInfoInterface>();
     Q_ASSERT(contactInfoInterface);
@@ -188,7 +214,7 @@ void ContactManager::PendingRefreshContactInfo::onRefreshInfoFinished(PendingOpe
             op->errorName() << "-" << op->errorMessage();
         setFinishedWithError(op->errorName(), op->errorMessage());
     } else {
-        debug() << "Got reply to ContactInfo.RefreshContactInfo";
+        tpDebug(DebugCategoryContacts) << "Got reply to ContactInfo.RefreshContactInfo";
         setFinished();
     }
 }
@@ -261,7 +287,8 @@ Features ContactManager::supportedFeatures() const
             }
         }
 
-        debug() << mPriv->supportedFeatures.size() << "contact features supported using" << this;
+        tpDebug(DebugCategoryContacts) << mPriv->supportedFeatures.size() <<
+            "contact features supported using" << this;
     }
 
     return mPriv->supportedFeatures;
@@ -993,7 +1020,7 @@ PendingContacts *ContactManager::contactsForHandles(const UIntList &handles,
 {
     QMap<uint, ContactPtr> satisfyingContacts;
     QSet<uint> otherContacts;
-    Features missingFeatures;
+    FeatureMask missingFeatures;
 
     if (!connection()->isValid()) {
         return new PendingContacts(ContactManagerPtr(this), handles, features, Features(),
@@ -1022,28 +1049,30 @@ PendingContacts *ContactManager::contactsForHandles(const UIntList &handles,
         }
     }
 
+    const FeatureMask realMask(realFeatures);
     foreach (uint handle, handles) {
         ContactPtr contact = lookupContactByHandle(handle);
         if (contact) {
-            if ((realFeatures - contact->requestedFeatures()).isEmpty()) {
+            if (contact->requestedFeatureMask().contains(realMask)) {
                 // Contact exists and has all the requested features
                 satisfyingContacts.insert(handle, contact);
             } else {
                 // Contact exists but is missing features
                 otherContacts.insert(handle);
-                missingFeatures.unite(realFeatures - contact->requestedFeatures());
+                missingFeatures |= realMask - contact->requestedFeatureMask();
             }
         } else {
             // Contact doesn't exist - we need to get all of the features (same as unite(features))
-            missingFeatures = realFeatures;
+            missingFeatures = realMask;
             otherContacts.insert(handle);
         }
     }
 
-    QSet<QString> interfaces = mPriv->interfacesForFeatures(missingFeatures);
+    Features missing = missingFeatures.toFeatures();
+    QSet<QString> interfaces = mPriv->interfacesForFeatures(missing);
 
     PendingContacts *contacts =
-        new PendingContacts(ContactManagerPtr(this), handles, features, missingFeatures,
+        new PendingContacts(ContactManagerPtr(this), handles, features, missing,
                 interfaces.toList(), satisfyingContacts, otherContacts);
     return contacts;
 }
@@ -1189,6 +1218,76 @@ ContactPtr ContactManager::lookupContactByHandle(uint handle)
     return contact;
 }
 
+// The known contact for handle, if it already has all the features contactsForHandles(handle)
+// would get for it
+ContactPtr ContactManager::lookupSatisfyingContact(uint handle)
+{
+    ContactPtr contact = lookupContactByHandle(handle);
+    if (contact &&
+            !contact->requestedFeatureMask().contains(FeatureMask(mPriv->realFeatures(Features())))) {
+        return ContactPtr();
+    }
+    return contact;
+}
+
+ContactPtr ContactManager::lookupContactByIdentifier(const QString &identifier)
+{
+    QHash<QString, uint>::iterator i = mPriv->identifierHandles.find(identifier);
+    if (i == mPriv->identifierHandles.end()) {
+        return ContactPtr();
+    }
+
+    ContactPtr contact = lookupContactByHandle(i.value());
+    if (!contact) {
+        // The contact went away, the handle may be reused for someone else
+        mPriv->handleIdentifiers.remove(i.value(), identifier);
+        mPriv->identifierHandles.erase(i);
+    }
+
+    return contact;
+}
+
+void ContactManager::addContactIdentifier(const QString &identifier, uint handle)
+{
+    if (identifier.isEmpty()) {
+        return;
+    }
+
+    QHash<QString, uint>::iterator i = mPriv->identifierHandles.find(identifier);
+    if (i != mPriv->identifierHandles.end()) {
+        if (i.value() == handle) {
+            return;
+        }
+        mPriv->handleIdentifiers.remove(i.value(), identifier);
+        i.value() = handle;
+    } else {
+        mPriv->identifierHandles.insert(identifier, handle);
+    }
+    mPriv->handleIdentifiers.insert(handle, identifier);
+}
+
+/*
+ * Called by the Contact destructor, so that contacts and identifierHandles don't keep growing
+ * with the contacts which are gone.
+ */
+void ContactManager::forgetContact(uint handle)
+{
+    QHash<uint, WeakPtr<Contact> >::iterator i = mPriv->contacts.find(handle);
+    if (i == mPriv->contacts.end() || !i.value().isNull()) {
+        // Another contact object took over the handle already
+        return;
+    }
+    mPriv->contacts.erase(i);
+
+    foreach (const QString &identifier, mPriv->handleIdentifiers.values(handle)) {
+        QHash<QString, uint>::iterator j = mPriv->identifierHandles.find(identifier);
+        if (j != mPriv->identifierHandles.end() && j.value() == handle) {
+            mPriv->identifierHandles.erase(j);
+        }
+    }
+    mPriv->handleIdentifiers.remove(handle);
+}
+
 /**
  * Start a request to retrieve the avatar for the given \a contacts.
  *
@@ -1244,9 +1343,187 @@ PendingOperation *ContactManager::refreshContactInfo(const QList<ContactPtr> &co
     return mPriv->refreshInfoOp;
 }
 
+/**
+ * Return whether contact changes are also reported in batches by contactsChanged().
+ *
+ * \return \c true if change coalescing is enabled, \c false otherwise.
+ * \sa setChangeCoalescingEnabled()
+ */
+bool ContactManager::isChangeCoalescingEnabled() const
+{
+    return mPriv->coalesceChanges;
+}
+
+/**
+ * Set whether contact changes should also be reported in batches by contactsChanged().
+ *
+ * When enabled, the changes of all the contacts built by this manager are merged per
+ * contact during changeCoalescingInterval() and then reported together, which is useful
+ * when a whole roster changes at once, for instance when the connection comes online.
+ * The per-contact change signals such as Contact::presenceChanged() are still emitted
+ * immediately.
+ *
+ * Disabling change coalescing reports the pending changes right away.
+ * Change coalescing is disabled by default.
+ *
+ * \param enabled Whether to enable change coalescing.
+ * \sa contactsChanged(), setChangeCoalescingInterval()
+ */
+void ContactManager::setChangeCoalescingEnabled(bool enabled)
+{
+    mPriv->coalesceChanges = enabled;
+    if (!enabled && !mPriv->changedContacts.isEmpty()) {
+        doFlushContactChanges();
+    }
+}
+
+/**
+ * Return the time in milliseconds during which contact changes are merged before being
+ * reported by contactsChanged().
+ *
+ * \return The interval in milliseconds.
+ * \sa setChangeCoalescingInterval()
+ */
+int ContactManager::changeCoalescingInterval() const
+{
+    return mPriv->coalesceInterval;
+}
+
+/**
+ * Set the time in milliseconds during which contact changes are merged before being
+ * reported by contactsChanged(), starting from the first unreported change.
+ *
+ * The default value of 0 reports the changes once control returns to the event loop.
+ *
+ * \param msecs The interval in milliseconds.
+ * \sa setChangeCoalescingEnabled()
+ */
+void ContactManager::setChangeCoalescingInterval(int msecs)
+{
+    mPriv->coalesceInterval = qMax(msecs, 0);
+}
+
+/**
+ * Return the maximum number of contacts whose attributes are retrieved with a single
+ * D-Bus call.
+ *
+ * \return The number of contacts, or 0 if requests are never split.
+ * \sa setContactAttributesChunkSize()
+ */
+int ContactManager::contactAttributesChunkSize() const
+{
+    return mPriv->attributesScheduler->chunkSize();
+}
+
+/**
+ * Set the maximum number of contacts whose attributes are retrieved with a single
+ * D-Bus call.
+ *
+ * The contacts requested with contactsForHandles() (and the other methods retrieving
+ * new contacts) during the same main loop iteration, for the same features, are fetched
+ * together, and contacts whose attributes are already being retrieved are not requested
+ * again. The resulting set is split into calls for at most \a size contacts each, so
+ * that replies for very large sets, such as a whole roster, don't block the event loop
+ * while they are being demarshalled.
+ *
+ * The default value is 500.
+ *
+ * \param size The number of contacts, or 0 to never split requests.
+ * \sa setMaxContactAttributesRequestsInFlight()
+ */
+void ContactManager::setContactAttributesChunkSize(int size)
+{
+    mPriv->attributesScheduler->setChunkSize(size);
+}
+
+/**
+ * Return the maximum number of contact attribute D-Bus calls waiting for a reply at
+ * any time.
+ *
+ * \return The number of calls, or 0 if unlimited.
+ * \sa setMaxContactAttributesRequestsInFlight()
+ */
+int ContactManager::maxContactAttributesRequestsInFlight() const
+{
+    return mPriv->attributesScheduler->maxChunksInFlight();
+}
+
+/**
+ * Set the maximum number of contact attribute D-Bus calls waiting for a reply at
+ * any time.
+ *
+ * Further calls are made as soon as earlier ones return. The default value is 4.
+ *
+ * \param max The number of calls, or 0 for no limit.
+ * \sa setContactAttributesChunkSize()
+ */
+void ContactManager::setMaxContactAttributesRequestsInFlight(int max)
+{
+    mPriv->attributesScheduler->setMaxChunksInFlight(max);
+}
+
+ContactAttributesScheduler *ContactManager::attributesScheduler() const
+{
+    return mPriv->attributesScheduler;
+}
+
+void ContactManager::contactChanged(Contact *contact, ChangedField change)
+{
+    if (!mPriv->coalesceChanges) {
+        return;
+    }
+
+    QHash<Contact*, ChangedFields>::iterator i = mPriv->contactChanges.find(contact);
+    if (i != mPriv->contactChanges.end()) {
+        *i |= change;
+        return;
+    }
+
+    mPriv->contactChanges.insert(contact, change);
+    mPriv->changedContacts.append(ContactPtr(contact));
+
+    if (!mPriv->flushChangesQueued) {
+        mPriv->flushChangesQueued = true;
+        QTimer::singleShot(mPriv->coalesceInterval, this, SLOT(doFlushContactChanges()));
+    }
+}
+
+void ContactManager::doFlushContactChanges()
+{
+    mPriv->flushChangesQueued = false;
+
+    QList<ContactPtr> changedContacts = mPriv->changedContacts;
+    QHash<Contact*, ChangedFields> contactChanges = mPriv->contactChanges;
+    mPriv->changedContacts.clear();
+    mPriv->contactChanges.clear();
+
+    if (changedContacts.isEmpty()) {
+        return;
+    }
+
+    // One signal per distinct set of changes, in order of first change; for a presence
+    // storm that is a single signal for the whole roster
+    QList<ChangedFields> changeSets;
+    QHash<int, QList<ContactPtr> > contactsByChanges;
+    foreach (const ContactPtr &contact, changedContacts) {
+        ChangedFields changes = contactChanges.value(contact.data());
+        if (!contactsByChanges.contains(int(changes))) {
+            changeSets.append(changes);
+        }
+        contactsByChanges[int(changes)].append(contact);
+    }
+
+    tpDebug(DebugCategoryContacts) << "Reporting changes for" << changedContacts.size() <<
+        "contacts";
+
+    foreach (ChangedFields changes, changeSets) {
+        emit contactsChanged(contactsByChanges.value(int(changes)), changes);
+    }
+}
+
 void ContactManager::onAliasesChanged(const AliasPairList &aliases)
 {
-    debug() << "Got AliasesChanged for" << aliases.size() << "contacts";
+    tpDebug(DebugCategoryContacts) << "Got AliasesChanged for" << aliases.size() << "contacts";
 
     foreach (AliasPair pair, aliases) {
         ContactPtr contact = lookupContactByHandle(pair.handle);
@@ -1266,6 +1543,19 @@ void ContactManager::doRequestAvatars()
     mPriv->requestAvatarsQueue.clear();
     mPriv->requestAvatarsIdle = false;
 
+    QStringList tokens;
+    foreach (const ContactPtr &contact, contacts) {
+        if (contact && contact->isAvatarTokenKnown()) {
+            tokens << contact->avatarToken();
+        }
+    }
+
+    /* Resolve all the known tokens against the cache index in one go */
+    QHash<QString, AvatarData> cached;
+    if (!tokens.isEmpty()) {
+        cached = mPriv->ensureAvatarCache()->lookup(tokens);
+    }
+
     int found = 0;
     UIntList notFound;
     foreach (const ContactPtr &contact, contacts) {
@@ -1273,38 +1563,27 @@ void ContactManager::doRequestAvatars()
             continue;
         }
 
-        QString avatarFileName;
-        QString mimeTypeFileName;
-        bool success = (contact->isAvatarTokenKnown() &&
-            mPriv->buildAvatarFileName(contact->avatarToken(), false,
-                avatarFileName, mimeTypeFileName));
-
-        /* Check if the avatar is already in the cache */
-        if (success && QFile::exists(avatarFileName)) {
-            QFile mimeTypeFile(mimeTypeFileName);
-            mimeTypeFile.open(QIODevice::ReadOnly);
-            QString mimeType = QString(QLatin1String(mimeTypeFile.readAll()));
-            mimeTypeFile.close();
-
-            found++;
-
-            contact->receiveAvatarData(AvatarData(avatarFileName, mimeType));
-
-            continue;
+        if (contact->isAvatarTokenKnown()) {
+            QHash<QString, AvatarData>::const_iterator i = cached.constFind(contact->avatarToken());
+            if (i != cached.constEnd()) {
+                found++;
+                contact->receiveAvatarData(i.value());
+                continue;
+            }
         }
 
         notFound << contact->handle()[0];
     }
 
     if (found > 0) {
-        debug() << "Avatar(s) found in cache for" << found << "contact(s)";
+        tpDebug(DebugCategoryContacts) << "Avatar(s) found in cache for" << found << "contact(s)";
     }
 
-    if (found == contacts.size()) {
+    if (notFound.isEmpty()) {
         return;
     }
 
-    debug() << "Requesting avatar(s) for" << contacts.size() - found << "contact(s)";
+    tpDebug(DebugCategoryContacts) << "Requesting avatar(s) for" << notFound.size() << "contact(s)";
 
     Client::ConnectionInterfaceAvatarsInterface *avatarsInterface =
         connection()->interface<Client::ConnectionInterfaceAvatarsInterface>();
@@ -1317,7 +1596,7 @@ void ContactManager::doRequestAvatars()
 
 void ContactManager::onAvatarUpdated(uint handle, const QString &token)
 {
-    debug() << "Got AvatarUpdate for contact with handle" << handle;
+    tpDebug(DebugCategoryContacts) << "Got AvatarUpdate for contact with handle" << handle;
 
     ContactPtr contact = lookupContactByHandle(handle);
     if (contact) {
@@ -1328,52 +1607,40 @@ void ContactManager::onAvatarUpdated(uint handle, const QString &token)
 void ContactManager::onAvatarRetrieved(uint handle, const QString &token,
     const QByteArray &data, const QString &mimeType)
 {
-    QString avatarFileName;
-    QString mimeTypeFileName;
-
-    debug() << "Got AvatarRetrieved for contact with handle" << handle;
-
-    bool success = mPriv->buildAvatarFileName(token, true, avatarFileName,
-        mimeTypeFileName);
+    tpDebug(DebugCategoryContacts) << "Got AvatarRetrieved for contact with handle" << handle;
 
-    if (success) {
-        debug() << "Write avatar in cache for handle" << handle;
-        debug() << "Filename:" << avatarFileName;
-        debug() << "MimeType:" << mimeType;
+    AvatarData avatarData = mPriv->ensureAvatarCache()->insert(token, data, mimeType);
 
-        if (!QFile::exists(mimeTypeFileName)) {
-            QTemporaryFile mimeTypeFile(mimeTypeFileName);
-            if (mimeTypeFile.open()) {
-                mimeTypeFile.write(mimeType.toLatin1());
-                mimeTypeFile.setAutoRemove(false);
-                if (!mimeTypeFile.rename(mimeTypeFileName)) {
-                    mimeTypeFile.remove();
-                }
-            }
-        }
+    tpDebug(DebugCategoryContacts) << "Write avatar in cache for handle" << handle;
+    tpDebug(DebugCategoryContacts) << "Filename:" << avatarData.fileName;
+    tpDebug(DebugCategoryContacts) << "MimeType:" << mimeType;
 
-        if (!QFile::exists(avatarFileName)) {
-            QTemporaryFile avatarFile(avatarFileName);
-            if (avatarFile.open()) {
-                avatarFile.write(data);
-                avatarFile.setAutoRemove(false);
-                if (!avatarFile.rename(avatarFileName)) {
-                    avatarFile.remove();
-                }
-            }
-        }
+    // AvatarRetrieved usually comes in bursts, write the index once per burst
+    if (!mPriv->syncAvatarCacheQueued) {
+        mPriv->syncAvatarCacheQueued = true;
+        QTimer::singleShot(0, this, SLOT(doSyncAvatarCache()));
     }
 
     ContactPtr contact = lookupContactByHandle(handle);
     if (contact) {
         contact->setAvatarToken(token);
-        contact->receiveAvatarData(AvatarData(avatarFileName, mimeType));
+        contact->receiveAvatarData(avatarData);
+    }
+}
+
+void ContactManager::doSyncAvatarCache()
+{
+    Q_ASSERT(mPriv->syncAvatarCacheQueued);
+    mPriv->syncAvatarCacheQueued = false;
+
+    if (mPriv->avatarCache) {
+        mPriv->avatarCache->sync();
     }
 }
 
 void ContactManager::onPresencesChanged(const SimpleContactPresences &presences)
 {
-    debug() << "Got PresencesChanged for" << presences.size() << "contacts";
+    tpDebug(DebugCategoryContacts) << "Got PresencesChanged for" << presences.size() << "contacts";
 
     foreach (uint handle, presences.keys()) {
         ContactPtr contact = lookupContactByHandle(handle);
@@ -1386,7 +1653,8 @@ void ContactManager::onPresencesChanged(const SimpleContactPresences &presences)
 
 void ContactManager::onCapabilitiesChanged(const ContactCapabilitiesMap &caps)
 {
-    debug() << "Got ContactCapabilitiesChanged for" << caps.size() << "contacts";
+    tpDebug(DebugCategoryContacts) << "Got ContactCapabilitiesChanged for" << caps.size() <<
+        "contacts";
 
     foreach (uint handle, caps.keys()) {
         ContactPtr contact = lookupContactByHandle(handle);
@@ -1399,7 +1667,7 @@ void ContactManager::onCapabilitiesChanged(const ContactCapabilitiesMap &caps)
 
 void ContactManager::onLocationUpdated(uint handle, const QVariantMap &location)
 {
-    debug() << "Got LocationUpdated for contact with handle" << handle;
+    tpDebug(DebugCategoryContacts) << "Got LocationUpdated for contact with handle" << handle;
 
     ContactPtr contact = lookupContactByHandle(handle);
 
@@ -1410,7 +1678,7 @@ void ContactManager::onLocationUpdated(uint handle, const QVariantMap &location)
 
 void ContactManager::onContactInfoChanged(uint handle, const Tp::ContactInfoFieldList &info)
 {
-    debug() << "Got ContactInfoChanged for contact with handle" << handle;
+    tpDebug(DebugCategoryContacts) << "Got ContactInfoChanged for contact with handle" << handle;
 
     ContactPtr contact = lookupContactByHandle(handle);
 
@@ -1421,7 +1689,7 @@ void ContactManager::onContactInfoChanged(uint handle, const Tp::ContactInfoFiel
 
 void ContactManager::onClientTypesUpdated(uint handle, const QStringList &clientTypes)
 {
-    debug() << "Got ClientTypesUpdated for contact with handle" << handle;
+    tpDebug(DebugCategoryContacts) << "Got ClientTypesUpdated for contact with handle" << handle;
 
     ContactPtr contact = lookupContactByHandle(handle);
 
@@ -1450,6 +1718,7 @@ ContactPtr ContactManager::ensureContact(const ReferencedHandles &handle,
     }
 
     contact->augment(features, attributes);
+    addContactIdentifier(contact->id(), bareHandle);
 
     return contact;
 }
@@ -1467,6 +1736,7 @@ ContactPtr ContactManager::ensureContact(uint bareHandle, const QString &id,
                 ReferencedHandles(connection(), HandleTypeContact, UIntList() << bareHandle),
                 features, attributes);
         mPriv->contacts.insert(bareHandle, contact);
+        addContactIdentifier(id, bareHandle);
 
         // do not call augment here as this is a fake contact
     }
@@ -1664,4 +1934,18 @@ void ContactManager::resetRoster()
  * \sa allKnownContacts()
  */
 
+/**
+ * \fn void ContactManager::contactsChanged(const QList<Tp::ContactPtr> &contacts,
+ *          Tp::ContactManager::ChangedFields changes)
+ *
+ * Emitted when change coalescing is enabled and the given \a contacts have changed.
+ *
+ * Each contact is reported at most once per coalescing interval. When contacts have
+ * different sets of changes, this signal is emitted once per distinct set.
+ *
+ * \param contacts The contacts that have changed, in order of their first change.
+ * \param changes The fields that have changed on all the \a contacts.
+ * \sa setChangeCoalescingEnabled()
+ */
+
 } // Tp
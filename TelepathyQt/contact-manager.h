@@ -44,6 +44,7 @@ namespace Tp
 {
 
 class Connection;
+class ContactAttributesScheduler;
 class PendingContacts;
 class PendingOperation;
 
@@ -53,6 +54,22 @@ class TP_QT_EXPORT ContactManager : public Object
     Q_DISABLE_COPY(ContactManager)
 
 public:
+    enum ChangedField {
+        AliasChanged = 0x0001,
+        AvatarTokenChanged = 0x0002,
+        AvatarDataChanged = 0x0004,
+        PresenceChanged = 0x0008,
+        CapabilitiesChanged = 0x0010,
+        LocationChanged = 0x0020,
+        InfoFieldsChanged = 0x0040,
+        ClientTypesChanged = 0x0080,
+        SubscriptionStateChanged = 0x0100,
+        PublishStateChanged = 0x0200,
+        BlockStatusChanged = 0x0400,
+        GroupsChanged = 0x0800
+    };
+    Q_DECLARE_FLAGS(ChangedFields, ChangedField)
+
     virtual ~ContactManager();
 
     ConnectionPtr connection() const;
@@ -129,6 +146,16 @@ public:
 
     PendingOperation *refreshContactInfo(const QList<ContactPtr> &contact);
 
+    bool isChangeCoalescingEnabled() const;
+    void setChangeCoalescingEnabled(bool enabled);
+    int changeCoalescingInterval() const;
+    void setChangeCoalescingInterval(int msecs);
+
+    int contactAttributesChunkSize() const;
+    void setContactAttributesChunkSize(int size);
+    int maxContactAttributesRequestsInFlight() const;
+    void setMaxContactAttributesRequestsInFlight(int max);
+
 Q_SIGNALS:
     void stateChanged(Tp::ContactListState state);
 
@@ -147,30 +174,41 @@ Q_SIGNALS:
             const Tp::Contacts &contactsRemoved,
             const Tp::Channel::GroupMemberChangeDetails &details);
 
+    void contactsChanged(const QList<Tp::ContactPtr> &contacts,
+            Tp::ContactManager::ChangedFields changes);
+
 private Q_SLOTS:
     TP_QT_NO_EXPORT void onAliasesChanged(const Tp::AliasPairList &);
     TP_QT_NO_EXPORT void doRequestAvatars();
     TP_QT_NO_EXPORT void onAvatarUpdated(uint, const QString &);
     TP_QT_NO_EXPORT void onAvatarRetrieved(uint, const QString &, const QByteArray &, const QString &);
+    TP_QT_NO_EXPORT void doSyncAvatarCache();
     TP_QT_NO_EXPORT void onPresencesChanged(const Tp::SimpleContactPresences &);
     TP_QT_NO_EXPORT void onCapabilitiesChanged(const Tp::ContactCapabilitiesMap &);
     TP_QT_NO_EXPORT void onLocationUpdated(uint, const QVariantMap &);
     TP_QT_NO_EXPORT void onContactInfoChanged(uint, const Tp::ContactInfoFieldList &);
     TP_QT_NO_EXPORT void onClientTypesUpdated(uint, const QStringList &);
     TP_QT_NO_EXPORT void doRefreshInfo();
+    TP_QT_NO_EXPORT void doFlushContactChanges();
 
 private:
     class PendingRefreshContactInfo;
     class Roster;
     friend class Channel;
     friend class Connection;
+    friend class Contact;
     friend class PendingContacts;
     friend class PendingRefreshContactInfo;
     friend class Roster;
+    friend class TextChannel;
 
     TP_QT_NO_EXPORT ContactManager(Connection *parent);
 
     TP_QT_NO_EXPORT ContactPtr lookupContactByHandle(uint handle);
+    TP_QT_NO_EXPORT ContactPtr lookupSatisfyingContact(uint handle);
+    TP_QT_NO_EXPORT ContactPtr lookupContactByIdentifier(const QString &identifier);
+    TP_QT_NO_EXPORT void addContactIdentifier(const QString &identifier, uint handle);
+    TP_QT_NO_EXPORT void forgetContact(uint handle);
 
     TP_QT_NO_EXPORT ContactPtr ensureContact(const ReferencedHandles &handle,
             const Features &features,
@@ -187,6 +225,10 @@ private:
 
     TP_QT_NO_EXPORT PendingOperation *refreshContactInfo(Contact *contact);
 
+    TP_QT_NO_EXPORT void contactChanged(Contact *contact, ChangedField change);
+
+    TP_QT_NO_EXPORT ContactAttributesScheduler *attributesScheduler() const;
+
     struct Private;
     friend struct Private;
     Private *mPriv;
@@ -194,4 +236,6 @@ private:
 
 } // Tp
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(Tp::ContactManager::ChangedFields)
+
 #endif
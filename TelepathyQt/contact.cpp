@@ -25,6 +25,7 @@
 #include "TelepathyQt/_gen/contact.moc.hpp"
 
 #include "TelepathyQt/debug-internal.h"
+#include "TelepathyQt/feature-internal.h"
 #include "TelepathyQt/future-internal.h"
 
 #include <TelepathyQt/AvatarData>
@@ -43,6 +44,109 @@
 namespace Tp
 {
 
+namespace
+{
+
+enum ContactAttribute {
+    ContactAttributeId = 0,
+    ContactAttributeSubscribe,
+    ContactAttributePublish,
+    ContactAttributePublishRequest,
+    ContactAttributeAlias,
+    ContactAttributeAvatarToken,
+    ContactAttributeCapabilities,
+    ContactAttributeInfo,
+    ContactAttributeLocation,
+    ContactAttributePresence,
+    ContactAttributeGroups,
+    ContactAttributeAddresses,
+    ContactAttributeUris,
+    ContactAttributeClientTypes,
+    NumContactAttributes
+};
+
+// Contact attribute keys, built once and shared by all the contacts
+struct ContactAttributeKeys
+{
+    ContactAttributeKeys();
+
+    QString keys[NumContactAttributes];
+    QHash<QString, int> index;
+};
+
+ContactAttributeKeys::ContactAttributeKeys()
+{
+    keys[ContactAttributeId] = TP_QT_IFACE_CONNECTION + QLatin1String("/contact-id");
+    keys[ContactAttributeSubscribe] =
+        TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_LIST + QLatin1String("/subscribe");
+    keys[ContactAttributePublish] =
+        TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_LIST + QLatin1String("/publish");
+    keys[ContactAttributePublishRequest] =
+        TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_LIST + QLatin1String("/publish-request");
+    keys[ContactAttributeAlias] =
+        TP_QT_IFACE_CONNECTION_INTERFACE_ALIASING + QLatin1String("/alias");
+    keys[ContactAttributeAvatarToken] =
+        TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS + QLatin1String("/token");
+    keys[ContactAttributeCapabilities] =
+        TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_CAPABILITIES + QLatin1String("/capabilities");
+    keys[ContactAttributeInfo] =
+        TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_INFO + QLatin1String("/info");
+    keys[ContactAttributeLocation] =
+        TP_QT_IFACE_CONNECTION_INTERFACE_LOCATION + QLatin1String("/location");
+    keys[ContactAttributePresence] =
+        TP_QT_IFACE_CONNECTION_INTERFACE_SIMPLE_PRESENCE + QLatin1String("/presence");
+    keys[ContactAttributeGroups] =
+        TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_GROUPS + QLatin1String("/groups");
+    keys[ContactAttributeAddresses] =
+        TP_QT_IFACE_CONNECTION_INTERFACE_ADDRESSING + QLatin1String("/addresses");
+    keys[ContactAttributeUris] =
+        TP_QT_IFACE_CONNECTION_INTERFACE_ADDRESSING + QLatin1String("/uris");
+    keys[ContactAttributeClientTypes] =
+        TP_QT_IFACE_CONNECTION_INTERFACE_CLIENT_TYPES + QLatin1String("/client-types");
+
+    index.reserve(NumContactAttributes);
+    for (int i = 0; i < NumContactAttributes; ++i) {
+        index.insert(keys[i], i);
+    }
+}
+
+Q_GLOBAL_STATIC(ContactAttributeKeys, contactAttributeKeys)
+
+// The attributes of a contact we know about, found with a single pass over the map
+struct ContactAttributes
+{
+    ContactAttributes(const QVariantMap &attributes)
+    {
+        for (int i = 0; i < NumContactAttributes; ++i) {
+            values[i] = 0;
+        }
+
+        const QHash<QString, int> &index = contactAttributeKeys()->index;
+        for (QVariantMap::const_iterator i = attributes.constBegin();
+                i != attributes.constEnd(); ++i) {
+            QHash<QString, int>::const_iterator key = index.constFind(i.key());
+            if (key != index.constEnd()) {
+                values[key.value()] = &i.value();
+            }
+        }
+    }
+
+    bool contains(ContactAttribute attribute) const
+    {
+        return values[attribute] != 0;
+    }
+
+    template<typename T>
+    T value(ContactAttribute attribute) const
+    {
+        return values[attribute] ? qdbus_cast<T>(*values[attribute]) : T();
+    }
+
+    const QVariant *values[NumContactAttributes];
+};
+
+}
+
 struct TP_QT_NO_EXPORT Contact::Private
 {
     Private(Contact *parent, ContactManager *manager,
@@ -61,6 +165,7 @@ struct TP_QT_NO_EXPORT Contact::Private
     }
 
     void updateAvatarData();
+    void notifyChanged(ContactManager::ChangedField change);
 
     Contact *parent;
 
@@ -68,7 +173,9 @@ struct TP_QT_NO_EXPORT Contact::Private
     ReferencedHandles handle;
     QString id;
 
-    Features requestedFeatures;
+    FeatureMask requestedFeatures;
+    FeatureInstances requestedFeatureInstances;
+    FeatureInstances::Cache requestedFeaturesCache;
     Features actualFeatures;
 
     QString alias;
@@ -107,15 +214,24 @@ void Contact::Private::updateAvatarData()
 
     /* If token is empty (""), it means the contact has no avatar. */
     if (avatarToken.isEmpty()) {
-        debug() << "Contact" << parent->id() << "has no avatar";
+        tpDebug(DebugCategoryContacts) << "Contact" << parent->id() << "has no avatar";
         avatarData = AvatarData();
         emit parent->avatarDataChanged(avatarData);
+        notifyChanged(ContactManager::AvatarDataChanged);
         return;
     }
 
     parent->manager()->requestContactAvatars(QList<ContactPtr>() << ContactPtr(parent));
 }
 
+void Contact::Private::notifyChanged(ContactManager::ChangedField change)
+{
+    ContactManagerPtr contactManager(manager);
+    if (contactManager) {
+        contactManager->contactChanged(parent, change);
+    }
+}
+
 struct TP_QT_NO_EXPORT Contact::InfoFields::Private : public QSharedData
 {
     Private(const ContactInfoFieldList &allFields)
@@ -321,9 +437,10 @@ Contact::Contact(ContactManager *manager, const ReferencedHandles &handle,
     : Object(),
       mPriv(new Private(this, manager, handle))
 {
-    mPriv->requestedFeatures.unite(requestedFeatures);
-    mPriv->id = qdbus_cast<QString>(attributes[
-            TP_QT_IFACE_CONNECTION + QLatin1String("/contact-id")]);
+    mPriv->requestedFeatureInstances.insert(requestedFeatures);
+    mPriv->requestedFeatures |= FeatureMask(requestedFeatures);
+    mPriv->id = qdbus_cast<QString>(attributes.value(
+            contactAttributeKeys()->keys[ContactAttributeId]));
 }
 
 /**
@@ -331,7 +448,13 @@ Contact::Contact(ContactManager *manager, const ReferencedHandles &handle,
  */
 Contact::~Contact()
 {
-    debug() << "Contact" << id() << "destroyed";
+    tpDebug(DebugCategoryContacts) << "Contact" << id() << "destroyed";
+
+    ContactManagerPtr manager(mPriv->manager);
+    if (manager && !mPriv->handle.isEmpty()) {
+        manager->forgetContact(mPriv->handle[0]);
+    }
+
     delete mPriv;
 }
 
@@ -371,6 +494,12 @@ QString Contact::id() const
  * \return The requested features as a set of Feature objects.
  */
 Features Contact::requestedFeatures() const
+{
+    return mPriv->requestedFeatureInstances.toFeatures(mPriv->requestedFeatures,
+            &mPriv->requestedFeaturesCache);
+}
+
+const FeatureMask &Contact::requestedFeatureMask() const
 {
     return mPriv->requestedFeatures;
 }
@@ -987,24 +1116,21 @@ PendingStringList *Contact::requestClientTypes()
 
 void Contact::augment(const Features &requestedFeatures, const QVariantMap &attributes)
 {
-    mPriv->requestedFeatures.unite(requestedFeatures);
+    mPriv->requestedFeatureInstances.insert(requestedFeatures);
+    mPriv->requestedFeatures |= FeatureMask(requestedFeatures);
+
+    const ContactAttributes decoded(attributes);
 
-    mPriv->id = qdbus_cast<QString>(attributes[
-            TP_QT_IFACE_CONNECTION + QLatin1String("/contact-id")]);
+    mPriv->id = decoded.value<QString>(ContactAttributeId);
 
-    if (attributes.contains(TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_LIST +
-                QLatin1String("/subscribe"))) {
-        uint subscriptionState = qdbus_cast<uint>(attributes.value(
-                     TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_LIST + QLatin1String("/subscribe")));
+    if (decoded.contains(ContactAttributeSubscribe)) {
+        uint subscriptionState = decoded.value<uint>(ContactAttributeSubscribe);
         setSubscriptionState((SubscriptionState) subscriptionState);
     }
 
-    if (attributes.contains(TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_LIST +
-                QLatin1String("/publish"))) {
-        uint publishState = qdbus_cast<uint>(attributes.value(
-                    TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_LIST + QLatin1String("/publish")));
-        QString publishRequest = qdbus_cast<QString>(attributes.value(
-                    TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_LIST + QLatin1String("/publish-request")));
+    if (decoded.contains(ContactAttributePublish)) {
+        uint publishState = decoded.value<uint>(ContactAttributePublish);
+        QString publishRequest = decoded.value<QString>(ContactAttributePublishRequest);
         setPublishState((SubscriptionState) publishState, publishRequest);
     }
 
@@ -1016,8 +1142,7 @@ void Contact::augment(const Features &requestedFeatures, const QVariantMap &attr
         ContactInfoFieldList maybeInfo;
 
         if (feature == FeatureAlias) {
-            maybeAlias = qdbus_cast<QString>(attributes.value(
-                        TP_QT_IFACE_CONNECTION_INTERFACE_ALIASING + QLatin1String("/alias")));
+            maybeAlias = decoded.value<QString>(ContactAttributeAlias);
 
             if (!maybeAlias.isEmpty()) {
                 receiveAlias(maybeAlias);
@@ -1030,10 +1155,8 @@ void Contact::augment(const Features &requestedFeatures, const QVariantMap &attr
                 mPriv->updateAvatarData();
             }
         } else if (feature == FeatureAvatarToken) {
-            if (attributes.contains(
-                        TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS + QLatin1String("/token"))) {
-                receiveAvatarToken(qdbus_cast<QString>(attributes.value(
-                                TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS + QLatin1String("/token"))));
+            if (decoded.contains(ContactAttributeAvatarToken)) {
+                receiveAvatarToken(decoded.value<QString>(ContactAttributeAvatarToken));
             } else {
                 if (manager()->supportedFeatures().contains(FeatureAvatarToken)) {
                     // AvatarToken being supported but not included in the mapping indicates
@@ -1045,8 +1168,7 @@ void Contact::augment(const Features &requestedFeatures, const QVariantMap &attr
                 mPriv->avatarToken = QLatin1String("");
             }
         } else if (feature == FeatureCapabilities) {
-            maybeCaps = qdbus_cast<RequestableChannelClassList>(attributes.value(
-                        TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_CAPABILITIES + QLatin1String("/capabilities")));
+            maybeCaps = decoded.value<RequestableChannelClassList>(ContactAttributeCapabilities);
 
             if (!maybeCaps.isEmpty()) {
                 receiveCapabilities(maybeCaps);
@@ -1060,8 +1182,7 @@ void Contact::augment(const Features &requestedFeatures, const QVariantMap &attr
                 }
             }
         } else if (feature == FeatureInfo) {
-            maybeInfo = qdbus_cast<ContactInfoFieldList>(attributes.value(
-                        TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_INFO + QLatin1String("/info")));
+            maybeInfo = decoded.value<ContactInfoFieldList>(ContactAttributeInfo);
 
             if (!maybeInfo.isEmpty()) {
                 receiveInfo(maybeInfo);
@@ -1075,8 +1196,7 @@ void Contact::augment(const Features &requestedFeatures, const QVariantMap &attr
                 }
             }
         } else if (feature == FeatureLocation) {
-            maybeLocation = qdbus_cast<QVariantMap>(attributes.value(
-                        TP_QT_IFACE_CONNECTION_INTERFACE_LOCATION + QLatin1String("/location")));
+            maybeLocation = decoded.value<QVariantMap>(ContactAttributeLocation);
 
             if (!maybeLocation.isEmpty()) {
                 receiveLocation(maybeLocation);
@@ -1090,8 +1210,7 @@ void Contact::augment(const Features &requestedFeatures, const QVariantMap &attr
                 }
             }
         } else if (feature == FeatureSimplePresence) {
-            maybePresence = qdbus_cast<SimplePresence>(attributes.value(
-                        TP_QT_IFACE_CONNECTION_INTERFACE_SIMPLE_PRESENCE + QLatin1String("/presence")));
+            maybePresence = decoded.value<SimplePresence>(ContactAttributePresence);
 
             if (!maybePresence.status.isEmpty()) {
                 receiveSimplePresence(maybePresence);
@@ -1100,18 +1219,15 @@ void Contact::augment(const Features &requestedFeatures, const QVariantMap &attr
                         QLatin1String("unknown"), QLatin1String(""));
             }
         } else if (feature == FeatureRosterGroups) {
-            QStringList groups = qdbus_cast<QStringList>(attributes.value(
-                        TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_GROUPS + QLatin1String("/groups")));
+            QStringList groups = decoded.value<QStringList>(ContactAttributeGroups);
             mPriv->groups = groups.toSet();
         } else if (feature == FeatureAddresses) {
-            VCardFieldAddressMap addresses = qdbus_cast<VCardFieldAddressMap>(attributes.value(
-                        TP_QT_IFACE_CONNECTION_INTERFACE_ADDRESSING + QLatin1String("/addresses")));
-            QStringList uris = qdbus_cast<QStringList>(attributes.value(
-                        TP_QT_IFACE_CONNECTION_INTERFACE_ADDRESSING + QLatin1String("/uris")));
+            VCardFieldAddressMap addresses =
+                decoded.value<VCardFieldAddressMap>(ContactAttributeAddresses);
+            QStringList uris = decoded.value<QStringList>(ContactAttributeUris);
             receiveAddresses(addresses, uris);
         } else if (feature == FeatureClientTypes) {
-            QStringList maybeClientTypes = qdbus_cast<QStringList>(attributes.value(
-                        TP_QT_IFACE_CONNECTION_INTERFACE_CLIENT_TYPES + QLatin1String("/client-types")));
+            QStringList maybeClientTypes = decoded.value<QStringList>(ContactAttributeClientTypes);
 
             if (!maybeClientTypes.isEmpty()) {
                 receiveClientTypes(maybeClientTypes);
@@ -1141,6 +1257,7 @@ void Contact::receiveAlias(const QString &alias)
     if (mPriv->alias != alias) {
         mPriv->alias = alias;
         emit aliasChanged(alias);
+        mPriv->notifyChanged(ContactManager::AliasChanged);
     }
 }
 
@@ -1165,6 +1282,7 @@ void Contact::setAvatarToken(const QString &token)
         mPriv->isAvatarTokenKnown = true;
         mPriv->avatarToken = token;
         emit avatarTokenChanged(mPriv->avatarToken);
+        mPriv->notifyChanged(ContactManager::AvatarTokenChanged);
     }
 }
 
@@ -1173,6 +1291,7 @@ void Contact::receiveAvatarData(const AvatarData &avatar)
     if (mPriv->avatarData.fileName != avatar.fileName) {
         mPriv->avatarData = avatar;
         emit avatarDataChanged(mPriv->avatarData);
+        mPriv->notifyChanged(ContactManager::AvatarDataChanged);
     }
 }
 
@@ -1188,6 +1307,7 @@ void Contact::receiveSimplePresence(const SimplePresence &presence)
         mPriv->presence.statusMessage() != presence.statusMessage) {
         mPriv->presence.setStatus(presence);
         emit presenceChanged(mPriv->presence);
+        mPriv->notifyChanged(ContactManager::PresenceChanged);
     }
 }
 
@@ -1202,6 +1322,7 @@ void Contact::receiveCapabilities(const RequestableChannelClassList &caps)
     if (mPriv->caps.allClassSpecs().bareClasses() != caps) {
         mPriv->caps.updateRequestableChannelClasses(caps);
         emit capabilitiesChanged(mPriv->caps);
+        mPriv->notifyChanged(ContactManager::CapabilitiesChanged);
     }
 }
 
@@ -1216,6 +1337,7 @@ void Contact::receiveLocation(const QVariantMap &location)
     if (mPriv->location.allDetails() != location) {
         mPriv->location.updateData(location);
         emit locationUpdated(mPriv->location);
+        mPriv->notifyChanged(ContactManager::LocationChanged);
     }
 }
 
@@ -1231,6 +1353,7 @@ void Contact::receiveInfo(const ContactInfoFieldList &info)
     if (mPriv->info.allFields() != info) {
         mPriv->info = InfoFields(info);
         emit infoFieldsChanged(mPriv->info);
+        mPriv->notifyChanged(ContactManager::InfoFieldsChanged);
     }
 }
 
@@ -1257,6 +1380,7 @@ void Contact::receiveClientTypes(const QStringList &clientTypes)
     if (mPriv->clientTypes != clientTypes) {
         mPriv->clientTypes = clientTypes;
         emit clientTypesChanged(mPriv->clientTypes);
+        mPriv->notifyChanged(ContactManager::ClientTypesChanged);
     }
 }
 
@@ -1281,6 +1405,7 @@ void Contact::setSubscriptionState(SubscriptionState state)
     mPriv->subscriptionState = state;
 
     emit subscriptionStateChanged(subscriptionStateToPresenceState(state));
+    mPriv->notifyChanged(ContactManager::SubscriptionStateChanged);
 }
 
 void Contact::setPublishState(SubscriptionState state, const QString &message)
@@ -1293,6 +1418,7 @@ void Contact::setPublishState(SubscriptionState state, const QString &message)
     mPriv->publishStateMessage = message;
 
     emit publishStateChanged(subscriptionStateToPresenceState(state), message);
+    mPriv->notifyChanged(ContactManager::PublishStateChanged);
 }
 
 void Contact::setBlocked(bool value)
@@ -1304,6 +1430,7 @@ void Contact::setBlocked(bool value)
     mPriv->blocked = value;
 
     emit blockStatusChanged(value);
+    mPriv->notifyChanged(ContactManager::BlockStatusChanged);
 }
 
 void Contact::setAddedToGroup(const QString &group)
@@ -1311,6 +1438,7 @@ void Contact::setAddedToGroup(const QString &group)
     if (!mPriv->groups.contains(group)) {
         mPriv->groups.insert(group);
         emit addedToGroup(group);
+        mPriv->notifyChanged(ContactManager::GroupsChanged);
     }
 }
 
@@ -1318,6 +1446,7 @@ void Contact::setRemovedFromGroup(const QString &group)
 {
     if (mPriv->groups.remove(group)) {
         emit removedFromGroup(group);
+        mPriv->notifyChanged(ContactManager::GroupsChanged);
     }
 }
 
@@ -42,6 +42,7 @@ struct AvatarData;
 class ContactCapabilities;
 class LocationInfo;
 class ContactManager;
+class FeatureMask;
 class PendingContactInfo;
 class PendingOperation;
 class PendingStringList;
@@ -233,10 +234,13 @@ private:
     TP_QT_NO_EXPORT void setAddedToGroup(const QString &group);
     TP_QT_NO_EXPORT void setRemovedFromGroup(const QString &group);
 
+    TP_QT_NO_EXPORT const FeatureMask &requestedFeatureMask() const;
+
     struct Private;
     friend class Connection;
     friend class ContactFactory;
     friend class ContactManager;
+    friend class PendingContacts;
     friend struct Private;
     Private *mPriv;
 };
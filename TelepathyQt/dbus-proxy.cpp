@@ -26,12 +26,12 @@
 
 #include "TelepathyQt/_gen/dbus-proxy.moc.hpp"
 
+#include "TelepathyQt/bus-name-owner-cache-internal.h"
 #include "TelepathyQt/debug-internal.h"
 
 #include <TelepathyQt/Constants>
 
 #include <QDBusConnection>
-#include <QDBusConnectionInterface>
 #include <QDBusError>
 #include <QDBusServiceWatcher>
 #include <QTimer>
@@ -327,15 +327,10 @@ QString StatefulDBusProxy::uniqueNameFrom(const QDBusConnection &bus, const QStr
     }
 
     // For a stateful interface, it makes no sense to follow name-owner
-    // changes, so we want to bind to the unique name.
-    QDBusReply<QString> reply = bus.interface()->serviceOwner(name);
-    if (reply.isValid()) {
-        return reply.value();
-    } else {
-        error = reply.error().name();
-        message = reply.error().message();
-        return QString();
-    }
+    // changes, so we want to bind to the unique name. The owners are cached
+    // per bus connection (and kept up to date with NameOwnerChanged), so
+    // creating many proxies for the same service only asks the bus daemon once.
+    return BusNameOwnerCache::forBus(bus)->resolve(name, error, message);
 }
 
 void StatefulDBusProxy::onServiceOwnerChanged(const QString &name, const QString &oldOwner, const QString &newOwner)
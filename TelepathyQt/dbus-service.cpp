@@ -183,7 +183,7 @@ bool DBusService::registerObject(const QString &busName, const QString &objectPa
         return false;
     }
 
-    debug() << "Registered object" << objectPath << "at bus name" << busName;
+    tpDebug(DebugCategoryService) << "Registered object" << objectPath << "at bus name" << busName;
 
     mPriv->busName = busName;
     mPriv->dbusObject->setObjectPath(objectPath);
@@ -207,13 +207,22 @@ struct AbstractDBusServiceInterface::Private
     Private(const QString &interfaceName)
         : interfaceName(interfaceName),
           dbusObject(0),
-          registered(false)
+          registered(false),
+          batchDepth(0),
+          deferPropertyChanges(false),
+          flushScheduled(false)
     {
     }
 
     QString interfaceName;
     DBusObject *dbusObject;
     bool registered;
+
+    // Property changes not signalled yet, the last value of each property wins
+    QVariantMap pendingProperties;
+    int batchDepth;
+    bool deferPropertyChanges;
+    bool flushScheduled;
 };
 
 /**
@@ -292,9 +301,14 @@ bool AbstractDBusServiceInterface::isRegistered() const
  * Emit PropertiesChanged signal on object org.freedesktop.DBus.Properties interface
  * with the property \a propertyName.
  *
+ * Between beginPropertyChanges() and endPropertyChanges(), or if deferPropertyChanges() is
+ * enabled, the change is merged with the other pending changes of this interface and signalled
+ * later, in a single PropertiesChanged signal.
+ *
  * \param propertyName The name of the changed property.
  * \param propertyValue The actual value of the changed property.
  * \return \c false if the signal can not be emmited or \a true otherwise.
+ * \sa beginPropertyChanges(), setDeferPropertyChanges()
  */
 bool AbstractDBusServiceInterface::notifyPropertyChanged(const QString &propertyName, const QVariant &propertyValue)
 {
@@ -302,12 +316,94 @@ bool AbstractDBusServiceInterface::notifyPropertyChanged(const QString &property
         return false;
     }
 
+    mPriv->pendingProperties.insert(propertyName, propertyValue);
+
+    if (mPriv->batchDepth > 0) {
+        return true;
+    }
+
+    if (mPriv->deferPropertyChanges) {
+        scheduleDeferredPropertyChanges();
+        return true;
+    }
+
+    return flushPropertyChanges();
+}
+
+/**
+ * Start merging property changes of this interface.
+ *
+ * Properties changed with notifyPropertyChanged() until the matching call to endPropertyChanges()
+ * are signalled in one PropertiesChanged signal, with the last value set for each property.
+ * Calls can be nested, in which case the signal is sent at the end of the outermost batch.
+ * The PropertyChangeBatch class calls both methods for the duration of a scope:
+ *
+ * \code
+ * {
+ *     AbstractDBusServiceInterface::PropertyChangeBatch batch(roomConfigInterface.data());
+ *     roomConfigInterface->setTitle(title);
+ *     roomConfigInterface->setDescription(description);
+ *     roomConfigInterface->setPersistent(true);
+ * }
+ * \endcode
+ *
+ * \sa endPropertyChanges(), setDeferPropertyChanges()
+ */
+void AbstractDBusServiceInterface::beginPropertyChanges()
+{
+    ++mPriv->batchDepth;
+}
+
+/**
+ * Finish merging property changes started with beginPropertyChanges().
+ *
+ * \return \c false if the signal for the pending changes can not be emitted, or \c true
+ *         otherwise.
+ * \sa beginPropertyChanges()
+ */
+bool AbstractDBusServiceInterface::endPropertyChanges()
+{
+    if (mPriv->batchDepth == 0) {
+        warning() << "AbstractDBusServiceInterface::endPropertyChanges() called without "
+            "beginPropertyChanges() for" << mPriv->interfaceName;
+        return false;
+    }
+
+    if (--mPriv->batchDepth > 0) {
+        return true;
+    }
+
+    if (mPriv->deferPropertyChanges) {
+        scheduleDeferredPropertyChanges();
+        return true;
+    }
+
+    return flushPropertyChanges();
+}
+
+/**
+ * Emit the PropertiesChanged signal for the property changes which are waiting to be signalled,
+ * if any.
+ *
+ * \return \c false if the signal can not be emitted, or \c true otherwise.
+ * \sa notifyPropertyChanged()
+ */
+bool AbstractDBusServiceInterface::flushPropertyChanges()
+{
+    if (mPriv->pendingProperties.isEmpty()) {
+        return true;
+    }
+
+    QVariantMap changedProperties;
+    changedProperties.swap(mPriv->pendingProperties);
+
+    if (!isRegistered()) {
+        return false;
+    }
+
     QDBusMessage signal = QDBusMessage::createSignal(dbusObject()->objectPath(),
                                                      TP_QT_IFACE_PROPERTIES,
                                                      QLatin1String("PropertiesChanged"));
-    QVariantMap changedProperties;
-    changedProperties.insert(propertyName, propertyValue);
-
     signal << interfaceName();
     signal << changedProperties;
     signal << QStringList();
@@ -315,6 +411,54 @@ bool AbstractDBusServiceInterface::notifyPropertyChanged(const QString &property
     return dbusObject()->dbusConnection().send(signal);
 }
 
+/**
+ * Return whether property changes are signalled when the event loop runs again.
+ *
+ * \return \c true if property changes are deferred, or \c false otherwise.
+ * \sa setDeferPropertyChanges()
+ */
+bool AbstractDBusServiceInterface::deferPropertyChanges() const
+{
+    return mPriv->deferPropertyChanges;
+}
+
+/**
+ * Set whether property changes are signalled when the event loop runs again.
+ *
+ * If \a defer is \c true, all the properties changed with notifyPropertyChanged() within one
+ * iteration of the event loop are signalled in a single PropertiesChanged signal, without having
+ * to delimit the changes with beginPropertyChanges() and endPropertyChanges().
+ * By default, each change not made within a batch is signalled right away.
+ *
+ * \param defer Whether property changes should be deferred.
+ * \sa deferPropertyChanges(), flushPropertyChanges()
+ */
+void AbstractDBusServiceInterface::setDeferPropertyChanges(bool defer)
+{
+    mPriv->deferPropertyChanges = defer;
+
+    if (!defer && mPriv->batchDepth == 0) {
+        flushPropertyChanges();
+    }
+}
+
+void AbstractDBusServiceInterface::scheduleDeferredPropertyChanges()
+{
+    if (!mPriv->flushScheduled) {
+        mPriv->flushScheduled = true;
+        QMetaObject::invokeMethod(this, "onDeferredPropertyChanges", Qt::QueuedConnection);
+    }
+}
+
+void AbstractDBusServiceInterface::onDeferredPropertyChanges()
+{
+    mPriv->flushScheduled = false;
+
+    if (mPriv->batchDepth == 0) {
+        flushPropertyChanges();
+    }
+}
+
 /**
  * Registers this interface by plugging its adaptor
  * on the given \a dbusObject.
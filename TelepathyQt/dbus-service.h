@@ -93,7 +93,39 @@ protected:
 public:
     bool notifyPropertyChanged(const QString &propertyName, const QVariant &propertyValue);
 
+    void beginPropertyChanges();
+    bool endPropertyChanges();
+    bool flushPropertyChanges();
+
+    bool deferPropertyChanges() const;
+    void setDeferPropertyChanges(bool defer);
+
+    class PropertyChangeBatch
+    {
+    public:
+        explicit PropertyChangeBatch(AbstractDBusServiceInterface *interface)
+            : mInterface(interface)
+        {
+            mInterface->beginPropertyChanges();
+        }
+
+        ~PropertyChangeBatch()
+        {
+            mInterface->endPropertyChanges();
+        }
+
+    private:
+        Q_DISABLE_COPY(PropertyChangeBatch)
+
+        AbstractDBusServiceInterface *mInterface;
+    };
+
+private Q_SLOTS:
+    TP_QT_NO_EXPORT void onDeferredPropertyChanges();
+
 private:
+    TP_QT_NO_EXPORT void scheduleDeferredPropertyChanges();
+
     struct Private;
     friend struct Private;
     Private *mPriv;
@@ -129,7 +129,8 @@ void DBusTubeChannel::Private::introspectBusNamesMonitoring(DBusTubeChannel::Pri
         connect(dbusTubeInterface->requestPropertyDBusNames(), SIGNAL(finished(Tp::PendingOperation*)),
                 parent, SLOT(onRequestPropertyDBusNamesFinished(Tp::PendingOperation*)));
     } else {
-        debug() << "FeatureBusNameMonitoring does not make sense in a P2P context";
+        tpDebug(DebugCategoryTubes) <<
+            "FeatureBusNameMonitoring does not make sense in a P2P context";
         self->readinessHelper->setIntrospectCompleted(DBusTubeChannel::FeatureBusNameMonitoring, false);
     }
 }
@@ -138,7 +139,7 @@ void DBusTubeChannel::Private::introspectDBusTube(DBusTubeChannel::Private *self
 {
     DBusTubeChannel *parent = self->parent;
 
-    debug() << "Introspect dbus tube properties";
+    tpDebug(DebugCategoryTubes) << "Introspect dbus tube properties";
 
     if (parent->immutableProperties().contains(TP_QT_IFACE_CHANNEL_TYPE_DBUS_TUBE + QLatin1String(".ServiceName")) &&
         parent->immutableProperties().contains(TP_QT_IFACE_CHANNEL_TYPE_DBUS_TUBE + QLatin1String(".SupportedAccessControls"))) {
@@ -339,7 +340,7 @@ QHash<QString, Tp::ContactPtr> DBusTubeChannel::contactsForBusNames() const
 void DBusTubeChannel::onRequestAllPropertiesFinished(PendingOperation *op)
 {
     if (!op->isError()) {
-        debug() << "RequestAllProperties succeeded";
+        tpDebug(DebugCategoryTubes) << "RequestAllProperties succeeded";
         PendingVariantMap *result = qobject_cast<PendingVariantMap*>(op);
 
         QVariantMap map = result->result();
@@ -362,7 +363,7 @@ void DBusTubeChannel::onRequestAllPropertiesFinished(PendingOperation *op)
 void DBusTubeChannel::onRequestPropertyDBusNamesFinished(PendingOperation *op)
 {
     if (!op->isError()) {
-        debug() << "RequestPropertyDBusNames succeeded";
+        tpDebug(DebugCategoryTubes) << "RequestPropertyDBusNames succeeded";
         PendingVariant *result = qobject_cast<PendingVariant*>(op);
         DBusTubeParticipants participants = qdbus_cast<DBusTubeParticipants>(result->result());
 
@@ -386,7 +387,7 @@ void DBusTubeChannel::onRequestPropertyDBusNamesFinished(PendingOperation *op)
 
 void DBusTubeChannel::onQueueCompleted()
 {
-    debug() << "Queue was completed";
+    tpDebug(DebugCategoryTubes) << "Queue was completed";
 
     // Set the feature as completed, and disconnect the signal as it's no longer useful
     mPriv->readinessHelper->setIntrospectCompleted(DBusTubeChannel::FeatureBusNameMonitoring, true);
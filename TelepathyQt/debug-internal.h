@@ -25,6 +25,7 @@
 
 #include <QDebug>
 
+#include <TelepathyQt/Debug>
 #include <TelepathyQt/Global>
 
 namespace Tp
@@ -33,9 +34,11 @@ namespace Tp
 class TP_QT_EXPORT Debug
 {
 public:
-    inline Debug() : debug(0) { }
-    inline Debug(QtMsgType type) : type(type), debug(new QDebug(&msg)) { }
-    inline Debug(const Debug &a) : type(a.type), debug(a.debug ? new QDebug(&msg) : 0)
+    inline Debug() : category(DebugCategoryGeneral), debug(0) { }
+    inline Debug(QtMsgType type, DebugCategory category = DebugCategoryGeneral)
+        : type(type), category(category), debug(new QDebug(&msg)) { }
+    inline Debug(const Debug &a)
+        : type(a.type), category(a.category), debug(a.debug ? new QDebug(&msg) : 0)
     {
         if (debug) {
             (*debug) << qPrintable(a.msg);
@@ -46,6 +49,7 @@ public:
     {
         if (this != &a) {
             type = a.type;
+            category = a.category;
             delete debug;
             debug = 0;
 
@@ -107,6 +111,7 @@ private:
 
     QString msg;
     QtMsgType type;
+    DebugCategory category;
     QDebug *debug;
 
     void invokeDebugCallback();
@@ -117,8 +122,26 @@ private:
 TP_QT_EXPORT Debug enabledDebug();
 TP_QT_EXPORT Debug enabledWarning();
 
+TP_QT_EXPORT Debug enabledDebug(DebugCategory category);
+
 #ifdef ENABLE_DEBUG
 
+// Bit n is set when debug messages in category n are either output or recorded. Exported
+// because tpDebug() reads it inline in the service library too.
+TP_QT_EXPORT extern uint activeDebugCategories;
+
+inline bool isDebugCategoryActive(DebugCategory category)
+{
+    return activeDebugCategories & (1U << category);
+}
+
+// Unlike debug(), the message isn't even built when the category is inactive:
+//     tpDebug(DebugCategoryContacts) << "Got" << expensive();
+#define tpDebug(category) \
+    for (bool tpDebugActive = Tp::isDebugCategoryActive(category); tpDebugActive; \
+            tpDebugActive = false) \
+        Tp::enabledDebug(category)
+
 inline Debug debug()
 {
     return enabledDebug();
@@ -165,6 +188,10 @@ inline NoDebug warning()
     return NoDebug();
 }
 
+#define tpDebug(category) \
+    while (false) \
+        Tp::NoDebug()
+
 #endif /* #ifdef ENABLE_DEBUG */
 
 } // Tp
@@ -26,6 +26,12 @@
 
 #include "config-version.h"
 
+#include <QDateTime>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <cstring>
+
 /**
  * \defgroup debug Common debug support
  *
@@ -37,6 +43,16 @@
  * warning messages. Normal debug output results in the normal operation of the
  * library, warning messages are output only when something goes wrong. Each
  * category can be invidually enabled.
+ *
+ * Debug output is further divided by the part of the library producing it, see
+ * DebugCategory. Messages of disabled categories are not even formatted, which
+ * makes it cheap to leave debug output enabled for the categories of interest
+ * only.
+ *
+ * Finally, a flight recorder can be enabled with setDebugFlightRecorderSize().
+ * It keeps the most recent messages of the enabled categories in memory, even
+ * while debug output is disabled, so that they can be retrieved with
+ * dumpDebugFlightRecorder() when something goes wrong.
  */
 
 namespace Tp
@@ -68,6 +84,83 @@ namespace Tp
  * \param enable Whether warnings should be enabled or not.
  */
 
+/**
+ * \enum DebugCategory
+ * \ingroup debug
+ *
+ * The parts of the library debug messages can come from.
+ *
+ * \value DebugCategoryGeneral Messages not belonging to any other category.
+ * \value DebugCategoryContacts Contact building and contact change notifications.
+ * \value DebugCategoryChannels Channel introspection and message queues.
+ * \value DebugCategoryDispatch Channel dispatching and client registration.
+ * \value DebugCategoryTubes Stream and D-Bus tubes.
+ * \value DebugCategoryService The service-side base classes.
+ * \value NumDebugCategories The number of categories.
+ */
+
+/**
+ * \fn void enableDebugCategory(DebugCategory category, bool enable)
+ * \ingroup debug
+ *
+ * Enable or disable debug messages from \a category, both for debug output and
+ * for the flight recorder.
+ *
+ * All categories are enabled by default, so enableDebug() alone enables all
+ * debug output.
+ *
+ * \param category The category to enable or disable.
+ * \param enable Whether messages from \a category should be enabled or not.
+ */
+
+/**
+ * \fn bool isDebugCategoryEnabled(DebugCategory category)
+ * \ingroup debug
+ *
+ * Return whether debug messages from \a category are enabled.
+ *
+ * \param category The category to check.
+ * \return \c true if the category is enabled, \c false otherwise.
+ * \sa enableDebugCategory()
+ */
+
+/**
+ * \fn void setDebugFlightRecorderSize(int size)
+ * \ingroup debug
+ *
+ * Set the size in bytes of the in-memory debug flight recorder, or disable it if
+ * \a size is 0.
+ *
+ * While enabled, warnings and the debug messages of the enabled categories are
+ * recorded, even if debug output is disabled. When the recorder is full, the
+ * oldest messages are dropped. Changing the size drops all recorded messages.
+ *
+ * The default is 0 ie. the flight recorder is disabled.
+ *
+ * \param size The maximum number of bytes used by recorded messages.
+ */
+
+/**
+ * \fn int debugFlightRecorderSize()
+ * \ingroup debug
+ *
+ * Return the size in bytes of the debug flight recorder.
+ *
+ * \return The size set with setDebugFlightRecorderSize(), 0 if disabled.
+ */
+
+/**
+ * \fn QStringList dumpDebugFlightRecorder()
+ * \ingroup debug
+ *
+ * Return the messages currently in the debug flight recorder, oldest first.
+ *
+ * Each message is prefixed with the time it was recorded, its category and
+ * whether it is a debug message or a warning.
+ *
+ * \return The recorded messages.
+ */
+
 /**
  * \typedef DebugCallback
  * \ingroup debug
@@ -100,12 +193,153 @@ namespace
 {
 bool debugEnabled = false;
 bool warningsEnabled = true;
+bool categoryEnabled[NumDebugCategories] = { true, true, true, true, true, true };
+bool flightRecorderEnabled = false;
 DebugCallback debugCallback = NULL;
+
+const char *categoryNames[NumDebugCategories] = {
+    "general", "contacts", "channels", "dispatch", "tubes", "service"
+};
+
+void updateActiveDebugCategories()
+{
+    uint active = 0;
+    if (debugEnabled || flightRecorderEnabled) {
+        for (int i = 0; i < NumDebugCategories; ++i) {
+            if (categoryEnabled[i]) {
+                active |= 1U << i;
+            }
+        }
+    }
+    activeDebugCategories = active;
 }
 
+// Ring of records, each made of a RecordHeader followed by the UTF-8 message, wrapping around
+// the end of the buffer as needed
+class FlightRecorder
+{
+public:
+    FlightRecorder() : head(0), used(0) { }
+
+    int size() const
+    {
+        QMutexLocker locker(&mutex);
+        return buffer.size();
+    }
+
+    void resize(int size)
+    {
+        QMutexLocker locker(&mutex);
+        buffer = QByteArray(size, '\0');
+        head = 0;
+        used = 0;
+    }
+
+    void record(QtMsgType type, DebugCategory category, const QString &msg)
+    {
+        QByteArray utf8 = msg.toUtf8();
+
+        QMutexLocker locker(&mutex);
+        int maxMessageSize = buffer.size() - (int) sizeof(RecordHeader);
+        if (maxMessageSize <= 0) {
+            return;
+        }
+        if (utf8.size() > maxMessageSize) {
+            utf8.truncate(maxMessageSize);
+        }
+
+        RecordHeader header;
+        header.timestamp = QDateTime::currentMSecsSinceEpoch();
+        header.size = utf8.size();
+        header.type = type;
+        header.category = category;
+
+        int recordSize = sizeof(RecordHeader) + utf8.size();
+        while (buffer.size() - used < recordSize) {
+            dropOldest();
+        }
+
+        write(reinterpret_cast<const char *>(&header), sizeof(RecordHeader));
+        write(utf8.constData(), utf8.size());
+    }
+
+    QStringList dump() const
+    {
+        QMutexLocker locker(&mutex);
+        QStringList ret;
+
+        int offset = head;
+        int left = used;
+        while (left > 0) {
+            RecordHeader header;
+            read(offset, reinterpret_cast<char *>(&header), sizeof(RecordHeader));
+            QByteArray utf8(header.size, '\0');
+            read((offset + sizeof(RecordHeader)) % buffer.size(), utf8.data(), header.size);
+
+            ret << QString(QLatin1String("%1 %2 %3: %4"))
+                .arg(QDateTime::fromMSecsSinceEpoch(header.timestamp).toString(
+                            QLatin1String("yyyy-MM-ddThh:mm:ss.zzz")))
+                .arg(QLatin1String(categoryNames[header.category]))
+                .arg(header.type == QtWarningMsg ? QLatin1String("WARN") : QLatin1String("DEBUG"))
+                .arg(QString::fromUtf8(utf8));
+
+            int recordSize = sizeof(RecordHeader) + header.size;
+            offset = (offset + recordSize) % buffer.size();
+            left -= recordSize;
+        }
+
+        return ret;
+    }
+
+private:
+    struct RecordHeader
+    {
+        qint64 timestamp;
+        quint32 size;
+        quint8 type;
+        quint8 category;
+    };
+
+    void dropOldest()
+    {
+        RecordHeader header;
+        read(head, reinterpret_cast<char *>(&header), sizeof(RecordHeader));
+        int recordSize = sizeof(RecordHeader) + header.size;
+        head = (head + recordSize) % buffer.size();
+        used -= recordSize;
+    }
+
+    void write(const char *data, int size)
+    {
+        int offset = (head + used) % buffer.size();
+        int first = qMin(size, buffer.size() - offset);
+        memcpy(buffer.data() + offset, data, first);
+        memcpy(buffer.data(), data + first, size - first);
+        used += size;
+    }
+
+    void read(int offset, char *data, int size) const
+    {
+        int first = qMin(size, buffer.size() - offset);
+        memcpy(data, buffer.constData() + offset, first);
+        memcpy(data + first, buffer.constData(), size - first);
+    }
+
+    mutable QMutex mutex;
+    QByteArray buffer;
+    int head;
+    int used;
+};
+
+Q_GLOBAL_STATIC(FlightRecorder, flightRecorder)
+}
+
+uint activeDebugCategories = 0;
+
 void enableDebug(bool enable)
 {
     debugEnabled = enable;
+    updateActiveDebugCategories();
 }
 
 void enableWarnings(bool enable)
@@ -113,6 +347,43 @@ void enableWarnings(bool enable)
     warningsEnabled = enable;
 }
 
+void enableDebugCategory(DebugCategory category, bool enable)
+{
+    if (category < 0 || category >= NumDebugCategories) {
+        return;
+    }
+
+    categoryEnabled[category] = enable;
+    updateActiveDebugCategories();
+}
+
+bool isDebugCategoryEnabled(DebugCategory category)
+{
+    if (category < 0 || category >= NumDebugCategories) {
+        return false;
+    }
+
+    return categoryEnabled[category];
+}
+
+void setDebugFlightRecorderSize(int size)
+{
+    size = qMax(size, 0);
+    flightRecorder()->resize(size);
+    flightRecorderEnabled = size > 0;
+    updateActiveDebugCategories();
+}
+
+int debugFlightRecorderSize()
+{
+    return flightRecorder()->size();
+}
+
+QStringList dumpDebugFlightRecorder()
+{
+    return flightRecorder()->dump();
+}
+
 void setDebugCallback(DebugCallback cb)
 {
     debugCallback = cb;
@@ -120,8 +391,13 @@ void setDebugCallback(DebugCallback cb)
 
 Debug enabledDebug()
 {
-    if (debugEnabled) {
-        return Debug(QtDebugMsg);
+    return enabledDebug(DebugCategoryGeneral);
+}
+
+Debug enabledDebug(DebugCategory category)
+{
+    if (isDebugCategoryActive(category)) {
+        return Debug(QtDebugMsg, category);
     } else {
         return Debug();
     }
@@ -129,7 +405,7 @@ Debug enabledDebug()
 
 Debug enabledWarning()
 {
-    if (warningsEnabled) {
+    if (warningsEnabled || flightRecorderEnabled) {
         return Debug(QtWarningMsg);
     } else {
         return Debug();
@@ -138,6 +414,15 @@ Debug enabledWarning()
 
 void Debug::invokeDebugCallback()
 {
+    if (flightRecorderEnabled) {
+        flightRecorder()->record(type, category, msg);
+    }
+
+    if (type == QtWarningMsg ? !warningsEnabled : !debugEnabled) {
+        // only built for the flight recorder
+        return;
+    }
+
     if (debugCallback) {
         debugCallback(QLatin1String("tp-qt"), QLatin1String(PACKAGE_VERSION), type, msg);
     } else {
@@ -164,6 +449,29 @@ void enableWarnings(bool enable)
 {
 }
 
+void enableDebugCategory(DebugCategory category, bool enable)
+{
+}
+
+bool isDebugCategoryEnabled(DebugCategory category)
+{
+    return false;
+}
+
+void setDebugFlightRecorderSize(int size)
+{
+}
+
+int debugFlightRecorderSize()
+{
+    return 0;
+}
+
+QStringList dumpDebugFlightRecorder()
+{
+    return QStringList();
+}
+
 void setDebugCallback(DebugCallback cb)
 {
 }
@@ -173,6 +481,11 @@ Debug enabledDebug()
     return Debug();
 }
 
+Debug enabledDebug(DebugCategory category)
+{
+    return Debug();
+}
+
 Debug enabledWarning()
 {
     return Debug();
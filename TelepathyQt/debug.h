@@ -29,12 +29,32 @@
 
 #include <TelepathyQt/Global>
 
+#include <QStringList>
+
 namespace Tp
 {
 
+enum DebugCategory
+{
+    DebugCategoryGeneral = 0,
+    DebugCategoryContacts,
+    DebugCategoryChannels,
+    DebugCategoryDispatch,
+    DebugCategoryTubes,
+    DebugCategoryService,
+    NumDebugCategories
+};
+
 TP_QT_EXPORT void enableDebug(bool enable);
 TP_QT_EXPORT void enableWarnings(bool enable);
 
+TP_QT_EXPORT void enableDebugCategory(DebugCategory category, bool enable);
+TP_QT_EXPORT bool isDebugCategoryEnabled(DebugCategory category);
+
+TP_QT_EXPORT void setDebugFlightRecorderSize(int size);
+TP_QT_EXPORT int debugFlightRecorderSize();
+TP_QT_EXPORT QStringList dumpDebugFlightRecorder();
+
 typedef void (*DebugCallback)(const QString &libraryName,
                               const QString &libraryVersion,
                               QtMsgType type,
@@ -0,0 +1,165 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2026 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TelepathyQt_deferred_reply_h_HEADER_GUARD_
+#define _TelepathyQt_deferred_reply_h_HEADER_GUARD_
+
+#ifndef IN_TP_QT_HEADER
+#error IN_TP_QT_HEADER
+#endif
+
+#include <TelepathyQt/DBusError>
+#include <TelepathyQt/Global>
+#include <TelepathyQt/SharedPtr>
+
+#include <QString>
+
+namespace Tp
+{
+
+/**
+ * \class DeferredReply
+ * \ingroup servicesideimpl
+ * \headerfile TelepathyQt/deferred-reply.h <TelepathyQt/DeferredReply>
+ *
+ * \brief The DeferredReply class is a handle used to finish a service method
+ * asynchronously.
+ *
+ * Only a few service methods can be finished asynchronously so far. Their asynchronous
+ * callbacks receive a DeferredReply instead of returning their result:
+ *  - BaseConnection::CreateChannelAsyncCallback, for CreateChannel, EnsureChannel and
+ *    RequestChannel,
+ *  - BaseConnection::RequestHandlesAsyncCallback, for RequestHandles,
+ *  - BaseConnectionContactsInterface::GetContactAttributesAsyncCallback, for
+ *    GetContactAttributes and GetContactByID,
+ *  - BaseChannelMessagesInterface::SendMessageAsyncCallback, for SendMessage.
+ *
+ * All the other callbacks of the Base* classes and interfaces are synchronous and must
+ * return their result right away.
+ *
+ * The callback may keep a copy of the reply and finish it later, for instance once a network
+ * request has completed, with setFinished() or setFinishedWithError(). Only the first call
+ * has an effect.
+ *
+ * If the last copy of a reply is destroyed without being finished, the pending D-Bus
+ * method call is answered with an error.
+ *
+ * A reply must be finished in the thread of the object which handed it out.
+ */
+template<typename T>
+class DeferredReply
+{
+public:
+    class Handler : public RefCounted
+    {
+        Q_DISABLE_COPY(Handler)
+
+    public:
+        Handler() : mFinished(false) { }
+        virtual ~Handler() { }
+
+        bool isFinished() const { return mFinished; }
+
+        void finish(const T &result)
+        {
+            if (mFinished) {
+                return;
+            }
+            mFinished = true;
+            onFinished(result);
+        }
+
+        void fail(const QString &errorName, const QString &errorMessage)
+        {
+            if (mFinished) {
+                return;
+            }
+            mFinished = true;
+            onFailed(errorName, errorMessage);
+        }
+
+    protected:
+        virtual void onFinished(const T &result) = 0;
+        virtual void onFailed(const QString &errorName, const QString &errorMessage) = 0;
+
+    private:
+        bool mFinished;
+    };
+
+    DeferredReply() { }
+    explicit DeferredReply(const SharedPtr<Handler> &handler) : mHandler(handler) { }
+
+    template<typename Context>
+    static DeferredReply<T> forContext(const SharedPtr<Context> &context)
+    {
+        return DeferredReply<T>(SharedPtr<Handler>(new ContextHandler<Context>(context)));
+    }
+
+    bool isValid() const { return !mHandler.isNull(); }
+    bool isFinished() const { return !mHandler.isNull() && mHandler->isFinished(); }
+
+    void setFinished(const T &result) const
+    {
+        if (!mHandler.isNull()) {
+            mHandler->finish(result);
+        }
+    }
+
+    void setFinishedWithError(const QString &errorName, const QString &errorMessage) const
+    {
+        if (!mHandler.isNull()) {
+            mHandler->fail(errorName, errorMessage);
+        }
+    }
+
+    void setFinishedWithError(const DBusError &error) const
+    {
+        setFinishedWithError(error.name(), error.message());
+    }
+
+private:
+    template<typename Context>
+    class ContextHandler : public Handler
+    {
+    public:
+        ContextHandler(const SharedPtr<Context> &context) : mContext(context) { }
+
+    protected:
+        void onFinished(const T &result)
+        {
+            mContext->setFinished(result);
+        }
+
+        void onFailed(const QString &errorName, const QString &errorMessage)
+        {
+            mContext->setFinishedWithError(errorName, errorMessage);
+        }
+
+    private:
+        SharedPtr<Context> mContext;
+    };
+
+    SharedPtr<Handler> mHandler;
+};
+
+} // Tp
+
+#endif
@@ -0,0 +1,194 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2026 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef _TelepathyQt_feature_internal_h_HEADER_GUARD_
+#define _TelepathyQt_feature_internal_h_HEADER_GUARD_
+
+#include <TelepathyQt/Feature>
+#include <TelepathyQt/Global>
+
+#include <QHash>
+#include <QVarLengthArray>
+#include <QtGlobal>
+
+namespace Tp
+{
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+// Set of features stored as a bitset over the global feature indexes, so union, subtraction and
+// subset checks don't need to hash the feature class names.
+class TP_QT_NO_EXPORT FeatureMask
+{
+public:
+    FeatureMask() { }
+    FeatureMask(const Feature &feature) { insert(feature); }
+    FeatureMask(const Features &features);
+
+    static int indexOf(const Feature &feature);
+    static Feature featureAt(int index);
+
+    bool isEmpty() const
+    {
+        for (int i = 0; i < mWords.size(); ++i) {
+            if (mWords[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int count() const;
+
+    bool contains(const Feature &feature) const { return testBit(indexOf(feature)); }
+
+    // Whether all features in other are also in this mask
+    bool contains(const FeatureMask &other) const
+    {
+        for (int i = 0; i < other.mWords.size(); ++i) {
+            if (other.mWords[i] & ~word(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool intersects(const FeatureMask &other) const
+    {
+        int n = qMin(mWords.size(), other.mWords.size());
+        for (int i = 0; i < n; ++i) {
+            if (mWords[i] & other.mWords[i]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    FeatureMask &insert(const Feature &feature);
+    FeatureMask &remove(const Feature &feature);
+    void clear() { mWords.clear(); }
+
+    FeatureMask &operator|=(const FeatureMask &other)
+    {
+        if (other.mWords.size() > mWords.size()) {
+            int oldSize = mWords.size();
+            mWords.resize(other.mWords.size());
+            for (int i = oldSize; i < mWords.size(); ++i) {
+                mWords[i] = 0;
+            }
+        }
+        for (int i = 0; i < other.mWords.size(); ++i) {
+            mWords[i] |= other.mWords[i];
+        }
+        return *this;
+    }
+
+    FeatureMask &operator-=(const FeatureMask &other)
+    {
+        int n = qMin(mWords.size(), other.mWords.size());
+        for (int i = 0; i < n; ++i) {
+            mWords[i] &= ~other.mWords[i];
+        }
+        return *this;
+    }
+
+    FeatureMask &operator&=(const FeatureMask &other)
+    {
+        for (int i = 0; i < mWords.size(); ++i) {
+            mWords[i] &= other.word(i);
+        }
+        return *this;
+    }
+
+    FeatureMask operator|(const FeatureMask &other) const { return FeatureMask(*this) |= other; }
+    FeatureMask operator-(const FeatureMask &other) const { return FeatureMask(*this) -= other; }
+    FeatureMask operator&(const FeatureMask &other) const { return FeatureMask(*this) &= other; }
+
+    bool operator==(const FeatureMask &other) const
+    {
+        int n = qMax(mWords.size(), other.mWords.size());
+        for (int i = 0; i < n; ++i) {
+            if (word(i) != other.word(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool operator!=(const FeatureMask &other) const { return !(*this == other); }
+
+    Features toFeatures() const;
+
+private:
+    friend class FeatureInstances;
+
+    enum { BitsPerWord = 64 };
+
+    quint64 word(int i) const { return i < mWords.size() ? mWords[i] : 0; }
+
+    bool testBit(int index) const
+    {
+        return index >= 0 &&
+            (word(index / BitsPerWord) & (Q_UINT64_C(1) << (index % BitsPerWord)));
+    }
+
+    // Two words cover all the features in the library without allocating
+    QVarLengthArray<quint64, 2> mWords;
+};
+
+// The Feature instances that were inserted into some masks, so that the Features built back from
+// them keep the criticality they were given with, instead of being the first instance registered
+// for each bit. Only instances other than the registered ones need to be remembered.
+class TP_QT_NO_EXPORT FeatureInstances
+{
+public:
+    // The Features last built for a mask, kept until the mask or the instances change
+    struct Cache
+    {
+        Cache() : generation(-1) { }
+
+        FeatureMask mask;
+        Features features;
+        int generation;
+    };
+
+    FeatureInstances() : mGeneration(0) { }
+
+    // Keeps the first instance inserted for each feature, like inserting into a Features set does
+    void insert(const Feature &feature);
+    void insert(const Features &features);
+
+    Feature at(int index) const;
+    Features toFeatures(const FeatureMask &mask) const;
+    const Features &toFeatures(const FeatureMask &mask, Cache *cache) const;
+
+private:
+    FeatureMask mInserted;
+    QHash<int, Feature> mUnregistered;
+    int mGeneration;
+};
+
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+} // Tp
+
+#endif
@@ -21,15 +21,73 @@
  */
 
 #include <TelepathyQt/Feature>
+#include "TelepathyQt/feature-internal.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtAlgorithms>
+#include <QVector>
 
 namespace Tp
 {
 
+namespace
+{
+
+// Assigns each distinct feature a small index, used as its bit in FeatureMask.
+//
+// Features are mostly static members, so this happens at static initialization time.
+struct FeatureRegistry
+{
+    int indexFor(const QString &className, uint id)
+    {
+        QMutexLocker lock(&mutex);
+        QPair<QString, uint> key(className, id);
+        QHash<QPair<QString, uint>, int>::const_iterator i = indexes.constFind(key);
+        if (i != indexes.constEnd()) {
+            return *i;
+        }
+
+        int index = features.size();
+        indexes.insert(key, index);
+        features.append(Feature());
+        return index;
+    }
+
+    bool setFeature(int index, const Feature &feature)
+    {
+        QMutexLocker lock(&mutex);
+        if (!features[index].isValid()) {
+            features[index] = feature;
+            return true;
+        }
+        return false;
+    }
+
+    Feature featureAt(int index)
+    {
+        QMutexLocker lock(&mutex);
+        return features.value(index);
+    }
+
+    QMutex mutex;
+    QHash<QPair<QString, uint>, int> indexes;
+    QVector<Feature> features;
+};
+
+Q_GLOBAL_STATIC(FeatureRegistry, featureRegistry)
+
+}
+
 struct TP_QT_NO_EXPORT Feature::Private : public QSharedData
 {
-    Private(bool critical) : critical(critical) {}
+    Private(bool critical, int index) : critical(critical), index(index), registered(false) {}
 
     bool critical;
+    int index;
+    // Whether this is the instance FeatureMask::featureAt() returns for index
+    bool registered;
 };
 
 /**
@@ -48,8 +106,9 @@ Feature::Feature()
 
 Feature::Feature(const QString &className, uint id, bool critical)
     : QPair<QString, uint>(className, id),
-      mPriv(new Private(critical))
+      mPriv(new Private(critical, featureRegistry()->indexFor(className, id)))
 {
+    mPriv->registered = featureRegistry()->setFeature(mPriv.constData()->index, *this);
 }
 
 Feature::Feature(const Feature &other)
@@ -64,7 +123,7 @@ Feature::~Feature()
 
 Feature &Feature::operator=(const Feature &other)
 {
-    *this = other;
+    QPair<QString, uint>::operator=(other);
     this->mPriv = other.mPriv;
     return *this;
 }
@@ -86,4 +145,125 @@ bool Feature::isCritical() const
  * \brief The Features class represents a list of Feature.
  */
 
+FeatureMask::FeatureMask(const Features &features)
+{
+    foreach (const Feature &feature, features) {
+        insert(feature);
+    }
+}
+
+int FeatureMask::indexOf(const Feature &feature)
+{
+    if (!feature.isValid()) {
+        return -1;
+    }
+    return feature.mPriv.constData()->index;
+}
+
+Feature FeatureMask::featureAt(int index)
+{
+    return featureRegistry()->featureAt(index);
+}
+
+int FeatureMask::count() const
+{
+    int ret = 0;
+    for (int i = 0; i < mWords.size(); ++i) {
+        for (quint64 w = mWords[i]; w; w &= w - 1) {
+            ++ret;
+        }
+    }
+    return ret;
+}
+
+FeatureMask &FeatureMask::insert(const Feature &feature)
+{
+    int index = indexOf(feature);
+    if (index < 0) {
+        return *this;
+    }
+
+    int wordIndex = index / BitsPerWord;
+    if (wordIndex >= mWords.size()) {
+        int oldSize = mWords.size();
+        mWords.resize(wordIndex + 1);
+        for (int i = oldSize; i < mWords.size(); ++i) {
+            mWords[i] = 0;
+        }
+    }
+    mWords[wordIndex] |= Q_UINT64_C(1) << (index % BitsPerWord);
+    return *this;
+}
+
+FeatureMask &FeatureMask::remove(const Feature &feature)
+{
+    int index = indexOf(feature);
+    if (index >= 0 && index / BitsPerWord < mWords.size()) {
+        mWords[index / BitsPerWord] &= ~(Q_UINT64_C(1) << (index % BitsPerWord));
+    }
+    return *this;
+}
+
+Features FeatureMask::toFeatures() const
+{
+    Features ret;
+    for (int i = 0; i < mWords.size(); ++i) {
+        for (quint64 w = mWords[i]; w; w &= w - 1) {
+            ret.insert(featureAt(i * BitsPerWord + qCountTrailingZeroBits(w)));
+        }
+    }
+    return ret;
+}
+
+void FeatureInstances::insert(const Feature &feature)
+{
+    int index = FeatureMask::indexOf(feature);
+    if (index < 0 || mInserted.contains(feature)) {
+        return;
+    }
+
+    mInserted.insert(feature);
+    if (!feature.mPriv.constData()->registered) {
+        mUnregistered.insert(index, feature);
+        ++mGeneration;
+    }
+}
+
+void FeatureInstances::insert(const Features &features)
+{
+    foreach (const Feature &feature, features) {
+        insert(feature);
+    }
+}
+
+Feature FeatureInstances::at(int index) const
+{
+    QHash<int, Feature>::const_iterator i = mUnregistered.constFind(index);
+    if (i != mUnregistered.constEnd()) {
+        return *i;
+    }
+    return FeatureMask::featureAt(index);
+}
+
+Features FeatureInstances::toFeatures(const FeatureMask &mask) const
+{
+    Features ret;
+    for (int i = 0; i < mask.mWords.size(); ++i) {
+        for (quint64 w = mask.mWords[i]; w; w &= w - 1) {
+            ret.insert(at(i * FeatureMask::BitsPerWord + qCountTrailingZeroBits(w)));
+        }
+    }
+    return ret;
+}
+
+const Features &FeatureInstances::toFeatures(const FeatureMask &mask, Cache *cache) const
+{
+    if (cache->generation != mGeneration || cache->mask != mask) {
+        cache->features = toFeatures(mask);
+        cache->mask = mask;
+        cache->generation = mGeneration;
+    }
+    return cache->features;
+}
+
 } // Tp
@@ -53,6 +53,9 @@ public:
     bool isCritical() const;
 
 private:
+    friend class FeatureInstances;
+    friend class FeatureMask;
+
     struct Private;
     friend struct Private;
     QSharedDataPointer<Private> mPriv;
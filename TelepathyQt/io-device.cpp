@@ -24,12 +24,34 @@
 
 #include "TelepathyQt/_gen/io-device.moc.hpp"
 
+#include <QList>
+
 namespace Tp
 {
 
+// Small writes are appended to the last chunk while it is smaller than this
+static const int c_chunkSize = 64 * 1024;
+
 struct TP_QT_NO_EXPORT IODevice::Private
 {
-    QByteArray data;
+    Private()
+        : chunkOffset(0),
+          size(0),
+          highWaterMark(0),
+          pendingBytesWritten(0),
+          readyReadPending(false),
+          signalsScheduled(false)
+    {
+    }
+
+    // The buffered data is split in chunks, so that reading never moves the remaining data
+    QList<QByteArray> chunks;
+    int chunkOffset; // Bytes of the first chunk which have already been read
+    qint64 size;
+    qint64 highWaterMark;
+    qint64 pendingBytesWritten;
+    bool readyReadPending;
+    bool signalsScheduled;
 };
 
 /**
@@ -45,6 +67,14 @@ struct TP_QT_NO_EXPORT IODevice::Private
  * This class is interesting for all CMs that use a library that accepts a
  * QIODevice for file transfers.
  *
+ * The readyRead() and bytesWritten() signals are emitted once per event loop iteration
+ * for all the data written or read since the previous iteration.
+ *
+ * By default the buffer grows without limit. Once a high-water mark is set with
+ * setHighWaterMark(), the device behaves like a socket whose peer is the reader: writes
+ * are cut short when the buffered data would go over the mark, bytesToWrite() returns the
+ * amount of data which has not been read yet, and bytesWritten() is emitted when data is read.
+ *
  * Note: This class belongs to the service library.
  */
 
@@ -59,34 +89,96 @@ IODevice::~IODevice()
     delete mPriv;
 }
 
-qint64 IODevice::bytesAvailable() const
-{
-    return QIODevice::bytesAvailable() + mPriv->data.size();
-}
-
 /**
  * Returns the number of bytes that are available for reading.
  *
  * \return the number of bytes that are available for reading.
  */
+qint64 IODevice::bytesAvailable() const
+{
+    return QIODevice::bytesAvailable() + mPriv->size;
+}
+
 bool IODevice::isSequential() const
 {
     return true;
 }
 
+/**
+ * Returns the number of bytes that have been written but not read yet if a high-water
+ * mark is set, and 0 otherwise.
+ *
+ * \return the number of bytes waiting to be read.
+ * \sa setHighWaterMark()
+ */
+qint64 IODevice::bytesToWrite() const
+{
+    if (mPriv->highWaterMark <= 0) {
+        return 0;
+    }
+
+    return mPriv->size;
+}
+
+/**
+ * Returns the maximum number of bytes buffered by this device, or 0 if there is no limit.
+ *
+ * \return the high-water mark of the buffer.
+ * \sa setHighWaterMark()
+ */
+qint64 IODevice::highWaterMark() const
+{
+    return mPriv->highWaterMark;
+}
+
+/**
+ * Set the maximum number of bytes buffered by this device.
+ *
+ * Writing stops at \a bytes unread bytes, and the writer is told with bytesWritten() when the
+ * reader has made room again. Setting it to 0, the default, lets the buffer grow without limit.
+ *
+ * \param bytes The high-water mark, or 0 for no limit.
+ * \sa highWaterMark(), bytesToWrite()
+ */
+void IODevice::setHighWaterMark(qint64 bytes)
+{
+    mPriv->highWaterMark = qMax<qint64>(bytes, 0);
+}
+
 qint64 IODevice::readData(char *data, qint64 maxSize)
 {
-    qint64 size = qMin<qint64>(mPriv->data.size(), maxSize);
-    memcpy(data, mPriv->data.constData(), size);
-    mPriv->data.remove(0, size);
+    qint64 size = 0;
+    while (size < maxSize && !mPriv->chunks.isEmpty()) {
+        const QByteArray &chunk = mPriv->chunks.first();
+        qint64 count = qMin<qint64>(chunk.size() - mPriv->chunkOffset, maxSize - size);
+        memcpy(data + size, chunk.constData() + mPriv->chunkOffset, count);
+        size += count;
+        mPriv->chunkOffset += count;
+
+        if (mPriv->chunkOffset == chunk.size()) {
+            mPriv->chunks.removeFirst();
+            mPriv->chunkOffset = 0;
+        }
+    }
+    mPriv->size -= size;
+
+    if (size > 0 && mPriv->highWaterMark > 0) {
+        mPriv->pendingBytesWritten += size;
+        if (!mPriv->signalsScheduled) {
+            mPriv->signalsScheduled = true;
+            QMetaObject::invokeMethod(this, "emitPendingSignals", Qt::QueuedConnection);
+        }
+    }
+
     return size;
 }
 
 /**
  * Writes the data to the buffer.
  *
- * Writes up to \a maxSize bytes from \a data to the buffer.
- * If maxSize is not a zero, emits readyRead() and bytesWritten() signals.
+ * Writes up to \a maxSize bytes from \a data to the buffer, or less if a high-water mark is set
+ * and the buffer is full. If any data is written, readyRead() and bytesWritten() signals are
+ * emitted when control returns to the event loop.
  *
  * \param data The data to write.
  * \param maxSize The number for bytes to write.
@@ -94,14 +186,50 @@ qint64 IODevice::readData(char *data, qint64 maxSize)
  */
 qint64 IODevice::writeData(const char *data, qint64 maxSize)
 {
+    if (mPriv->highWaterMark > 0) {
+        maxSize = qMin(maxSize, mPriv->highWaterMark - mPriv->size);
+    }
+
     if (maxSize <= 0) {
         return 0;
     }
 
-    mPriv->data.append(data, maxSize);
-    Q_EMIT bytesWritten(maxSize);
-    Q_EMIT readyRead();
+    if (!mPriv->chunks.isEmpty() && mPriv->chunks.last().size() + maxSize <= c_chunkSize) {
+        mPriv->chunks.last().append(data, maxSize);
+    } else {
+        mPriv->chunks.append(QByteArray(data, maxSize));
+    }
+    mPriv->size += maxSize;
+
+    if (mPriv->highWaterMark <= 0) {
+        mPriv->pendingBytesWritten += maxSize;
+    }
+    mPriv->readyReadPending = true;
+
+    if (!mPriv->signalsScheduled) {
+        mPriv->signalsScheduled = true;
+        QMetaObject::invokeMethod(this, "emitPendingSignals", Qt::QueuedConnection);
+    }
+
     return maxSize;
 }
 
+void IODevice::emitPendingSignals()
+{
+    mPriv->signalsScheduled = false;
+
+    qint64 written = mPriv->pendingBytesWritten;
+    mPriv->pendingBytesWritten = 0;
+    if (written > 0) {
+        Q_EMIT bytesWritten(written);
+    }
+
+    if (mPriv->readyReadPending) {
+        mPriv->readyReadPending = false;
+        if (bytesAvailable() > 0) {
+            Q_EMIT readyRead();
+        }
+    }
+}
+
 }
@@ -42,11 +42,18 @@ public:
     ~IODevice();
     bool isSequential() const;
     qint64 bytesAvailable() const;
+    qint64 bytesToWrite() const;
+
+    qint64 highWaterMark() const;
+    void setHighWaterMark(qint64 bytes);
 
 protected:
     qint64 readData(char *data, qint64 maxSize);
     qint64 writeData(const char *data, qint64 maxSize);
 
+private Q_SLOTS:
+    TP_QT_NO_EXPORT void emitPendingSignals();
+
 private:
     struct Private;
     friend struct Private;
@@ -240,7 +240,7 @@ void PendingChannelRequest::onWatcherFinished(QDBusPendingCallWatcher *watcher)
 
     if (!reply.isError()) {
         QDBusObjectPath objectPath = reply.argumentAt<0>();
-        debug() << "Got reply to ChannelDispatcher.Ensure/CreateChannel "
+        tpDebug(DebugCategoryDispatch) << "Got reply to ChannelDispatcher.Ensure/CreateChannel "
             "- object path:" << objectPath.path();
 
         if (!account().isNull()) {
@@ -265,7 +265,7 @@ void PendingChannelRequest::onWatcherFinished(QDBusPendingCallWatcher *watcher)
                     SLOT(onProceedOperationFinished(Tp::PendingOperation*)));
         }
     } else {
-        debug().nospace() << "Ensure/CreateChannel failed:" <<
+        tpDebug(DebugCategoryDispatch).nospace() << "Ensure/CreateChannel failed:" <<
             reply.error().name() << ": " << reply.error().message();
         setFinishedWithError(reply.error());
     }
@@ -184,7 +184,7 @@ void PendingContactAttributes::onCallFinished(QDBusPendingCallWatcher* watcher)
     QDBusPendingReply<ContactAttributesMap> reply = *watcher;
 
     if (reply.isError()) {
-        debug().nospace() << "GetCAs: error " << reply.error().name() << ": " << reply.error().message();
+        tpDebug(DebugCategoryContacts).nospace() << "GetCAs: error " << reply.error().name() << ": " << reply.error().message();
         setFinishedWithError(reply.error());
     } else {
         mPriv->attributes = reply.value();
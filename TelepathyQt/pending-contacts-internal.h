@@ -24,11 +24,127 @@
 #define _TelepathyQt_pending_contacts_internal_h_HEADER_GUARD_
 
 #include <TelepathyQt/PendingOperation>
+#include <TelepathyQt/ReferencedHandles>
 #include <TelepathyQt/Types>
 
+#include <QHash>
+#include <QMap>
+#include <QPointer>
+#include <QQueue>
+#include <QSet>
+#include <QSharedPointer>
+#include <QStringList>
+
 namespace Tp
 {
 
+class ContactManager;
+class PendingScheduledContactAttributes;
+
+// One GetContactAttributes call, shared by every request waiting for its handles
+struct TP_QT_NO_EXPORT ContactAttributesChunk
+{
+    ContactAttributesChunk(const QString &interfacesKey, const QStringList &interfaces)
+        : interfacesKey(interfacesKey), interfaces(interfaces), finished(false)
+    { }
+
+    QString interfacesKey;
+    QStringList interfaces;
+    UIntList handles;
+
+    bool finished;
+    QString errorName;
+    QString errorMessage;
+    ReferencedHandles validHandles;
+    QHash<uint, int> validIndexes;
+    ContactAttributesMap attributes;
+
+    QList<QPointer<PendingScheduledContactAttributes> > waiters;
+};
+typedef QSharedPointer<ContactAttributesChunk> ContactAttributesChunkPtr;
+
+class TP_QT_NO_EXPORT PendingScheduledContactAttributes : public PendingOperation
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(PendingScheduledContactAttributes)
+
+public:
+    PendingScheduledContactAttributes(const ConnectionPtr &connection, const UIntList &handles);
+    ~PendingScheduledContactAttributes();
+
+    UIntList contactsRequested() const { return mHandles; }
+
+    bool isValidHandle(uint handle) const;
+    ReferencedHandles referencedHandle(uint handle) const;
+    QVariantMap attributes(uint handle) const;
+
+private:
+    friend class ContactAttributesScheduler;
+
+    void addChunk(uint handle, const ContactAttributesChunkPtr &chunk);
+    void chunkFinished(ContactAttributesChunk *chunk);
+
+    void batchSent();
+
+    UIntList mHandles;
+    QHash<uint, ContactAttributesChunkPtr> mChunks;
+    QSet<ContactAttributesChunk *> mPendingChunks;
+    // Some handles are in a batch which flush() has not turned into chunks yet
+    bool mWaitingForBatch;
+};
+
+// Merges the GetContactAttributes requests made for the same interfaces during a main
+// loop iteration, skips handles which are already being fetched, and splits large
+// requests into chunks of which only a few are in flight at any time
+class TP_QT_NO_EXPORT ContactAttributesScheduler : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(ContactAttributesScheduler)
+
+public:
+    enum {
+        DefaultChunkSize = 500,
+        DefaultMaxChunksInFlight = 4
+    };
+
+    ContactAttributesScheduler(ContactManager *manager);
+    ~ContactAttributesScheduler();
+
+    int chunkSize() const { return mChunkSize; }
+    void setChunkSize(int chunkSize) { mChunkSize = qMax(chunkSize, 0); }
+    int maxChunksInFlight() const { return mMaxChunksInFlight; }
+    void setMaxChunksInFlight(int maxChunksInFlight);
+
+    PendingScheduledContactAttributes *request(const UIntList &handles,
+            const QStringList &interfaces);
+
+private Q_SLOTS:
+    void flush();
+    void onChunkFinished(Tp::PendingOperation *op);
+
+private:
+    struct Batch
+    {
+        QStringList interfaces;
+        UIntList handles;
+        QSet<uint> handleSet;
+        QList<QPointer<PendingScheduledContactAttributes> > waiters;
+    };
+
+    void startChunks();
+
+    ContactManager *mManager;
+    int mChunkSize;
+    int mMaxChunksInFlight;
+
+    bool mFlushQueued;
+    QMap<QString, Batch> mBatches;
+    // chunks not finished yet, by interfaces and handle
+    QHash<QString, QHash<uint, ContactAttributesChunkPtr> > mChunks;
+    QQueue<ContactAttributesChunkPtr> mWaitingChunks;
+    QHash<PendingOperation *, ContactAttributesChunkPtr> mChunksInFlight;
+};
+
 class TP_QT_NO_EXPORT PendingAddressingGetContacts : public PendingOperation
 {
     Q_OBJECT
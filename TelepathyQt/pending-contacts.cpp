@@ -27,6 +27,7 @@
 #include "TelepathyQt/_gen/pending-contacts-internal.moc.hpp"
 
 #include "TelepathyQt/debug-internal.h"
+#include "TelepathyQt/feature-internal.h"
 
 #include <TelepathyQt/Connection>
 #include <TelepathyQt/ConnectionLowlevel>
@@ -36,6 +37,8 @@
 #include <TelepathyQt/PendingHandles>
 #include <TelepathyQt/ReferencedHandles>
 
+#include <QTimer>
+
 // FIXME: Refactor PendingContacts code to make it more readable/maintainable and reuse common code
 //        when appropriate.
 
@@ -100,6 +103,7 @@ struct TP_QT_NO_EXPORT PendingContacts::Private
     }
 
     void setFinished();
+    void setIdentifierResults(const QHash<uint, ContactPtr> &contactsByHandle);
 
     bool checkRequestTypeAndState(const char *methodName, const char *debug, RequestType type);
 
@@ -118,6 +122,8 @@ struct TP_QT_NO_EXPORT PendingContacts::Private
     QStringList addresses;
     QString vcardField;
     QList<ContactPtr> contactsToUpgrade;
+    QHash<QString, ContactPtr> satisfyingIds;
+    QHash<QString, uint> requestedIds;
     PendingContacts *nested;
 
     // Results
@@ -146,6 +152,25 @@ void PendingContacts::Private::setFinished()
     parent->setFinished();
 }
 
+void PendingContacts::Private::setIdentifierResults(const QHash<uint, ContactPtr> &contactsByHandle)
+{
+    // Merge the contacts found locally with the ones resolved on the bus, keeping the order in
+    // which the identifiers were requested
+    contacts.clear();
+    validIds.clear();
+    foreach (const QString &id, addresses) {
+        ContactPtr contact = satisfyingIds.value(id);
+        if (!contact && requestedIds.contains(id)) {
+            contact = contactsByHandle.value(requestedIds.value(id));
+        }
+
+        if (contact) {
+            contacts.append(contact);
+            validIds.append(id);
+        }
+    }
+}
+
 bool PendingContacts::Private::checkRequestTypeAndState(const char *methodName,
         const char *debug,
         RequestType type)
@@ -196,9 +221,9 @@ PendingContacts::PendingContacts(const ContactManagerPtr &manager,
     if (!otherContacts.isEmpty()) {
         ConnectionPtr conn = manager->connection();
         if (conn->interfaces().contains(TP_QT_IFACE_CONNECTION_INTERFACE_CONTACTS)) {
-            PendingContactAttributes *attributes =
-                conn->lowlevel()->contactAttributes(otherContacts.toList(),
-                        interfaces, true);
+            PendingScheduledContactAttributes *attributes =
+                manager->attributesScheduler()->request(otherContacts.toList(),
+                        interfaces);
 
             connect(attributes,
                     SIGNAL(finished(Tp::PendingOperation*)),
@@ -232,7 +257,30 @@ PendingContacts::PendingContacts(const ContactManagerPtr &manager,
 
     if (type == ForIdentifiers) {
         Q_ASSERT(interfaces.isEmpty());
-        PendingHandles *handles = conn->lowlevel()->requestHandles(HandleTypeContact, list);
+
+        // Identifiers of contacts we already have with all the requested features don't need
+        // to go through RequestHandles again
+        QStringList idsToRequest;
+        const FeatureMask featureMask(features);
+        foreach (const QString &id, list) {
+            ContactPtr contact = manager->lookupContactByIdentifier(id);
+            if (contact && contact->requestedFeatureMask().contains(featureMask)) {
+                mPriv->satisfyingIds.insert(id, contact);
+            } else if (!idsToRequest.contains(id)) {
+                idsToRequest.append(id);
+            }
+        }
+
+        if (idsToRequest.isEmpty()) {
+            tpDebug(DebugCategoryContacts) <<
+                "All identifiers resolved locally, not requesting handles";
+            mPriv->setIdentifierResults(QHash<uint, ContactPtr>());
+            mPriv->setFinished();
+            return;
+        }
+
+        PendingHandles *handles = conn->lowlevel()->requestHandles(HandleTypeContact,
+                idsToRequest);
         connect(handles,
                 SIGNAL(finished(Tp::PendingOperation*)),
                 SLOT(onRequestHandlesFinished(Tp::PendingOperation*)));
@@ -481,27 +529,22 @@ QStringList PendingContacts::invalidUris() const
 
 void PendingContacts::onAttributesFinished(PendingOperation *operation)
 {
-    PendingContactAttributes *pendingAttributes =
-        qobject_cast<PendingContactAttributes *>(operation);
+    PendingScheduledContactAttributes *pendingAttributes =
+        qobject_cast<PendingScheduledContactAttributes *>(operation);
 
     if (pendingAttributes->isError()) {
-        debug() << "PendingAttrs error" << pendingAttributes->errorName()
+        tpDebug(DebugCategoryContacts) << "PendingAttrs error" << pendingAttributes->errorName()
                 << "message" << pendingAttributes->errorMessage();
         setFinishedWithError(pendingAttributes->errorName(), pendingAttributes->errorMessage());
         return;
     }
 
-    ReferencedHandles validHandles = pendingAttributes->validHandles();
-    ContactAttributesMap attributes = pendingAttributes->attributes();
-
     foreach (uint handle, mPriv->handles) {
         if (!mPriv->satisfyingContacts.contains(handle)) {
-            int indexInValid = validHandles.indexOf(handle);
-            if (indexInValid >= 0) {
-                ReferencedHandles referencedHandle = validHandles.mid(indexInValid, 1);
-                QVariantMap handleAttributes = attributes[handle];
-                mPriv->satisfyingContacts.insert(handle, manager()->ensureContact(referencedHandle,
-                            mPriv->missingFeatures, handleAttributes));
+            if (pendingAttributes->isValidHandle(handle)) {
+                mPriv->satisfyingContacts.insert(handle, manager()->ensureContact(
+                            pendingAttributes->referencedHandle(handle),
+                            mPriv->missingFeatures, pendingAttributes->attributes(handle)));
             } else {
                 mPriv->invalidHandles.push_back(handle);
             }
@@ -519,12 +562,17 @@ void PendingContacts::onRequestHandlesFinished(PendingOperation *operation)
     mPriv->invalidIds = pendingHandles->invalidNames();
 
     if (pendingHandles->isError()) {
-        debug() << "RequestHandles error" << operation->errorName()
+        tpDebug(DebugCategoryContacts) << "RequestHandles error" << operation->errorName()
                 << "message" << operation->errorMessage();
         setFinishedWithError(operation->errorName(), operation->errorMessage());
         return;
     }
 
+    ReferencedHandles handles = pendingHandles->handles();
+    for (int i = 0; i < mPriv->validIds.size(); ++i) {
+        mPriv->requestedIds.insert(mPriv->validIds[i], handles[i]);
+    }
+
     mPriv->nested = manager()->contactsForHandles(pendingHandles->handles(), features());
     connect(mPriv->nested,
             SIGNAL(finished(Tp::PendingOperation*)),
@@ -567,7 +615,7 @@ void PendingContacts::onReferenceHandlesFinished(PendingOperation *operation)
     PendingHandles *pendingHandles = qobject_cast<PendingHandles *>(operation);
 
     if (pendingHandles->isError()) {
-        debug() << "ReferenceHandles error" << operation->errorName()
+        tpDebug(DebugCategoryContacts) << "ReferenceHandles error" << operation->errorName()
                 << "message" << operation->errorMessage();
         setFinishedWithError(operation->errorName(), operation->errorMessage());
         return;
@@ -604,14 +652,34 @@ void PendingContacts::onNestedFinished(PendingOperation *operation)
     Q_ASSERT(operation == mPriv->nested);
 
     if (operation->isError()) {
-        debug() << " error" << operation->errorName()
+        tpDebug(DebugCategoryContacts) << " error" << operation->errorName()
                 << "message" << operation->errorMessage();
         setFinishedWithError(operation->errorName(), operation->errorMessage());
         return;
     }
 
-    mPriv->contacts = mPriv->nested->contacts();
+    if (mPriv->requestType != ForIdentifiers) {
+        mPriv->contacts = mPriv->nested->contacts();
+        mPriv->nested = 0;
+        mPriv->setFinished();
+        return;
+    }
+
+    QHash<uint, ContactPtr> contactsByHandle;
+    foreach (const ContactPtr &contact, mPriv->nested->contacts()) {
+        contactsByHandle.insert(contact->handle()[0], contact);
+    }
     mPriv->nested = 0;
+
+    // Also index the identifiers as they were requested, which may not be normalized
+    QHash<QString, uint>::const_iterator i = mPriv->requestedIds.constBegin();
+    for (; i != mPriv->requestedIds.constEnd(); ++i) {
+        if (contactsByHandle.contains(i.value())) {
+            mPriv->manager->addContactIdentifier(i.key(), i.value());
+        }
+    }
+
+    mPriv->setIdentifierResults(contactsByHandle);
     mPriv->setFinished();
 }
 
@@ -620,7 +688,8 @@ void PendingContacts::onInspectHandlesFinished(QDBusPendingCallWatcher *watcher)
     QDBusPendingReply<QStringList> reply = *watcher;
 
     if (reply.isError()) {
-        debug().nospace() << "InspectHandles: error " << reply.error().name() << ": "
+        tpDebug(DebugCategoryContacts).nospace() << "InspectHandles: error " <<
+            reply.error().name() << ": "
             << reply.error().message();
         setFinishedWithError(reply.error());
         return;
@@ -712,7 +781,7 @@ void PendingAddressingGetContacts::onGetContactsFinished(QDBusPendingCallWatcher
         mAttributes = reply.argumentAt<1>();
         setFinished();
     } else {
-        debug().nospace() << "GetContactsBy* failed: " <<
+        tpDebug(DebugCategoryContacts).nospace() << "GetContactsBy* failed: " <<
             reply.error().name() << ": " << reply.error().message();
         setFinishedWithError(reply.error());
     }
@@ -720,4 +789,238 @@ void PendingAddressingGetContacts::onGetContactsFinished(QDBusPendingCallWatcher
     watcher->deleteLater();
 }
 
+PendingScheduledContactAttributes::PendingScheduledContactAttributes(
+        const ConnectionPtr &connection, const UIntList &handles)
+    : PendingOperation(connection),
+      mHandles(handles),
+      mWaitingForBatch(false)
+{
+}
+
+PendingScheduledContactAttributes::~PendingScheduledContactAttributes()
+{
+}
+
+bool PendingScheduledContactAttributes::isValidHandle(uint handle) const
+{
+    ContactAttributesChunkPtr chunk = mChunks.value(handle);
+    return chunk && chunk->validIndexes.contains(handle);
+}
+
+ReferencedHandles PendingScheduledContactAttributes::referencedHandle(uint handle) const
+{
+    ContactAttributesChunkPtr chunk = mChunks.value(handle);
+    if (!chunk || !chunk->validIndexes.contains(handle)) {
+        return ReferencedHandles();
+    }
+    return chunk->validHandles.mid(chunk->validIndexes.value(handle), 1);
+}
+
+QVariantMap PendingScheduledContactAttributes::attributes(uint handle) const
+{
+    ContactAttributesChunkPtr chunk = mChunks.value(handle);
+    if (!chunk) {
+        return QVariantMap();
+    }
+    return chunk->attributes.value(handle);
+}
+
+void PendingScheduledContactAttributes::addChunk(uint handle,
+        const ContactAttributesChunkPtr &chunk)
+{
+    mChunks.insert(handle, chunk);
+    if (!mPendingChunks.contains(chunk.data())) {
+        mPendingChunks.insert(chunk.data());
+        chunk->waiters.append(QPointer<PendingScheduledContactAttributes>(this));
+    }
+}
+
+void PendingScheduledContactAttributes::chunkFinished(ContactAttributesChunk *chunk)
+{
+    mPendingChunks.remove(chunk);
+
+    if (isFinished()) {
+        return;
+    }
+
+    if (!chunk->errorName.isEmpty()) {
+        setFinishedWithError(chunk->errorName, chunk->errorMessage);
+    } else if (mPendingChunks.isEmpty() && !mWaitingForBatch) {
+        setFinished();
+    }
+}
+
+void PendingScheduledContactAttributes::batchSent()
+{
+    mWaitingForBatch = false;
+
+    // The chunks this was waiting for may all have finished before the batch was sent
+    if (!isFinished() && mPendingChunks.isEmpty()) {
+        setFinished();
+    }
+}
+
+ContactAttributesScheduler::ContactAttributesScheduler(ContactManager *manager)
+    : QObject(),
+      mManager(manager),
+      mChunkSize(DefaultChunkSize),
+      mMaxChunksInFlight(DefaultMaxChunksInFlight),
+      mFlushQueued(false)
+{
+}
+
+ContactAttributesScheduler::~ContactAttributesScheduler()
+{
+}
+
+void ContactAttributesScheduler::setMaxChunksInFlight(int maxChunksInFlight)
+{
+    mMaxChunksInFlight = qMax(maxChunksInFlight, 0);
+    startChunks();
+}
+
+PendingScheduledContactAttributes *ContactAttributesScheduler::request(const UIntList &handles,
+        const QStringList &interfaces)
+{
+    ConnectionPtr conn = mManager->connection();
+    PendingScheduledContactAttributes *op = new PendingScheduledContactAttributes(conn, handles);
+
+    QStringList sortedInterfaces = interfaces;
+    sortedInterfaces.sort();
+    QString key = sortedInterfaces.join(QLatin1String(" "));
+
+    // handles already being fetched with the same interfaces are not asked for again
+    const QHash<uint, ContactAttributesChunkPtr> chunks = mChunks.value(key);
+    Batch &batch = mBatches[key];
+    batch.interfaces = sortedInterfaces;
+    bool waitsForBatch = false;
+    foreach (uint handle, handles) {
+        ContactAttributesChunkPtr chunk = chunks.value(handle);
+        if (chunk) {
+            op->addChunk(handle, chunk);
+        } else {
+            if (!batch.handleSet.contains(handle)) {
+                batch.handleSet.insert(handle);
+                batch.handles.append(handle);
+            }
+            waitsForBatch = true;
+        }
+    }
+
+    if (waitsForBatch) {
+        op->mWaitingForBatch = true;
+        batch.waiters.append(QPointer<PendingScheduledContactAttributes>(op));
+        if (!mFlushQueued) {
+            mFlushQueued = true;
+            QTimer::singleShot(0, this, SLOT(flush()));
+        }
+    } else if (batch.handles.isEmpty()) {
+        mBatches.remove(key);
+        if (handles.isEmpty()) {
+            op->setFinished();
+        }
+    }
+
+    return op;
+}
+
+void ContactAttributesScheduler::flush()
+{
+    mFlushQueued = false;
+
+    QMap<QString, Batch> batches = mBatches;
+    mBatches.clear();
+
+    for (QMap<QString, Batch>::const_iterator i = batches.constBegin();
+            i != batches.constEnd(); ++i) {
+        const Batch &batch = i.value();
+        QHash<uint, ContactAttributesChunkPtr> &chunks = mChunks[i.key()];
+
+        tpDebug(DebugCategoryContacts) << "Fetching attributes for" << batch.handles.size() <<
+            "contacts requested by" << batch.waiters.size() << "operations";
+
+        int size = mChunkSize > 0 ? mChunkSize : batch.handles.size();
+        for (int pos = 0; pos < batch.handles.size(); pos += size) {
+            ContactAttributesChunkPtr chunk(new ContactAttributesChunk(i.key(),
+                        batch.interfaces));
+            chunk->handles = batch.handles.mid(pos, size);
+            foreach (uint handle, chunk->handles) {
+                chunks.insert(handle, chunk);
+            }
+            mWaitingChunks.enqueue(chunk);
+        }
+
+        foreach (const QPointer<PendingScheduledContactAttributes> &op, batch.waiters) {
+            if (!op) {
+                continue;
+            }
+            foreach (uint handle, op->contactsRequested()) {
+                ContactAttributesChunkPtr chunk = chunks.value(handle);
+                if (chunk) {
+                    op->addChunk(handle, chunk);
+                }
+            }
+            op->batchSent();
+        }
+    }
+
+    startChunks();
+}
+
+void ContactAttributesScheduler::startChunks()
+{
+    while (!mWaitingChunks.isEmpty() &&
+            (mMaxChunksInFlight == 0 || mChunksInFlight.size() < mMaxChunksInFlight)) {
+        ContactAttributesChunkPtr chunk = mWaitingChunks.dequeue();
+
+        ConnectionPtr conn = mManager->connection();
+        PendingContactAttributes *attributes = conn->lowlevel()->contactAttributes(
+                chunk->handles, chunk->interfaces, true);
+        mChunksInFlight.insert(attributes, chunk);
+        connect(attributes,
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(onChunkFinished(Tp::PendingOperation*)));
+    }
+}
+
+void ContactAttributesScheduler::onChunkFinished(PendingOperation *op)
+{
+    PendingContactAttributes *pendingAttributes = qobject_cast<PendingContactAttributes *>(op);
+    ContactAttributesChunkPtr chunk = mChunksInFlight.take(op);
+    Q_ASSERT(chunk);
+
+    if (pendingAttributes->isError()) {
+        tpDebug(DebugCategoryContacts) << "PendingAttrs error" << pendingAttributes->errorName()
+                << "message" << pendingAttributes->errorMessage();
+        chunk->errorName = pendingAttributes->errorName();
+        chunk->errorMessage = pendingAttributes->errorMessage();
+    } else {
+        chunk->validHandles = pendingAttributes->validHandles();
+        chunk->attributes = pendingAttributes->attributes();
+        for (int i = 0; i < chunk->validHandles.size(); ++i) {
+            chunk->validIndexes.insert(chunk->validHandles.at(i), i);
+        }
+    }
+    chunk->finished = true;
+
+    QHash<uint, ContactAttributesChunkPtr> &chunks = mChunks[chunk->interfacesKey];
+    foreach (uint handle, chunk->handles) {
+        if (chunks.value(handle) == chunk) {
+            chunks.remove(handle);
+        }
+    }
+    if (chunks.isEmpty()) {
+        mChunks.remove(chunk->interfacesKey);
+    }
+
+    foreach (const QPointer<PendingScheduledContactAttributes> &waiter, chunk->waiters) {
+        if (waiter) {
+            waiter->chunkFinished(chunk.data());
+        }
+    }
+    chunk->waiters.clear();
+
+    startChunks();
+}
+
 } // Tp
@@ -162,11 +162,11 @@ void PendingDBusTubeConnection::onConnectionFinished(PendingOperation *op)
         return;
     }
 
-    debug() << "Accept/Offer tube finished successfully";
+    tpDebug(DebugCategoryTubes) << "Accept/Offer tube finished successfully";
 
     // Now get the address and set it
     PendingString *ps = qobject_cast<PendingString*>(op);
-    debug() << "Got address " << ps->result();
+    tpDebug(DebugCategoryTubes) << "Got address " << ps->result();
     mPriv->tube->setAddress(ps->result());
 
     // It might have been already opened - check
@@ -181,7 +181,7 @@ void PendingDBusTubeConnection::onConnectionFinished(PendingOperation *op)
 
 void PendingDBusTubeConnection::onStateChanged(TubeChannelState state)
 {
-    debug() << "Tube state changed to " << state;
+    tpDebug(DebugCategoryTubes) << "Tube state changed to " << state;
     if (state == TubeChannelStateOpen) {
         if (!mPriv->parameters.isEmpty()) {
             // Inject the parameters into the tube
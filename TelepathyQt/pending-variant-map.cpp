@@ -58,6 +58,14 @@ PendingVariantMap::PendingVariantMap(QDBusPendingCall call, const SharedPtr<RefC
             SLOT(watcherFinished(QDBusPendingCallWatcher*)));
 }
 
+PendingVariantMap::PendingVariantMap(const QVariantMap &result, const SharedPtr<RefCounted> &object)
+    : PendingOperation(object),
+      mPriv(new Private)
+{
+    mPriv->result = result;
+    setFinished();
+}
+
 /**
  * Class destructor.
  */
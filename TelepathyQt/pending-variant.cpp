@@ -58,6 +58,14 @@ PendingVariant::PendingVariant(QDBusPendingCall call, const SharedPtr<RefCounted
             SLOT(watcherFinished(QDBusPendingCallWatcher*)));
 }
 
+PendingVariant::PendingVariant(const QVariant &result, const SharedPtr<RefCounted> &object)
+    : PendingOperation(object),
+      mPriv(new Private)
+{
+    mPriv->result = result;
+    setFinished();
+}
+
 /**
  * Class destructor.
  */
@@ -50,6 +50,10 @@ private Q_SLOTS:
     TP_QT_NO_EXPORT void watcherFinished(QDBusPendingCallWatcher*);
 
 private:
+    friend class AbstractInterface;
+
+    TP_QT_NO_EXPORT PendingVariant(const QVariant &result, const SharedPtr<RefCounted> &object);
+
     struct Private;
     friend struct Private;
     Private *mPriv;
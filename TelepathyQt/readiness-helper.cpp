@@ -25,6 +25,7 @@
 #include "TelepathyQt/_gen/readiness-helper.moc.hpp"
 
 #include "TelepathyQt/debug-internal.h"
+#include "TelepathyQt/feature-internal.h"
 
 #include <TelepathyQt/Constants>
 #include <TelepathyQt/DBusProxy>
@@ -33,6 +34,8 @@
 #include <TelepathyQt/SharedPtr>
 
 #include <QDBusError>
+#include <QElapsedTimer>
+#include <QPointer>
 #include <QSharedData>
 #include <QTimer>
 
@@ -49,6 +52,7 @@ struct TP_QT_NO_EXPORT ReadinessHelper::Introspectable::Private : public QShared
             bool critical)
         : makesSenseForStatuses(makesSenseForStatuses),
         dependsOnFeatures(dependsOnFeatures),
+        dependsOnMask(dependsOnFeatures),
         dependsOnInterfaces(dependsOnInterfaces),
         introspectFunc(introspectFunc),
         introspectFuncData(introspectFuncData),
@@ -56,6 +60,7 @@ struct TP_QT_NO_EXPORT ReadinessHelper::Introspectable::Private : public QShared
 
     QSet<uint> makesSenseForStatuses;
     Features dependsOnFeatures;
+    FeatureMask dependsOnMask;
     QStringList dependsOnInterfaces;
     IntrospectFunc introspectFunc;
     void *introspectFuncData;
@@ -107,8 +112,10 @@ struct TP_QT_NO_EXPORT ReadinessHelper::Private
     void setIntrospectCompleted(const Feature &feature, bool success,
             const QString &errorName = QString(),
             const QString &errorMessage = QString());
+    void scheduleIteration();
     void iterateIntrospection();
-    Features depsFor(const Feature &feature); // Recursive dependencies for a feature
+    void iterateIntrospectionOnce();
+    FeatureMask depsFor(const Feature &feature); // Recursive dependencies for a feature
 
     void abortOperations(const QString &errorName, const QString &errorMessage);
 
@@ -119,17 +126,33 @@ struct TP_QT_NO_EXPORT ReadinessHelper::Private
     QStringList interfaces;
     Introspectables introspectables;
     QSet<uint> supportedStatuses;
-    Features supportedFeatures;
-    Features satisfiedFeatures;
-    Features requestedFeatures;
-    Features missingFeatures;
-    Features pendingFeatures;
-    Features inFlightFeatures;
+    // Kept as bitsets, as they are combined on every introspection step
+    FeatureMask supportedFeatures;
+    FeatureMask satisfiedFeatures;
+    FeatureMask requestedFeatures;
+    FeatureMask missingFeatures;
+    FeatureMask pendingFeatures;
+    FeatureMask inFlightFeatures;
+    // The instances given to becomeReady(), and the Features last handed out for each mask
+    FeatureInstances featureInstances;
+    FeatureInstances::Cache requestedCache;
+    FeatureInstances::Cache satisfiedCache;
+    FeatureInstances::Cache missingCache;
     QHash<Feature, QPair<QString, QString> > missingFeaturesErrors;
+    QHash<Feature, FeatureMask> depsCache;
     QList<PendingReady *> pendingOperations;
 
     bool pendingStatusChange;
     uint pendingStatus;
+
+    // Set while iterateIntrospection() runs, so that features completing
+    // synchronously are picked up without another main loop round trip
+    bool iterationQueued;
+    bool iterating;
+    bool iterateAgain;
+
+    QHash<Feature, QElapsedTimer> introspectionTimers;
+    QHash<Feature, qint64> introspectionTimes;
 };
 
 ReadinessHelper::Private::Private(
@@ -143,7 +166,10 @@ ReadinessHelper::Private::Private(
       currentStatus(currentStatus),
       introspectables(introspectables),
       pendingStatusChange(false),
-      pendingStatus(-1)
+      pendingStatus(-1),
+      iterationQueued(false),
+      iterating(false),
+      iterateAgain(false)
 {
     for (Introspectables::const_iterator i = introspectables.constBegin();
             i != introspectables.constEnd(); ++i) {
@@ -151,7 +177,7 @@ ReadinessHelper::Private::Private(
         Introspectable introspectable = i.value();
         Q_ASSERT(introspectable.mPriv->introspectFunc != 0);
         supportedStatuses += introspectable.mPriv->makesSenseForStatuses;
-        supportedFeatures += feature;
+        supportedFeatures.insert(feature);
     }
 }
 
@@ -166,7 +192,10 @@ ReadinessHelper::Private::Private(
       currentStatus(currentStatus),
       introspectables(introspectables),
       pendingStatusChange(false),
-      pendingStatus(-1)
+      pendingStatus(-1),
+      iterationQueued(false),
+      iterating(false),
+      iterateAgain(false)
 {
     Q_ASSERT(proxy != 0);
 
@@ -176,7 +205,7 @@ ReadinessHelper::Private::Private(
         Introspectable introspectable = i.value();
         Q_ASSERT(introspectable.mPriv->introspectFunc != 0);
         supportedStatuses += introspectable.mPriv->makesSenseForStatuses;
-        supportedFeatures += feature;
+        supportedFeatures.insert(feature);
     }
 }
 
@@ -205,7 +234,7 @@ void ReadinessHelper::Private::setCurrentStatus(uint newStatus)
         // in the requested set, so we don't have to re-add them here
 
         if (supportedStatuses.contains(currentStatus)) {
-            QTimer::singleShot(0, parent, SLOT(iterateIntrospection()));
+            scheduleIteration();
         } else {
             emit parent->statusReady(currentStatus);
         }
@@ -226,6 +255,7 @@ void ReadinessHelper::Private::setIntrospectCompleted(const Feature &feature,
             "a pending status change - ignoring";
 
         inFlightFeatures.remove(feature);
+        introspectionTimers.remove(feature);
 
         // ignore all introspection completed as the state changed
         if (!inFlightFeatures.isEmpty()) {
@@ -239,6 +269,13 @@ void ReadinessHelper::Private::setIntrospectCompleted(const Feature &feature,
     Q_ASSERT(pendingFeatures.contains(feature));
     Q_ASSERT(inFlightFeatures.contains(feature));
 
+    if (introspectionTimers.contains(feature)) {
+        qint64 elapsed = introspectionTimers.take(feature).elapsed();
+        introspectionTimes.insert(feature, elapsed);
+        debug() << "ReadinessHelper: introspection of feature" << feature <<
+            "took" << elapsed << "ms";
+    }
+
     if (success) {
         satisfiedFeatures.insert(feature);
     }
@@ -255,10 +292,42 @@ void ReadinessHelper::Private::setIntrospectCompleted(const Feature &feature,
     pendingFeatures.remove(feature);
     inFlightFeatures.remove(feature);
 
-    QTimer::singleShot(0, parent, SLOT(iterateIntrospection()));
+    scheduleIteration();
+}
+
+void ReadinessHelper::Private::scheduleIteration()
+{
+    if (iterating) {
+        iterateAgain = true;
+        return;
+    }
+
+    if (!iterationQueued) {
+        iterationQueued = true;
+        QTimer::singleShot(0, parent, SLOT(iterateIntrospection()));
+    }
 }
 
 void ReadinessHelper::Private::iterateIntrospection()
+{
+    // Walk the dependency graph until no more progress can be made without
+    // waiting for an introspection call, so that features which are completed
+    // synchronously (no-ops, missing interfaces, cached data) immediately
+    // unblock their dependents instead of costing a main loop iteration each
+    QPointer<ReadinessHelper> guard(parent);
+    iterating = true;
+    do {
+        iterateAgain = false;
+        iterateIntrospectionOnce();
+        if (!guard) {
+            // deleted by a statusReady() handler or an introspection function
+            return;
+        }
+    } while (iterateAgain);
+    iterating = false;
+}
+
+void ReadinessHelper::Private::iterateIntrospectionOnce()
 {
     if (proxy && !proxy->isValid()) {
         debug() << "ReadinessHelper: not iterating as the proxy is invalidated";
@@ -282,8 +351,8 @@ void ReadinessHelper::Private::iterateIntrospection()
 
     // Flag the currently pending reverse dependencies of any previously discovered missing features
     // as missing
-    foreach (const Feature &feature, pendingFeatures) {
-        if (!depsFor(feature).intersect(missingFeatures).isEmpty()) {
+    foreach (const Feature &feature, featureInstances.toFeatures(pendingFeatures)) {
+        if (depsFor(feature).intersects(missingFeatures)) {
             missingFeatures.insert(feature);
             missingFeaturesErrors.insert(feature,
                     QPair<QString, QString>(TP_QT_ERROR_NOT_AVAILABLE,
@@ -291,7 +360,7 @@ void ReadinessHelper::Private::iterateIntrospection()
         }
     }
 
-    const Features completedFeatures = satisfiedFeatures + missingFeatures;
+    const FeatureMask completedFeatures = satisfiedFeatures | missingFeatures;
 
     // check if any pending operations for becomeReady should finish now
     // based on their requested features having nothing more than what
@@ -299,7 +368,7 @@ void ReadinessHelper::Private::iterateIntrospection()
     QString errorName;
     QString errorMessage;
     foreach (PendingReady *operation, pendingOperations) {
-        if ((operation->requestedFeatures() - completedFeatures).isEmpty()) {
+        if (completedFeatures.contains(FeatureMask(operation->requestedFeatures()))) {
             if (parent->isReady(operation->requestedFeatures(), &errorName, &errorMessage)) {
                 operation->setFinished();
             } else {
@@ -314,7 +383,7 @@ void ReadinessHelper::Private::iterateIntrospection()
         }
     }
 
-    if ((requestedFeatures - completedFeatures).isEmpty()) {
+    if (completedFeatures.contains(requestedFeatures)) {
         // Otherwise, we'd emit statusReady with currentStatus although we are supposed to be
         // introspecting the pendingStatus and only when that is complete, emit statusReady
         Q_ASSERT(!pendingStatusChange);
@@ -330,9 +399,9 @@ void ReadinessHelper::Private::iterateIntrospection()
 
     // find out which features don't have dependencies that are still pending
     Features readyToIntrospect;
-    foreach (const Feature &feature, pendingFeatures) {
+    foreach (const Feature &feature, featureInstances.toFeatures(pendingFeatures)) {
         // missing doesn't have to be considered here anymore
-        if ((introspectables[feature].mPriv->dependsOnFeatures - satisfiedFeatures).isEmpty()) {
+        if (satisfiedFeatures.contains(introspectables[feature].mPriv->dependsOnMask)) {
             readyToIntrospect.insert(feature);
         }
     }
@@ -352,7 +421,7 @@ void ReadinessHelper::Private::iterateIntrospection()
             // No-op satisfy features for which nothing has to be done in
             // the current state
             setIntrospectCompleted(feature, true);
-            return; // will be called with a single-shot soon again
+            return; // will iterate again right away
         }
 
         foreach (const QString &interface, introspectable.mPriv->dependsOnInterfaces) {
@@ -365,26 +434,33 @@ void ReadinessHelper::Private::iterateIntrospection()
                 setIntrospectCompleted(feature, false,
                         TP_QT_ERROR_NOT_AVAILABLE,
                         QLatin1String("Feature depend on interfaces that are not available"));
-                return; // will be called with a single-shot soon again
+                return; // will iterate again right away
             }
         }
 
         // yes, with the dependency info, we can even parallelize
         // introspection of several features at once, reducing total round trip
         // time considerably with many independent features!
+        introspectionTimers[feature].start();
         (*(introspectable.mPriv->introspectFunc))(introspectable.mPriv->introspectFuncData);
     }
 }
 
-Features ReadinessHelper::Private::depsFor(const Feature &feature)
+FeatureMask ReadinessHelper::Private::depsFor(const Feature &feature)
 {
-    Features deps;
+    QHash<Feature, FeatureMask>::const_iterator i = depsCache.constFind(feature);
+    if (i != depsCache.constEnd()) {
+        return *i;
+    }
+
+    FeatureMask deps;
 
     foreach (Feature dep, introspectables[feature].mPriv->dependsOnFeatures) {
-        deps += dep;
-        deps += depsFor(dep);
+        deps.insert(dep);
+        deps |= depsFor(dep);
     }
 
+    depsCache.insert(feature, deps);
     return deps;
 }
 
@@ -453,12 +529,13 @@ void ReadinessHelper::addIntrospectables(const Introspectables &introspectables)
             Introspectable introspectable = i.value();
             mPriv->introspectables.insert(feature, introspectable);
             mPriv->supportedStatuses += introspectable.mPriv->makesSenseForStatuses;
-            mPriv->supportedFeatures += feature;
+            mPriv->supportedFeatures.insert(feature);
         }
     }
+    mPriv->depsCache.clear();
 
     debug() << "ReadinessHelper: new supportedStatuses =" << mPriv->supportedStatuses;
-    debug() << "ReadinessHelper: new supportedFeatures =" << mPriv->supportedFeatures;
+    debug() << "ReadinessHelper: new supportedFeatures =" << mPriv->supportedFeatures.toFeatures();
 }
 
 uint ReadinessHelper::currentStatus() const
@@ -499,18 +576,23 @@ void ReadinessHelper::setInterfaces(const QStringList &interfaces)
 }
 
 Features ReadinessHelper::requestedFeatures() const
+{
+    return mPriv->featureInstances.toFeatures(mPriv->requestedFeatures, &mPriv->requestedCache);
+}
+
+const FeatureMask &ReadinessHelper::requestedFeatureMask() const
 {
     return mPriv->requestedFeatures;
 }
 
 Features ReadinessHelper::actualFeatures() const
 {
-    return mPriv->satisfiedFeatures;
+    return mPriv->featureInstances.toFeatures(mPriv->satisfiedFeatures, &mPriv->satisfiedCache);
 }
 
 Features ReadinessHelper::missingFeatures() const
 {
-    return mPriv->missingFeatures;
+    return mPriv->featureInstances.toFeatures(mPriv->missingFeatures, &mPriv->missingCache);
 }
 
 bool ReadinessHelper::isReady(const Feature &feature,
@@ -576,6 +658,12 @@ bool ReadinessHelper::isReady(const Features &features, QString *errorName, QStr
 
     Q_ASSERT(!features.isEmpty());
 
+    // Satisfied features are ready whether they are critical or not
+    FeatureMask mask(features);
+    if (mPriv->satisfiedFeatures.contains(mask) && mPriv->supportedFeatures.contains(mask)) {
+        return true;
+    }
+
     foreach (const Feature &feature, features) {
         if (!isReady(feature, errorName, errorMessage)) {
             return false;
@@ -604,10 +692,10 @@ PendingReady *ReadinessHelper::becomeReady(const Features &requestedFeatures)
         }
     }
 
-    Features supportedFeatures = mPriv->supportedFeatures;
-    if (supportedFeatures.intersect(requestedFeatures) != requestedFeatures) {
+    FeatureMask requestedMask(requestedFeatures);
+    if (!mPriv->supportedFeatures.contains(requestedMask)) {
         warning() << "ReadinessHelper::becomeReady called with invalid features: requestedFeatures =" <<
-            requestedFeatures << "- supportedFeatures =" << mPriv->supportedFeatures;
+            requestedFeatures << "- supportedFeatures =" << mPriv->supportedFeatures.toFeatures();
         PendingReady *operation = new PendingReady(SharedPtr<RefCounted>(mPriv->object),
                 requestedFeatures);
         operation->setFinishedWithError(
@@ -632,20 +720,21 @@ PendingReady *ReadinessHelper::becomeReady(const Features &requestedFeatures)
     }
 
     // Insert the dependencies of the requested features too
-    Features requestedWithDeps = requestedFeatures;
+    FeatureMask requestedWithDeps = requestedMask;
     foreach (const Feature &feature, requestedFeatures) {
-        requestedWithDeps.unite(mPriv->depsFor(feature));
+        requestedWithDeps |= mPriv->depsFor(feature);
     }
 
-    mPriv->requestedFeatures += requestedWithDeps;
-    mPriv->pendingFeatures += requestedWithDeps; // will be updated in iterateIntrospection
+    mPriv->featureInstances.insert(requestedFeatures);
+    mPriv->requestedFeatures |= requestedWithDeps;
+    mPriv->pendingFeatures |= requestedWithDeps; // will be updated in iterateIntrospection
 
     operation = new PendingReady(SharedPtr<RefCounted>(mPriv->object), requestedFeatures);
     mPriv->pendingOperations.append(operation);
     // Only we finish these PendingReadys, so we don't need destroyed or finished handling for them
     // - we already know when that happens, as we caused it!
 
-    QTimer::singleShot(0, this, SLOT(iterateIntrospection()));
+    mPriv->scheduleIteration();
 
     return operation;
 }
@@ -666,8 +755,27 @@ void ReadinessHelper::setIntrospectCompleted(const Feature &feature, bool succes
     setIntrospectCompleted(feature, success, error.name(), error.message());
 }
 
+/**
+ * Return how long the last introspection of \a feature took, from the
+ * moment its introspection function was invoked until setIntrospectCompleted()
+ * was called for it.
+ *
+ * Features whose dependencies were being introspected meanwhile are not
+ * charged for that waiting time, so this can be used to find out which
+ * introspection steps dominate the time it takes for an object to become ready.
+ *
+ * \param feature The feature to query.
+ * \return The time in milliseconds, or -1 if \a feature has not been
+ *         introspected, or its introspection needed no work.
+ */
+qint64 ReadinessHelper::introspectionTime(const Feature &feature) const
+{
+    return mPriv->introspectionTimes.value(feature, -1);
+}
+
 void ReadinessHelper::iterateIntrospection()
 {
+    mPriv->iterationQueued = false;
     mPriv->iterateIntrospection();
 }
 
@@ -41,6 +41,7 @@ namespace Tp
 {
 
 class DBusProxy;
+class FeatureMask;
 class PendingOperation;
 class PendingReady;
 class RefCounted;
@@ -96,6 +97,7 @@ public:
     void setInterfaces(const QStringList &interfaces);
 
     Features requestedFeatures() const;
+    TP_QT_NO_EXPORT const FeatureMask &requestedFeatureMask() const;
     Features actualFeatures() const;
     Features missingFeatures() const;
 
@@ -105,6 +107,8 @@ public:
             QString *errorName = 0, QString *errorMessage = 0) const;
     PendingReady *becomeReady(const Features &requestedFeatures);
 
+    qint64 introspectionTime(const Feature &feature) const;
+
     void setIntrospectCompleted(const Feature &feature, bool success,
             const QString &errorName = QString(),
             const QString &errorMessage = QString());
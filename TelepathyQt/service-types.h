@@ -52,6 +52,7 @@ class BaseConnectionAvatarsInterface;
 class BaseConnectionClientTypesInterface;
 class BaseConnectionContactCapabilitiesInterface;
 class BaseConnectionManager;
+class BaseHandleRepository;
 class BaseProtocol;
 class BaseProtocolAddressingInterface;
 class BaseProtocolAvatarsInterface;
@@ -99,6 +100,7 @@ typedef SharedPtr<BaseConnectionAvatarsInterface> BaseConnectionAvatarsInterface
 typedef SharedPtr<BaseConnectionClientTypesInterface> BaseConnectionClientTypesInterfacePtr;
 typedef SharedPtr<BaseConnectionContactCapabilitiesInterface> BaseConnectionContactCapabilitiesInterfacePtr;
 typedef SharedPtr<BaseConnectionManager> BaseConnectionManagerPtr;
+typedef SharedPtr<BaseHandleRepository> BaseHandleRepositoryPtr;
 typedef SharedPtr<BaseProtocol> BaseProtocolPtr;
 typedef SharedPtr<BaseProtocolAddressingInterface> BaseProtocolAddressingInterfacePtr;
 typedef SharedPtr<BaseProtocolAvatarsInterface> BaseProtocolAvatarsInterfacePtr;
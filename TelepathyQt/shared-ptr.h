@@ -32,6 +32,10 @@
 #include <QHash>
 #include <QObject>
 
+#include <cstddef>
+#include <new>
+#include <utility>
+
 namespace Tp
 {
 
@@ -58,13 +62,84 @@ class TP_QT_EXPORT RefCounted
         template <class T> friend class WeakPtr;
         friend class RefCounted;
 
+        // Counts allocated together with their object by SharedPtr<T>::create() carry this bit
+        // in weakref. A separate flag would change the size of the count that the RefCounted
+        // constructor, inlined in existing binaries, allocates.
+        enum { AllocatedWithObject = 0x40000000 };
+
+        inline bool isAllocatedWithObject() const
+        {
+            return (weakref.loadAcquire() & AllocatedWithObject) != 0;
+        }
+
+        // Drop a weak reference, returning true if it was the last one
+        static inline bool weakDeref(SharedCount *sc)
+        {
+            return ((sc->weakref.fetchAndAddOrdered(-1) - 1) & ~AllocatedWithObject) == 0;
+        }
+
+        static inline void release(SharedCount *sc)
+        {
+            if (sc->isAllocatedWithObject()) {
+                // SharedPtr<T>::create() put the count at the start of the object's memory block
+                sc->~SharedCount();
+                ::operator delete(static_cast<void*>(sc));
+            } else {
+                delete sc;
+            }
+        }
+
         RefCounted *d;
         mutable QAtomicInt strongref;
         mutable QAtomicInt weakref;
     };
 
+    // Set by SharedPtr<T>::create() while constructing the object, so that the RefCounted
+    // constructor uses the count allocated together with the object instead of a new one
+    struct PendingSharedCount
+    {
+        inline PendingSharedCount(SharedCount *sc, const void *storage, size_t size)
+            : sc(sc),
+              begin(static_cast<const char*>(storage)),
+              end(static_cast<const char*>(storage) + size),
+              claimed(false),
+              previous(current())
+        {
+            current() = this;
+        }
+
+        inline ~PendingSharedCount()
+        {
+            current() = previous;
+        }
+
+        static inline PendingSharedCount *&current()
+        {
+            static thread_local PendingSharedCount *pending = 0;
+            return pending;
+        }
+
+        SharedCount *sc;
+        const char *begin;
+        const char *end;
+        bool claimed;
+        PendingSharedCount *previous;
+    };
+
+    static inline SharedCount *claimSharedCount(RefCounted *self)
+    {
+        PendingSharedCount *pending = PendingSharedCount::current();
+        const char *p = reinterpret_cast<const char*>(self);
+        if (pending && !pending->claimed && p >= pending->begin && p < pending->end) {
+            pending->claimed = true;
+            pending->sc->d = self;
+            return pending->sc;
+        }
+        return new SharedCount(self);
+    }
+
 public:
-    inline RefCounted() : sc(new SharedCount(this))
+    inline RefCounted() : sc(claimSharedCount(this))
     {
         sc->weakref.ref();
     }
@@ -72,8 +147,8 @@ public:
     inline virtual ~RefCounted()
     {
         sc->d = 0;
-        if (!sc->weakref.deref()) {
-            delete sc;
+        if (SharedCount::weakDeref(sc)) {
+            SharedCount::release(sc);
         }
     }
 
@@ -103,31 +178,29 @@ public:
     template <typename Subclass>
         inline SharedPtr(const SharedPtr<Subclass> &o) : d(o.data()) { if (d) { d->ref(); } }
     inline SharedPtr(const SharedPtr<T> &o) : d(o.d) { if (d) { d->ref(); } }
-    explicit inline SharedPtr(const WeakPtr<T> &o)
+#ifdef Q_COMPILER_RVALUE_REFS
+    template <typename Subclass>
+        inline SharedPtr(SharedPtr<Subclass> &&o) : d(o.d) { o.d = 0; }
+    inline SharedPtr(SharedPtr<T> &&o) : d(o.d) { o.d = 0; }
+#endif
+    explicit inline SharedPtr(const WeakPtr<T> &o) : d(0)
     {
         RefCounted::SharedCount *sc = o.sc;
         if (sc) {
             // increase the strongref, but never up from zero
             // or less (negative is used on untracked objects)
-            register int tmp = sc->strongref.fetchAndAddOrdered(0);
+            int tmp = sc->strongref.loadAcquire();
             while (tmp > 0) {
-                // try to increment from "tmp" to "tmp + 1"
-                if (sc->strongref.testAndSetRelaxed(tmp, tmp + 1)) {
-                    // succeeded
+                // try to increment from "tmp" to "tmp + 1", a failed attempt updates "tmp" with
+                // the current value
+                if (sc->strongref.testAndSetOrdered(tmp, tmp + 1, tmp)) {
+                    // succeeded, and as a WeakPtr<T> is only ever created from a T, there is no
+                    // need to check the type of the object
+                    d = static_cast<T*>(sc->d);
+                    Q_ASSERT(d != NULL);
                     break;
                 }
-                // failed, try again
-                tmp = sc->strongref.fetchAndAddOrdered(0);
-            }
-
-            if (tmp > 0) {
-                d = dynamic_cast<T*>(sc->d);
-                Q_ASSERT(d != NULL);
-            } else {
-                d = 0;
             }
-        } else {
-            d = 0;
         }
     }
 
@@ -136,7 +209,20 @@ public:
         if (d && !d->deref()) {
             T *saved = d;
             d = 0;
-            delete saved;
+            const RefCounted *rc = saved;
+            RefCounted::SharedCount *sc = rc->sc;
+            if (sc->isAllocatedWithObject()) {
+                // The memory is freed together with the count, when the last WeakPtr is gone.
+                // ~RefCounted() runs before the destructors of the bases listed before it, such
+                // as QObject, so hold a weak reference until the whole object is destroyed.
+                sc->weakref.ref();
+                rc->~RefCounted();
+                if (RefCounted::SharedCount::weakDeref(sc)) {
+                    RefCounted::SharedCount::release(sc);
+                }
+            } else {
+                delete saved;
+            }
         }
     }
 
@@ -165,6 +251,14 @@ public:
         return *this;
     }
 
+#ifdef Q_COMPILER_RVALUE_REFS
+    inline SharedPtr<T> &operator=(SharedPtr<T> &&o)
+    {
+        SharedPtr<T>(std::move(o)).swap(*this);
+        return *this;
+    }
+#endif
+
     inline void swap(SharedPtr<T> &o)
     {
         T *tmp = d;
@@ -196,7 +290,44 @@ public:
         return SharedPtr<T>(qobject_cast<T*>(src.data()));
     }
 
+#if defined(Q_COMPILER_RVALUE_REFS) && defined(Q_COMPILER_VARIADIC_TEMPLATES)
+    template <typename... Args>
+    static inline SharedPtr<T> create(Args &&... args)
+    {
+        typedef RefCounted::SharedCount SharedCount;
+        Q_STATIC_ASSERT(Q_ALIGNOF(T) <= Q_ALIGNOF(std::max_align_t));
+
+        // allocate the count and the object in a single block, the count first
+        const size_t offset = (sizeof(SharedCount) + Q_ALIGNOF(T) - 1) &
+            ~size_t(Q_ALIGNOF(T) - 1);
+        void *block = ::operator new(offset + sizeof(T));
+        SharedCount *sc = new (block) SharedCount(0);
+        // the weak reference taken here keeps the block alive until the construction is over,
+        // even if it throws after the RefCounted base was constructed and destroyed again
+        sc->weakref.storeRelease(SharedCount::AllocatedWithObject + 1);
+        void *storage = static_cast<char*>(block) + offset;
+
+        T *obj;
+        {
+            RefCounted::PendingSharedCount pending(sc, storage, sizeof(T));
+            QT_TRY {
+                obj = new (storage) T(std::forward<Args>(args)...);
+            } QT_CATCH(...) {
+                if (SharedCount::weakDeref(sc)) {
+                    SharedCount::release(sc);
+                }
+                QT_RETHROW;
+            }
+            Q_ASSERT(pending.claimed);
+        }
+        SharedCount::weakDeref(sc);
+
+        return SharedPtr<T>(obj);
+    }
+#endif
+
 private:
+    template <class X> friend class SharedPtr;
     friend class WeakPtr<T>;
 
     T *d;
@@ -227,6 +358,9 @@ public:
         }
     }
     inline WeakPtr(const WeakPtr<T> &o) : sc(o.sc) { if (sc) { sc->weakref.ref(); } }
+#ifdef Q_COMPILER_RVALUE_REFS
+    inline WeakPtr(WeakPtr<T> &&o) : sc(o.sc) { o.sc = 0; }
+#endif
     inline WeakPtr(const SharedPtr<T> &o)
     {
         if (o.d) {
@@ -238,12 +372,12 @@ public:
     }
     inline ~WeakPtr()
     {
-        if (sc && !sc->weakref.deref()) {
-            delete sc;
+        if (sc && RefCounted::SharedCount::weakDeref(sc)) {
+            RefCounted::SharedCount::release(sc);
         }
     }
 
-    inline bool isNull() const { return !sc || sc->strongref.fetchAndAddOrdered(0) <= 0; }
+    inline bool isNull() const { return !sc || sc->strongref.loadAcquire() <= 0; }
     inline bool operator!() const { return isNull(); }
     operator UnspecifiedBoolType() const { return !isNull() ? &WeakPtr<T>::operator! : 0; }
 
@@ -259,6 +393,14 @@ public:
         return *this;
     }
 
+#ifdef Q_COMPILER_RVALUE_REFS
+    inline WeakPtr<T> &operator=(WeakPtr<T> &&o)
+    {
+        WeakPtr<T>(std::move(o)).swap(*this);
+        return *this;
+    }
+#endif
+
     inline void swap(WeakPtr<T> &o)
     {
         RefCounted::SharedCount *tmp = sc;
@@ -278,7 +420,7 @@ private:
 template<typename T>
 inline uint qHash(const WeakPtr<T> &ptr)
 {
-    T *actualPtr = ptr.sc ? ptr.sc.d : 0;
+    T *actualPtr = ptr.sc ? static_cast<T*>(ptr.sc->d) : 0;
     return QT_PREPEND_NAMESPACE(qHash<T>(actualPtr));
 }
 
@@ -29,6 +29,8 @@
 #include <TelepathyQt/ClientRegistrar>
 #include <TelepathyQt/Types>
 
+#include "TelepathyQt/channel-class-matcher-internal.h"
+
 namespace Tp
 {
 
@@ -153,6 +155,11 @@ public:
     void registerExtraChannelFeatures(const QList<ChannelClassFeatures> &features)
     {
         mExtraChannelFeatures.unite(features.toSet());
+
+        mExtraChannelFeaturesMatcher.clear();
+        foreach (const ChannelClassFeatures &spec, mExtraChannelFeatures) {
+            mExtraChannelFeaturesMatcher.append(spec.first, spec.second);
+        }
     }
 
     QSet<AccountPtr> accounts() const { return mAccounts; }
@@ -184,12 +191,13 @@ private Q_SLOTS:
     void onChannelsReady(Tp::PendingOperation *op);
 
 private:
-    Features featuresFor(const ChannelClassSpec &channelClass) const;
+    Features featuresFor(const QVariantMap &immutableProperties) const;
 
     WeakPtr<ClientRegistrar> mCr;
     SharedPtr<FakeAccountFactory> mFakeAccountFactory;
     QString mObserverName;
     QSet<ChannelClassFeatures> mExtraChannelFeatures;
+    ChannelClassMatcher<Features> mExtraChannelFeaturesMatcher;
     QSet<AccountPtr> mAccounts;
     QHash<ChannelPtr, ChannelWrapper*> mChannels;
     QHash<ChannelPtr, ChannelWrapper*> mIncompleteChannels;
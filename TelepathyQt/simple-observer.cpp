@@ -241,7 +241,7 @@ void SimpleObserver::Private::Observer::observeChannels(
 
         SimpleObserver::Private::ChannelWrapper *wrapper =
             new SimpleObserver::Private::ChannelWrapper(account, channel,
-                featuresFor(ChannelClassSpec(channel->immutableProperties())), this);
+                featuresFor(channel->immutableProperties()), this);
         mIncompleteChannels.insert(channel, wrapper);
         connect(wrapper,
                 SIGNAL(channelInvalidated(Tp::AccountPtr,Tp::ChannelPtr,QString,QString)),
@@ -304,14 +304,13 @@ void SimpleObserver::Private::Observer::onChannelsReady(PendingOperation *op)
 }
 
 Features SimpleObserver::Private::Observer::featuresFor(
-        const ChannelClassSpec &channelClass) const
+        const QVariantMap &immutableProperties) const
 {
     Features features;
 
-    foreach (const ChannelClassFeatures &spec, mExtraChannelFeatures) {
-        if (spec.first.isSubsetOf(channelClass)) {
-            features.unite(spec.second);
-        }
+    foreach (const Features &matching,
+            mExtraChannelFeaturesMatcher.valuesForChannel(immutableProperties)) {
+        features.unite(matching);
     }
 
     return features;
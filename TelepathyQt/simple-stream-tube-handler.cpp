@@ -94,7 +94,8 @@ SimpleStreamTubeHandler::SimpleStreamTubeHandler(
 SimpleStreamTubeHandler::~SimpleStreamTubeHandler()
 {
     if (!mTubes.empty()) {
-        debug() << "~SSTubeHandler(): Closing" << mTubes.size() << "leftover tubes";
+        tpDebug(DebugCategoryTubes) << "~SSTubeHandler(): Closing" << mTubes.size() <<
+            "leftover tubes";
 
         foreach (const StreamTubeChannelPtr &tube, mTubes.keys()) {
             tube->requestClose();
@@ -111,7 +112,7 @@ void SimpleStreamTubeHandler::handleChannels(
         const QDateTime &userActionTime,
         const HandlerInfo &handlerInfo)
 {
-    debug() << "SimpleStreamTubeHandler::handleChannels() invoked for " <<
+    tpDebug(DebugCategoryTubes) << "SimpleStreamTubeHandler::handleChannels() invoked for " <<
         channels.size() << "channels on account" << account->objectPath();
 
     SharedPtr<InvocationData> invocation(new InvocationData());
@@ -127,7 +128,8 @@ void SimpleStreamTubeHandler::handleChannels(
                 chan->immutableProperties()[TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType")].toString();
 
             if (channelType != TP_QT_IFACE_CHANNEL_TYPE_STREAM_TUBE) {
-                debug() << "We got a non-StreamTube channel" << chan->objectPath() <<
+                tpDebug(DebugCategoryTubes) << "We got a non-StreamTube channel" <<
+                    chan->objectPath() <<
                     "of type" << channelType << ", ignoring";
             } else {
                 warning() << "The channel factory used for a simple StreamTube handler must" <<
@@ -202,12 +204,14 @@ void SimpleStreamTubeHandler::onReadyOpFinished(Tp::PendingOperation *op)
             continue;
         }
 
-        debug() << "Emitting SSTubeHandler::invokedForTube for" << invocation->tubes.size()
+        tpDebug(DebugCategoryTubes) << "Emitting SSTubeHandler::invokedForTube for" <<
+            invocation->tubes.size()
             << "tubes";
 
         foreach (const StreamTubeChannelPtr &tube, invocation->tubes) {
             if (!tube->isValid()) {
-                debug() << "Skipping already invalidated tube" << tube->objectPath();
+                tpDebug(DebugCategoryTubes) << "Skipping already invalidated tube" <<
+                    tube->objectPath();
                 continue;
             }
 
@@ -238,7 +242,8 @@ void SimpleStreamTubeHandler::onTubeInvalidated(DBusProxy *proxy,
     Q_ASSERT(!tube.isNull());
     Q_ASSERT(mTubes.contains(tube));
 
-    debug() << "Tube" << tube->objectPath() << "invalidated - " << errorName << ':' << errorMessage;
+    tpDebug(DebugCategoryTubes) << "Tube" << tube->objectPath() << "invalidated - " << errorName <<
+        ':' << errorMessage;
 
     AccountPtr acc = mTubes.value(tube);
     mTubes.remove(tube);
@@ -101,7 +101,7 @@ void StreamTubeChannel::Private::introspectStreamTube(
 {
     StreamTubeChannel *parent = self->parent;
 
-    debug() << "Introspecting stream tube properties";
+    tpDebug(DebugCategoryTubes) << "Introspecting stream tube properties";
     Client::ChannelTypeStreamTubeInterface *streamTubeInterface =
             parent->interface<Client::ChannelTypeStreamTubeInterface>();
 
@@ -673,7 +673,7 @@ void StreamTubeChannel::gotStreamTubeProperties(PendingOperation *op)
 
         mPriv->extractStreamTubeProperties(pvm->result());
 
-        debug() << "Got reply to Properties::GetAll(StreamTubeChannel)";
+        tpDebug(DebugCategoryTubes) << "Got reply to Properties::GetAll(StreamTubeChannel)";
         mPriv->readinessHelper->setIntrospectCompleted(StreamTubeChannel::FeatureCore, true);
     }
     else {
@@ -693,7 +693,8 @@ void StreamTubeChannel::onConnectionClosed(uint connId, const QString &error,
 void StreamTubeChannel::dropConnections()
 {
     if (!mPriv->connections.isEmpty()) {
-        debug() << "StreamTubeChannel invalidated with" << mPriv->connections.size()
+        tpDebug(DebugCategoryTubes) << "StreamTubeChannel invalidated with" <<
+            mPriv->connections.size()
             << "connections remaining, synthesizing close events";
         mPriv->droppingConnections = true;
         foreach (uint connId, mPriv->connections) {
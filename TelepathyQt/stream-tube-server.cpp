@@ -317,7 +317,7 @@ struct StreamTubeServer::Private
             return;
         }
 
-        debug() << "Register StreamTubeServer with name " << clientName;
+        tpDebug(DebugCategoryTubes) << "Register StreamTubeServer with name " << clientName;
 
         if (registrar->registerClient(handler, clientName)) {
             isRegistered = true;
@@ -943,7 +943,8 @@ void StreamTubeServer::onInvokedForTube(
     }
 
     if (!mPriv->tubes.contains(tube)) {
-        debug().nospace() << "Offering socket " << mPriv->exportedAddr << ":" << mPriv->exportedPort
+        tpDebug(DebugCategoryTubes).nospace() << "Offering socket " << mPriv->exportedAddr << ":" <<
+            mPriv->exportedPort
             << " on tube " << tube->objectPath();
 
         QVariantMap params;
@@ -995,7 +996,7 @@ void StreamTubeServer::onOfferFinished(
         mPriv->tubes.remove(wrapper->mTube);
         wrapper->deleteLater();
     } else {
-        debug() << "Tube" << tube->objectPath() << "offered successfully";
+        tpDebug(DebugCategoryTubes) << "Tube" << tube->objectPath() << "offered successfully";
     }
 }
 
@@ -1013,7 +1014,8 @@ void StreamTubeServer::onTubeInvalidated(
         return;
     }
 
-    debug() << "Tube" << tube->objectPath() << "invalidated with" << error << ':' << message;
+    tpDebug(DebugCategoryTubes) << "Tube" << tube->objectPath() << "invalidated with" << error <<
+        ':' << message;
 
     emit tubeClosed(wrapper->mAcc, wrapper->mTube, error, message);
     mPriv->tubes.remove(tube);
@@ -25,6 +25,7 @@
 #include "TelepathyQt/_gen/text-channel.moc.hpp"
 
 #include "TelepathyQt/debug-internal.h"
+#include "TelepathyQt/feature-internal.h"
 
 #include <TelepathyQt/Connection>
 #include <TelepathyQt/ConnectionLowlevel>
@@ -37,6 +38,9 @@
 #include <TelepathyQt/ReferencedHandles>
 
 #include <QDateTime>
+#include <QTimer>
+
+#include <algorithm>
 
 namespace Tp
 {
@@ -56,6 +60,8 @@ struct TP_QT_NO_EXPORT TextChannel::Private
 
     void processMessageQueue();
     void processChatStateQueue();
+    void trimMessageQueue();
+    void requestContacts(const HandleIdentifierMap &contacts);
 
     void contactLost(uint handle);
     void contactFound(ContactPtr contact);
@@ -91,12 +97,48 @@ struct TP_QT_NO_EXPORT TextChannel::Private
             : isMessage(false), message(), removed(removed)
         { }
 
+        bool waitsForSender() const
+        {
+            return isMessage && message.senderHandle() != 0 && !message.sender();
+        }
+
         bool isMessage;
         ReceivedMessage message;
         uint removed;
     };
-    QList<ReceivedMessage> messages;
+    void queueMessageEvent(MessageEvent *e);
+    bool isBlocked(const MessageEvent *e) const;
+    void deliverMessageEvent(MessageEvent *e);
+    void messageQueueProcessed();
+    // Received messages in arrival order, indexed by pending message ID
+    struct MessageQueue
+    {
+        MessageQueue()
+            : nextSerial(0), listValid(true)
+        { }
+
+        int size() const { return messages.size(); }
+        void append(const ReceivedMessage &message);
+        bool remove(const ReceivedMessage &message);
+        QList<ReceivedMessage> takeByPendingId(uint pendingId);
+        ReceivedMessage takeFirst();
+        QList<ReceivedMessage> toList() const;
+
+        quint64 nextSerial;
+        QMap<quint64, ReceivedMessage> messages;
+        QMultiHash<uint, quint64> serials;
+        // messageQueue() result, kept up to date on append
+        mutable QList<ReceivedMessage> list;
+        mutable bool listValid;
+    };
+    MessageQueue messages;
+    int maxMessageQueueSize;
+    MessageDeliveryMode deliveryMode;
     QList<MessageEvent *> incompleteMessages;
+    // Senders and pending message IDs of the events in incompleteMessages, which later events
+    // must wait behind in MessageDeliveryModePerSender
+    QSet<uint> blockedSenders;
+    QSet<uint> blockedIds;
     QHash<QDBusPendingCallWatcher *, UIntList> acknowledgeBatches;
 
     // FeatureChatState
@@ -114,6 +156,9 @@ struct TP_QT_NO_EXPORT TextChannel::Private
     QHash<ContactPtr, ChannelChatState> chatStates;
 
     QSet<uint> awaitingContacts;
+    // Contacts to be requested on the next main loop iteration
+    HandleIdentifierMap queuedContacts;
+    bool contactsRequestQueued;
 };
 
 TextChannel::Private::Private(TextChannel *parent)
@@ -125,7 +170,10 @@ TextChannel::Private::Private(TextChannel *parent)
       gotProperties(false),
       messagePartSupport(0),
       deliveryReportingSupport(0),
-      initialMessagesReceived(false)
+      initialMessagesReceived(false),
+      maxMessageQueueSize(0),
+      deliveryMode(MessageDeliveryModeInOrder),
+      contactsRequestQueued(false)
 {
     ReadinessHelper::Introspectables introspectables;
 
@@ -175,6 +223,74 @@ TextChannel::Private::~Private()
     }
 }
 
+void TextChannel::Private::MessageQueue::append(const ReceivedMessage &message)
+{
+    quint64 serial = nextSerial++;
+    messages.insert(serial, message);
+    serials.insert(message.pendingId(), serial);
+    if (listValid) {
+        list.append(message);
+    }
+}
+
+bool TextChannel::Private::MessageQueue::remove(const ReceivedMessage &message)
+{
+    QMultiHash<uint, quint64>::iterator i = serials.find(message.pendingId());
+    while (i != serials.end() && i.key() == message.pendingId()) {
+        QMap<quint64, ReceivedMessage>::iterator j = messages.find(i.value());
+        if (j != messages.end() && j.value() == message) {
+            messages.erase(j);
+            serials.erase(i);
+            listValid = false;
+            return true;
+        }
+        ++i;
+    }
+    return false;
+}
+
+QList<ReceivedMessage> TextChannel::Private::MessageQueue::takeByPendingId(uint pendingId)
+{
+    QList<quint64> removedSerials = serials.values(pendingId);
+    if (removedSerials.isEmpty()) {
+        return QList<ReceivedMessage>();
+    }
+
+    // IDs may be reused, report the messages in the order they were received
+    std::sort(removedSerials.begin(), removedSerials.end());
+    serials.remove(pendingId);
+    listValid = false;
+
+    QList<ReceivedMessage> removed;
+    foreach (quint64 serial, removedSerials) {
+        QMap<quint64, ReceivedMessage>::iterator i = messages.find(serial);
+        removed << i.value();
+        messages.erase(i);
+    }
+    return removed;
+}
+
+ReceivedMessage TextChannel::Private::MessageQueue::takeFirst()
+{
+    QMap<quint64, ReceivedMessage>::iterator first = messages.begin();
+    ReceivedMessage message = first.value();
+    serials.remove(message.pendingId(), first.key());
+    messages.erase(first);
+    if (listValid) {
+        list.removeFirst();
+    }
+    return message;
+}
+
+QList<ReceivedMessage> TextChannel::Private::MessageQueue::toList() const
+{
+    if (!listValid) {
+        list = messages.values();
+        listValid = true;
+    }
+    return list;
+}
+
 void TextChannel::Private::introspectMessageQueue(
         TextChannel::Private *self)
 {
@@ -290,8 +406,8 @@ void TextChannel::Private::enableChatStateNotifications(
 
 void TextChannel::Private::updateInitialMessages()
 {
-    if (!readinessHelper->requestedFeatures().contains(FeatureMessageQueue) ||
-        readinessHelper->isReady(Features() << FeatureMessageQueue)) {
+    if (!readinessHelper->requestedFeatureMask().contains(FeatureMessageQueue) ||
+        readinessHelper->isReady(FeatureMessageQueue)) {
         return;
     }
 
@@ -301,7 +417,7 @@ void TextChannel::Private::updateInitialMessages()
     MessagePartListList messages = qdbus_cast<MessagePartListList>(
             props[QLatin1String("PendingMessages")]);
     if (messages.isEmpty()) {
-        debug() << "Message queue empty: FeatureMessageQueue is now ready";
+        tpDebug(DebugCategoryChannels) << "Message queue empty: FeatureMessageQueue is now ready";
         readinessHelper->setIntrospectCompleted(FeatureMessageQueue, true);
     } else {
         foreach (const MessagePartList &message, messages) {
@@ -312,8 +428,8 @@ void TextChannel::Private::updateInitialMessages()
 
 void TextChannel::Private::updateCapabilities()
 {
-    if (!readinessHelper->requestedFeatures().contains(FeatureMessageCapabilities) ||
-        readinessHelper->isReady(Features() << FeatureMessageCapabilities)) {
+    if (!readinessHelper->requestedFeatureMask().contains(FeatureMessageCapabilities) ||
+        readinessHelper->isReady(FeatureMessageCapabilities)) {
         return;
     }
 
@@ -338,55 +454,123 @@ void TextChannel::Private::updateCapabilities()
     readinessHelper->setIntrospectCompleted(FeatureMessageCapabilities, true);
 }
 
+void TextChannel::Private::queueMessageEvent(MessageEvent *e)
+{
+    // Messages from senders we already know about don't need to wait for a contact request
+    if (e->waitsForSender()) {
+        ContactPtr sender = parent->connection()->contactManager()->lookupSatisfyingContact(
+                e->message.senderHandle());
+        if (sender) {
+            e->message.setSender(sender);
+        }
+    }
+
+    // Only events queued before this one can hold it back, and the ones they block are already
+    // known, so there is no need to go through the whole queue again
+    bool held = deliveryMode == MessageDeliveryModeInOrder ?
+        (!incompleteMessages.isEmpty() || e->waitsForSender()) : isBlocked(e);
+    if (!held) {
+        deliverMessageEvent(e);
+        messageQueueProcessed();
+        return;
+    }
+
+    incompleteMessages << e;
+    if (e->isMessage) {
+        if (e->message.senderHandle() != 0) {
+            blockedSenders.insert(e->message.senderHandle());
+        }
+        blockedIds.insert(e->message.pendingId());
+    }
+
+    if (e->waitsForSender() && !awaitingContacts.contains(e->message.senderHandle())) {
+        HandleIdentifierMap contactsRequired;
+        contactsRequired.insert(e->message.senderHandle(), e->message.senderId());
+        requestContacts(contactsRequired);
+    }
+}
+
+bool TextChannel::Private::isBlocked(const MessageEvent *e) const
+{
+    if (!e->isMessage) {
+        // a message with this ID is still waiting, so this removal
+        // event must not overtake it
+        return blockedIds.contains(e->removed);
+    }
+
+    // the message doesn't have a sender Contact, but needs one,
+    // or something it must be ordered after is still waiting
+    uint handle = e->message.senderHandle();
+    return e->waitsForSender() ||
+        (handle != 0 && blockedSenders.contains(handle)) ||
+        blockedIds.contains(e->message.pendingId());
+}
+
+void TextChannel::Private::deliverMessageEvent(MessageEvent *e)
+{
+    if (e->isMessage) {
+        tpDebug(DebugCategoryChannels) << "Message is usable, copying to main queue";
+        messages.append(e->message);
+        emit parent->messageReceived(e->message);
+        trimMessageQueue();
+    } else {
+        // forget about the message(s) with ID e->removed (there should be
+        // at most one under normal circumstances)
+        foreach (const ReceivedMessage &removedMessage,
+                messages.takeByPendingId(e->removed)) {
+            emit parent->pendingMessageRemoved(removedMessage);
+        }
+    }
+
+    tpDebug(DebugCategoryChannels) << "Dropping event";
+    delete e;
+}
+
 void TextChannel::Private::processMessageQueue()
 {
     // Proceed as far as we can with the processing of incoming messages
     // and message-removal events; message IDs aren't necessarily globally
     // unique, so we need to process them in the correct order relative
-    // to incoming messages
-    while (!incompleteMessages.isEmpty()) {
-        const MessageEvent *e = incompleteMessages.first();
-        debug() << "MessageEvent:" << reinterpret_cast<const void *>(e);
-
-        if (e->isMessage) {
-            if (e->message.senderHandle() != 0 &&
-                    !e->message.sender()) {
-                // the message doesn't have a sender Contact, but needs one.
-                // We'll have to stop processing here, and come back to it
-                // when we have more Contact objects
+    // to incoming messages.
+    //
+    // In MessageDeliveryModeInOrder, the first message still waiting for its
+    // sender blocks everything queued after it. In MessageDeliveryModePerSender,
+    // it only blocks later messages from the same sender and later events
+    // with the same pending message ID.
+    //
+    // New events go through queueMessageEvent(), so this only has to run when
+    // Contact objects for queued messages arrive, or the delivery mode changes.
+    blockedSenders.clear();
+    blockedIds.clear();
+    QList<MessageEvent *>::iterator i = incompleteMessages.begin();
+    while (i != incompleteMessages.end()) {
+        MessageEvent *e = *i;
+        tpDebug(DebugCategoryChannels) << "MessageEvent:" << reinterpret_cast<const void *>(e);
+
+        if (isBlocked(e)) {
+            // We'll have to leave it here, and come back to it when we
+            // have more Contact objects
+            if (deliveryMode == MessageDeliveryModeInOrder) {
                 break;
             }
-
-            // if we reach here, the message is ready
-            debug() << "Message is usable, copying to main queue";
-            messages << e->message;
-            emit parent->messageReceived(e->message);
-        } else {
-            // forget about the message(s) with ID e->removed (there should be
-            // at most one under normal circumstances)
-            int i = 0;
-            while (i < messages.size()) {
-                if (messages.at(i).pendingId() == e->removed) {
-                    ReceivedMessage removedMessage = messages.at(i);
-                    messages.removeAt(i);
-                    emit parent->pendingMessageRemoved(removedMessage);
-                } else {
-                    i++;
+            if (e->isMessage) {
+                if (e->message.senderHandle() != 0) {
+                    blockedSenders.insert(e->message.senderHandle());
                 }
+                blockedIds.insert(e->message.pendingId());
             }
+            ++i;
+            continue;
         }
 
-        debug() << "Dropping first event";
-        delete incompleteMessages.takeFirst();
+        // if we reach here, the event is ready
+        deliverMessageEvent(e);
+        i = incompleteMessages.erase(i);
     }
 
+    messageQueueProcessed();
+
     if (incompleteMessages.isEmpty()) {
-        if (readinessHelper->requestedFeatures().contains(FeatureMessageQueue) &&
-            !readinessHelper->isReady(Features() << FeatureMessageQueue)) {
-            debug() << "incompleteMessages empty for the first time: "
-                "FeatureMessageQueue is now ready";
-            readinessHelper->setIntrospectCompleted(FeatureMessageQueue, true);
-        }
         return;
     }
 
@@ -394,35 +578,30 @@ void TextChannel::Private::processMessageQueue()
     // for which we've already sent a request?
     HandleIdentifierMap contactsRequired;
     foreach (const MessageEvent *e, incompleteMessages) {
-        if (e->isMessage) {
-            uint handle = e->message.senderHandle();
-            if (handle != 0 && !e->message.sender()
-                    && !awaitingContacts.contains(handle)) {
-                contactsRequired.insert(handle, e->message.senderId());
-            }
+        if (e->waitsForSender() && !awaitingContacts.contains(e->message.senderHandle())) {
+            contactsRequired.insert(e->message.senderHandle(), e->message.senderId());
         }
     }
 
-    if (contactsRequired.isEmpty()) {
-        return;
-    }
-
-    ConnectionPtr conn = parent->connection();
-    conn->lowlevel()->injectContactIds(contactsRequired);
-
-    parent->connect(conn->contactManager()->contactsForHandles(
-                contactsRequired.keys()),
-            SIGNAL(finished(Tp::PendingOperation*)),
-            SLOT(onContactsFinished(Tp::PendingOperation*)));
+    requestContacts(contactsRequired);
+}
 
-    awaitingContacts |= contactsRequired.keys().toSet();
+void TextChannel::Private::messageQueueProcessed()
+{
+    if (incompleteMessages.isEmpty() &&
+            readinessHelper->requestedFeatureMask().contains(FeatureMessageQueue) &&
+            !readinessHelper->isReady(FeatureMessageQueue)) {
+        tpDebug(DebugCategoryChannels) << "incompleteMessages empty for the first time: "
+            "FeatureMessageQueue is now ready";
+        readinessHelper->setIntrospectCompleted(FeatureMessageQueue, true);
+    }
 }
 
 void TextChannel::Private::processChatStateQueue()
 {
     while (!chatStateQueue.isEmpty()) {
         const ChatStateEvent *e = chatStateQueue.first();
-        debug() << "ChatStateEvent:" << reinterpret_cast<const void *>(e);
+        tpDebug(DebugCategoryChannels) << "ChatStateEvent:" << reinterpret_cast<const void *>(e);
 
         if (e->contact.isNull()) {
             // the chat state Contact object wasn't retrieved yet, but needs
@@ -436,32 +615,56 @@ void TextChannel::Private::processChatStateQueue()
         // if we reach here, the Contact object is ready
         emit parent->chatStateChanged(e->contact, (ChannelChatState) e->state);
 
-        debug() << "Dropping first event";
+        tpDebug(DebugCategoryChannels) << "Dropping first event";
         delete chatStateQueue.takeFirst();
     }
 
     // What Contact objects do we need in order to proceed, ignoring those
     // for which we've already sent a request?
-    QSet<uint> contactsRequired;
+    // TODO: pass id hints to ContactManager if we ever gain support to retrieve contact ids
+    //       from ChatState.
+    HandleIdentifierMap contactsRequired;
     foreach (const ChatStateEvent *e, chatStateQueue) {
         if (!e->contact &&
             !awaitingContacts.contains(e->contactHandle)) {
-            contactsRequired << e->contactHandle;
+            contactsRequired.insert(e->contactHandle, QString());
         }
     }
 
-    if (contactsRequired.isEmpty()) {
+    requestContacts(contactsRequired);
+}
+
+void TextChannel::Private::trimMessageQueue()
+{
+    if (maxMessageQueueSize <= 0) {
         return;
     }
 
-    // TODO: pass id hints to ContactManager if we ever gain support to retrieve contact ids
-    //       from ChatState.
-    parent->connect(parent->connection()->contactManager()->contactsForHandles(
-                contactsRequired.toList()),
-            SIGNAL(finished(Tp::PendingOperation*)),
-            SLOT(onContactsFinished(Tp::PendingOperation*)));
+    while (messages.size() > maxMessageQueueSize) {
+        emit parent->pendingMessageRemoved(messages.takeFirst());
+    }
+}
+
+void TextChannel::Private::requestContacts(const HandleIdentifierMap &contacts)
+{
+    if (contacts.isEmpty()) {
+        return;
+    }
 
-    awaitingContacts |= contactsRequired;
+    // Senders showing up in a burst (e.g. a busy MUC) are looked up with a single
+    // request once control returns to the main loop
+    for (HandleIdentifierMap::const_iterator i = contacts.constBegin();
+            i != contacts.constEnd(); ++i) {
+        if (!i.value().isEmpty() || !queuedContacts.contains(i.key())) {
+            queuedContacts.insert(i.key(), i.value());
+        }
+    }
+    awaitingContacts |= contacts.keys().toSet();
+
+    if (!contactsRequestQueued) {
+        QTimer::singleShot(0, parent, SLOT(requestQueuedContacts()));
+        contactsRequestQueued = true;
+    }
 }
 
 void TextChannel::Private::contactLost(uint handle)
@@ -825,7 +1028,76 @@ DeliveryReportingSupportFlags TextChannel::deliveryReportingSupport() const
  */
 QList<ReceivedMessage> TextChannel::messageQueue() const
 {
-    return mPriv->messages;
+    return mPriv->messages.toList();
+}
+
+/**
+ * Return the maximum number of messages kept in messageQueue().
+ *
+ * \return The maximum number of messages, or 0 if the queue is unbounded.
+ * \sa setMaxMessageQueueSize()
+ */
+int TextChannel::maxMessageQueueSize() const
+{
+    return mPriv->maxMessageQueueSize;
+}
+
+/**
+ * Set the maximum number of messages kept in messageQueue().
+ *
+ * When a message is received and the queue is full, the oldest messages are forgotten as if
+ * forget() had been called for them, so that observers of long-lived channels use a
+ * constant amount of memory. They are not acknowledged.
+ *
+ * The default value of 0 means that the queue is unbounded.
+ *
+ * \param size The maximum number of messages, or 0 for an unbounded queue.
+ * \sa forget(), pendingMessageRemoved()
+ */
+void TextChannel::setMaxMessageQueueSize(int size)
+{
+    mPriv->maxMessageQueueSize = qMax(size, 0);
+    mPriv->trimMessageQueue();
+}
+
+/**
+ * Return how messages waiting for their sender Contact are released to messageQueue().
+ *
+ * \return The delivery mode as #MessageDeliveryMode.
+ * \sa setMessageDeliveryMode()
+ */
+TextChannel::MessageDeliveryMode TextChannel::messageDeliveryMode() const
+{
+    return mPriv->deliveryMode;
+}
+
+/**
+ * Set how messages waiting for their sender Contact are released to messageQueue().
+ *
+ * With the default #MessageDeliveryModeInOrder, messageReceived() is emitted in the
+ * order the messages were received, so a message whose sender is still being
+ * retrieved delays every message received after it.
+ *
+ * With #MessageDeliveryModePerSender, each message is delivered as soon as its own
+ * sender is available. Messages from the same sender are still delivered in order,
+ * and a message removal is never processed before the message it refers to, but
+ * messages from different senders may be reordered. This is useful on busy
+ * multi-user chats, where a slow contact lookup for a new participant would
+ * otherwise hold back the whole conversation.
+ *
+ * \param mode The delivery mode as #MessageDeliveryMode.
+ * \sa messageDeliveryMode(), messageReceived()
+ */
+void TextChannel::setMessageDeliveryMode(MessageDeliveryMode mode)
+{
+    if (mPriv->deliveryMode == mode) {
+        return;
+    }
+
+    mPriv->deliveryMode = mode;
+    if (mPriv->initialMessagesReceived) {
+        mPriv->processMessageQueue();
+    }
 }
 
 /**
@@ -861,7 +1133,7 @@ void TextChannel::onAcknowledgePendingMessagesReply(
     if (reply.isError()) {
         // One of the IDs was bad, and we can't know which one. Recover by
         // doing as much as possible, and hope for the best...
-        debug() << "Recovering from AcknowledgePendingMessages failure for: "
+        tpDebug(DebugCategoryChannels) << "Recovering from AcknowledgePendingMessages failure for: "
             << ids;
         foreach (uint id, ids) {
             mPriv->textInterface->AcknowledgePendingMessages(UIntList() << id);
@@ -936,7 +1208,7 @@ void TextChannel::forget(const QList<ReceivedMessage> &messages)
     foreach (const ReceivedMessage &m, messages) {
         if (!m.isFromChannel(TextChannelPtr(this))) {
             warning() << "message did not come from this channel, ignoring";
-        } else if (mPriv->messages.removeOne(m)) {
+        } else if (mPriv->messages.remove(m)) {
             emit pendingMessageRemoved(m);
         }
     }
@@ -1102,15 +1374,35 @@ void TextChannel::onContactsFinished(PendingOperation *op)
     mPriv->processChatStateQueue();
 }
 
+void TextChannel::requestQueuedContacts()
+{
+    mPriv->contactsRequestQueued = false;
+
+    if (mPriv->queuedContacts.isEmpty()) {
+        return;
+    }
+
+    HandleIdentifierMap contacts = mPriv->queuedContacts;
+    mPriv->queuedContacts.clear();
+
+    ConnectionPtr conn = connection();
+    conn->lowlevel()->injectContactIds(contacts);
+
+    tpDebug(DebugCategoryChannels) << "Requesting" << contacts.size() <<
+        "contacts for queued events";
+    connect(conn->contactManager()->contactsForHandles(contacts.keys()),
+            SIGNAL(finished(Tp::PendingOperation*)),
+            SLOT(onContactsFinished(Tp::PendingOperation*)));
+}
+
 void TextChannel::onMessageReceived(const MessagePartList &parts)
 {
     if (!mPriv->initialMessagesReceived) {
         return;
     }
 
-    mPriv->incompleteMessages << new Private::MessageEvent(
-            ReceivedMessage(parts, TextChannelPtr(this)));
-    mPriv->processMessageQueue();
+    mPriv->queueMessageEvent(new Private::MessageEvent(
+            ReceivedMessage(parts, TextChannelPtr(this))));
 }
 
 void TextChannel::onPendingMessagesRemoved(const UIntList &ids)
@@ -1119,9 +1411,8 @@ void TextChannel::onPendingMessagesRemoved(const UIntList &ids)
         return;
     }
     foreach (uint id, ids) {
-        mPriv->incompleteMessages << new Private::MessageEvent(id);
+        mPriv->queueMessageEvent(new Private::MessageEvent(id));
     }
-    mPriv->processMessageQueue();
 }
 
 void TextChannel::onTextSent(uint timestamp, uint type, const QString &text)
@@ -1181,8 +1472,7 @@ void TextChannel::onTextReceived(uint id, uint timestamp, uint sender,
         m.setForceNonText();
     }
 
-    mPriv->incompleteMessages << new Private::MessageEvent(m);
-    mPriv->processMessageQueue();
+    mPriv->queueMessageEvent(new Private::MessageEvent(m));
 }
 
 void TextChannel::onTextSendError(uint error, uint timestamp, uint type,
@@ -1264,19 +1554,19 @@ void TextChannel::gotProperties(QDBusPendingCallWatcher *watcher)
             reply.error().message();
 
         ReadinessHelper *readinessHelper = mPriv->readinessHelper;
-        if (readinessHelper->requestedFeatures().contains(FeatureMessageQueue) &&
-            !readinessHelper->isReady(Features() << FeatureMessageQueue)) {
+        if (readinessHelper->requestedFeatureMask().contains(FeatureMessageQueue) &&
+            !readinessHelper->isReady(FeatureMessageQueue)) {
             readinessHelper->setIntrospectCompleted(FeatureMessageQueue, false, reply.error());
         }
 
-        if (readinessHelper->requestedFeatures().contains(FeatureMessageCapabilities) &&
-            !readinessHelper->isReady(Features() << FeatureMessageCapabilities)) {
+        if (readinessHelper->requestedFeatureMask().contains(FeatureMessageCapabilities) &&
+            !readinessHelper->isReady(FeatureMessageCapabilities)) {
             readinessHelper->setIntrospectCompleted(FeatureMessageCapabilities, false, reply.error());
         }
         return;
     }
 
-    debug() << "Properties::GetAll(Channel.Interface.Messages) returned";
+    tpDebug(DebugCategoryChannels) << "Properties::GetAll(Channel.Interface.Messages) returned";
     mPriv->props = reply.value();
 
     mPriv->updateInitialMessages();
@@ -1301,7 +1591,7 @@ void TextChannel::gotPendingMessages(QDBusPendingCallWatcher *watcher)
         return;
     }
 
-    debug() << "Text::ListPendingMessages returned";
+    tpDebug(DebugCategoryChannels) << "Text::ListPendingMessages returned";
     PendingTextMessageList list = reply.value();
 
     if (!list.isEmpty()) {
@@ -1310,8 +1600,7 @@ void TextChannel::gotPendingMessages(QDBusPendingCallWatcher *watcher)
                     message.sender, message.messageType, message.flags,
                     message.text);
         }
-        // processMessageQueue sets FeatureMessageQueue ready when the queue is empty for the first
-        // time
+        // The message queue is set ready once it is empty for the first time
     } else {
         mPriv->readinessHelper->setIntrospectCompleted(FeatureMessageQueue, true);
     }
@@ -49,6 +49,11 @@ public:
     static const Feature FeatureMessageSentSignal;
     static const Feature FeatureChatState;
 
+    enum MessageDeliveryMode {
+        MessageDeliveryModeInOrder,
+        MessageDeliveryModePerSender
+    };
+
     static TextChannelPtr create(const ConnectionPtr &connection,
             const QString &objectPath, const QVariantMap &immutableProperties);
 
@@ -67,6 +72,10 @@ public:
 
     // requires FeatureMessageQueue
     QList<ReceivedMessage> messageQueue() const;
+    int maxMessageQueueSize() const;
+    void setMaxMessageQueueSize(int size);
+    MessageDeliveryMode messageDeliveryMode() const;
+    void setMessageDeliveryMode(MessageDeliveryMode mode);
 
     // requires FeatureChatState
     ChannelChatState chatState(const ContactPtr &contact) const;
@@ -130,6 +139,8 @@ private Q_SLOTS:
 
     TP_QT_NO_EXPORT void onChatStateChanged(uint, uint);
 
+    TP_QT_NO_EXPORT void requestQueuedContacts();
+
 private:
     struct Private;
     friend struct Private;
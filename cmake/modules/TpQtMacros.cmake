@@ -430,6 +430,33 @@ macro(tpqt_add_dbus_unit_test _fancyName _name)
     _tpqt_add_check_targets(${_fancyName} ${_name} ${with_session_bus} ${CMAKE_CURRENT_BINARY_DIR}/test-${_name})
 endmacro()
 
+# Benchmarks are only built with ENABLE_BENCHMARKS and are never registered with ctest, so
+# that make check stays fast. Run them with make benchmark or make benchmark-<name>.
+macro(tpqt_add_generic_benchmark _fancyName _name)
+    if(ENABLE_BENCHMARKS)
+        tpqt_generate_moc_i(${_name}.cpp ${CMAKE_CURRENT_BINARY_DIR}/_gen/${_name}.cpp.moc.hpp)
+        add_executable(test-${_name} ${_name}.cpp ${CMAKE_CURRENT_BINARY_DIR}/_gen/${_name}.cpp.moc.hpp)
+        target_link_libraries(test-${_name} ${QT_QTCORE_LIBRARY} ${QT_QTNETWORK_LIBRARY} ${QT_QTXML_LIBRARY} ${QT_QTTEST_LIBRARY} telepathy-qt${QT_VERSION_MAJOR} tp-qt-tests ${TP_QT_EXECUTABLE_LINKER_FLAGS} ${ARGN})
+        _tpqt_add_benchmark_target(${_fancyName} ${_name} ${CMAKE_CURRENT_BINARY_DIR}/runGenericTest.sh ${CMAKE_CURRENT_BINARY_DIR}/test-${_name})
+    endif()
+endmacro()
+
+macro(tpqt_add_dbus_benchmark _fancyName _name)
+    if(ENABLE_BENCHMARKS)
+        tpqt_generate_moc_i(${_name}.cpp ${CMAKE_CURRENT_BINARY_DIR}/_gen/${_name}.cpp.moc.hpp)
+        add_executable(test-${_name} ${_name}.cpp ${CMAKE_CURRENT_BINARY_DIR}/_gen/${_name}.cpp.moc.hpp)
+        target_link_libraries(test-${_name} ${QT_QTCORE_LIBRARY} ${QT_QTDBUS_LIBRARY} ${QT_QTNETWORK_LIBRARY} ${QT_QTXML_LIBRARY} ${QT_QTTEST_LIBRARY} telepathy-qt${QT_VERSION_MAJOR} tp-qt-tests ${TP_QT_EXECUTABLE_LINKER_FLAGS} ${ARGN})
+        _tpqt_add_benchmark_target(${_fancyName} ${_name} ${CMAKE_CURRENT_BINARY_DIR}/runDbusTest.sh ${CMAKE_CURRENT_BINARY_DIR}/test-${_name})
+    endif()
+endmacro()
+
+macro(_tpqt_add_benchmark_target _fancyName _name _runnerScript)
+    add_custom_target(benchmark-${_fancyName} ${SH} ${_runnerScript} ${ARGN}
+                      WORKING_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR})
+    add_dependencies(benchmark-${_fancyName} test-${_name})
+    add_dependencies(benchmark benchmark-${_fancyName})
+endmacro()
+
 macro(_tpqt_add_check_targets _fancyName _name _runnerScript)
     set_tests_properties(${_fancyName}
         PROPERTIES
@@ -0,0 +1,190 @@
+#include <QtTest/QtTest>
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+
+#include "TelepathyQt/avatar-cache.h"
+
+#include <TelepathyQt/Utils>
+
+using namespace Tp;
+
+class TestAvatarCache : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testInsertLookup();
+    void testPersistence();
+    void testLegacyMigration();
+    void testEviction();
+    void testSharedDirectory();
+};
+
+void TestAvatarCache::testInsertLookup()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString path = dir.path() + QLatin1String("/avatars");
+
+    AvatarCache cache(path);
+    QCOMPARE(cache.count(), 0);
+
+    AvatarData avatarData;
+    QVERIFY(!cache.lookup(QLatin1String("token-1"), avatarData));
+
+    AvatarData inserted = cache.insert(QLatin1String("token-1"),
+            QByteArray("image data"), QLatin1String("image/png"));
+    QCOMPARE(inserted.mimeType, QLatin1String("image/png"));
+    QVERIFY(QFile::exists(inserted.fileName));
+    QCOMPARE(cache.count(), 1);
+    QCOMPARE(cache.diskUsage(), (qint64) 10);
+
+    QVERIFY(cache.lookup(QLatin1String("token-1"), avatarData));
+    QCOMPARE(avatarData.fileName, inserted.fileName);
+    QCOMPARE(avatarData.mimeType, inserted.mimeType);
+
+    // Avatars read back are kept in memory
+    QCOMPARE(cache.avatar(QLatin1String("token-1")), QByteArray("image data"));
+    QVERIFY(QFile::remove(inserted.fileName));
+    QCOMPARE(cache.avatar(QLatin1String("token-1")), QByteArray("image data"));
+    QVERIFY(cache.avatar(QLatin1String("token-3")).isEmpty());
+
+    cache.insert(QLatin1String("token-2"), QByteArray("more image data"),
+            QLatin1String("image/jpeg"));
+
+    QHash<QString, AvatarData> found = cache.lookup(QStringList() <<
+            QLatin1String("token-1") << QLatin1String("token-2") << QLatin1String("token-3"));
+    QCOMPARE(found.size(), 2);
+    QCOMPARE(found.value(QLatin1String("token-1")).mimeType, QLatin1String("image/png"));
+    QCOMPARE(found.value(QLatin1String("token-2")).mimeType, QLatin1String("image/jpeg"));
+    QVERIFY(!found.contains(QLatin1String("token-3")));
+}
+
+void TestAvatarCache::testPersistence()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    {
+        AvatarCache cache(dir.path());
+        cache.insert(QLatin1String("token"), QByteArray("image data"),
+                QLatin1String("image/png"));
+        QVERIFY(cache.isDirty());
+        QVERIFY(cache.sync());
+        QVERIFY(!cache.isDirty());
+    }
+
+    AvatarCache cache(dir.path());
+    QCOMPARE(cache.count(), 1);
+    QCOMPARE(cache.diskUsage(), (qint64) 10);
+
+    AvatarData avatarData;
+    QVERIFY(cache.lookup(QLatin1String("token"), avatarData));
+    QCOMPARE(avatarData.mimeType, QLatin1String("image/png"));
+    QCOMPARE(avatarData.fileName, dir.path() + QLatin1Char('/') +
+            escapeAsIdentifier(QLatin1String("token")));
+
+    // Lookups alone don't make the index worth writing again
+    QVERIFY(!cache.lookup(QLatin1String("other"), avatarData));
+    QVERIFY(cache.lookup(QLatin1String("token"), avatarData));
+    QVERIFY(!cache.isDirty());
+}
+
+void TestAvatarCache::testLegacyMigration()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // Layout written by versions of the library without an index
+    QString fileName = dir.path() + QLatin1Char('/') + escapeAsIdentifier(QLatin1String("old"));
+    QFile avatarFile(fileName);
+    QVERIFY(avatarFile.open(QIODevice::WriteOnly));
+    avatarFile.write("old image");
+    avatarFile.close();
+    QFile mimeTypeFile(fileName + QLatin1String(".mime"));
+    QVERIFY(mimeTypeFile.open(QIODevice::WriteOnly));
+    mimeTypeFile.write("image/gif");
+    mimeTypeFile.close();
+
+    AvatarCache cache(dir.path());
+    AvatarData avatarData;
+    QVERIFY(cache.lookup(QLatin1String("old"), avatarData));
+    QCOMPARE(avatarData.fileName, fileName);
+    QCOMPARE(avatarData.mimeType, QLatin1String("image/gif"));
+    QCOMPARE(cache.count(), 1);
+}
+
+void TestAvatarCache::testEviction()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    AvatarCache cache(dir.path());
+    cache.setMaxDiskSize(100);
+
+    QByteArray data(40, 'x');
+    cache.insert(QLatin1String("first"), data, QLatin1String("image/png"));
+    cache.insert(QLatin1String("second"), data, QLatin1String("image/png"));
+    QCOMPARE(cache.diskUsage(), (qint64) 80);
+
+    // Going over budget drops the least recently used avatar, never the new one
+    AvatarData third = cache.insert(QLatin1String("third"), data, QLatin1String("image/png"));
+    QVERIFY(cache.diskUsage() <= 100);
+    QCOMPARE(cache.count(), 2);
+    QVERIFY(QFile::exists(third.fileName));
+
+    AvatarData avatarData;
+    QVERIFY(cache.lookup(QLatin1String("third"), avatarData));
+}
+
+void TestAvatarCache::testSharedDirectory()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // Two caches on the same directory stand in for two processes
+    AvatarCache first(dir.path());
+    AvatarCache second(dir.path());
+    QCOMPARE(first.count(), 0);
+    QCOMPARE(second.count(), 0);
+
+    AvatarData inserted = first.insert(QLatin1String("shared"), QByteArray("image data"),
+            QLatin1String("image/png"));
+    QVERIFY(QFile::exists(inserted.fileName + QLatin1String(".mime")));
+
+    // An avatar written by someone else is picked up on a miss once they wrote their index,
+    // MIME type included
+    AvatarData avatarData;
+    QVERIFY(!second.lookup(QLatin1String("shared"), avatarData));
+    QVERIFY(first.sync());
+    QVERIFY(second.lookup(QLatin1String("shared"), avatarData));
+    QCOMPARE(avatarData.fileName, inserted.fileName);
+    QCOMPARE(avatarData.mimeType, QLatin1String("image/png"));
+
+    // Both indexes are merged rather than overwriting each other
+    first.insert(QLatin1String("first-only"), QByteArray("first"), QLatin1String("image/png"));
+    QVERIFY(first.sync());
+    second.insert(QLatin1String("second-only"), QByteArray("second"), QLatin1String("image/png"));
+    QVERIFY(second.sync());
+    {
+        AvatarCache third(dir.path());
+        QCOMPARE(third.count(), 3);
+    }
+
+    // An avatar which was removed from disk is only found out about when reading it back
+    QVERIFY(QFile::remove(inserted.fileName));
+    QVERIFY(first.lookup(QLatin1String("shared"), avatarData));
+    QVERIFY(!first.isDirty());
+    QVERIFY(first.avatar(QLatin1String("shared")).isEmpty());
+    QVERIFY(first.isDirty());
+    // Missing it also picked up the index the second cache wrote in the meantime
+    QVERIFY(!first.lookup(QLatin1String("shared"), avatarData));
+    QCOMPARE(first.count(), 2);
+    QCOMPARE(first.diskUsage(), (qint64) 11);
+}
+
+QTEST_MAIN(TestAvatarCache)
+
+#include "_gen/avatar-cache.cpp.moc.hpp"
@@ -0,0 +1,123 @@
+#include <QtTest/QtTest>
+
+#include <TelepathyQt/BaseChannel>
+#include <TelepathyQt/Types>
+
+using namespace Tp;
+
+namespace
+{
+
+UIntList handleRange(uint first, int count)
+{
+    UIntList handles;
+    handles.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        handles << first + i;
+    }
+    return handles;
+}
+
+}
+
+// Pushes big chat room rosters through BaseChannelGroupInterface, both as whole member lists and
+// as joins and parts, including the MembersChanged emission at the end of the event loop iteration
+class TestBaseChannelGroupBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestBaseChannelGroupBenchmark(QObject *parent = 0)
+        : QObject(parent)
+    { }
+
+private Q_SLOTS:
+    void benchmarkSetMembers_data();
+    void benchmarkSetMembers();
+    void benchmarkDeltas_data();
+    void benchmarkDeltas();
+    void benchmarkJoinOneByOne_data();
+    void benchmarkJoinOneByOne();
+};
+
+void TestBaseChannelGroupBenchmark::benchmarkSetMembers_data()
+{
+    QTest::addColumn<int>("roomSize");
+
+    QTest::newRow("10k members") << 10000;
+    QTest::newRow("100k members") << 100000;
+}
+
+void TestBaseChannelGroupBenchmark::benchmarkSetMembers()
+{
+    QFETCH(int, roomSize);
+
+    // Alternate between two rosters which differ by 1% of the members
+    const int churn = roomSize / 100;
+    const UIntList first = handleRange(1, roomSize);
+    const UIntList second = handleRange(1 + churn, roomSize);
+
+    BaseChannelGroupInterfacePtr group = BaseChannelGroupInterface::create();
+    group->setMembers(first, QVariantMap());
+    QCoreApplication::processEvents();
+
+    bool useSecond = true;
+    QBENCHMARK {
+        group->setMembers(useSecond ? second : first, QVariantMap());
+        QCoreApplication::processEvents();
+        useSecond = !useSecond;
+    }
+}
+
+void TestBaseChannelGroupBenchmark::benchmarkDeltas_data()
+{
+    benchmarkSetMembers_data();
+}
+
+void TestBaseChannelGroupBenchmark::benchmarkDeltas()
+{
+    QFETCH(int, roomSize);
+
+    // The same churn as benchmarkSetMembers, reported as individual joins and parts
+    const int churn = roomSize / 100;
+    BaseChannelGroupInterfacePtr group = BaseChannelGroupInterface::create();
+    group->setMembers(handleRange(1, roomSize), QVariantMap());
+    QCoreApplication::processEvents();
+
+    uint firstMember = 1;
+    QBENCHMARK {
+        for (int i = 0; i < churn; ++i) {
+            group->removeFromMembers(UIntList() << firstMember + i, QVariantMap());
+            group->addToMembers(UIntList() << firstMember + roomSize + i, QVariantMap());
+        }
+        QCoreApplication::processEvents();
+        firstMember += churn;
+    }
+
+    QCOMPARE(group->members().size(), roomSize);
+}
+
+void TestBaseChannelGroupBenchmark::benchmarkJoinOneByOne_data()
+{
+    benchmarkSetMembers_data();
+}
+
+void TestBaseChannelGroupBenchmark::benchmarkJoinOneByOne()
+{
+    QFETCH(int, roomSize);
+
+    const UIntList handles = handleRange(1, roomSize);
+
+    QBENCHMARK {
+        BaseChannelGroupInterfacePtr group = BaseChannelGroupInterface::create();
+        foreach (uint handle, handles) {
+            group->addToMembers(UIntList() << handle, QVariantMap());
+        }
+        QCoreApplication::processEvents();
+        QCOMPARE(group->members().size(), roomSize);
+    }
+}
+
+QTEST_MAIN(TestBaseChannelGroupBenchmark)
+
+#include "_gen/base-channel-group-benchmark.cpp.moc.hpp"
@@ -0,0 +1,112 @@
+#include <QtTest/QtTest>
+
+#include <TelepathyQt/BaseChannel>
+#include <TelepathyQt/Types>
+
+using namespace Tp;
+
+namespace
+{
+
+QObject *adapteeOf(const BaseChannelGroupInterfacePtr &group)
+{
+    foreach (QObject *child, group->children()) {
+        if (qstrcmp(child->metaObject()->className(), "Tp::BaseChannelGroupInterface::Adaptee") == 0) {
+            return child;
+        }
+    }
+    return 0;
+}
+
+}
+
+class TestBaseChannelGroup : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestBaseChannelGroup(QObject *parent = 0)
+        : QObject(parent), mSignals(0)
+    { }
+
+protected Q_SLOTS:
+    void onMembersChangedDetailed(const Tp::UIntList &added, const Tp::UIntList &removed,
+            const Tp::UIntList &localPending, const Tp::UIntList &remotePending,
+            const QVariantMap &details);
+
+private Q_SLOTS:
+    void testDeltas();
+
+private:
+    int mSignals;
+    UIntList mAdded;
+    UIntList mRemoved;
+    UIntList mRemotePending;
+};
+
+void TestBaseChannelGroup::onMembersChangedDetailed(const Tp::UIntList &added,
+        const Tp::UIntList &removed, const Tp::UIntList &localPending,
+        const Tp::UIntList &remotePending, const QVariantMap &details)
+{
+    Q_UNUSED(localPending);
+    Q_UNUSED(details);
+
+    ++mSignals;
+    mAdded = added;
+    mRemoved = removed;
+    mRemotePending = remotePending;
+}
+
+void TestBaseChannelGroup::testDeltas()
+{
+    BaseChannelGroupInterfacePtr group = BaseChannelGroupInterface::create();
+    QObject *adaptee = adapteeOf(group);
+    QVERIFY(adaptee);
+    QVERIFY(connect(adaptee,
+                SIGNAL(membersChangedDetailed(Tp::UIntList,Tp::UIntList,Tp::UIntList,Tp::UIntList,QVariantMap)),
+                SLOT(onMembersChangedDetailed(Tp::UIntList,Tp::UIntList,Tp::UIntList,Tp::UIntList,QVariantMap))));
+
+    group->setMembers(UIntList() << 1 << 2 << 3, LocalPendingInfoList(), UIntList() << 4 << 5,
+            QVariantMap());
+    group->addToMembers(UIntList() << 4 << 3, QVariantMap());
+    group->removeFromMembers(UIntList() << 2 << 7, QVariantMap());
+    group->addToMembers(UIntList() << 2, QVariantMap());
+    group->removeFromMembers(UIntList() << 4, QVariantMap());
+    group->addToMembers(UIntList() << 8, QVariantMap());
+
+    // The state is up to date right away
+    QCOMPARE(group->members(), UIntList() << 1 << 2 << 3 << 8);
+    QVERIFY(group->isMember(2));
+    QVERIFY(!group->isMember(4));
+    QCOMPARE(group->remotePendingMembers(), UIntList() << 5);
+
+    // And a single signal reports the net change
+    QCOMPARE(mSignals, 0);
+    QCoreApplication::processEvents();
+    QCOMPARE(mSignals, 1);
+    QCOMPARE(mAdded, UIntList() << 1 << 2 << 3 << 8);
+    QCOMPARE(mRemoved, UIntList());
+    QCOMPARE(mRemotePending, UIntList() << 5);
+
+    // Changes with different details are not merged
+    QVariantMap details;
+    details.insert(QLatin1String("message"), QLatin1String("bye"));
+    group->removeFromMembers(UIntList() << 1, details);
+    group->removeFromMembers(UIntList() << 3, QVariantMap());
+    QCOMPARE(mSignals, 2);
+    QCOMPARE(mRemoved, UIntList() << 1);
+    QCoreApplication::processEvents();
+    QCOMPARE(mSignals, 3);
+    QCOMPARE(mRemoved, UIntList() << 3);
+
+    // Changes which cancel out are not signalled
+    group->addToMembers(UIntList() << 9, QVariantMap());
+    group->removeFromMembers(UIntList() << 9, QVariantMap());
+    QCoreApplication::processEvents();
+    QCOMPARE(mSignals, 3);
+    QCOMPARE(group->members(), UIntList() << 2 << 8);
+}
+
+QTEST_MAIN(TestBaseChannelGroup)
+
+#include "_gen/base-channel-group.cpp.moc.hpp"
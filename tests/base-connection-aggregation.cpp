@@ -0,0 +1,157 @@
+#include <QtTest/QtTest>
+
+#include <TelepathyQt/BaseConnection>
+#include <TelepathyQt/Types>
+
+using namespace Tp;
+
+namespace
+{
+
+QObject *adapteeOf(QObject *interface)
+{
+    foreach (QObject *child, interface->children()) {
+        if (QByteArray(child->metaObject()->className()).endsWith("::Adaptee")) {
+            return child;
+        }
+    }
+    return 0;
+}
+
+SimplePresence presence(ConnectionPresenceType type, const char *status)
+{
+    SimplePresence ret;
+    ret.type = type;
+    ret.status = QLatin1String(status);
+    return ret;
+}
+
+}
+
+class TestBaseConnectionAggregation : public QObject
+{
+    Q_OBJECT
+
+protected Q_SLOTS:
+    void onPresencesChanged(const Tp::SimpleContactPresences &presences);
+    void onAliasesChanged(const Tp::AliasPairList &aliases);
+
+private Q_SLOTS:
+    void init();
+
+    void testPresences();
+    void testImmediate();
+    void testAliases();
+
+private:
+    QList<SimpleContactPresences> mPresences;
+    QList<AliasPairList> mAliases;
+};
+
+void TestBaseConnectionAggregation::onPresencesChanged(const Tp::SimpleContactPresences &presences)
+{
+    mPresences.append(presences);
+}
+
+void TestBaseConnectionAggregation::onAliasesChanged(const Tp::AliasPairList &aliases)
+{
+    mAliases.append(aliases);
+}
+
+void TestBaseConnectionAggregation::init()
+{
+    mPresences.clear();
+    mAliases.clear();
+}
+
+void TestBaseConnectionAggregation::testPresences()
+{
+    BaseConnectionSimplePresenceInterfacePtr iface = BaseConnectionSimplePresenceInterface::create();
+    QCOMPARE(iface->changeAggregationInterval(), 0);
+    QVERIFY(connect(adapteeOf(iface.data()),
+                SIGNAL(presencesChanged(Tp::SimpleContactPresences)),
+                SLOT(onPresencesChanged(Tp::SimpleContactPresences))));
+
+    const SimplePresence available = presence(ConnectionPresenceTypeAvailable, "available");
+    const SimplePresence away = presence(ConnectionPresenceTypeAway, "away");
+
+    for (uint handle = 1; handle <= 100; ++handle) {
+        SimpleContactPresences presences;
+        presences.insert(handle, available);
+        iface->setPresences(presences);
+    }
+    SimpleContactPresences presences;
+    presences.insert(1, away);
+    iface->setPresences(presences);
+
+    // The state is up to date right away, the signal waits for the event loop
+    QCOMPARE(iface->getPresences(UIntList() << 1).value(1), away);
+    QVERIFY(mPresences.isEmpty());
+
+    QCoreApplication::processEvents();
+    QCOMPARE(mPresences.size(), 1);
+    QCOMPARE(mPresences.first().size(), 100);
+    QCOMPARE(mPresences.first().value(1), away);
+    QCOMPARE(mPresences.first().value(100), available);
+
+    // Unchanged presences are not signalled again
+    iface->setPresences(presences);
+    QCoreApplication::processEvents();
+    QCOMPARE(mPresences.size(), 1);
+
+    // Flushing sends pending changes right away
+    iface->setChangeAggregationInterval(60000);
+    presences.insert(2, away);
+    iface->setPresences(presences);
+    QCOMPARE(mPresences.size(), 1);
+    iface->flushChanges();
+    QCOMPARE(mPresences.size(), 2);
+    QCOMPARE(mPresences.last().keys(), QList<uint>() << 2);
+}
+
+void TestBaseConnectionAggregation::testImmediate()
+{
+    BaseConnectionSimplePresenceInterfacePtr iface = BaseConnectionSimplePresenceInterface::create();
+    QVERIFY(connect(adapteeOf(iface.data()),
+                SIGNAL(presencesChanged(Tp::SimpleContactPresences)),
+                SLOT(onPresencesChanged(Tp::SimpleContactPresences))));
+
+    iface->setChangeAggregationInterval(60000);
+    SimpleContactPresences presences;
+    presences.insert(1, presence(ConnectionPresenceTypeAvailable, "available"));
+    iface->setPresences(presences);
+
+    // Disabling the aggregation sends what was pending, then each change as it is set
+    iface->setChangeAggregationInterval(-1);
+    QCOMPARE(mPresences.size(), 1);
+    presences.insert(2, presence(ConnectionPresenceTypeBusy, "busy"));
+    iface->setPresences(presences);
+    QCOMPARE(mPresences.size(), 2);
+    QCOMPARE(mPresences.last().keys(), QList<uint>() << 2);
+}
+
+void TestBaseConnectionAggregation::testAliases()
+{
+    BaseConnectionAliasingInterfacePtr iface = BaseConnectionAliasingInterface::create();
+    QVERIFY(connect(adapteeOf(iface.data()),
+                SIGNAL(aliasesChanged(Tp::AliasPairList)),
+                SLOT(onAliasesChanged(Tp::AliasPairList))));
+
+    AliasPair first = { 1, QLatin1String("Alice") };
+    AliasPair second = { 2, QLatin1String("Bob") };
+    AliasPair renamed = { 1, QLatin1String("Alice Liddell") };
+
+    iface->aliasesChanged(AliasPairList() << first << second);
+    iface->aliasesChanged(AliasPairList() << renamed);
+    QVERIFY(mAliases.isEmpty());
+
+    QCoreApplication::processEvents();
+    QCOMPARE(mAliases.size(), 1);
+    QCOMPARE(mAliases.first().size(), 2);
+    QCOMPARE(mAliases.first().at(0).alias, QLatin1String("Alice Liddell"));
+    QCOMPARE(mAliases.first().at(1).alias, QLatin1String("Bob"));
+}
+
+QTEST_MAIN(TestBaseConnectionAggregation)
+
+#include "_gen/base-connection-aggregation.cpp.moc.hpp"
@@ -0,0 +1,102 @@
+#include <QtTest/QtTest>
+
+#include <TelepathyQt/BaseHandleRepository>
+#include <TelepathyQt/Constants>
+#include <TelepathyQt/DBusError>
+
+using namespace Tp;
+
+namespace
+{
+
+QString normalizeLowerCase(const QString &identifier, DBusError *error)
+{
+    if (identifier.contains(QLatin1Char(' '))) {
+        error->set(TP_QT_ERROR_INVALID_HANDLE, QLatin1String("Spaces are not allowed"));
+        return QString();
+    }
+    return identifier.toLower();
+}
+
+}
+
+class TestBaseHandleRepository : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testEnsureInspect();
+    void testNormalization();
+    void testBulkErrors();
+};
+
+void TestBaseHandleRepository::testEnsureInspect()
+{
+    BaseHandleRepositoryPtr repository = BaseHandleRepository::create();
+    QCOMPARE(repository->handleType(), HandleTypeContact);
+    QCOMPARE(repository->count(), 0);
+    QVERIFY(!repository->isValidHandle(0));
+    QVERIFY(!repository->isValidHandle(1));
+
+    DBusError error;
+    uint alice = repository->ensureHandle(QLatin1String("alice"), &error);
+    QVERIFY(!error.isValid());
+    QCOMPARE(alice, 1u);
+
+    UIntList handles = repository->ensureHandles(QStringList() <<
+            QLatin1String("bob") << QLatin1String("alice") << QLatin1String("carol"), &error);
+    QVERIFY(!error.isValid());
+    QCOMPARE(handles, UIntList() << 2 << 1 << 3);
+    QCOMPARE(repository->count(), 3);
+
+    // Handles are dense, so they can index arrays
+    QCOMPARE(repository->identifier(3), QLatin1String("carol"));
+    QCOMPARE(repository->handle(QLatin1String("bob")), 2u);
+    QCOMPARE(repository->handle(QLatin1String("dave")), 0u);
+    QVERIFY(repository->identifier(4).isEmpty());
+
+    QStringList identifiers = repository->identifiers(UIntList() << 3 << 1, &error);
+    QVERIFY(!error.isValid());
+    QCOMPARE(identifiers, QStringList() << QLatin1String("carol") << QLatin1String("alice"));
+}
+
+void TestBaseHandleRepository::testNormalization()
+{
+    BaseHandleRepositoryPtr repository = BaseHandleRepository::create(HandleTypeRoom);
+    repository->setNormalizeIdentifierCallback(ptrFun(&normalizeLowerCase));
+
+    DBusError error;
+    uint room = repository->ensureHandle(QLatin1String("Lobby"), &error);
+    QVERIFY(!error.isValid());
+    QCOMPARE(repository->ensureHandle(QLatin1String("LOBBY"), &error), room);
+    QCOMPARE(repository->identifier(room), QLatin1String("lobby"));
+    QCOMPARE(repository->count(), 1);
+
+    repository->ensureHandle(QLatin1String("the lobby"), &error);
+    QVERIFY(error.isValid());
+    QCOMPARE(error.name(), TP_QT_ERROR_INVALID_HANDLE);
+}
+
+void TestBaseHandleRepository::testBulkErrors()
+{
+    BaseHandleRepositoryPtr repository = BaseHandleRepository::create();
+
+    DBusError error;
+    UIntList handles = repository->ensureHandles(QStringList() <<
+            QLatin1String("alice") << QString(), &error);
+    QVERIFY(error.isValid());
+    QVERIFY(handles.isEmpty());
+    // Nothing is allocated if one of the identifiers is not valid
+    QCOMPARE(repository->count(), 0);
+
+    DBusError inspectError;
+    repository->ensureHandle(QLatin1String("alice"), &inspectError);
+    QStringList identifiers = repository->identifiers(UIntList() << 1 << 2, &inspectError);
+    QVERIFY(inspectError.isValid());
+    QCOMPARE(inspectError.name(), TP_QT_ERROR_INVALID_HANDLE);
+    QVERIFY(identifiers.isEmpty());
+}
+
+QTEST_MAIN(TestBaseHandleRepository)
+
+#include "_gen/base-handle-repository.cpp.moc.hpp"
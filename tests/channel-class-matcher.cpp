@@ -0,0 +1,148 @@
+#include <QtTest/QtTest>
+
+#include "TelepathyQt/channel-class-matcher-internal.h"
+
+#include <TelepathyQt/ChannelClassSpec>
+#include <TelepathyQt/Constants>
+
+using namespace Tp;
+
+namespace
+{
+
+ChannelClassSpec withoutHandleType(const ChannelClassSpec &spec)
+{
+    ChannelClassSpec ret(spec);
+    ret.unsetProperty(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandleType"));
+    return ret;
+}
+
+}
+
+class TestChannelClassMatcher : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testMatching();
+    void testMatchingChannel();
+    void testFirstValue();
+};
+
+void TestChannelClassMatcher::testMatching()
+{
+    QList<ChannelClassSpec> specs;
+    specs << ChannelClassSpec::textChat()
+        << ChannelClassSpec::textChatroom()
+        << ChannelClassSpec::unnamedTextChat()
+        << ChannelClassSpec::audioCall()
+        << ChannelClassSpec::outgoingFileTransfer()
+        << ChannelClassSpec::incomingStreamTube(QLatin1String("ftp"))
+        << ChannelClassSpec(TP_QT_IFACE_CHANNEL_TYPE_TEXT, HandleTypeNone)
+        << ChannelClassSpec();
+
+    ChannelClassIndex index;
+    for (int i = 0; i < specs.size(); ++i) {
+        QCOMPARE(index.add(specs[i]), i);
+    }
+    QCOMPARE(index.size(), specs.size());
+
+    // The index must agree with checking every class one by one
+    QList<ChannelClassSpec> queries(specs);
+    queries << ChannelClassSpec::textChat(QVariantMap())
+        << ChannelClassSpec(TP_QT_IFACE_CHANNEL_TYPE_TEXT, HandleTypeContact, true)
+        << ChannelClassSpec::incomingStreamTube(QLatin1String("http"))
+        << withoutHandleType(ChannelClassSpec::audioCall());
+    foreach (const ChannelClassSpec &query, queries) {
+        QList<int> expected;
+        for (int i = 0; i < specs.size(); ++i) {
+            if (specs[i].isSubsetOf(query)) {
+                expected << i;
+            }
+        }
+        QCOMPARE(index.matching(query), expected);
+    }
+
+    index.clear();
+    QCOMPARE(index.size(), 0);
+    QVERIFY(index.matching(ChannelClassSpec::textChat()).isEmpty());
+}
+
+void TestChannelClassMatcher::testMatchingChannel()
+{
+    QList<ChannelClassSpec> specs;
+    specs << ChannelClassSpec::textChat()
+        << withoutHandleType(ChannelClassSpec::textChat())
+        << ChannelClassSpec::unnamedTextChat()
+        << ChannelClassSpec::incomingFileTransfer();
+
+    ChannelClassIndex index;
+    foreach (const ChannelClassSpec &spec, specs) {
+        index.add(spec);
+    }
+
+    QVariantMap chat;
+    chat.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType"),
+            TP_QT_IFACE_CHANNEL_TYPE_TEXT);
+    chat.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandleType"),
+            (uint) HandleTypeContact);
+    chat.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetID"), QLatin1String("alice"));
+
+    QVariantMap anonymous;
+    anonymous.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType"),
+            TP_QT_IFACE_CHANNEL_TYPE_TEXT);
+
+    QVariantMap transfer;
+    transfer.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType"),
+            TP_QT_IFACE_CHANNEL_TYPE_FILE_TRANSFER);
+    transfer.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandleType"),
+            (uint) HandleTypeContact);
+    transfer.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".Requested"), false);
+
+    // A channel without a handle type counts as HandleTypeNone, as in ChannelClassSpec::matches()
+    QList<QVariantMap> channels;
+    channels << chat << anonymous << transfer << QVariantMap();
+    foreach (const QVariantMap &channel, channels) {
+        QList<int> expected;
+        for (int i = 0; i < specs.size(); ++i) {
+            if (specs[i].matches(channel)) {
+                expected << i;
+            }
+        }
+        QCOMPARE(index.matchingChannel(channel), expected);
+    }
+
+    QCOMPARE(index.matchingChannel(anonymous), QList<int>() << 1 << 2);
+}
+
+void TestChannelClassMatcher::testFirstValue()
+{
+    ChannelClassMatcher<QString> matcher;
+    QVERIFY(matcher.isEmpty());
+    QCOMPARE(matcher.firstValue(ChannelClassSpec::textChat(), QLatin1String("none")),
+            QLatin1String("none"));
+
+    // Most specific first, as ChannelFactory keeps them
+    matcher.append(ChannelClassSpec::textChatroom(), QLatin1String("room"));
+    matcher.append(ChannelClassSpec(TP_QT_IFACE_CHANNEL_TYPE_TEXT, HandleTypeContact),
+            QLatin1String("chat"));
+    matcher.append(ChannelClassSpec(), QLatin1String("fallback"));
+    QVERIFY(!matcher.isEmpty());
+
+    QCOMPARE(matcher.firstValue(ChannelClassSpec::textChat()), QLatin1String("chat"));
+    QCOMPARE(matcher.firstValue(ChannelClassSpec::audioCall()), QLatin1String("fallback"));
+    QCOMPARE(matcher.values(ChannelClassSpec::textChatroom()),
+            QList<QString>() << QLatin1String("room") << QLatin1String("fallback"));
+
+    QVariantMap room;
+    room.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType"),
+            TP_QT_IFACE_CHANNEL_TYPE_TEXT);
+    room.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandleType"),
+            (uint) HandleTypeRoom);
+    QCOMPARE(matcher.firstValueForChannel(room), QLatin1String("room"));
+    QCOMPARE(matcher.valuesForChannel(QVariantMap()), QList<QString>() << QLatin1String("fallback"));
+}
+
+QTEST_MAIN(TestChannelClassMatcher)
+
+#include "_gen/channel-class-matcher.cpp.moc.hpp"
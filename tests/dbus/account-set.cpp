@@ -377,6 +377,26 @@ void TestAccountSet::testFilters()
         QVERIFY(disabledAccounts->accounts().contains(fooAcc));
     }
 
+    {
+        // property filters keep matching correctly when changed after being used
+        AccountPropertyFilterPtr filter = AccountPropertyFilter::create();
+        filter->addProperty(QLatin1String("cmName"), QLatin1String("foo"));
+        QVERIFY(filter->matches(fooAcc));
+        QVERIFY(!filter->matches(spuriousAcc));
+
+        filter->addProperty(QLatin1String("enabled"), false);
+        QVERIFY(filter->matches(fooAcc));
+
+        QVariantMap properties;
+        properties.insert(QLatin1String("enabled"), true);
+        filter->setProperties(properties);
+        QVERIFY(!filter->matches(fooAcc));
+        QVERIFY(filter->matches(spuriousAcc));
+
+        filter->addProperty(QLatin1String("noSuchProperty"), 1);
+        QVERIFY(!filter->matches(spuriousAcc));
+    }
+
     {
         QCOMPARE(mAM->invalidAccounts()->accounts().size(), 0);
         QCOMPARE(mAM->onlineAccounts()->accounts().size(), 0);
@@ -0,0 +1,159 @@
+#include <tests/lib/test.h>
+
+#include <TelepathyQt/BaseDebug>
+#include <TelepathyQt/Constants>
+#include <TelepathyQt/DBusError>
+#include <TelepathyQt/Types>
+
+using namespace Tp;
+
+class TestBaseDebug : public Test
+{
+    Q_OBJECT
+public:
+    TestBaseDebug(QObject *parent = 0)
+        : Test(parent), mExpectedMessages(0)
+    { }
+
+protected Q_SLOTS:
+    void onNewDebugMessage(double time, const QString &domain, uint level, const QString &message);
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testHistory();
+    void testBatching();
+
+    void cleanup();
+    void cleanupTestCase();
+
+private:
+    QStringList mMessages;
+    int mExpectedMessages;
+};
+
+void TestBaseDebug::onNewDebugMessage(double time, const QString &domain, uint level,
+        const QString &message)
+{
+    Q_UNUSED(time);
+    Q_UNUSED(domain);
+    Q_UNUSED(level);
+
+    mMessages.append(message);
+    if (mMessages.size() == mExpectedMessages) {
+        mLoop->exit(0);
+    }
+}
+
+void TestBaseDebug::initTestCase()
+{
+    initTestCaseImpl();
+}
+
+void TestBaseDebug::init()
+{
+    initImpl();
+}
+
+void TestBaseDebug::testHistory()
+{
+    BaseDebug debug;
+    DBusError error;
+
+    // No history is kept by default
+    debug.newDebugMessage(QLatin1String("test"), DebugLevelInfo, QLatin1String("lost"));
+    QVERIFY(debug.getMessages(&error).isEmpty());
+    QCOMPARE(error.name(), TP_QT_ERROR_NOT_IMPLEMENTED);
+
+    debug.setGetMessagesLimit(3);
+    for (int i = 0; i < 5; ++i) {
+        debug.newDebugMessage(QLatin1String("test"), DebugLevelInfo, QString::number(i));
+    }
+
+    DBusError historyError;
+    DebugMessageList messages = debug.getMessages(&historyError);
+    QVERIFY(!historyError.isValid());
+    QCOMPARE(messages.size(), 3);
+    QCOMPARE(messages[0].message, QLatin1String("2"));
+    QCOMPARE(messages[2].message, QLatin1String("4"));
+
+    // Lowering the limit keeps the most recent messages
+    debug.setGetMessagesLimit(2);
+    messages = debug.getMessages(&historyError);
+    QCOMPARE(messages.size(), 2);
+    QCOMPARE(messages[0].message, QLatin1String("3"));
+    QCOMPARE(messages[1].message, QLatin1String("4"));
+
+    debug.newDebugMessage(QLatin1String("test"), DebugLevelInfo, QLatin1String("5"));
+
+    // Removing the limit after wrapping around keeps the order
+    debug.setGetMessagesLimit(-1);
+    debug.newDebugMessage(QLatin1String("test"), DebugLevelInfo, QLatin1String("6"));
+    debug.newDebugMessage(QLatin1String("test"), DebugLevelInfo, QLatin1String("7"));
+    messages = debug.getMessages(&historyError);
+    QCOMPARE(messages.size(), 4);
+    QCOMPARE(messages[0].message, QLatin1String("4"));
+    QCOMPARE(messages[3].message, QLatin1String("7"));
+
+    debug.clear();
+    QVERIFY(debug.getMessages(&historyError).isEmpty());
+    QVERIFY(!historyError.isValid());
+}
+
+void TestBaseDebug::testBatching()
+{
+    BaseDebug debug;
+    DBusError error;
+    QVERIFY(debug.registerObject(QLatin1String("org.freedesktop.Telepathy.TestBaseDebug"), &error));
+    QVERIFY(!error.isValid());
+
+    QVERIFY(QDBusConnection::sessionBus().connect(QString(), TP_QT_DEBUG_OBJECT_PATH,
+                TP_QT_IFACE_DEBUG, QLatin1String("NewDebugMessage"),
+                this, SLOT(onNewDebugMessage(double,QString,uint,QString))));
+
+    debug.setEnabled(true);
+    debug.setBatchInterval(50);
+    debug.setMaxBatchSize(3);
+    QCOMPARE(debug.batchInterval(), 50);
+    QCOMPARE(debug.maxBatchSize(), 3);
+
+    for (int i = 0; i < 5; ++i) {
+        debug.newDebugMessage(QLatin1String("test"), DebugLevelDebug, QString::number(i));
+    }
+    QCOMPARE(debug.droppedMessages(), 2U);
+
+    // The first three messages, then a warning about the two that did not fit in the batch
+    mExpectedMessages = 4;
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mMessages.mid(0, 3), QStringList() << QLatin1String("0") << QLatin1String("1") <<
+            QLatin1String("2"));
+    QVERIFY(mMessages[3].contains(QLatin1String("2 debug messages were dropped")));
+
+    // Without a batch interval messages are signalled as they arrive again
+    debug.setBatchInterval(0);
+    mMessages.clear();
+    mExpectedMessages = 1;
+    debug.newDebugMessage(QLatin1String("test"), DebugLevelDebug, QLatin1String("immediate"));
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mMessages, QStringList() << QLatin1String("immediate"));
+
+    QDBusConnection::sessionBus().disconnect(QString(), TP_QT_DEBUG_OBJECT_PATH,
+            TP_QT_IFACE_DEBUG, QLatin1String("NewDebugMessage"),
+            this, SLOT(onNewDebugMessage(double,QString,uint,QString)));
+}
+
+void TestBaseDebug::cleanup()
+{
+    mMessages.clear();
+    mExpectedMessages = 0;
+    cleanupImpl();
+}
+
+void TestBaseDebug::cleanupTestCase()
+{
+    cleanupTestCaseImpl();
+}
+
+QTEST_MAIN(TestBaseDebug)
+#include "_gen/base-debug.cpp.moc.hpp"
@@ -377,6 +377,8 @@ private Q_SLOTS:
     void testSendFile_data();
     void testReceiveFile();
     void testReceiveFile_data();
+    void testReceiveLargeFile();
+    void testReceiveLargeFile_data();
 
     void cleanup();
     void cleanupTestCase();
@@ -902,6 +904,97 @@ void TestBaseFileTranfserChannel::testReceiveFile_data()
     QTest::newRow("Cancel in the middle of the data") << 2048 << 0 << int(CancelBeforeComplete)<< true << false;
 }
 
+void TestBaseFileTranfserChannel::testReceiveLargeFile()
+{
+    QFETCH(bool, useFile);
+
+    QCOMPARE(mCliConnection->status(), Tp::ConnectionStatusConnected);
+    QVERIFY(!mCliContact.isNull());
+
+    // Large enough to take many event loop iterations, so that progress has to be throttled
+    const int fileSize = 8 * 1024 * 1024;
+    const QByteArray fileContent = generateFileContent(fileSize);
+
+    Tp::FileTransferChannelCreationProperties fileTransferProperties(QLatin1String("file-transfer-test-large.txt"), c_fileContentType, fileContent.size());
+    fileTransferProperties.setLastModificationTime(c_fileTimestamp);
+
+    Tp::BaseChannelPtr svcTransferBaseChannel = g_connection->receiveFile(fileTransferProperties, mCliContact->handle().first());
+    QVERIFY(!svcTransferBaseChannel.isNull());
+
+    Tp::IncomingFileTransferChannelPtr cliTransferChannel = Tp::IncomingFileTransferChannel::create(mCliConnection, svcTransferBaseChannel->objectPath(), svcTransferBaseChannel->immutableProperties());
+
+    Tp::PendingReady *pendingChannelReady = cliTransferChannel->becomeReady(Tp::IncomingFileTransferChannel::FeatureCore);
+    connect(pendingChannelReady, SIGNAL(finished(Tp::PendingOperation*)),
+            SLOT(expectSuccessfulCall(Tp::PendingOperation*)));
+    QCOMPARE(mLoop->exec(), 0);
+
+    Tp::BaseChannelFileTransferTypePtr svcTransferChannel = Tp::BaseChannelFileTransferTypePtr::dynamicCast(svcTransferBaseChannel->interface(TP_QT_IFACE_CHANNEL_TYPE_FILE_TRANSFER));
+    QSignalSpy spySvcState(svcTransferChannel.data(), SIGNAL(stateChanged(uint,uint)));
+
+    Tp::IODevice cliInputDevice;
+    cliInputDevice.open(QIODevice::ReadWrite);
+
+    Tp::PendingOperation *acceptFileOperation = cliTransferChannel->acceptFile(0, &cliInputDevice);
+    connect(acceptFileOperation, SIGNAL(finished(Tp::PendingOperation*)),
+            SLOT(expectSuccessfulCall(Tp::PendingOperation*)));
+    QCOMPARE(mLoop->exec(), 0);
+
+    QTRY_COMPARE_WITH_TIMEOUT(uint(svcTransferChannel->state()), uint(Tp::FileTransferStateAccepted), c_defaultTimeout);
+
+    // A QFile is sent to the client socket with sendfile() where available, other devices
+    // go through the buffered path
+    QTemporaryFile svcOutputFile;
+    QBuffer svcOutputBuffer;
+    QIODevice *svcOutputDevice;
+    if (useFile) {
+        QVERIFY(svcOutputFile.open());
+        QCOMPARE(svcOutputFile.write(fileContent), qint64(fileSize));
+        QVERIFY(svcOutputFile.flush());
+        QVERIFY(svcOutputFile.seek(0));
+        svcOutputDevice = &svcOutputFile;
+    } else {
+        svcOutputBuffer.setData(fileContent);
+        svcOutputDevice = &svcOutputBuffer;
+    }
+
+    QSignalSpy spyClientTransferredBytes(cliTransferChannel.data(), SIGNAL(transferredBytesChanged(qulonglong)));
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    svcTransferChannel->remoteProvideFile(svcOutputDevice);
+
+    // The final byte count is always announced, however recently progress was reported
+    QTRY_VERIFY_WITH_TIMEOUT(!spyClientTransferredBytes.isEmpty() &&
+            spyClientTransferredBytes.last().at(0).toInt() == fileSize, 10000);
+    const qint64 transferTime = elapsed.elapsed();
+
+    QTRY_COMPARE_WITH_TIMEOUT(uint(cliTransferChannel->state()), uint(Tp::FileTransferStateCompleted), c_defaultTimeout);
+    QCOMPARE(uint(svcTransferChannel->state()), uint(Tp::FileTransferStateCompleted));
+    QCOMPARE(svcTransferChannel->transferredBytes(), qulonglong(fileSize));
+
+    // At most one progress report per 100 ms, plus the final one
+    QVERIFY2(spyClientTransferredBytes.count() <= transferTime / 100 + 2,
+            qPrintable(QString(QLatin1String("%1 progress reports in %2 ms"))
+                .arg(spyClientTransferredBytes.count()).arg(transferTime)));
+
+    qulonglong previous = 0;
+    for (int i = 0; i < spyClientTransferredBytes.count(); ++i) {
+        qulonglong current = spyClientTransferredBytes.at(i).at(0).toULongLong();
+        QVERIFY(current > previous);
+        previous = current;
+    }
+
+    QCOMPARE(cliInputDevice.readAll(), fileContent);
+}
+
+void TestBaseFileTranfserChannel::testReceiveLargeFile_data()
+{
+    QTest::addColumn<bool>("useFile");
+
+    QTest::newRow("File (sendfile)")    << true;
+    QTest::newRow("Buffer (buffered)")  << false;
+}
+
 void TestBaseFileTranfserChannel::cleanup()
 {
     cleanupImpl();
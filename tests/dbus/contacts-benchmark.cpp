@@ -0,0 +1,212 @@
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QList>
+
+#include <QtDBus>
+#include <QtTest>
+
+#define TP_QT_ENABLE_LOWLEVEL_API
+
+#include <TelepathyQt/ChannelFactory>
+#include <TelepathyQt/Connection>
+#include <TelepathyQt/ConnectionLowlevel>
+#include <TelepathyQt/Contact>
+#include <TelepathyQt/ContactFactory>
+#include <TelepathyQt/ContactManager>
+#include <TelepathyQt/PendingContacts>
+#include <TelepathyQt/Types>
+
+#include <telepathy-glib/debug.h>
+
+#include <tests/lib/glib/contacts-conn.h>
+#include <tests/lib/test.h>
+
+using namespace Tp;
+
+// Measures how fast contacts are built from GetContactAttributes replies, which ends up in
+// ContactManager::ensureContact() and Contact::augment() once per contact
+class TestContactsBenchmark : public Test
+{
+    Q_OBJECT
+
+public:
+    TestContactsBenchmark(QObject *parent = 0)
+        : Test(parent), mConnService(0)
+    {
+    }
+
+protected Q_SLOTS:
+    void expectPendingContactsFinished(Tp::PendingOperation *);
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void benchmarkContactsForHandles_data();
+    void benchmarkContactsForHandles();
+
+    void cleanup();
+    void cleanupTestCase();
+
+private:
+    QString mConnName, mConnPath;
+    TpTestsContactsConnection *mConnService;
+    ConnectionPtr mConn;
+    QList<ContactPtr> mContacts;
+    Tp::UIntList mHandles;
+};
+
+static const int maxContacts = 5000;
+
+void TestContactsBenchmark::expectPendingContactsFinished(PendingOperation *op)
+{
+    TEST_VERIFY_OP(op);
+
+    PendingContacts *pending = qobject_cast<PendingContacts *>(op);
+    mContacts = pending->contacts();
+    mLoop->exit(0);
+}
+
+void TestContactsBenchmark::initTestCase()
+{
+    initTestCaseImpl();
+
+    g_type_init();
+    g_set_prgname("contacts-benchmark");
+    tp_debug_set_flags("");
+    dbus_g_bus_get(DBUS_BUS_STARTER, 0);
+
+    gchar *name;
+    gchar *connPath;
+    GError *error = 0;
+
+    mConnService = TP_TESTS_CONTACTS_CONNECTION(g_object_new(
+            TP_TESTS_TYPE_CONTACTS_CONNECTION,
+            "account", "me@example.com",
+            "protocol", "simple",
+            NULL));
+    QVERIFY(mConnService != 0);
+    QVERIFY(tp_base_connection_register(TP_BASE_CONNECTION(mConnService), "contacts",
+                &name, &connPath, &error));
+    QVERIFY(error == 0);
+
+    mConnName = QLatin1String(name);
+    mConnPath = QLatin1String(connPath);
+
+    g_free(name);
+    g_free(connPath);
+
+    mConn = Connection::create(mConnName, mConnPath,
+            ChannelFactory::create(QDBusConnection::sessionBus()),
+            ContactFactory::create());
+    mConn->lowlevel()->requestConnect();
+
+    Features features = Features() << Connection::FeatureSelfContact;
+    QVERIFY(connect(mConn->becomeReady(features),
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(expectSuccessfulCall(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mConn->status(), ConnectionStatusConnected);
+
+    // Give every contact an alias and a presence, so all the attributes are decoded
+    TpHandleRepoIface *serviceRepo =
+        tp_base_connection_get_handles(TP_BASE_CONNECTION(mConnService), TP_HANDLE_TYPE_CONTACT);
+    QList<QByteArray> aliases;
+    QVector<const gchar *> aliasPtrs;
+    QVector<TpTestsContactsConnectionPresenceStatusIndex> statuses;
+    QVector<const gchar *> messages;
+    for (int i = 0; i < maxContacts; ++i) {
+        QByteArray id = QByteArray("contact") + QByteArray::number(i) + "@example.com";
+        mHandles << tp_handle_ensure(serviceRepo, id.constData(), NULL, NULL);
+        QVERIFY(mHandles.last() != 0);
+        aliases << QByteArray("Contact ") + QByteArray::number(i);
+        statuses << (i % 2 ? TP_TESTS_CONTACTS_CONNECTION_STATUS_AWAY :
+                TP_TESTS_CONTACTS_CONNECTION_STATUS_AVAILABLE);
+        messages << "";
+    }
+    foreach (const QByteArray &alias, aliases) {
+        aliasPtrs << alias.constData();
+    }
+
+    QVector<uint> handles = mHandles.toVector();
+    tp_tests_contacts_connection_change_aliases(mConnService, maxContacts,
+            handles.constData(), aliasPtrs.constData());
+    tp_tests_contacts_connection_change_presences(mConnService, maxContacts,
+            handles.constData(), statuses.constData(), messages.constData());
+    processDBusQueue(mConn.data());
+}
+
+void TestContactsBenchmark::init()
+{
+    initImpl();
+}
+
+void TestContactsBenchmark::benchmarkContactsForHandles_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("1000 contacts") << 1000;
+    QTest::newRow("5000 contacts") << maxContacts;
+}
+
+void TestContactsBenchmark::benchmarkContactsForHandles()
+{
+    QFETCH(int, count);
+
+    Tp::UIntList handles = mHandles.mid(0, count);
+    Features features = Features()
+        << Contact::FeatureAlias
+        << Contact::FeatureAvatarToken
+        << Contact::FeatureSimplePresence;
+
+    qint64 elapsed = 0;
+    qint64 built = 0;
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+
+        PendingContacts *pending = mConn->contactManager()->contactsForHandles(handles, features);
+        QVERIFY(connect(pending,
+                    SIGNAL(finished(Tp::PendingOperation*)),
+                    SLOT(expectPendingContactsFinished(Tp::PendingOperation*))));
+        QCOMPARE(mLoop->exec(), 0);
+
+        elapsed += timer.nsecsElapsed();
+        built += mContacts.size();
+        QCOMPARE(mContacts.size(), count);
+
+        // Drop the contacts so that the next iteration builds them again
+        mContacts.clear();
+    }
+
+    if (elapsed > 0) {
+        qDebug() << built << "contacts built at" <<
+            qRound64(built * 1000000000.0 / elapsed) << "contacts/s";
+    }
+}
+
+void TestContactsBenchmark::cleanup()
+{
+    mContacts.clear();
+    cleanupImpl();
+}
+
+void TestContactsBenchmark::cleanupTestCase()
+{
+    if (mConn) {
+        QVERIFY(connect(mConn->lowlevel()->requestDisconnect(),
+                    SIGNAL(finished(Tp::PendingOperation*)),
+                    SLOT(expectSuccessfulCall(Tp::PendingOperation*))));
+        QCOMPARE(mLoop->exec(), 0);
+    }
+
+    if (mConnService != 0) {
+        g_object_unref(mConnService);
+        mConnService = 0;
+    }
+
+    cleanupTestCaseImpl();
+}
+
+QTEST_MAIN(TestContactsBenchmark)
+#include "_gen/contacts-benchmark.cpp.moc.hpp"
@@ -35,7 +35,7 @@ class TestContacts : public Test
 
 public:
     TestContacts(QObject *parent = 0)
-        : Test(parent), mConnService(0)
+        : Test(parent), mConnService(0), mContactsChangedCount(0)
     {
     }
 
@@ -43,6 +43,8 @@ protected Q_SLOTS:
     void expectConnReady(Tp::ConnectionStatus, Tp::ConnectionStatusReason);
     void expectConnInvalidated();
     void expectPendingContactsFinished(Tp::PendingOperation *);
+    void onContactsChanged(const QList<Tp::ContactPtr> &,
+            Tp::ContactManager::ChangedFields);
 
 private Q_SLOTS:
     void initTestCase();
@@ -52,9 +54,12 @@ private Q_SLOTS:
     void testSelfContact();
     void testForHandles();
     void testForIdentifiers();
+    void testForKnownIdentifiers();
     void testFeatures();
     void testFeaturesNotRequested();
     void testUpgrade();
+    void testChangeCoalescing();
+    void testAttributesScheduling();
     void testSelfContactFallback();
 
     void cleanup();
@@ -66,6 +71,9 @@ private:
     ConnectionPtr mConn;
     QList<ContactPtr> mContacts;
     Tp::UIntList mInvalidHandles;
+    int mContactsChangedCount;
+    QList<ContactPtr> mChangedContacts;
+    ContactManager::ChangedFields mChanges;
 };
 
 void TestContacts::expectConnReady(Tp::ConnectionStatus newStatus,
@@ -96,6 +104,14 @@ void TestContacts::expectConnInvalidated()
     mLoop->exit(0);
 }
 
+void TestContacts::onContactsChanged(const QList<Tp::ContactPtr> &contacts,
+        Tp::ContactManager::ChangedFields changes)
+{
+    mContactsChangedCount++;
+    mChangedContacts = contacts;
+    mChanges = changes;
+}
+
 void TestContacts::expectPendingContactsFinished(PendingOperation *op)
 {
     TEST_VERIFY_OP(op);
@@ -413,6 +429,69 @@ void TestContacts::testForIdentifiers()
     processDBusQueue(mConn.data());
 }
 
+void TestContacts::testForKnownIdentifiers()
+{
+    ContactManagerPtr contactManager = mConn->contactManager();
+    QStringList ids = QStringList() << QLatin1String("Alice") << QLatin1String("bob");
+
+    PendingContacts *pending = contactManager->contactsForIdentifiers(ids);
+    QVERIFY(connect(pending,
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(expectPendingContactsFinished(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(pending->validIdentifiers(), ids);
+    QCOMPARE(mContacts.size(), 2);
+    QList<ContactPtr> known = mContacts;
+
+    // Contacts that are still around with all the requested features are returned as is, both
+    // for the identifier as requested and for the normalized one, mixed with new ones in the
+    // requested order
+    ids = QStringList() << QLatin1String("chris") << QLatin1String("Alice")
+        << QLatin1String("Not valid") << QLatin1String("bob");
+    pending = contactManager->contactsForIdentifiers(ids);
+    QVERIFY(connect(pending,
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(expectPendingContactsFinished(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(pending->validIdentifiers(), QStringList() << QLatin1String("chris")
+            << QLatin1String("Alice") << QLatin1String("bob"));
+    QCOMPARE(pending->invalidIdentifiers().keys(), QStringList() << QLatin1String("Not valid"));
+    QCOMPARE(mContacts.size(), 3);
+    QCOMPARE(mContacts[0]->id(), QString(QLatin1String("chris")));
+    QCOMPARE(mContacts[1], known[0]);
+    QCOMPARE(mContacts[2], known[1]);
+    known.append(mContacts[0]);
+
+    ids = QStringList() << QLatin1String("alice") << QLatin1String("chris");
+    pending = contactManager->contactsForIdentifiers(ids);
+    QVERIFY(connect(pending,
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(expectPendingContactsFinished(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(pending->validIdentifiers(), ids);
+    QCOMPARE(mContacts.size(), 2);
+    QCOMPARE(mContacts[0], known[0]);
+    QCOMPARE(mContacts[1], known[2]);
+
+    // Missing features still have to be fetched
+    Features features = Features() << Contact::FeatureAlias;
+    pending = contactManager->contactsForIdentifiers(ids, features);
+    QVERIFY(connect(pending,
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(expectPendingContactsFinished(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mContacts.size(), 2);
+    QCOMPARE(mContacts[0], known[0]);
+    QCOMPARE(mContacts[1], known[2]);
+    QVERIFY(mContacts[0]->requestedFeatures().contains(Contact::FeatureAlias));
+    QVERIFY(mContacts[1]->requestedFeatures().contains(Contact::FeatureAlias));
+
+    mContacts.clear();
+    known.clear();
+    mLoop->processEvents();
+    processDBusQueue(mConn.data());
+}
+
 void TestContacts::testFeatures()
 {
     QStringList ids = QStringList() << QLatin1String("alice")
@@ -717,6 +796,181 @@ void TestContacts::testUpgrade()
     processDBusQueue(mConn.data());
 }
 
+void TestContacts::testChangeCoalescing()
+{
+    QStringList ids = QStringList() << QLatin1String("alice")
+        << QLatin1String("bob") << QLatin1String("chris");
+    static TpTestsContactsConnectionPresenceStatusIndex initialStatuses[] = {
+        TP_TESTS_CONTACTS_CONNECTION_STATUS_AVAILABLE,
+        TP_TESTS_CONTACTS_CONNECTION_STATUS_AVAILABLE,
+        TP_TESTS_CONTACTS_CONNECTION_STATUS_AVAILABLE
+    };
+    static TpTestsContactsConnectionPresenceStatusIndex latterStatuses[] = {
+        TP_TESTS_CONTACTS_CONNECTION_STATUS_AWAY,
+        TP_TESTS_CONTACTS_CONNECTION_STATUS_BUSY,
+        TP_TESTS_CONTACTS_CONNECTION_STATUS_AWAY
+    };
+    const char *messages[] = {
+        "",
+        "",
+        ""
+    };
+    TpHandleRepoIface *serviceRepo =
+        tp_base_connection_get_handles(TP_BASE_CONNECTION(mConnService), TP_HANDLE_TYPE_CONTACT);
+
+    Tp::UIntList handles;
+    for (int i = 0; i < 3; i++) {
+        handles.push_back(tp_handle_ensure(serviceRepo, ids[i].toLatin1().constData(), NULL, NULL));
+        QVERIFY(handles[i] != 0);
+    }
+
+    tp_tests_contacts_connection_change_presences(mConnService, 3, handles.toVector().constData(),
+            initialStatuses, messages);
+
+    ContactManagerPtr contactManager = mConn->contactManager();
+    PendingContacts *pending = contactManager->contactsForHandles(handles,
+            Features() << Contact::FeatureSimplePresence);
+    QVERIFY(connect(pending,
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(expectPendingContactsFinished(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mContacts.size(), 3);
+
+    QVERIFY(!contactManager->isChangeCoalescingEnabled());
+    contactManager->setChangeCoalescingEnabled(true);
+    // Long enough for both changes below to fall within the same frame
+    contactManager->setChangeCoalescingInterval(200);
+    QVERIFY(connect(contactManager.data(),
+                SIGNAL(contactsChanged(QList<Tp::ContactPtr>,Tp::ContactManager::ChangedFields)),
+                SLOT(onContactsChanged(QList<Tp::ContactPtr>,Tp::ContactManager::ChangedFields))));
+    mContactsChangedCount = 0;
+
+    // Two separate PresencesChanged signals for the same contacts
+    tp_tests_contacts_connection_change_presences(mConnService, 3, handles.toVector().constData(),
+            latterStatuses, messages);
+    tp_tests_contacts_connection_change_presences(mConnService, 2, handles.toVector().constData(),
+            initialStatuses, messages);
+    processDBusQueue(mConn.data());
+
+    // The changes were applied to the contacts, but reported once per contact
+    QTRY_COMPARE(mContactsChangedCount, 1);
+    QCOMPARE(mChanges, ContactManager::ChangedFields(ContactManager::PresenceChanged));
+    QCOMPARE(mChangedContacts.toSet(), mContacts.toSet());
+    QCOMPARE(mContacts[0]->presence().status(), QString(QLatin1String("available")));
+    QCOMPARE(mContacts[2]->presence().status(), QString(QLatin1String("away")));
+
+    contactManager->setChangeCoalescingEnabled(false);
+    contactManager->setChangeCoalescingInterval(0);
+    QVERIFY(disconnect(contactManager.data(),
+                SIGNAL(contactsChanged(QList<Tp::ContactPtr>,Tp::ContactManager::ChangedFields)),
+                this,
+                SLOT(onContactsChanged(QList<Tp::ContactPtr>,Tp::ContactManager::ChangedFields))));
+
+    mChangedContacts.clear();
+    mContacts.clear();
+    mLoop->processEvents();
+    processDBusQueue(mConn.data());
+}
+
+void TestContacts::testAttributesScheduling()
+{
+    QStringList ids = QStringList() << QLatin1String("sched-alice")
+        << QLatin1String("sched-bob") << QLatin1String("sched-chris")
+        << QLatin1String("sched-dora") << QLatin1String("sched-edgar");
+    TpHandleRepoIface *serviceRepo =
+        tp_base_connection_get_handles(TP_BASE_CONNECTION(mConnService), TP_HANDLE_TYPE_CONTACT);
+
+    Tp::UIntList handles;
+    for (int i = 0; i < ids.size(); i++) {
+        handles.push_back(tp_handle_ensure(serviceRepo, ids[i].toLatin1().constData(), NULL, NULL));
+        QVERIFY(handles[i] != 0);
+    }
+
+    ContactManagerPtr contactManager = mConn->contactManager();
+    QCOMPARE(contactManager->contactAttributesChunkSize(), 500);
+    QCOMPARE(contactManager->maxContactAttributesRequestsInFlight(), 4);
+    contactManager->setContactAttributesChunkSize(2);
+    contactManager->setMaxContactAttributesRequestsInFlight(1);
+
+    // Overlapping requests made in the same main loop iteration are fetched together,
+    // two contacts at a time, one call after the other
+    PendingContacts *first = contactManager->contactsForHandles(handles.mid(0, 3));
+    PendingContacts *second = contactManager->contactsForHandles(handles);
+    QVERIFY(connect(first,
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(expectPendingContactsFinished(Tp::PendingOperation*))));
+    QVERIFY(connect(second,
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(expectPendingContactsFinished(Tp::PendingOperation*))));
+
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mContacts.size(), 3);
+    QList<ContactPtr> firstContacts = mContacts;
+
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mContacts.size(), 5);
+    QVERIFY(mInvalidHandles.isEmpty());
+    for (int i = 0; i < ids.size(); i++) {
+        QCOMPARE(mContacts[i]->handle()[0], handles[i]);
+        QCOMPARE(mContacts[i]->id(), ids[i]);
+    }
+    for (int i = 0; i < firstContacts.size(); i++) {
+        QCOMPARE(firstContacts[i], mContacts[i]);
+    }
+
+    contactManager->setContactAttributesChunkSize(500);
+    contactManager->setMaxContactAttributesRequestsInFlight(4);
+    mContacts.clear();
+    firstContacts.clear();
+
+    // A request can wait both for a call in flight and for a batch which is not sent yet, and
+    // must not finish when the call is answered before the batch goes out
+    QStringList moreIds = QStringList() << QLatin1String("sched-fred")
+        << QLatin1String("sched-gina") << QLatin1String("sched-hank");
+    Tp::UIntList moreHandles;
+    for (int i = 0; i < moreIds.size(); i++) {
+        moreHandles.push_back(tp_handle_ensure(serviceRepo, moreIds[i].toLatin1().constData(), NULL, NULL));
+        QVERIFY(moreHandles[i] != 0);
+    }
+
+    PendingContacts *inFlight = contactManager->contactsForHandles(moreHandles.mid(0, 2));
+    QVERIFY(connect(inFlight,
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(expectPendingContactsFinished(Tp::PendingOperation*))));
+
+    // Queued after the flush which sends the call for inFlight, so that the service answers
+    // the call below after it. When that answer is handled, the first call has been answered
+    // too, but its operation has not told the scheduler yet.
+    QTimer::singleShot(0, this, [&]() {
+        QDBusMessage message = QDBusMessage::createMethodCall(mConn->busName(),
+                mConn->objectPath(), QLatin1String("org.freedesktop.DBus.Properties"),
+                QLatin1String("Get"));
+        message << TP_QT_IFACE_CONNECTION << QLatin1String("SelfHandle");
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
+                mConn->dbusConnection().asyncCall(message), this);
+        connect(watcher, &QDBusPendingCallWatcher::finished,
+                [this, &contactManager, &moreHandles](QDBusPendingCallWatcher *watcher) {
+            PendingContacts *mixed = contactManager->contactsForHandles(moreHandles);
+            connect(mixed,
+                    SIGNAL(finished(Tp::PendingOperation*)),
+                    SLOT(expectPendingContactsFinished(Tp::PendingOperation*)));
+            watcher->deleteLater();
+        });
+    });
+
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mContacts.size(), 2);
+
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mContacts.size(), 3);
+    QVERIFY(mInvalidHandles.isEmpty());
+    for (int i = 0; i < moreIds.size(); i++) {
+        QCOMPARE(mContacts[i]->id(), moreIds[i]);
+    }
+
+    mContacts.clear();
+}
+
 void TestContacts::testSelfContactFallback()
 {
     gchar *name;
@@ -0,0 +1,180 @@
+#include <tests/lib/test.h>
+
+#include <TelepathyQt/Constants>
+#include <TelepathyQt/DBusObject>
+#include <TelepathyQt/DBusService>
+
+using namespace Tp;
+
+namespace
+{
+
+const char *objectPath = "/org/freedesktop/Telepathy/TestDBusServiceProperties";
+const char *interfaceName = "org.freedesktop.Telepathy.TestInterface";
+
+class TestInterface : public AbstractDBusServiceInterface
+{
+public:
+    TestInterface()
+        : AbstractDBusServiceInterface(QLatin1String(interfaceName))
+    {
+    }
+
+    bool registerOn(DBusObject *dbusObject)
+    {
+        return registerInterface(dbusObject);
+    }
+
+protected:
+    void createAdaptor() { }
+};
+
+}
+
+class TestDBusServiceProperties : public Test
+{
+    Q_OBJECT
+public:
+    TestDBusServiceProperties(QObject *parent = 0)
+        : Test(parent), mDBusObject(0)
+    { }
+
+protected Q_SLOTS:
+    void onPropertiesChanged(const QString &interface, const QVariantMap &changed,
+            const QStringList &invalidated);
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testImmediate();
+    void testBatch();
+    void testDeferred();
+
+    void cleanup();
+    void cleanupTestCase();
+
+private:
+    void expectSignals(int count);
+
+    DBusObject *mDBusObject;
+    QList<QVariantMap> mChanges;
+};
+
+void TestDBusServiceProperties::onPropertiesChanged(const QString &interface,
+        const QVariantMap &changed, const QStringList &invalidated)
+{
+    Q_UNUSED(invalidated);
+
+    if (interface != QLatin1String(interfaceName)) {
+        return;
+    }
+    mChanges.append(changed);
+    mLoop->exit(0);
+}
+
+void TestDBusServiceProperties::expectSignals(int count)
+{
+    while (mChanges.size() < count) {
+        QCOMPARE(mLoop->exec(), 0);
+    }
+}
+
+void TestDBusServiceProperties::initTestCase()
+{
+    initTestCaseImpl();
+
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    mDBusObject = new DBusObject(bus, this);
+    QVERIFY(bus.registerObject(QLatin1String(objectPath), mDBusObject));
+    QVERIFY(bus.connect(QString(), QLatin1String(objectPath), TP_QT_IFACE_PROPERTIES,
+                QLatin1String("PropertiesChanged"), this,
+                SLOT(onPropertiesChanged(QString,QVariantMap,QStringList))));
+}
+
+void TestDBusServiceProperties::init()
+{
+    initImpl();
+}
+
+void TestDBusServiceProperties::testImmediate()
+{
+    TestInterface iface;
+    QVERIFY(!iface.notifyPropertyChanged(QLatin1String("Title"), QLatin1String("unregistered")));
+    QVERIFY(iface.registerOn(mDBusObject));
+
+    QVERIFY(iface.notifyPropertyChanged(QLatin1String("Title"), QLatin1String("first")));
+    QVERIFY(iface.notifyPropertyChanged(QLatin1String("Limit"), 10U));
+    expectSignals(2);
+    QCOMPARE(mChanges[0].keys(), QStringList() << QLatin1String("Title"));
+    QCOMPARE(mChanges[0].value(QLatin1String("Title")).toString(), QLatin1String("first"));
+    QCOMPARE(mChanges[1].keys(), QStringList() << QLatin1String("Limit"));
+}
+
+void TestDBusServiceProperties::testBatch()
+{
+    TestInterface iface;
+    QVERIFY(iface.registerOn(mDBusObject));
+
+    {
+        AbstractDBusServiceInterface::PropertyChangeBatch batch(&iface);
+        iface.notifyPropertyChanged(QLatin1String("Title"), QLatin1String("first"));
+        {
+            AbstractDBusServiceInterface::PropertyChangeBatch nested(&iface);
+            iface.notifyPropertyChanged(QLatin1String("Limit"), 10U);
+        }
+        iface.notifyPropertyChanged(QLatin1String("Title"), QLatin1String("second"));
+    }
+    iface.notifyPropertyChanged(QLatin1String("Moderated"), true);
+
+    // One signal for the batch, with the last value of each property, then the next change
+    expectSignals(2);
+    QCOMPARE(mChanges[0].size(), 2);
+    QCOMPARE(mChanges[0].value(QLatin1String("Title")).toString(), QLatin1String("second"));
+    QCOMPARE(mChanges[0].value(QLatin1String("Limit")).toUInt(), 10U);
+    QCOMPARE(mChanges[1].keys(), QStringList() << QLatin1String("Moderated"));
+
+    QVERIFY(!iface.endPropertyChanges());
+}
+
+void TestDBusServiceProperties::testDeferred()
+{
+    TestInterface iface;
+    QVERIFY(iface.registerOn(mDBusObject));
+    QVERIFY(!iface.deferPropertyChanges());
+    iface.setDeferPropertyChanges(true);
+    QVERIFY(iface.deferPropertyChanges());
+
+    iface.notifyPropertyChanged(QLatin1String("Title"), QLatin1String("first"));
+    iface.notifyPropertyChanged(QLatin1String("Description"), QLatin1String("room"));
+    iface.notifyPropertyChanged(QLatin1String("Title"), QLatin1String("second"));
+
+    expectSignals(1);
+    QCOMPARE(mChanges[0].size(), 2);
+    QCOMPARE(mChanges[0].value(QLatin1String("Title")).toString(), QLatin1String("second"));
+
+    // Explicit flushes do not wait for the event loop
+    iface.notifyPropertyChanged(QLatin1String("Limit"), 5U);
+    QVERIFY(iface.flushPropertyChanges());
+    expectSignals(2);
+    QCOMPARE(mChanges[1].keys(), QStringList() << QLatin1String("Limit"));
+
+    // Nothing is left for the queued flush
+    mLoop->processEvents();
+    QCOMPARE(mChanges.size(), 2);
+}
+
+void TestDBusServiceProperties::cleanup()
+{
+    mChanges.clear();
+    cleanupImpl();
+}
+
+void TestDBusServiceProperties::cleanupTestCase()
+{
+    QDBusConnection::sessionBus().unregisterObject(QLatin1String(objectPath));
+    cleanupTestCaseImpl();
+}
+
+QTEST_MAIN(TestDBusServiceProperties)
+#include "_gen/dbus-service-properties.cpp.moc.hpp"
@@ -8,6 +8,8 @@
 
 #include <TelepathyQt/Connection>
 #include <TelepathyQt/Debug>
+#include <TelepathyQt/PendingVariant>
+#include <TelepathyQt/PendingVariantMap>
 
 #include <telepathy-glib/dbus.h>
 #include <telepathy-glib/debug.h>
@@ -32,6 +34,7 @@ private Q_SLOTS:
     void init();
 
     void testPropertiesMonitoring();
+    void testPropertiesCaching();
 
     void cleanup();
     void cleanupTestCase();
@@ -126,6 +129,79 @@ void TestProperties::testPropertiesMonitoring()
     g_hash_table_destroy (changed);
 }
 
+void TestProperties::testPropertiesCaching()
+{
+    QCOMPARE(mConn->isCachingProperties(), false);
+    QCOMPARE(mConn->isPropertyCacheSeeded(), false);
+
+    // Enabling the cache monitors changes and seeds it with GetAll
+    connect(mConn, SIGNAL(propertyCacheSeeded()), mLoop, SLOT(quit()));
+    mConn->setCachingProperties(true);
+    QCOMPARE(mConn->isCachingProperties(), true);
+    QCOMPARE(mConn->isMonitoringProperties(), true);
+    QCOMPARE(mLoop->exec(), 0);
+    disconnect(mConn, SIGNAL(propertyCacheSeeded()), mLoop, SLOT(quit()));
+
+    QCOMPARE(mConn->isPropertyCacheSeeded(), true);
+    QVERIFY(mConn->hasCachedProperty(QLatin1String("Status")));
+    QCOMPARE(mConn->cachedProperty(QLatin1String("Status")).toUInt(),
+            static_cast<uint>(ConnectionStatusDisconnected));
+    QCOMPARE(mConn->propertyCacheHits(), 1U);
+    QVERIFY(!mConn->cachedProperty(QLatin1String("test-prop")).isValid());
+    uint misses = mConn->propertyCacheMisses();
+    QVERIFY(misses > 0);
+
+    // Cached properties are answered without going to the bus
+    PendingVariant *pv = mConn->requestPropertyStatus();
+    QVERIFY(pv->isFinished());
+    QVERIFY(!pv->isError());
+    QCOMPARE(pv->result().toUInt(), static_cast<uint>(ConnectionStatusDisconnected));
+    PendingVariantMap *pvm = mConn->requestAllProperties();
+    QVERIFY(pvm->isFinished());
+    QCOMPARE(pvm->result(), mConn->cachedProperties());
+    QCOMPARE(mConn->propertyCacheHits(), 3U);
+    QCOMPARE(mConn->propertyCacheMisses(), misses);
+
+    // Changes update the cache
+    connect(mConn, SIGNAL(propertiesChanged(QVariantMap,QStringList)),
+            mLoop, SLOT(quit()));
+
+    GHashTable *changed = tp_asv_new(
+                "test-prop", G_TYPE_STRING, "Cached",
+                NULL
+                );
+    tp_svc_dbus_properties_emit_properties_changed (mConnService,
+            mConn->interface().toLatin1().data(), changed, NULL);
+    g_hash_table_destroy (changed);
+    QCOMPARE(mLoop->exec(), 0);
+
+    QCOMPARE(mConn->cachedProperty(QLatin1String("test-prop")).toString(),
+            QLatin1String("Cached"));
+
+    // Invalidated properties are dropped, and the cache no longer answers GetAll
+    GHashTable *empty = tp_asv_new(NULL, NULL);
+    const gchar *invalidated[] = { "test-prop", NULL };
+    tp_svc_dbus_properties_emit_properties_changed (mConnService,
+            mConn->interface().toLatin1().data(), empty, invalidated);
+    g_hash_table_destroy (empty);
+    QCOMPARE(mLoop->exec(), 0);
+
+    QVERIFY(!mConn->hasCachedProperty(QLatin1String("test-prop")));
+    QVERIFY(mConn->hasCachedProperty(QLatin1String("Status")));
+    misses = mConn->propertyCacheMisses();
+    pvm = mConn->requestAllProperties();
+    QVERIFY(!pvm->isFinished());
+    QCOMPARE(mConn->propertyCacheMisses(), misses + 1);
+
+    // Disabling the cache drops everything
+    mConn->setCachingProperties(false);
+    QCOMPARE(mConn->isCachingProperties(), false);
+    QCOMPARE(mConn->isPropertyCacheSeeded(), false);
+    QVERIFY(mConn->cachedProperties().isEmpty());
+    pv = mConn->requestPropertyStatus();
+    QVERIFY(!pv->isFinished());
+}
+
 void TestProperties::cleanup()
 {
     if (mConn) {
@@ -73,6 +73,7 @@ private Q_SLOTS:
 
     void testBasics();
     void testNameOwnerChanged();
+    void testOwnerCache();
 
     void cleanup();
     void cleanupTestCase();
@@ -293,6 +294,37 @@ void TestStatefulProxy::testNameOwnerChanged()
     QCOMPARE(mProxy->invalidationMessage(), mSignalledInvalidationMessage);
 }
 
+void TestStatefulProxy::testOwnerCache()
+{
+    QString name = QLatin1String("org.freedesktop.Telepathy.Qt.TestStatefulProxy.Cached");
+
+    QDBusConnection firstOwner = QDBusConnection::connectToBus(
+            QDBusConnection::SessionBus, QLatin1String("first owner"));
+    QVERIFY(firstOwner.registerService(name));
+
+    mProxy = new MyStatefulDBusProxy(QDBusConnection::sessionBus(), name, objectPath());
+    QVERIFY(mProxy->isValid());
+    QCOMPARE(mProxy->busName(), firstOwner.baseService());
+    QCOMPARE(StatefulDBusProxy::uniqueNameFrom(QDBusConnection::sessionBus(), name),
+            firstOwner.baseService());
+    delete mProxy;
+    mProxy = 0;
+
+    // The cached owner must not outlive the owner itself
+    QDBusConnection::disconnectFromBus(QLatin1String("first owner"));
+    QDBusConnection secondOwner = QDBusConnection::connectToBus(
+            QDBusConnection::SessionBus, QLatin1String("second owner"));
+    QVERIFY(secondOwner.registerService(name));
+    QTRY_COMPARE(StatefulDBusProxy::uniqueNameFrom(QDBusConnection::sessionBus(), name),
+            secondOwner.baseService());
+
+    mProxy = new MyStatefulDBusProxy(QDBusConnection::sessionBus(), name, objectPath());
+    QVERIFY(mProxy->isValid());
+    QCOMPARE(mProxy->busName(), secondOwner.baseService());
+
+    QDBusConnection::disconnectFromBus(QLatin1String("second owner"));
+}
+
 void TestStatefulProxy::cleanup()
 {
     if (mProxy) {
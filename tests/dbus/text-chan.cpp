@@ -15,6 +15,7 @@
 #include <TelepathyQt/ReceivedMessage>
 #include <TelepathyQt/TextChannel>
 
+#include <telepathy-glib/cm-message.h>
 #include <telepathy-glib/debug.h>
 
 using namespace Tp;
@@ -57,6 +58,8 @@ private Q_SLOTS:
 
     void testMessages();
     void testLegacyText();
+    void testBoundedMessageQueue();
+    void testPerSenderDelivery();
 
     void cleanup();
     void cleanupTestCase();
@@ -64,6 +67,7 @@ private Q_SLOTS:
 private:
     void commonTest(bool withMessages);
     void sendText(const char *text);
+    void receiveText(TpHandle sender, const char *text);
 
     TestConnHelper *mConn;
     TpHandleRepoIface *mContactRepo;
@@ -120,6 +124,18 @@ void TestTextChan::sendText(const char *text)
     qDebug() << "message send mainloop finished";
 }
 
+void TestTextChan::receiveText(TpHandle sender, const char *text)
+{
+    qDebug() << "receiving message:" << text;
+    TpMessage *message = tp_cm_message_new(TP_BASE_CONNECTION(mConn->service()), 2);
+    tp_cm_message_set_sender(message, sender);
+    tp_message_set_uint32(message, 0, "message-type", TP_CHANNEL_TEXT_MESSAGE_TYPE_NORMAL);
+    tp_message_set_int64(message, 0, "message-received", time(NULL));
+    tp_message_set_string(message, 1, "content-type", "text/plain");
+    tp_message_set_string(message, 1, "content", text);
+    tp_message_mixin_take_received(G_OBJECT(mMessagesChanService), message);
+}
+
 void TestTextChan::initTestCase()
 {
     initTestCaseImpl();
@@ -534,6 +550,116 @@ void TestTextChan::testLegacyText()
     commonTest(false);
 }
 
+void TestTextChan::testBoundedMessageQueue()
+{
+    mChan = TextChannel::create(mConn->client(), mMessagesChanPath, QVariantMap());
+
+    QVERIFY(connect(mChan->becomeReady(Features() << TextChannel::FeatureMessageQueue),
+                SIGNAL(finished(Tp::PendingOperation *)),
+                SLOT(expectSuccessfulCall(Tp::PendingOperation *))));
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mChan->messageQueue().size(), 0);
+
+    QCOMPARE(mChan->maxMessageQueueSize(), 0);
+    mChan->setMaxMessageQueueSize(1);
+    QCOMPARE(mChan->maxMessageQueueSize(), 1);
+
+    QVERIFY(connect(mChan.data(),
+                SIGNAL(messageReceived(const Tp::ReceivedMessage &)),
+                SLOT(onMessageReceived(const Tp::ReceivedMessage &))));
+    QVERIFY(connect(mChan.data(),
+                SIGNAL(pendingMessageRemoved(const Tp::ReceivedMessage &)),
+                SLOT(onMessageRemoved(const Tp::ReceivedMessage &))));
+
+    sendText("One");
+    sendText("Two");
+    processDBusQueue(mChan.data());
+
+    while (received.size() != 2) {
+        QCOMPARE(mLoop->exec(), 0);
+    }
+
+    // The oldest message was forgotten to make room for the newest one
+    QCOMPARE(mChan->messageQueue().size(), 1);
+    QVERIFY(mChan->messageQueue().at(0) == received.at(1));
+    QCOMPARE(removed.size(), 1);
+    QVERIFY(removed.at(0) == received.at(0));
+
+    // Forgotten messages are still pending in the service
+    mChan->acknowledge(received);
+    QCOMPARE(mChan->messageQueue().size(), 0);
+
+    while (tp_message_mixin_has_pending_messages(
+                G_OBJECT(mMessagesChanService), 0)) {
+        QTest::qWait(1);
+    }
+}
+
+void TestTextChan::testPerSenderDelivery()
+{
+    mChan = TextChannel::create(mConn->client(), mMessagesChanPath, QVariantMap());
+
+    QCOMPARE(mChan->messageDeliveryMode(), TextChannel::MessageDeliveryModeInOrder);
+    mChan->setMessageDeliveryMode(TextChannel::MessageDeliveryModePerSender);
+    QCOMPARE(mChan->messageDeliveryMode(), TextChannel::MessageDeliveryModePerSender);
+
+    QVERIFY(connect(mChan->becomeReady(Features() << TextChannel::FeatureMessageQueue),
+                SIGNAL(finished(Tp::PendingOperation *)),
+                SLOT(expectSuccessfulCall(Tp::PendingOperation *))));
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mChan->messageQueue().size(), 0);
+
+    QVERIFY(connect(mChan.data(),
+                SIGNAL(messageReceived(const Tp::ReceivedMessage &)),
+                SLOT(onMessageReceived(const Tp::ReceivedMessage &))));
+
+    sendText("One");
+    sendText("Two");
+    sendText("Three");
+    processDBusQueue(mChan.data());
+
+    while (received.size() != 3) {
+        QCOMPARE(mLoop->exec(), 0);
+    }
+
+    // Messages from the same sender keep their relative order
+    QCOMPARE(received.at(0).text(), QLatin1String("One"));
+    QCOMPARE(received.at(1).text(), QLatin1String("Two"));
+    QCOMPARE(received.at(2).text(), QLatin1String("Three"));
+    QCOMPARE(received.at(2).sender()->id(), QLatin1String("someone@localhost"));
+    QCOMPARE(mChan->messageQueue().size(), 3);
+
+    mChan->acknowledge(received);
+    QCOMPARE(mChan->messageQueue().size(), 0);
+    received.clear();
+
+    // A sender whose contact still has to be looked up doesn't hold back a later message from
+    // a sender we already know
+    TpHandle newSender = tp_handle_ensure(mContactRepo, "newcomer@localhost", 0, 0);
+    receiveText(newSender, "Hello from a newcomer");
+    receiveText(mContact->handle()[0], "Hello from someone");
+    processDBusQueue(mChan.data());
+
+    while (received.size() != 2) {
+        QCOMPARE(mLoop->exec(), 0);
+    }
+
+    QCOMPARE(received.at(0).text(), QLatin1String("Hello from someone"));
+    QCOMPARE(received.at(0).sender(), mContact);
+    QCOMPARE(received.at(1).text(), QLatin1String("Hello from a newcomer"));
+    QCOMPARE(received.at(1).sender()->id(), QLatin1String("newcomer@localhost"));
+    QCOMPARE(mChan->messageQueue().size(), 2);
+    QVERIFY(mChan->messageQueue().at(0) == received.at(0));
+
+    mChan->acknowledge(received);
+    QCOMPARE(mChan->messageQueue().size(), 0);
+
+    while (tp_message_mixin_has_pending_messages(
+                G_OBJECT(mMessagesChanService), 0)) {
+        QTest::qWait(1);
+    }
+}
+
 void TestTextChan::cleanup()
 {
     received.clear();
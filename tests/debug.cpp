@@ -0,0 +1,108 @@
+#include <QtTest/QtTest>
+
+#include <TelepathyQt/Debug>
+
+#include "TelepathyQt/debug-internal.h"
+
+using namespace Tp;
+
+class TestDebug : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+
+    void testCategories();
+    void testFlightRecorder();
+    void testFlightRecorderWrap();
+
+    void cleanup();
+};
+
+void TestDebug::init()
+{
+#ifndef ENABLE_DEBUG
+    QSKIP("Built without debug output support");
+#endif
+
+    enableDebug(false);
+    enableWarnings(false);
+}
+
+void TestDebug::testCategories()
+{
+    for (int i = 0; i < NumDebugCategories; ++i) {
+        QVERIFY(isDebugCategoryEnabled((DebugCategory) i));
+    }
+
+    enableDebugCategory(DebugCategoryTubes, false);
+    QVERIFY(!isDebugCategoryEnabled(DebugCategoryTubes));
+    QVERIFY(isDebugCategoryEnabled(DebugCategoryContacts));
+    enableDebugCategory(DebugCategoryTubes, true);
+    QVERIFY(isDebugCategoryEnabled(DebugCategoryTubes));
+
+    QVERIFY(!isDebugCategoryEnabled(NumDebugCategories));
+}
+
+void TestDebug::testFlightRecorder()
+{
+    QCOMPARE(debugFlightRecorderSize(), 0);
+    enabledDebug(DebugCategoryContacts) << "not recorded";
+    QVERIFY(dumpDebugFlightRecorder().isEmpty());
+
+    setDebugFlightRecorderSize(4096);
+    QCOMPARE(debugFlightRecorderSize(), 4096);
+
+    // Recorded even though debug output is disabled
+    enabledDebug(DebugCategoryContacts) << "Got PresencesChanged for" << 3 << "contacts";
+    enabledWarning() << "Something went wrong";
+    enableDebugCategory(DebugCategoryChannels, false);
+    enabledDebug(DebugCategoryChannels) << "disabled category";
+    enableDebugCategory(DebugCategoryChannels, true);
+
+    QStringList messages = dumpDebugFlightRecorder();
+    QCOMPARE(messages.size(), 2);
+    QVERIFY(messages[0].contains(QLatin1String(
+                    " contacts DEBUG: Got PresencesChanged for 3 contacts")));
+    QVERIFY(messages[1].contains(QLatin1String(" general WARN: Something went wrong")));
+
+    setDebugFlightRecorderSize(0);
+    QCOMPARE(debugFlightRecorderSize(), 0);
+    QVERIFY(dumpDebugFlightRecorder().isEmpty());
+}
+
+void TestDebug::testFlightRecorderWrap()
+{
+    setDebugFlightRecorderSize(256);
+
+    for (int i = 0; i < 100; ++i) {
+        enabledDebug(DebugCategoryDispatch) << "message" << i;
+    }
+
+    // Only the most recent messages fit, oldest first
+    QStringList messages = dumpDebugFlightRecorder();
+    QVERIFY(!messages.isEmpty());
+    QVERIFY(messages.size() < 100);
+    int first = 100 - messages.size();
+    for (int i = 0; i < messages.size(); ++i) {
+        QVERIFY(messages[i].contains(QString(QLatin1String("dispatch DEBUG: message %1 "))
+                    .arg(first + i)));
+    }
+
+    // Messages larger than the recorder are truncated rather than dropped
+    enabledDebug(DebugCategoryDispatch) << QString(1024, QLatin1Char('x'));
+    messages = dumpDebugFlightRecorder();
+    QCOMPARE(messages.size(), 1);
+    QVERIFY(messages[0].contains(QLatin1String("xxxxxxxx")));
+}
+
+void TestDebug::cleanup()
+{
+    setDebugFlightRecorderSize(0);
+    enableWarnings(true);
+}
+
+QTEST_MAIN(TestDebug)
+
+#include "_gen/debug.cpp.moc.hpp"
@@ -0,0 +1,205 @@
+#include <QtTest/QtTest>
+
+#include <TelepathyQt/BaseConnection>
+#include <TelepathyQt/DeferredReply>
+#include <TelepathyQt/Types>
+
+using namespace Tp;
+
+namespace
+{
+
+// Records how a reply was finished, standing in for a D-Bus method invocation context
+class RecordingHandler : public DeferredReply<QString>::Handler
+{
+public:
+    RecordingHandler() : finishedCount(0), failedCount(0) { }
+
+    int finishedCount;
+    int failedCount;
+    QString result;
+    QString errorName;
+
+protected:
+    void onFinished(const QString &value)
+    {
+        ++finishedCount;
+        result = value;
+    }
+
+    void onFailed(const QString &name, const QString &message)
+    {
+        Q_UNUSED(message);
+        ++failedCount;
+        errorName = name;
+    }
+};
+
+class RecordingAttributesHandler : public DeferredReply<ContactAttributesMap>::Handler
+{
+public:
+    RecordingAttributesHandler() : finished(false) { }
+
+    bool finished;
+    ContactAttributesMap attributes;
+    QString errorName;
+
+protected:
+    void onFinished(const ContactAttributesMap &value)
+    {
+        finished = true;
+        attributes = value;
+    }
+
+    void onFailed(const QString &name, const QString &message)
+    {
+        Q_UNUSED(message);
+        finished = true;
+        errorName = name;
+    }
+};
+
+QVariantMap attributesOf(uint handle)
+{
+    QVariantMap ret;
+    ret.insert(TP_QT_IFACE_CONNECTION + QLatin1String("/contact-id"),
+            QString::number(handle));
+    return ret;
+}
+
+}
+
+class TestDeferredReply : public QObject
+{
+    Q_OBJECT
+
+public:
+    ContactAttributesMap getAttributes(const Tp::UIntList &handles,
+            const QStringList &interfaces, DBusError *error);
+    void getAttributesAsync(const Tp::UIntList &handles, const QStringList &interfaces,
+            const DeferredReply<Tp::ContactAttributesMap> &reply);
+
+private Q_SLOTS:
+    void testFinishOnce();
+    void testFailOnce();
+    void testContactAttributes();
+
+private:
+    QList<DeferredReply<ContactAttributesMap> > mPendingReplies;
+    QList<UIntList> mPendingHandles;
+};
+
+ContactAttributesMap TestDeferredReply::getAttributes(const Tp::UIntList &handles,
+        const QStringList &interfaces, DBusError *error)
+{
+    Q_UNUSED(interfaces);
+    Q_UNUSED(error);
+    ContactAttributesMap ret;
+    foreach (uint handle, handles) {
+        ret.insert(handle, attributesOf(handle));
+    }
+    return ret;
+}
+
+void TestDeferredReply::getAttributesAsync(const Tp::UIntList &handles,
+        const QStringList &interfaces, const DeferredReply<Tp::ContactAttributesMap> &reply)
+{
+    Q_UNUSED(interfaces);
+    // Answered later, as after a round trip to the server
+    mPendingReplies.append(reply);
+    mPendingHandles.append(handles);
+}
+
+void TestDeferredReply::testFinishOnce()
+{
+    DeferredReply<QString> invalid;
+    QVERIFY(!invalid.isValid());
+    QVERIFY(!invalid.isFinished());
+    invalid.setFinished(QLatin1String("ignored"));
+
+    RecordingHandler *handler = new RecordingHandler;
+    SharedPtr<DeferredReply<QString>::Handler> handlerPtr(handler);
+    DeferredReply<QString> reply(handlerPtr);
+    QVERIFY(reply.isValid());
+    QVERIFY(!reply.isFinished());
+
+    // Copies share the same state, so the callback can keep one around
+    DeferredReply<QString> copy(reply);
+    copy.setFinished(QLatin1String("token"));
+    QVERIFY(reply.isFinished());
+    QCOMPARE(handler->finishedCount, 1);
+    QCOMPARE(handler->result, QLatin1String("token"));
+
+    reply.setFinished(QLatin1String("other"));
+    reply.setFinishedWithError(TP_QT_ERROR_NETWORK_ERROR, QLatin1String("late"));
+    QCOMPARE(handler->finishedCount, 1);
+    QCOMPARE(handler->failedCount, 0);
+    QCOMPARE(handler->result, QLatin1String("token"));
+}
+
+void TestDeferredReply::testFailOnce()
+{
+    RecordingHandler *handler = new RecordingHandler;
+    SharedPtr<DeferredReply<QString>::Handler> handlerPtr(handler);
+    DeferredReply<QString> reply(handlerPtr);
+
+    DBusError error(TP_QT_ERROR_NETWORK_ERROR, QLatin1String("Timed out"));
+    reply.setFinishedWithError(error);
+    reply.setFinished(QLatin1String("token"));
+
+    QVERIFY(reply.isFinished());
+    QCOMPARE(handler->failedCount, 1);
+    QCOMPARE(handler->finishedCount, 0);
+    QCOMPARE(handler->errorName, TP_QT_ERROR_NETWORK_ERROR);
+}
+
+void TestDeferredReply::testContactAttributes()
+{
+    BaseConnectionContactsInterfacePtr iface = BaseConnectionContactsInterface::create();
+
+    // Without an asynchronous callback the synchronous one answers right away
+    iface->setGetContactAttributesCallback(memFun(this, &TestDeferredReply::getAttributes));
+    RecordingAttributesHandler *syncHandler = new RecordingAttributesHandler;
+    DeferredReply<ContactAttributesMap> syncReply(
+            SharedPtr<DeferredReply<ContactAttributesMap>::Handler>(syncHandler));
+    iface->getContactAttributes(UIntList() << 1 << 2, QStringList(), syncReply);
+    QVERIFY(syncHandler->finished);
+    QCOMPARE(syncHandler->attributes.size(), 2);
+
+    // With one, several requests can be pending and be answered in any order
+    iface->setGetContactAttributesAsyncCallback(
+            memFun(this, &TestDeferredReply::getAttributesAsync));
+    QList<RecordingAttributesHandler*> handlers;
+    QList<DeferredReply<ContactAttributesMap> > replies;
+    for (uint handle = 1; handle <= 3; ++handle) {
+        RecordingAttributesHandler *handler = new RecordingAttributesHandler;
+        handlers.append(handler);
+        replies.append(DeferredReply<ContactAttributesMap>(
+                    SharedPtr<DeferredReply<ContactAttributesMap>::Handler>(handler)));
+        iface->getContactAttributes(UIntList() << handle, QStringList(), replies.last());
+    }
+    QCOMPARE(mPendingReplies.size(), 3);
+    foreach (RecordingAttributesHandler *handler, handlers) {
+        QVERIFY(!handler->finished);
+    }
+
+    mPendingReplies[1].setFinishedWithError(TP_QT_ERROR_INVALID_HANDLE, QLatin1String("Gone"));
+    for (int i = 2; i >= 0; i -= 2) {
+        ContactAttributesMap attributes;
+        attributes.insert(mPendingHandles[i].first(), attributesOf(mPendingHandles[i].first()));
+        mPendingReplies[i].setFinished(attributes);
+    }
+
+    QVERIFY(handlers[0]->finished);
+    QCOMPARE(handlers[0]->attributes.keys(), UIntList() << 1);
+    QCOMPARE(handlers[1]->errorName, TP_QT_ERROR_INVALID_HANDLE);
+    QVERIFY(handlers[1]->attributes.isEmpty());
+    QCOMPARE(handlers[2]->attributes.value(3), attributesOf(3));
+
+    mPendingReplies.clear();
+    mPendingHandles.clear();
+}
+
+QTEST_MAIN(TestDeferredReply)
+
+#include "_gen/deferred-reply.cpp.moc.hpp"
@@ -29,6 +29,7 @@ public:
 
 private Q_SLOTS:
     void testFeaturesHash();
+    void testFeatureAssignment();
 };
 
 TestFeatures::TestFeatures(QObject *parent)
@@ -68,6 +69,27 @@ void TestFeatures::testFeaturesHash()
     QVERIFY(qHash(fs1.toSet()) != qHash(fs2.toSet()));
 }
 
+void TestFeatures::testFeatureAssignment()
+{
+    Feature critical(QLatin1String("Assigned"), 0, true);
+    Feature feature;
+    QVERIFY(!feature.isValid());
+
+    feature = critical;
+    QVERIFY(feature.isValid());
+    QCOMPARE(feature, critical);
+    QVERIFY(feature.isCritical());
+
+    // Features with the same class and id are the same feature, whatever the criticality
+    Features features = Features() << feature << Feature(QLatin1String("Assigned"), 0);
+    QCOMPARE(features.size(), 1);
+    QVERIFY(features.contains(Feature(QLatin1String("Assigned"), 0)));
+
+    feature = Feature(QLatin1String("Assigned"), 1);
+    QVERIFY(feature != critical);
+    QVERIFY(!feature.isCritical());
+}
+
 QTEST_MAIN(TestFeatures)
 
 #include "_gen/features.cpp.moc.hpp"
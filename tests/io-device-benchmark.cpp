@@ -0,0 +1,37 @@
+#include <QtTest/QtTest>
+
+#include <TelepathyQt/IODevice>
+
+using namespace Tp;
+
+class TestIODeviceBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkStreaming();
+};
+
+void TestIODeviceBenchmark::benchmarkStreaming()
+{
+    // Keeps a large amount buffered while reading small blocks from the front, which used to
+    // move the whole remaining buffer on every read
+    const QByteArray block(4096, 'b');
+    char readBuffer[1024];
+
+    IODevice device;
+    QVERIFY(device.open(QIODevice::ReadWrite | QIODevice::Unbuffered));
+
+    QBENCHMARK {
+        for (int i = 0; i < 4096; ++i) {
+            device.write(block);
+        }
+        while (device.read(readBuffer, sizeof(readBuffer)) > 0) {
+        }
+    }
+    QCOMPARE(device.bytesAvailable(), (qint64) 0);
+}
+
+QTEST_MAIN(TestIODeviceBenchmark)
+
+#include "_gen/io-device-benchmark.cpp.moc.hpp"
@@ -0,0 +1,105 @@
+#include <QtTest/QtTest>
+
+#include <TelepathyQt/IODevice>
+
+using namespace Tp;
+
+class TestIODevice : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testReadWrite();
+    void testCoalescedSignals();
+    void testHighWaterMark();
+};
+
+void TestIODevice::testReadWrite()
+{
+    IODevice device;
+    QVERIFY(device.open(QIODevice::ReadWrite | QIODevice::Unbuffered));
+    QCOMPARE(device.bytesAvailable(), (qint64) 0);
+    QCOMPARE(device.bytesToWrite(), (qint64) 0);
+
+    // Small writes share chunks, large ones get their own
+    QByteArray expected;
+    for (int i = 0; i < 100; ++i) {
+        QByteArray data(i * 37 + 1, char('a' + i % 26));
+        QCOMPARE(device.write(data), (qint64) data.size());
+        expected += data;
+    }
+    QByteArray large(200 * 1024, 'x');
+    QCOMPARE(device.write(large), (qint64) large.size());
+    expected += large;
+    QCOMPARE(device.bytesAvailable(), (qint64) expected.size());
+
+    // Reads of odd sizes cross chunk boundaries
+    QByteArray read;
+    while (device.bytesAvailable() > 0) {
+        read += device.read(1000 + read.size() % 7);
+    }
+    QCOMPARE(read, expected);
+    QCOMPARE(device.read(10), QByteArray());
+
+    QCOMPARE(device.write("more"), (qint64) 4);
+    QCOMPARE(device.readAll(), QByteArray("more"));
+}
+
+void TestIODevice::testCoalescedSignals()
+{
+    IODevice device;
+    QVERIFY(device.open(QIODevice::ReadWrite));
+    QSignalSpy readyReadSpy(&device, SIGNAL(readyRead()));
+    QSignalSpy bytesWrittenSpy(&device, SIGNAL(bytesWritten(qint64)));
+
+    for (int i = 0; i < 10; ++i) {
+        device.write("0123456789");
+    }
+    QCOMPARE(readyReadSpy.count(), 0);
+    QCOMPARE(bytesWrittenSpy.count(), 0);
+
+    QTRY_COMPARE(readyReadSpy.count(), 1);
+    QCOMPARE(bytesWrittenSpy.count(), 1);
+    QCOMPARE(bytesWrittenSpy.first().at(0).toLongLong(), (qint64) 100);
+    QCOMPARE(device.readAll().size(), 100);
+
+    // Nothing is announced for data which was read before the event loop ran
+    device.write("gone");
+    QCOMPARE(device.readAll(), QByteArray("gone"));
+    QTRY_COMPARE(bytesWrittenSpy.count(), 2);
+    QCOMPARE(readyReadSpy.count(), 1);
+}
+
+void TestIODevice::testHighWaterMark()
+{
+    IODevice device;
+    QVERIFY(device.open(QIODevice::ReadWrite | QIODevice::Unbuffered));
+    device.setHighWaterMark(100);
+    QCOMPARE(device.highWaterMark(), (qint64) 100);
+    QSignalSpy bytesWrittenSpy(&device, SIGNAL(bytesWritten(qint64)));
+
+    QByteArray data(80, 'a');
+    QCOMPARE(device.write(data), (qint64) 80);
+    QCOMPARE(device.write(data), (qint64) 20);
+    QCOMPARE(device.write(data), (qint64) 0);
+    QCOMPARE(device.bytesToWrite(), (qint64) 100);
+
+    // Written data is only acknowledged once it has been read
+    QTest::qWait(10);
+    QCOMPARE(bytesWrittenSpy.count(), 0);
+
+    QCOMPARE(device.read(30).size(), 30);
+    QCOMPARE(device.bytesToWrite(), (qint64) 70);
+    QTRY_COMPARE(bytesWrittenSpy.count(), 1);
+    QCOMPARE(bytesWrittenSpy.first().at(0).toLongLong(), (qint64) 30);
+    QCOMPARE(device.write(data), (qint64) 30);
+
+    device.setHighWaterMark(0);
+    QCOMPARE(device.bytesToWrite(), (qint64) 0);
+    QCOMPARE(device.write(data), (qint64) 80);
+    QCOMPARE(device.readAll().size(), 180);
+}
+
+QTEST_MAIN(TestIODevice)
+
+#include "_gen/io-device.cpp.moc.hpp"
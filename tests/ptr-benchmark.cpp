@@ -0,0 +1,139 @@
+#include <QtTest/QtTest>
+
+#include <QtCore/QList>
+#include <QtCore/QVector>
+
+#include <TelepathyQt/SharedPtr>
+
+using namespace Tp;
+
+class Item;
+typedef SharedPtr<Item> ItemPtr;
+
+class Item : public QObject,
+             public RefCounted
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(Item);
+
+public:
+    Item() {}
+};
+
+// Compares the SharedPtr operations used on hot paths, like filling containers of ContactPtr and
+// promoting WeakPtr back-references, with the way they were done before move support, co-allocated
+// counts and cast-free promotion
+class TestSharedPtrBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void benchmarkCreate_data();
+    void benchmarkCreate();
+    void benchmarkFillVector_data();
+    void benchmarkFillVector();
+    void benchmarkPromote_data();
+    void benchmarkPromote();
+
+    void cleanupTestCase();
+
+private:
+    QList<ItemPtr> mItems;
+};
+
+static const int itemCount = 10000;
+
+void TestSharedPtrBenchmark::initTestCase()
+{
+    for (int i = 0; i < itemCount; ++i) {
+        mItems.append(ItemPtr::create());
+    }
+}
+
+void TestSharedPtrBenchmark::benchmarkCreate_data()
+{
+    QTest::addColumn<bool>("coallocated");
+
+    QTest::newRow("new") << false;
+    QTest::newRow("create") << true;
+}
+
+void TestSharedPtrBenchmark::benchmarkCreate()
+{
+    QFETCH(bool, coallocated);
+
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i) {
+            ItemPtr ptr = coallocated ? ItemPtr::create() : ItemPtr(new Item);
+            QVERIFY(!ptr.isNull());
+        }
+    }
+}
+
+void TestSharedPtrBenchmark::benchmarkFillVector_data()
+{
+    QTest::addColumn<bool>("move");
+
+    QTest::newRow("copy") << false;
+    QTest::newRow("move") << true;
+}
+
+void TestSharedPtrBenchmark::benchmarkFillVector()
+{
+    QFETCH(bool, move);
+
+    QBENCHMARK {
+        // Growing the vector relocates the elements already in it, and each element is
+        // returned by value first, as when building contact lists
+        QVector<ItemPtr> objects;
+        foreach (const ItemPtr &object, mItems) {
+            ItemPtr tmp(object);
+            if (move) {
+                objects.append(std::move(tmp));
+            } else {
+                objects.append(tmp);
+            }
+        }
+        QCOMPARE(objects.size(), itemCount);
+    }
+}
+
+void TestSharedPtrBenchmark::benchmarkPromote_data()
+{
+    QTest::addColumn<bool>("dynamicCast");
+
+    QTest::newRow("dynamic_cast") << true;
+    QTest::newRow("static type") << false;
+}
+
+void TestSharedPtrBenchmark::benchmarkPromote()
+{
+    QFETCH(bool, dynamicCast);
+
+    QList<WeakPtr<Item> > weakObjects;
+    foreach (const ItemPtr &object, mItems) {
+        weakObjects.append(WeakPtr<Item>(object));
+    }
+
+    QBENCHMARK {
+        foreach (const WeakPtr<Item> &weakObject, weakObjects) {
+            ItemPtr ptr(weakObject);
+            if (dynamicCast) {
+                // what promoting used to cost on top of the reference count update
+                QVERIFY(dynamic_cast<Item*>(static_cast<RefCounted*>(ptr.data())));
+            }
+            QVERIFY(!ptr.isNull());
+        }
+    }
+}
+
+void TestSharedPtrBenchmark::cleanupTestCase()
+{
+    mItems.clear();
+}
+
+QTEST_MAIN(TestSharedPtrBenchmark)
+
+#include "_gen/ptr-benchmark.cpp.moc.hpp"
@@ -14,6 +14,8 @@ private Q_SLOTS:
     void testSharedPtrBoolConversion();
     void testWeakPtrBoolConversion();
     void testThreadSafety();
+    void testMove();
+    void testCreate();
 };
 
 class Data;
@@ -33,6 +35,28 @@ private:
     Data() {}
 };
 
+class Item : public RefCounted
+{
+    Q_DISABLE_COPY(Item);
+
+public:
+    Item(int value, bool *destroyed = 0) : value(value), destroyed(destroyed) {}
+    ~Item() { if (destroyed) { *destroyed = true; } }
+
+    int value;
+    bool *destroyed;
+};
+typedef SharedPtr<Item> ItemPtr;
+
+class Node : public QObject,
+             public RefCounted
+{
+    Q_DISABLE_COPY(Node);
+
+public:
+    Node(const QString &name) { setObjectName(name); }
+};
+
 void TestSharedPtr::testSharedPtrDict()
 {
     QHash<DataPtr, int> dict;
@@ -331,6 +355,73 @@ void TestSharedPtr::testThreadSafety()
     QVERIFY(promotedPtr.isNull());
 }
 
+void TestSharedPtr::testMove()
+{
+    DataPtr ptr = Data::create();
+    Data *savedData = ptr.data();
+    WeakPtr<Data> weakPtr(ptr);
+
+    DataPtr moved(std::move(ptr));
+    QVERIFY(ptr.isNull());
+    QCOMPARE(moved.data(), savedData);
+
+    DataPtr other = Data::create();
+    other = std::move(moved);
+    QVERIFY(moved.isNull());
+    QCOMPARE(other.data(), savedData);
+    QVERIFY(!weakPtr.isNull());
+
+    SharedPtr<const Data> constPtr(std::move(other));
+    QVERIFY(other.isNull());
+    QCOMPARE(constPtr.data(), static_cast<const Data*>(savedData));
+
+    WeakPtr<Data> movedWeakPtr(std::move(weakPtr));
+    QVERIFY(weakPtr.isNull());
+    QVERIFY(!movedWeakPtr.isNull());
+    weakPtr = std::move(movedWeakPtr);
+    QVERIFY(movedWeakPtr.isNull());
+    QVERIFY(!weakPtr.isNull());
+
+    constPtr.reset();
+    QVERIFY(weakPtr.isNull());
+    QVERIFY(DataPtr(weakPtr).isNull());
+}
+
+void TestSharedPtr::testCreate()
+{
+    bool destroyed = false;
+    ItemPtr ptr = ItemPtr::create(42, &destroyed);
+    QVERIFY(!ptr.isNull());
+    QCOMPARE(ptr->value, 42);
+
+    WeakPtr<Item> weakPtr(ptr);
+    ItemPtr promoted(weakPtr);
+    QCOMPARE(promoted.data(), ptr.data());
+    promoted.reset();
+
+    // The object goes away with the last SharedPtr even if a WeakPtr keeps the count alive
+    ptr.reset();
+    QVERIFY(destroyed);
+    QVERIFY(weakPtr.isNull());
+    QVERIFY(ItemPtr(weakPtr).isNull());
+    weakPtr = WeakPtr<Item>();
+
+    // And when no WeakPtr is left, the object is freed together with its count
+    destroyed = false;
+    SharedPtr<const Item> constPtr = SharedPtr<const Item>::create(7, &destroyed);
+    QCOMPARE(constPtr->value, 7);
+    constPtr.reset();
+    QVERIFY(destroyed);
+
+    // QObject is destroyed after RefCounted, and still has to find its memory in place
+    SharedPtr<Node> node = SharedPtr<Node>::create(QLatin1String("node"));
+    QString destroyedName;
+    QObject::connect(node.data(), &QObject::destroyed,
+            [&destroyedName](QObject *obj) { destroyedName = obj->objectName(); });
+    node.reset();
+    QCOMPARE(destroyedName, QLatin1String("node"));
+}
+
 QTEST_MAIN(TestSharedPtr)
 
 #include "_gen/ptr.cpp.moc.hpp"
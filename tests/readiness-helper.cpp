@@ -0,0 +1,168 @@
+#include <QtTest/QtTest>
+
+#include <TelepathyQt/Feature>
+#include <TelepathyQt/Object>
+#include <TelepathyQt/PendingReady>
+#include <TelepathyQt/ReadinessHelper>
+#include <TelepathyQt/ReadyObject>
+#include <TelepathyQt/SharedPtr>
+
+using namespace Tp;
+
+namespace {
+
+class IntrospectedObject : public Object, public ReadyObject
+{
+public:
+    static const Feature FeatureCore;
+    static const Feature FeatureA;
+    static const Feature FeatureB;
+    static const Feature FeatureNoOp;
+    static const Feature FeatureDependent;
+
+    IntrospectedObject()
+        : Object(),
+          ReadyObject(this, FeatureCore)
+    {
+        ReadinessHelper::Introspectables introspectables;
+        introspectables[FeatureCore] = ReadinessHelper::Introspectable(
+                QSet<uint>() << 0, Features(), QStringList(),
+                (ReadinessHelper::IntrospectFunc) &IntrospectedObject::introspectCore, this);
+        introspectables[FeatureA] = ReadinessHelper::Introspectable(
+                QSet<uint>() << 0, Features() << FeatureCore, QStringList(),
+                (ReadinessHelper::IntrospectFunc) &IntrospectedObject::introspectA, this);
+        introspectables[FeatureB] = ReadinessHelper::Introspectable(
+                QSet<uint>() << 0, Features() << FeatureCore, QStringList(),
+                (ReadinessHelper::IntrospectFunc) &IntrospectedObject::introspectB, this);
+        // Nothing to do for this one in the current status
+        introspectables[FeatureNoOp] = ReadinessHelper::Introspectable(
+                QSet<uint>() << 1, Features() << FeatureCore, QStringList(),
+                (ReadinessHelper::IntrospectFunc) &IntrospectedObject::introspectNoOp, this);
+        introspectables[FeatureDependent] = ReadinessHelper::Introspectable(
+                QSet<uint>() << 0, Features() << FeatureNoOp, QStringList(),
+                (ReadinessHelper::IntrospectFunc) &IntrospectedObject::introspectDependent, this);
+        readinessHelper()->addIntrospectables(introspectables);
+    }
+
+    ReadinessHelper *helper() const { return readinessHelper(); }
+
+    QList<Feature> started;
+
+private:
+    static void introspectCore(IntrospectedObject *self) { self->started << FeatureCore; }
+    static void introspectA(IntrospectedObject *self) { self->started << FeatureA; }
+    static void introspectB(IntrospectedObject *self) { self->started << FeatureB; }
+    static void introspectNoOp(IntrospectedObject *self) { self->started << FeatureNoOp; }
+    static void introspectDependent(IntrospectedObject *self) { self->started << FeatureDependent; }
+};
+
+const Feature IntrospectedObject::FeatureCore(QLatin1String("IntrospectedObject"), 0, true);
+const Feature IntrospectedObject::FeatureA(QLatin1String("IntrospectedObject"), 1);
+const Feature IntrospectedObject::FeatureB(QLatin1String("IntrospectedObject"), 2);
+const Feature IntrospectedObject::FeatureNoOp(QLatin1String("IntrospectedObject"), 3);
+const Feature IntrospectedObject::FeatureDependent(QLatin1String("IntrospectedObject"), 4);
+
+}
+
+class TestReadinessHelper : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestReadinessHelper(QObject *parent = 0)
+        : QObject(parent), mFinished(false), mSucceeded(false)
+    { }
+
+protected Q_SLOTS:
+    void onFinished(Tp::PendingOperation *op);
+
+private Q_SLOTS:
+    void init();
+
+    void testConcurrentIntrospection();
+    void testRequestedFeatureInstances();
+
+private:
+    bool mFinished;
+    bool mSucceeded;
+};
+
+void TestReadinessHelper::onFinished(PendingOperation *op)
+{
+    mFinished = true;
+    mSucceeded = !op->isError();
+}
+
+void TestReadinessHelper::init()
+{
+    mFinished = false;
+    mSucceeded = false;
+}
+
+void TestReadinessHelper::testConcurrentIntrospection()
+{
+    SharedPtr<IntrospectedObject> object(new IntrospectedObject);
+    ReadinessHelper *helper = object->helper();
+
+    QVERIFY(connect(object->becomeReady(Features() << IntrospectedObject::FeatureA <<
+                    IntrospectedObject::FeatureB << IntrospectedObject::FeatureDependent),
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(onFinished(Tp::PendingOperation*))));
+
+    QCoreApplication::processEvents();
+    QCOMPARE(object->started, QList<Feature>() << IntrospectedObject::FeatureCore);
+
+    // Everything which only waits for core starts together, and the no-op feature
+    // doesn't cost its dependent another main loop iteration
+    helper->setIntrospectCompleted(IntrospectedObject::FeatureCore, true);
+    QCoreApplication::processEvents();
+    QCOMPARE(object->started.size(), 4);
+    QVERIFY(object->started.contains(IntrospectedObject::FeatureA));
+    QVERIFY(object->started.contains(IntrospectedObject::FeatureB));
+    QVERIFY(object->started.contains(IntrospectedObject::FeatureDependent));
+    QVERIFY(!object->started.contains(IntrospectedObject::FeatureNoOp));
+
+    helper->setIntrospectCompleted(IntrospectedObject::FeatureA, true);
+    helper->setIntrospectCompleted(IntrospectedObject::FeatureB, true);
+    helper->setIntrospectCompleted(IntrospectedObject::FeatureDependent, true);
+    QTRY_VERIFY(mFinished);
+    QVERIFY(mSucceeded);
+    QVERIFY(object->isReady(Features() << IntrospectedObject::FeatureA <<
+                IntrospectedObject::FeatureB << IntrospectedObject::FeatureDependent));
+
+    QVERIFY(helper->introspectionTime(IntrospectedObject::FeatureCore) >= 0);
+    QVERIFY(helper->introspectionTime(IntrospectedObject::FeatureA) >= 0);
+    QVERIFY(helper->introspectionTime(IntrospectedObject::FeatureDependent) >= 0);
+    QCOMPARE(helper->introspectionTime(IntrospectedObject::FeatureNoOp), (qint64) -1);
+}
+
+void TestReadinessHelper::testRequestedFeatureInstances()
+{
+    SharedPtr<IntrospectedObject> object(new IntrospectedObject);
+
+    // Same feature as FeatureA, which was constructed first and is not critical
+    Feature criticalA(QLatin1String("IntrospectedObject"), 1, true);
+    object->becomeReady(Features() << criticalA);
+
+    Features requested = object->requestedFeatures();
+    QCOMPARE(requested.size(), 2);
+    QVERIFY(requested.contains(IntrospectedObject::FeatureCore));
+    foreach (const Feature &feature, requested) {
+        // The instance that was asked for is handed back, not the one registered first
+        QVERIFY(feature.isCritical());
+    }
+    QCOMPARE(object->requestedFeatures(), requested);
+
+    QCoreApplication::processEvents();
+    object->helper()->setIntrospectCompleted(IntrospectedObject::FeatureCore, true);
+    QCoreApplication::processEvents();
+    object->helper()->setIntrospectCompleted(IntrospectedObject::FeatureA, true);
+    QTRY_COMPARE(object->actualFeatures().size(), 2);
+    foreach (const Feature &feature, object->actualFeatures()) {
+        QVERIFY(feature.isCritical());
+    }
+}
+
+QTEST_MAIN(TestReadinessHelper)
+
+#include "_gen/readiness-helper.cpp.moc.hpp"
@@ -42,6 +42,7 @@ class Generator(object):
             self.dbus_proxy = opts.get('--dbus-proxy',
                     'Tp::DBusProxy')
             self.visibility = opts.get('--visibility', '')
+            self.property_cache = '--property-cache' in opts
             ifacedom = xml.dom.minidom.parse(opts['--ifacexml'])
             specdom = xml.dom.minidom.parse(opts['--specxml'])
         except KeyError as k:
@@ -380,6 +381,26 @@ void %(name)s::invalidate(Tp::DBusProxy *proxy,
        'val' : binding.val,
        'gettername' : 'requestProperty' + name})
 
+            if self.property_cache:
+                self.h("""
+    /**
+     * Synchronous getter for the cached value of the remote object property \\c %(name)s
+     * of type \\c %(val)s.
+     *
+     * The value is only available while caching properties, see
+     * Tp::AbstractInterface::setCachingProperties().
+     *
+     * \\return The cached value, or a default constructed value if the property
+     *          is not in the cache.
+     */
+    inline %(val)s %(gettername)s() const
+    {
+        return qdbus_cast<%(val)s>(cachedProperty(QLatin1String("%(name)s")));
+    }
+""" % {'name' : name,
+       'val' : binding.val,
+       'gettername' : 'cachedProperty' + name})
+
         if 'write' in access:
             self.h("""
     /**
@@ -543,6 +564,7 @@ if __name__ == '__main__':
              'mainiface=',
              'must-define=',
              'dbus-proxy=',
-             'visibility='])
+             'visibility=',
+             'property-cache'])
 
     Generator(dict(options))()